@@ -38,6 +38,27 @@ def compile(call):
 
 	return result.returncode
 
+### BUILD HEADLESS PROGRAM FOR LINUX, no window, gpu or audio device required
+if 'headless' in sys.argv:
+	print ("FRIENDSIMULATOR [96mHEADLESS[0m BUILD")
+
+	imgui_include = os.environ['LEO_EXTERNAL_LIBRARIES_INCLUDE']
+
+	os.makedirs("headless", exist_ok = True)
+
+	# Note(Leo): Arguments are passed as list, since posix subprocess does not split strings
+	call = [
+		"clang++",
+		"src/fsheadless_friendsimulator.cpp",
+		"-o", "headless/friendsimulator_headless",
+		"-std=c++17", "-O2", "-g", "-Werror",
+		"-DFS_DEVELOPMENT", "-DBUILD_DATE_TIME=\"{}\"".format(datetime.now().strftime("%B %d, %Y, %H:%M:%S")),
+		"-I" + imgui_include,
+		"-lpthread",
+	]
+
+	exit(compile(call))
+
 vulkan_sdk = os.environ['VULKAN_SDK']
 imgui_include = os.environ['LEO_EXTERNAL_LIBRARIES_INCLUDE']
 
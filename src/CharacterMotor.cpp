@@ -77,6 +77,11 @@ struct CharacterMotor
 	f32 maxLandingDepthZSpeed = 8.0f;
 
 	f32 collisionRadius = 0.25f;
+
+	/* Note(Leo): Test movement with one capsule sweep instead of fan of rays. Rays can slip past
+	thin colliders that are between them, sweep does not. */
+	bool8 useCapsuleSweep = false;
+
 	v3 hitRayPosition;
 	v3 hitRayNormal;
 
@@ -240,7 +245,59 @@ update_character_motor( CharacterMotor & 	motor,
 
 	if (motor.movementMode == CharacterMovementMode_walking)
 	{
-		if (speed > 0)
+		if (speed > 0 && motor.useCapsuleSweep)
+		{
+			v3 sweepDirection 	= forward;
+			v3 up 				= get_up(*motor.transform);
+			v3 position 		= motor.transform->position;
+
+			f32 skinwidth 		= 0.01f;
+			f32 sweepLength 	= elapsedTime * speed;
+
+			// Note(Leo): Bottom is at same height as ray fan, things lower than that are stepped over
+			v3 capsuleStart 	= position + up * (0.25f + motor.collisionRadius);
+			v3 capsuleEnd 		= position + up * f32_max(1.0f, 0.25f + motor.collisionRadius);
+
+			RaycastResult sweepResult;
+			if (capsule_sweep_3d(&collisionSystem, capsuleStart, capsuleEnd, motor.collisionRadius, sweepDirection, sweepLength + skinwidth, &sweepResult, CollisionLayer_colliders))
+			{
+				// Note(Leo): Move until skinwidth away from contact, and slide rest of the way along contact plane
+				f32 freeLength 		= f32_max(0, sweepResult.distance - skinwidth);
+				v3 slide 			= sweepDirection * (sweepLength - freeLength);
+				slide 				-= sweepResult.hitNormal * f32_min(0, v3_dot(slide, sweepResult.hitNormal));
+
+				motor.transform->position += sweepDirection * freeLength + slide;
+
+				FS_DEBUG(debugLevel, debug_draw_vector(sweepResult.hitPosition, sweepResult.hitNormal, colour_bright_yellow));
+
+				/* Note(Leo): Climb ray is like fan's ray that would have hit: it starts on front half of
+				character's circle at contact's side, and at climbing height. */
+				v3 lateral 			= sweepResult.hitPosition - position;
+				lateral 			-= sweepDirection * v3_dot(lateral, sweepDirection) + up * v3_dot(lateral, up);
+				f32 lateralLength 	= f32_min(v3_length(lateral), motor.collisionRadius);
+				if (lateralLength > 0)
+				{
+					lateral = v3_normalize(lateral) * lateralLength;
+				}
+
+				f32 frontDistance 	= f32_sqr_root(square_f32(motor.collisionRadius) - square_f32(lateralLength));
+				v3 climbRayStart 	= position + lateral + sweepDirection * (frontDistance - skinwidth) + up * 1.0f;
+				f32 climbRayLength 	= 0.5f + skinwidth;
+
+				FS_DEBUG_ALWAYS(debug_draw_line(climbRayStart, climbRayStart + sweepDirection, colour_bright_blue));
+
+				if (raycast_3d(&collisionSystem, climbRayStart, sweepDirection, climbRayLength, nullptr, CollisionLayer_colliders))
+				{
+					motor.movementMode 			= CharacterMovementMode_climbing;
+					motor.climbingSurfaceNormal = sweepResult.hitNormal;
+				}
+			}
+			else
+			{
+				motor.transform->position += sweepDirection * sweepLength;
+			}
+		}
+		else if (speed > 0)
 		{
 			v3 rayDirection = forward;
 
@@ -266,23 +323,30 @@ update_character_motor( CharacterMotor & 	motor,
 
 			f32 rayLength = elapsedTime * speed + skinwidth;
 
+			RayPacket rayPacket = {};
+			for (int i  = 0; i < rayCount; ++i)
+			{
+				v3 rayStart = rayStartPositions[i] + up * 0.25f + motor.transform->position;
+				ray_packet_add(rayPacket, rayStart, rayDirection, rayLength);
+			}
+
+			RaycastResult packetResults[rayCount];
+			u32 packetHits = raycast_3d_batch(&collisionSystem, rayPacket, packetResults, CollisionLayer_colliders);
+
 			RaycastResult rayHitResults[rayCount];
 			s32 rayHitCount = 0;
 
 			for (int i  = 0; i < rayCount; ++i)
 			{
-				v3 rayStart = rayStartPositions[i] + up * 0.25f + motor.transform->position;
-
-				RaycastResult currentResult;
-				bool32 hit = raycast_3d(&collisionSystem, rayStart, rayDirection, rayLength, &currentResult);
+				v3 rayStart = ray_packet_get_ray(rayPacket, i).start;
 
-				if (hit)
+				if (packetHits & (1 << i))
 				{
-					rayHitResults[rayHitCount] = currentResult;
+					rayHitResults[rayHitCount] = packetResults[i];
 					++rayHitCount;
 
 					FS_DEBUG(debugLevel, debug_draw_line(rayStart, rayStart + rayDirection, colour_bright_red));
-					FS_DEBUG(debugLevel, debug_draw_vector(currentResult.hitPosition, currentResult.hitNormal, colour_bright_yellow));
+					FS_DEBUG(debugLevel, debug_draw_vector(packetResults[i].hitPosition, packetResults[i].hitNormal, colour_bright_yellow));
 				}
 				else
 				{
@@ -298,6 +362,20 @@ update_character_motor( CharacterMotor & 	motor,
 			{
 				v3 movement = rayDirection * rayLength;
 
+				// Note(Leo): Climb rays do not depend on each other, so cast them all at once
+				RayPacket climbRayPacket = {};
+				for (s32 i = 0; i < rayHitCount; ++i)
+				{
+					v3 climbRayStart 		= rayStartPositions[i] + 1.0f * up + motor.transform->position;
+					v3 climbRayDirection 	= rayDirection;
+					// climbRayStart 			+= -rayDirection * skinwidth;
+					f32 climbRayLength 		= 0.5 + skinwidth;
+
+					ray_packet_add(climbRayPacket, climbRayStart, climbRayDirection, climbRayLength);
+				}
+
+				u32 climbRayHits = raycast_3d_batch(&collisionSystem, climbRayPacket, nullptr, CollisionLayer_colliders);
+
 				// Todo(Leo): only check the most shortening ray result.
 				for (s32 i = 0; i < rayHitCount; ++i)
 				{
@@ -310,10 +388,7 @@ update_character_motor( CharacterMotor & 	motor,
 					// f32 steepAngleLimit = f32_cos(to_radians(30));
 					// f32 dot 			= v3_dot(rayHitResults[i].hitNormal, -forward);
 
-					v3 climbRayStart 		= rayStartPositions[i] + 1.0f * up + motor.transform->position;
-					v3 climbRayDirection 	= rayDirection;
-					// climbRayStart 			+= -rayDirection * skinwidth;
-					f32 climbRayLength 		= 0.5 + skinwidth;
+					Ray climbRay = ray_packet_get_ray(climbRayPacket, i);
 
 
 					f32 angleThreshold 	= 30;
@@ -323,10 +398,9 @@ update_character_motor( CharacterMotor & 	motor,
 					// if (angle < angleThreshold)
 					{
 
-						FS_DEBUG_ALWAYS(debug_draw_line(climbRayStart, climbRayStart + climbRayDirection, colour_bright_blue));
+						FS_DEBUG_ALWAYS(debug_draw_line(climbRay.start, climbRay.start + climbRay.direction, colour_bright_blue));
 	
-						RaycastResult climbRayResult;
-						if (raycast_3d(&collisionSystem, climbRayStart, climbRayDirection, climbRayLength, &climbRayResult))
+						if (climbRayHits & (1 << i))
 						{
 							motor.movementMode 			= CharacterMovementMode_climbing;
 							motor.climbingSurfaceNormal = rayHitResults[i].hitNormal;
@@ -334,7 +408,7 @@ update_character_motor( CharacterMotor & 	motor,
 					}
 					// else
 					// {
-					// 	FS_DEBUG_ALWAYS(debug_draw_line(climbRayStart, climbRayStart + climbRayDirection, colour_bright_red));
+					// 	FS_DEBUG_ALWAYS(debug_draw_line(climbRay.start, climbRay.start + climbRay.direction, colour_bright_red));
 					// }
 				}
 
@@ -381,12 +455,23 @@ update_character_motor( CharacterMotor & 	motor,
 											colour_bright_green));
 	
 
-		RaycastResult rayResult;
-		if (raycast_3d(&collisionSystem, rayStart, rayDirection, rayLength, &rayResult))
+		/* Note(Leo): Secondary ray is only needed if surface ray misses, but it is cheaper to cast
+		both at once than one after another */
+		RayPacket rayPacket = {};
+		s32 surfaceRayIndex 	= ray_packet_add(rayPacket, rayStart, rayDirection, rayLength);
+		s32 secondaryRayIndex 	= ray_packet_add(	rayPacket,
+													verticalSecondaryRayStart - verticalSecondaryRayDirection * skinwidth,
+													verticalSecondaryRayDirection,
+													secondaryRayLength + skinwidth);
+
+		RaycastResult rayResults[2];
+		u32 rayHits = raycast_3d_batch(&collisionSystem, rayPacket, rayResults, CollisionLayer_colliders);
+
+		if (rayHits & (1 << surfaceRayIndex))
 		{
 			// Note(Leo): All good, keep on climbing
 			// Todo(Leo): Check if this is actually climbable
-			motor.climbingSurfaceNormal = rayResult.hitNormal;
+			motor.climbingSurfaceNormal = rayResults[surfaceRayIndex].hitNormal;
 
 			FS_DEBUG_ALWAYS(debug_draw_line(rayStart, rayStart + rayDirection, colour_bright_red));
 		}
@@ -400,7 +485,7 @@ update_character_motor( CharacterMotor & 	motor,
 			verticalSecondaryRayStart 	-= verticalSecondaryRayDirection * skinwidth;
 			secondaryRayLength 			+= skinwidth;
 
-			if (raycast_3d(&collisionSystem, verticalSecondaryRayStart, verticalSecondaryRayDirection, secondaryRayLength, &rayResult))
+			if (rayHits & (1 << secondaryRayIndex))
 			{
 				// Note(Leo): Jump over the edge
 				motor.movementMode 	= CharacterMovementMode_walking;
@@ -467,8 +552,9 @@ update_character_motor( CharacterMotor & 	motor,
 		v3 groundRayStart 		= motor.transform->position - groundRayDirection * groundRaySkinWidth;
 		f32 groundRayLength 	= groundRaySkinWidth + f32_max(0.1f, abs_f32(motor.zSpeed));
 
+		// Note(Leo): Terrain is already in groundHeight, and character motor rays only test colliders
 		RaycastResult rayResult;
-		if (raycast_3d(&collisionSystem, groundRayStart, groundRayDirection, groundRayLength, &rayResult))
+		if (raycast_3d(&collisionSystem, groundRayStart, groundRayDirection, groundRayLength, &rayResult, CollisionLayer_colliders))
 		{
 			float angle = v3_unsigned_angle(v3_up, rayResult.hitNormal);
 			if (angle < 0.25f * π)
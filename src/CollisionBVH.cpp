@@ -0,0 +1,489 @@
+/*
+Leo Tamminen
+
+Bounding volume hierarchy for static colliders in CollisionSystem3D. Tree is built top down
+with binned surface area heuristic, and stored depth first in a flat array, so that left child
+is always the next node after its parent and only right child's index is stored.
+
+Rays visit nearer child first and skip nodes that start further than closest hit so far.
+
+Reference:
+	Wald: On fast Construction of SAH-based Bounding Volume Hierarchies (2007)
+	Ericson: Real-Time Collision Detection, chapter 6 (2005)
+*/
+
+struct AABB3D
+{
+	v3 min;
+	v3 max;
+};
+
+internal AABB3D aabb_3d_empty()
+{
+	AABB3D result = {{highest_f32, highest_f32, highest_f32}, {lowest_f32, lowest_f32, lowest_f32}};
+	return result;
+}
+
+internal AABB3D aabb_3d_grow(AABB3D aabb, v3 point)
+{
+	aabb.min = {f32_min(aabb.min.x, point.x), f32_min(aabb.min.y, point.y), f32_min(aabb.min.z, point.z)};
+	aabb.max = {f32_max(aabb.max.x, point.x), f32_max(aabb.max.y, point.y), f32_max(aabb.max.z, point.z)};
+	return aabb;
+}
+
+// Note(Leo): Component wise, so that union with empty box is the other box. Growing by corners would make it infinite.
+internal AABB3D aabb_3d_union(AABB3D a, AABB3D b)
+{
+	a.min = {f32_min(a.min.x, b.min.x), f32_min(a.min.y, b.min.y), f32_min(a.min.z, b.min.z)};
+	a.max = {f32_max(a.max.x, b.max.x), f32_max(a.max.y, b.max.y), f32_max(a.max.z, b.max.z)};
+	return a;
+}
+
+internal f32 aabb_3d_surface_area(AABB3D aabb)
+{
+	v3 size = aabb.max - aabb.min;
+	f32 result = 2 * (size.x * size.y + size.y * size.z + size.z * size.x);
+	return result;
+}
+
+internal v3 aabb_3d_center(AABB3D aabb)
+{
+	return (aabb.min + aabb.max) * 0.5f;
+}
+
+internal bool32 aabb_3d_overlaps(AABB3D const & a, AABB3D const & b)
+{
+	bool32 result 	= a.min.x <= b.max.x && b.min.x <= a.max.x
+					&& a.min.y <= b.max.y && b.min.y <= a.max.y
+					&& a.min.z <= b.max.z && b.min.z <= a.max.z;
+	return result;
+}
+
+// Note(Leo): 0 is x, 1 is y and 2 is z
+internal f32 v3_component(v3 v, s32 axis)
+{
+	return (&v.x)[axis];
+}
+
+/*
+Note(Leo): Returns distance along ray where it enters box, or highest_f32 if it misses or enters
+further than 'maxDistance'. Ray that starts inside box enters at 0. 'inverseDirection' can have
+infinities from zero direction components, these work out with min and max.
+*/
+internal f32 ray_aabb_3d_distance(v3 rayStart, v3 inverseDirection, f32 maxDistance, AABB3D const & aabb)
+{
+	f32 x0 = (aabb.min.x - rayStart.x) * inverseDirection.x;
+	f32 x1 = (aabb.max.x - rayStart.x) * inverseDirection.x;
+	f32 y0 = (aabb.min.y - rayStart.y) * inverseDirection.y;
+	f32 y1 = (aabb.max.y - rayStart.y) * inverseDirection.y;
+	f32 z0 = (aabb.min.z - rayStart.z) * inverseDirection.z;
+	f32 z1 = (aabb.max.z - rayStart.z) * inverseDirection.z;
+
+	f32 enter 	= f32_max(f32_max(f32_min(x0, x1), f32_min(y0, y1)), f32_max(f32_min(z0, z1), 0));
+	f32 exit 	= f32_min(f32_min(f32_max(x0, x1), f32_max(y0, y1)), f32_min(f32_max(z0, z1), maxDistance));
+
+	return enter <= exit ? enter : highest_f32;
+}
+
+/// ---------- STATIC COLLIDER BVH -------------
+
+enum StaticColliderType : s32
+{
+	StaticColliderType_box,
+	StaticColliderType_triangle,
+};
+
+struct StaticColliderReference
+{
+	StaticColliderType 	type;
+	s32 				index;
+};
+
+// Note(Leo): 32 bytes, two nodes per cache line
+struct CollisionBVHNode
+{
+	v3 	min;
+	s32 index; 	// Note(Leo): Leaf: first reference, inner node: right child. Left child is next node.
+	v3 	max;
+	s32 count; 	// Note(Leo): Leaf: reference count, inner node: 0
+};
+
+struct CollisionBVH
+{
+	Array<CollisionBVHNode> 		nodes;
+	Array<StaticColliderReference> 	references;
+
+	// Note(Leo): Colliders pushed after building are not in tree, these tell where those start
+	s32 boxCount;
+	s32 triangleCount;
+};
+
+constexpr s32 collision_bvh_bin_count 		= 12;
+constexpr s32 collision_bvh_max_leaf_size 	= 8;
+constexpr s32 collision_bvh_max_depth 		= 64;
+
+// Note(Leo): Relative to cost of one collider test, which is 1
+constexpr f32 collision_bvh_traversal_cost 	= 1.0f;
+
+struct CollisionBVHBuildContext
+{
+	CollisionBVH & 				bvh;
+	StaticColliderReference * 	references;
+	AABB3D * 					bounds;
+	v3 * 						centers;
+};
+
+internal void collision_bvh_swap(CollisionBVHBuildContext & context, s32 a, s32 b)
+{
+	memory_swap(context.references[a], context.references[b]);
+	memory_swap(context.bounds[a], context.bounds[b]);
+	memory_swap(context.centers[a], context.centers[b]);
+}
+
+internal void collision_bvh_build_node(CollisionBVHBuildContext & context, s32 first, s32 count, s32 depth)
+{
+	s32 nodeIndex = context.bvh.nodes.count;
+	context.bvh.nodes.push({});
+
+	AABB3D nodeBounds 	= aabb_3d_empty();
+	AABB3D centerBounds = aabb_3d_empty();
+	for (s32 i = first; i < first + count; ++i)
+	{
+		nodeBounds 		= aabb_3d_union(nodeBounds, context.bounds[i]);
+		centerBounds 	= aabb_3d_grow(centerBounds, context.centers[i]);
+	}
+
+	context.bvh.nodes[nodeIndex].min 	= nodeBounds.min;
+	context.bvh.nodes[nodeIndex].max 	= nodeBounds.max;
+
+	auto make_leaf = [&]()
+	{
+		context.bvh.nodes[nodeIndex].index 	= first;
+		context.bvh.nodes[nodeIndex].count 	= count;
+	};
+
+	// Note(Leo): Traversal stack has room for this many levels
+	if (count == 1 || depth >= collision_bvh_max_depth - 1)
+	{
+		make_leaf();
+		return;
+	}
+
+	/// FIND BEST SPLIT
+	struct Bin
+	{
+		AABB3D 	bounds;
+		s32 	count;
+	};
+
+	f32 bestCost 	= highest_f32;
+	s32 bestAxis 	= -1;
+	s32 bestSplit 	= 0;
+
+	for (s32 axis = 0; axis < 3; ++axis)
+	{
+		f32 axisMin 	= v3_component(centerBounds.min, axis);
+		f32 axisExtent 	= v3_component(centerBounds.max, axis) - axisMin;
+
+		if (axisExtent <= 0)
+		{
+			continue;
+		}
+
+		Bin bins [collision_bvh_bin_count];
+		for (auto & bin : bins)
+		{
+			bin = {aabb_3d_empty(), 0};
+		}
+
+		f32 binScale = collision_bvh_bin_count / axisExtent;
+		for (s32 i = first; i < first + count; ++i)
+		{
+			s32 binIndex 		= s32_min((s32)((v3_component(context.centers[i], axis) - axisMin) * binScale), collision_bvh_bin_count - 1);
+			bins[binIndex].bounds = aabb_3d_union(bins[binIndex].bounds, context.bounds[i]);
+			bins[binIndex].count += 1;
+		}
+
+		// Note(Leo): Sweep from right to get cost of everything right of each split, then from left to complete
+		f32 rightCosts [collision_bvh_bin_count];
+		{
+			AABB3D rightBounds 	= aabb_3d_empty();
+			s32 rightCount 		= 0;
+			for (s32 split = collision_bvh_bin_count - 1; split > 0; --split)
+			{
+				rightBounds 		= aabb_3d_union(rightBounds, bins[split].bounds);
+				rightCount 			+= bins[split].count;
+				rightCosts[split] 	= rightCount > 0 ? aabb_3d_surface_area(rightBounds) * rightCount : 0;
+			}
+		}
+
+		AABB3D leftBounds 	= aabb_3d_empty();
+		s32 leftCount 		= 0;
+		for (s32 split = 1; split < collision_bvh_bin_count; ++split)
+		{
+			leftBounds 	= aabb_3d_union(leftBounds, bins[split - 1].bounds);
+			leftCount 	+= bins[split - 1].count;
+
+			if (leftCount == 0 || leftCount == count)
+			{
+				continue;
+			}
+
+			f32 cost = aabb_3d_surface_area(leftBounds) * leftCount + rightCosts[split];
+			if (cost < bestCost)
+			{
+				bestCost 	= cost;
+				bestAxis 	= axis;
+				bestSplit 	= split;
+			}
+		}
+	}
+
+	f32 nodeArea 	= aabb_3d_surface_area(nodeBounds);
+	f32 leafCost 	= (f32)count;
+	f32 splitCost 	= nodeArea > 0 ? collision_bvh_traversal_cost + bestCost / nodeArea : highest_f32;
+
+	// Note(Leo): If all centers are in same point, we cannot split by bins, so split in the middle
+	s32 leftCount = 0;
+	if (bestAxis < 0)
+	{
+		if (count <= collision_bvh_max_leaf_size)
+		{
+			make_leaf();
+			return;
+		}
+
+		leftCount = count / 2;
+	}
+	else
+	{
+		if (splitCost >= leafCost && count <= collision_bvh_max_leaf_size)
+		{
+			make_leaf();
+			return;
+		}
+
+		f32 axisMin 	= v3_component(centerBounds.min, bestAxis);
+		f32 binScale 	= collision_bvh_bin_count / (v3_component(centerBounds.max, bestAxis) - axisMin);
+
+		s32 left 	= first;
+		s32 right 	= first + count - 1;
+		while (left <= right)
+		{
+			s32 binIndex = s32_min((s32)((v3_component(context.centers[left], bestAxis) - axisMin) * binScale), collision_bvh_bin_count - 1);
+			if (binIndex < bestSplit)
+			{
+				left += 1;
+			}
+			else
+			{
+				collision_bvh_swap(context, left, right);
+				right -= 1;
+			}
+		}
+
+		leftCount = left - first;
+	}
+
+	collision_bvh_build_node(context, first, leftCount, depth + 1);
+	context.bvh.nodes[nodeIndex].index = context.bvh.nodes.count;
+	collision_bvh_build_node(context, first + leftCount, count - leftCount, depth + 1);
+}
+
+/*
+Note(Leo): Builds tree of all current boxes and triangles. Nodes and references are allocated
+from 'allocator', and temporary bounds from transient memory. Building again allocates again,
+this is meant to be done once, after level's static colliders are all pushed.
+*/
+internal CollisionBVH make_collision_bvh(	MemoryArena & allocator,
+											Array<PrecomputedBoxCollider> const & boxes,
+											Array<TriangleCollider> const & triangles)
+{
+	CollisionBVH bvh 	= {};
+	bvh.boxCount 		= boxes.count;
+	bvh.triangleCount 	= triangles.count;
+
+	s32 count = bvh.boxCount + bvh.triangleCount;
+	if (count == 0)
+	{
+		return bvh;
+	}
+
+	bvh.references 	= push_array<StaticColliderReference>(allocator, count, ALLOC_GARBAGE);
+	bvh.nodes 		= push_array<CollisionBVHNode>(allocator, 2 * count - 1, ALLOC_GARBAGE);
+
+	AABB3D * bounds = push_memory<AABB3D>(*global_transientMemory, count, ALLOC_GARBAGE);
+	v3 * centers 	= push_memory<v3>(*global_transientMemory, count, ALLOC_GARBAGE);
+
+	for (s32 i = 0; i < bvh.boxCount; ++i)
+	{
+		// Note(Leo): Box is unit cube transformed, so its corners are at +-1
+		AABB3D aabb = aabb_3d_empty();
+		for (s32 corner = 0; corner < 8; ++corner)
+		{
+			v3 unitCorner = {corner & 1 ? 1.0f : -1.0f, corner & 2 ? 1.0f : -1.0f, corner & 4 ? 1.0f : -1.0f};
+			aabb = aabb_3d_grow(aabb, multiply_point(boxes.memory[i].transform, unitCorner));
+		}
+
+		bvh.references.push({StaticColliderType_box, i});
+		bounds[i] 	= aabb;
+		centers[i] 	= aabb_3d_center(aabb);
+	}
+
+	for (s32 i = 0; i < bvh.triangleCount; ++i)
+	{
+		AABB3D aabb = aabb_3d_empty();
+		aabb 		= aabb_3d_grow(aabb, triangles.memory[i].vertices[0]);
+		aabb 		= aabb_3d_grow(aabb, triangles.memory[i].vertices[1]);
+		aabb 		= aabb_3d_grow(aabb, triangles.memory[i].vertices[2]);
+
+		s32 referenceIndex = bvh.references.count;
+		bvh.references.push({StaticColliderType_triangle, i});
+		bounds[referenceIndex] 	= aabb;
+		centers[referenceIndex] = aabb_3d_center(aabb);
+	}
+
+	CollisionBVHBuildContext context = {bvh, bvh.references.memory, bounds, centers};
+	collision_bvh_build_node(context, 0, count, 0);
+
+	return bvh;
+}
+
+/*
+Note(Leo): Finds closest collider that ray hits before 'maxDistance', and returns distance to it,
+or highest_f32 if nothing was hit. Colliders are tested with 'test_reference', which is called as
+test_reference(StaticColliderReference, f32 closestDistance) and must return distance to hit if
+it is closer than 'closestDistance', and highest_f32 otherwise. It should also store whatever
+caller wants to know about hit, since later calls only happen for closer hits.
+*/
+template<typename TTestFunc>
+internal f32 ray_collision_bvh(CollisionBVH const & bvh, v3 rayStart, v3 rayDirection, f32 maxDistance, TTestFunc test_reference)
+{
+	if (bvh.nodes.count == 0)
+	{
+		return highest_f32;
+	}
+
+	v3 inverseDirection = {1.0f / rayDirection.x, 1.0f / rayDirection.y, 1.0f / rayDirection.z};
+	f32 closestDistance = maxDistance;
+	f32 hitDistance 	= highest_f32;
+
+	// Note(Leo): Far children are stored with their entry distance, so they can be skipped if a closer hit was found meanwhile
+	struct StackEntry
+	{
+		s32 nodeIndex;
+		f32 distance;
+	};
+
+	StackEntry stack [collision_bvh_max_depth];
+	s32 stackCount = 0;
+
+	CollisionBVHNode const * nodes = bvh.nodes.memory;
+
+	if (ray_aabb_3d_distance(rayStart, inverseDirection, closestDistance, {nodes[0].min, nodes[0].max}) == highest_f32)
+	{
+		return highest_f32;
+	}
+
+	s32 nodeIndex = 0;
+	while(true)
+	{
+		CollisionBVHNode const & node = nodes[nodeIndex];
+
+		if (node.count > 0)
+		{
+			for (s32 i = node.index; i < node.index + node.count; ++i)
+			{
+				f32 distance = test_reference(bvh.references.memory[i], closestDistance);
+				if (distance < closestDistance)
+				{
+					closestDistance = distance;
+					hitDistance 	= distance;
+				}
+			}
+		}
+		else
+		{
+			s32 nearIndex 	= nodeIndex + 1;
+			s32 farIndex 	= node.index;
+
+			f32 nearDistance 	= ray_aabb_3d_distance(rayStart, inverseDirection, closestDistance, {nodes[nearIndex].min, nodes[nearIndex].max});
+			f32 farDistance 	= ray_aabb_3d_distance(rayStart, inverseDirection, closestDistance, {nodes[farIndex].min, nodes[farIndex].max});
+
+			if (farDistance < nearDistance)
+			{
+				memory_swap(nearIndex, farIndex);
+				memory_swap(nearDistance, farDistance);
+			}
+
+			if (nearDistance != highest_f32)
+			{
+				if (farDistance != highest_f32)
+				{
+					stack[stackCount++] = {farIndex, farDistance};
+				}
+
+				nodeIndex = nearIndex;
+				continue;
+			}
+		}
+
+		// Note(Leo): Pop next node that still starts before closest hit
+		bool32 foundNode = false;
+		while (stackCount > 0 && foundNode == false)
+		{
+			stackCount -= 1;
+			nodeIndex 	= stack[stackCount].nodeIndex;
+			foundNode 	= stack[stackCount].distance < closestDistance;
+		}
+
+		if (foundNode == false)
+		{
+			break;
+		}
+	}
+
+	return hitDistance;
+}
+
+// Note(Leo): Calls 'func(StaticColliderReference)' for each collider whose bounds overlap 'aabb'
+template<typename TFunc>
+internal void collision_bvh_query_aabb(CollisionBVH const & bvh, AABB3D aabb, TFunc func)
+{
+	if (bvh.nodes.count == 0)
+	{
+		return;
+	}
+
+	s32 stack [collision_bvh_max_depth];
+	s32 stackCount = 0;
+
+	CollisionBVHNode const * nodes = bvh.nodes.memory;
+
+	stack[stackCount++] = 0;
+
+	while (stackCount > 0)
+	{
+		s32 nodeIndex 					= stack[--stackCount];
+		CollisionBVHNode const & node 	= nodes[nodeIndex];
+
+		if (aabb_3d_overlaps({node.min, node.max}, aabb) == false)
+		{
+			continue;
+		}
+
+		if (node.count > 0)
+		{
+			for (s32 i = node.index; i < node.index + node.count; ++i)
+			{
+				func(bvh.references.memory[i]);
+			}
+		}
+		else
+		{
+			Assert(stackCount + 2 <= collision_bvh_max_depth);
+			stack[stackCount++] = node.index;
+			stack[stackCount++] = nodeIndex + 1;
+		}
+	}
+}
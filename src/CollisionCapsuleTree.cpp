@@ -0,0 +1,215 @@
+/*
+Leo Tamminen
+
+Colliders made of many capsules that change a little at a time, like growing trees' branches.
+Capsules are in collider's local space, and they are in a dynamic AABB tree, whose root box is
+collider's bounding box, so whole collider is rejected with one box test.
+
+Capsules are not reinserted when they change. Their leaves' fat boxes are grown to fit and boxes
+above are refit only up to first one that already contains them, see dynamic_aabb_tree_refit_proxy.
+Growing capsules move only a little at a time, so most changes do not touch tree at all.
+
+Memory is from MemoryPool, so that collider can grow with the thing it belongs to.
+*/
+
+struct CapsuleCollider
+{
+	v3 	start;
+	v3 	end;
+	f32 radius;
+};
+
+struct CapsuleTreeCollider
+{
+	Array<CapsuleCollider> 	capsules;
+
+	// Note(Leo): Each capsule's leaf in tree, and leaf's user data is capsule's index
+	Array<s32> 				proxies;
+	DynamicAABBTree 		tree;
+};
+
+internal AABB3D compute_capsule_collider_aabb(CapsuleCollider const & capsule)
+{
+	AABB3D aabb = aabb_3d_empty();
+	aabb 		= aabb_3d_grow(aabb, capsule.start);
+	aabb 		= aabb_3d_grow(aabb, capsule.end);
+	return aabb_3d_expand(aabb, capsule.radius);
+}
+
+internal bool32 capsule_tree_collider_has_room(CapsuleTreeCollider const & collider, s32 capsuleCount)
+{
+	s32 capacity = collider.capsules.count + capsuleCount;
+	return capacity <= collider.capsules.capacity && capacity <= collider.proxies.capacity && 2 * capacity - 1 <= collider.tree.nodeCapacity;
+}
+
+// Note(Leo): Makes room for this many more capsules. Returns false if pool is out of budget.
+internal bool32 capsule_tree_collider_reserve(MemoryPool & pool, CapsuleTreeCollider & collider, s32 capsuleCount)
+{
+	s32 capacity = collider.capsules.count + capsuleCount;
+
+	return array_reserve(pool, collider.capsules, capacity)
+		&& array_reserve(pool, collider.proxies, capacity)
+		&& dynamic_aabb_tree_reserve(pool, collider.tree, capacity);
+}
+
+internal void capsule_tree_collider_free(MemoryPool & pool, CapsuleTreeCollider & collider)
+{
+	array_free(pool, collider.capsules);
+	array_free(pool, collider.proxies);
+	dynamic_aabb_tree_free(pool, collider.tree);
+}
+
+// Note(Leo): Room must have been reserved before. Returns index of capsule.
+internal s32 capsule_tree_collider_add(CapsuleTreeCollider & collider, CapsuleCollider capsule)
+{
+	Assert(capsule_tree_collider_has_room(collider, 1));
+
+	s32 index = collider.capsules.count;
+	collider.capsules.push(capsule);
+	collider.proxies.push(dynamic_aabb_tree_create_proxy(collider.tree, compute_capsule_collider_aabb(capsule), index));
+
+	return index;
+}
+
+// Note(Leo): Returns true if tree was refit
+internal bool32 capsule_tree_collider_set(CapsuleTreeCollider & collider, s32 index, CapsuleCollider capsule)
+{
+	collider.capsules[index] = capsule;
+	return dynamic_aabb_tree_refit_proxy(collider.tree, collider.proxies[index], compute_capsule_collider_aabb(capsule));
+}
+
+// Note(Leo): Root's box, which is fat, so it is a little bigger than capsules
+internal AABB3D capsule_tree_collider_bounds(CapsuleTreeCollider const & collider)
+{
+	if (collider.tree.root == dynamic_aabb_tree_null)
+	{
+		return aabb_3d_empty();
+	}
+	return collider.tree.nodes[collider.tree.root].aabb;
+}
+
+/*
+Note(Leo): Ray against capsule's cylinder part, and if that misses, against spheres at its ends. Like
+other ray tests, only hits closer than 'maxDistance' are found, and rays that start inside do not hit.
+*/
+internal bool32 ray_capsule_collision(CapsuleCollider const & capsule, v3 rayStart, v3 rayDirection, f32 maxDistance, f32 * outDistance, v3 * outNormal)
+{
+	constexpr f32 epsilon = 0.00001f;
+
+	v3 axis 		= capsule.end - capsule.start;
+	v3 toStart 		= rayStart - capsule.start;
+	f32 radius2 	= capsule.radius * capsule.radius;
+
+	f32 axisLength2 		= v3_dot(axis, axis);
+	f32 axisDotDirection 	= v3_dot(axis, rayDirection);
+	f32 axisDotToStart 		= v3_dot(axis, toStart);
+
+	// Note(Leo): Infinite cylinder in quadratic form, everything multiplied by 'axisLength2' to avoid divisions
+	f32 a = axisLength2 - axisDotDirection * axisDotDirection;
+	if (a > epsilon)
+	{
+		f32 b = axisLength2 * v3_dot(toStart, rayDirection) - axisDotToStart * axisDotDirection;
+		f32 c = axisLength2 * v3_dot(toStart, toStart) - axisDotToStart * axisDotToStart - radius2 * axisLength2;
+		f32 h = b * b - a * c;
+
+		if (h < 0)
+		{
+			return false;
+		}
+
+		f32 distance 	= (-b - f32_sqr_root(h)) / a;
+		f32 alongAxis 	= axisDotToStart + distance * axisDotDirection;
+
+		if (alongAxis > 0 && alongAxis < axisLength2)
+		{
+			if (distance > epsilon && distance < maxDistance)
+			{
+				v3 hitPosition 	= rayStart + rayDirection * distance;
+				*outDistance 	= distance;
+				*outNormal 		= (hitPosition - capsule.start - axis * (alongAxis / axisLength2)) / capsule.radius;
+				return true;
+			}
+			return false;
+		}
+	}
+
+	bool32 hit = false;
+
+	auto ray_sphere = [&](v3 center)
+	{
+		v3 toCenter = rayStart - center;
+		f32 b 		= v3_dot(toCenter, rayDirection);
+		f32 c 		= v3_dot(toCenter, toCenter) - radius2;
+		f32 h 		= b * b - c;
+
+		if (h < 0)
+		{
+			return;
+		}
+
+		f32 distance = -b - f32_sqr_root(h);
+		if (distance > epsilon && distance < maxDistance)
+		{
+			maxDistance 	= distance;
+			*outDistance 	= distance;
+			*outNormal 		= (rayStart + rayDirection * distance - center) / capsule.radius;
+			hit 			= true;
+		}
+	};
+
+	ray_sphere(capsule.start);
+	ray_sphere(capsule.end);
+
+	return hit;
+}
+
+/*
+Note(Leo): 'position' is collider's offset in world, and ray is in world space. Index of capsule
+that was hit is written to 'outCapsuleIndex', which can be null.
+*/
+internal bool32 ray_capsule_tree_collision(	CapsuleTreeCollider const & collider,
+											v3 position,
+											v3 rayStart,
+											v3 rayDirection,
+											f32 maxDistance,
+											f32 * outDistance,
+											v3 * outNormal,
+											s32 * outCapsuleIndex = nullptr)
+{
+	v3 localStart 	= rayStart - position;
+	v3 normal;
+
+	f32 distance = dynamic_aabb_tree_raycast(collider.tree, localStart, rayDirection, maxDistance, [&](s32 capsuleIndex, f32 closestDistance) -> f32
+	{
+		f32 capsuleDistance;
+		v3 capsuleNormal;
+
+		if (ray_capsule_collision(collider.capsules.memory[capsuleIndex], localStart, rayDirection, closestDistance, &capsuleDistance, &capsuleNormal))
+		{
+			normal = capsuleNormal;
+			if (outCapsuleIndex != nullptr)
+			{
+				*outCapsuleIndex = capsuleIndex;
+			}
+			return capsuleDistance;
+		}
+		return highest_f32;
+	});
+
+	if (distance == highest_f32)
+	{
+		return false;
+	}
+
+	*outDistance 	= distance;
+	*outNormal 		= normal;
+	return true;
+}
+
+// Note(Leo): Calls 'func(s32 capsuleIndex)' for capsules whose fat box overlaps 'aabb', which is in world space
+template<typename TFunc>
+internal void capsule_tree_collider_query_aabb(CapsuleTreeCollider const & collider, v3 position, AABB3D aabb, TFunc func)
+{
+	AABB3D localAABB = {aabb.min - position, aabb.max - position};
+	dynamic_aabb_tree_query_aabb(collider.tree, localAABB, func);
+}
@@ -0,0 +1,568 @@
+/*
+Leo Tamminen
+
+Dynamic AABB tree for colliders that can move. Each collider has a proxy, which is a leaf with
+fat bounding box that is bigger than the collider, so that collider can move a little without
+tree changing. Proxy is only reinserted when collider leaves its fat box. New leaves are put next
+to sibling that grows surface area least, and tree is kept balanced with AVL tree like rotations.
+
+Reference:
+	Catto: Box2D b2_dynamic_tree.cpp (2009)
+	Catto: Dynamic Bounding Volume Hierarchies, GDC (2019)
+*/
+
+constexpr s32 dynamic_aabb_tree_null = -1;
+
+// Note(Leo): Fat boxes are this much bigger in all directions, and they extend this many frames of displacement to moving direction
+constexpr f32 dynamic_aabb_tree_margin 					= 0.1f;
+constexpr f32 dynamic_aabb_tree_displacement_multiplier = 4.0f;
+
+// Note(Leo): Balanced tree of 2^32 leaves is not this high, so this is plenty
+constexpr s32 dynamic_aabb_tree_max_stack_size = 128;
+
+struct DynamicAABBTreeNode
+{
+	AABB3D 	aabb;
+
+	// Note(Leo): Free nodes use 'parent' as next node in free list
+	s32 	parent;
+	s32 	child1;
+	s32 	child2;
+
+	// Note(Leo): Leaf is 0 and free node is -1
+	s32 	height;
+	s32 	userData;
+};
+
+struct DynamicAABBTree
+{
+	s32 					root 		= dynamic_aabb_tree_null;
+	s32 					freeList 	= dynamic_aabb_tree_null;
+	s32 					nodeCount;
+	s32 					nodeCapacity;
+	DynamicAABBTreeNode * 	nodes;
+};
+
+internal DynamicAABBTree make_dynamic_aabb_tree(MemoryArena & allocator, s32 proxyCapacity)
+{
+	DynamicAABBTree tree 	= {};
+	tree.root 				= dynamic_aabb_tree_null;
+	tree.nodeCapacity 		= s32_max(1, 2 * proxyCapacity - 1);
+	tree.nodes 				= push_memory<DynamicAABBTreeNode>(allocator, tree.nodeCapacity, ALLOC_GARBAGE);
+
+	for (s32 i = 0; i < tree.nodeCapacity; ++i)
+	{
+		tree.nodes[i].parent = i + 1 < tree.nodeCapacity ? i + 1 : dynamic_aabb_tree_null;
+		tree.nodes[i].height = -1;
+	}
+	tree.freeList = 0;
+
+	return tree;
+}
+
+/*
+Note(Leo): For trees whose memory is from MemoryPool, like array_reserve. Grows node capacity so that
+there is room for at least 'proxyCapacity' proxies, and adds new nodes to free list. Returns false
+and leaves tree as it was if pool is out of budget.
+*/
+internal bool32 dynamic_aabb_tree_reserve(MemoryPool & pool, DynamicAABBTree & tree, s32 proxyCapacity)
+{
+	s32 nodeCapacity = 2 * proxyCapacity - 1;
+	if (nodeCapacity <= tree.nodeCapacity)
+	{
+		return true;
+	}
+
+	nodeCapacity 	= s32_max(nodeCapacity, tree.nodeCapacity * 2);
+	u64 blockSize 	= memory_pool_block_size(nodeCapacity * sizeof(DynamicAABBTreeNode));
+	nodeCapacity 	= blockSize / sizeof(DynamicAABBTreeNode);
+
+	DynamicAABBTreeNode * nodes = reinterpret_cast<DynamicAABBTreeNode*>(memory_pool_allocate(pool, blockSize));
+	if (nodes == nullptr)
+	{
+		return false;
+	}
+
+	memory_copy(nodes, tree.nodes, tree.nodeCapacity * sizeof(DynamicAABBTreeNode));
+
+	for (s32 i = tree.nodeCapacity; i < nodeCapacity; ++i)
+	{
+		nodes[i].parent = i + 1 < nodeCapacity ? i + 1 : tree.freeList;
+		nodes[i].height = -1;
+	}
+	tree.freeList = tree.nodeCapacity;
+
+	if (tree.nodes != nullptr)
+	{
+		memory_pool_free(pool, tree.nodes, tree.nodeCapacity * sizeof(DynamicAABBTreeNode));
+	}
+
+	tree.nodes 			= nodes;
+	tree.nodeCapacity 	= nodeCapacity;
+
+	return true;
+}
+
+internal void dynamic_aabb_tree_free(MemoryPool & pool, DynamicAABBTree & tree)
+{
+	if (tree.nodes != nullptr)
+	{
+		memory_pool_free(pool, tree.nodes, tree.nodeCapacity * sizeof(DynamicAABBTreeNode));
+	}
+	tree = {};
+}
+
+internal bool32 aabb_3d_contains(AABB3D const & outer, AABB3D const & inner)
+{
+	bool32 result 	= outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z
+					&& inner.max.x <= outer.max.x && inner.max.y <= outer.max.y && inner.max.z <= outer.max.z;
+	return result;
+}
+
+internal AABB3D aabb_3d_expand(AABB3D aabb, f32 amount)
+{
+	aabb.min = aabb.min - v3{amount, amount, amount};
+	aabb.max = aabb.max + v3{amount, amount, amount};
+	return aabb;
+}
+
+internal bool32 dynamic_aabb_tree_is_leaf(DynamicAABBTree const & tree, s32 index)
+{
+	return tree.nodes[index].child1 == dynamic_aabb_tree_null;
+}
+
+internal s32 dynamic_aabb_tree_allocate_node(DynamicAABBTree & tree)
+{
+	AssertRelease(tree.freeList != dynamic_aabb_tree_null, "Dynamic AABB tree is full");
+
+	s32 index 		= tree.freeList;
+	tree.freeList 	= tree.nodes[index].parent;
+	tree.nodeCount 	+= 1;
+
+	DynamicAABBTreeNode & node 	= tree.nodes[index];
+	node.parent 				= dynamic_aabb_tree_null;
+	node.child1 				= dynamic_aabb_tree_null;
+	node.child2 				= dynamic_aabb_tree_null;
+	node.height 				= 0;
+	node.userData 				= -1;
+
+	return index;
+}
+
+internal void dynamic_aabb_tree_free_node(DynamicAABBTree & tree, s32 index)
+{
+	tree.nodes[index].parent 	= tree.freeList;
+	tree.nodes[index].height 	= -1;
+	tree.freeList 				= index;
+	tree.nodeCount 				-= 1;
+}
+
+internal void dynamic_aabb_tree_replace_child(DynamicAABBTree & tree, s32 parent, s32 oldChild, s32 newChild)
+{
+	if (parent == dynamic_aabb_tree_null)
+	{
+		tree.root = newChild;
+	}
+	else if (tree.nodes[parent].child1 == oldChild)
+	{
+		tree.nodes[parent].child1 = newChild;
+	}
+	else
+	{
+		tree.nodes[parent].child2 = newChild;
+	}
+}
+
+/*
+Note(Leo): If one child of 'iA' is more than one level higher than other, rotate its higher
+grandchild up, and return index of node that is now in iA's place.
+*/
+internal s32 dynamic_aabb_tree_balance(DynamicAABBTree & tree, s32 iA)
+{
+	DynamicAABBTreeNode * nodes = tree.nodes;
+	DynamicAABBTreeNode & A 	= nodes[iA];
+
+	if (dynamic_aabb_tree_is_leaf(tree, iA) || A.height < 2)
+	{
+		return iA;
+	}
+
+	s32 iB = A.child1;
+	s32 iC = A.child2;
+	DynamicAABBTreeNode & B = nodes[iB];
+	DynamicAABBTreeNode & C = nodes[iC];
+
+	s32 balance = C.height - B.height;
+
+	// Note(Leo): Rotate C up
+	if (balance > 1)
+	{
+		s32 iF = C.child1;
+		s32 iG = C.child2;
+		DynamicAABBTreeNode & F = nodes[iF];
+		DynamicAABBTreeNode & G = nodes[iG];
+
+		C.child1 = iA;
+		C.parent = A.parent;
+		A.parent = iC;
+		dynamic_aabb_tree_replace_child(tree, C.parent, iA, iC);
+
+		if (F.height > G.height)
+		{
+			C.child2 = iF;
+			A.child2 = iG;
+			G.parent = iA;
+			A.aabb 	= aabb_3d_union(B.aabb, G.aabb);
+			C.aabb 	= aabb_3d_union(A.aabb, F.aabb);
+			A.height = 1 + s32_max(B.height, G.height);
+			C.height = 1 + s32_max(A.height, F.height);
+		}
+		else
+		{
+			C.child2 = iG;
+			A.child2 = iF;
+			F.parent = iA;
+			A.aabb 	= aabb_3d_union(B.aabb, F.aabb);
+			C.aabb 	= aabb_3d_union(A.aabb, G.aabb);
+			A.height = 1 + s32_max(B.height, F.height);
+			C.height = 1 + s32_max(A.height, G.height);
+		}
+
+		return iC;
+	}
+
+	// Note(Leo): Rotate B up
+	if (balance < -1)
+	{
+		s32 iD = B.child1;
+		s32 iE = B.child2;
+		DynamicAABBTreeNode & D = nodes[iD];
+		DynamicAABBTreeNode & E = nodes[iE];
+
+		B.child1 = iA;
+		B.parent = A.parent;
+		A.parent = iB;
+		dynamic_aabb_tree_replace_child(tree, B.parent, iA, iB);
+
+		if (D.height > E.height)
+		{
+			B.child2 = iD;
+			A.child1 = iE;
+			E.parent = iA;
+			A.aabb 	= aabb_3d_union(C.aabb, E.aabb);
+			B.aabb 	= aabb_3d_union(A.aabb, D.aabb);
+			A.height = 1 + s32_max(C.height, E.height);
+			B.height = 1 + s32_max(A.height, D.height);
+		}
+		else
+		{
+			B.child2 = iE;
+			A.child1 = iD;
+			D.parent = iA;
+			A.aabb 	= aabb_3d_union(C.aabb, D.aabb);
+			B.aabb 	= aabb_3d_union(A.aabb, E.aabb);
+			A.height = 1 + s32_max(C.height, D.height);
+			B.height = 1 + s32_max(A.height, E.height);
+		}
+
+		return iB;
+	}
+
+	return iA;
+}
+
+// Note(Leo): Walk from 'index' to root, balancing and refitting
+internal void dynamic_aabb_tree_refit_to_root(DynamicAABBTree & tree, s32 index)
+{
+	while (index != dynamic_aabb_tree_null)
+	{
+		index = dynamic_aabb_tree_balance(tree, index);
+
+		DynamicAABBTreeNode & node 	= tree.nodes[index];
+		node.height 				= 1 + s32_max(tree.nodes[node.child1].height, tree.nodes[node.child2].height);
+		node.aabb 					= aabb_3d_union(tree.nodes[node.child1].aabb, tree.nodes[node.child2].aabb);
+
+		index = node.parent;
+	}
+}
+
+internal void dynamic_aabb_tree_insert_leaf(DynamicAABBTree & tree, s32 leaf)
+{
+	if (tree.root == dynamic_aabb_tree_null)
+	{
+		tree.root 					= leaf;
+		tree.nodes[leaf].parent 	= dynamic_aabb_tree_null;
+		return;
+	}
+
+	/// FIND BEST SIBLING
+	AABB3D leafAABB = tree.nodes[leaf].aabb;
+	s32 index 		= tree.root;
+
+	while (dynamic_aabb_tree_is_leaf(tree, index) == false)
+	{
+		DynamicAABBTreeNode const & node = tree.nodes[index];
+
+		f32 area 			= aabb_3d_surface_area(node.aabb);
+		f32 combinedArea 	= aabb_3d_surface_area(aabb_3d_union(node.aabb, leafAABB));
+
+		// Note(Leo): Cost of making new parent for this node and leaf, and minimum cost that pushing leaf further down adds to this node
+		f32 cost 			= 2 * combinedArea;
+		f32 inheritanceCost = 2 * (combinedArea - area);
+
+		auto child_cost = [&](s32 child)
+		{
+			AABB3D combined = aabb_3d_union(leafAABB, tree.nodes[child].aabb);
+			if (dynamic_aabb_tree_is_leaf(tree, child))
+			{
+				return aabb_3d_surface_area(combined) + inheritanceCost;
+			}
+			return aabb_3d_surface_area(combined) - aabb_3d_surface_area(tree.nodes[child].aabb) + inheritanceCost;
+		};
+
+		f32 cost1 = child_cost(node.child1);
+		f32 cost2 = child_cost(node.child2);
+
+		if (cost < cost1 && cost < cost2)
+		{
+			break;
+		}
+
+		index = cost1 < cost2 ? node.child1 : node.child2;
+	}
+
+	/// MAKE NEW PARENT FOR SIBLING AND LEAF
+	s32 sibling 	= index;
+	s32 oldParent 	= tree.nodes[sibling].parent;
+	s32 newParent 	= dynamic_aabb_tree_allocate_node(tree);
+
+	tree.nodes[newParent].parent 	= oldParent;
+	tree.nodes[newParent].aabb 		= aabb_3d_union(leafAABB, tree.nodes[sibling].aabb);
+	tree.nodes[newParent].height 	= tree.nodes[sibling].height + 1;
+	tree.nodes[newParent].child1 	= sibling;
+	tree.nodes[newParent].child2 	= leaf;
+
+	dynamic_aabb_tree_replace_child(tree, oldParent, sibling, newParent);
+
+	tree.nodes[sibling].parent 	= newParent;
+	tree.nodes[leaf].parent 	= newParent;
+
+	dynamic_aabb_tree_refit_to_root(tree, oldParent);
+}
+
+internal void dynamic_aabb_tree_remove_leaf(DynamicAABBTree & tree, s32 leaf)
+{
+	if (leaf == tree.root)
+	{
+		tree.root = dynamic_aabb_tree_null;
+		return;
+	}
+
+	s32 parent 		= tree.nodes[leaf].parent;
+	s32 grandParent = tree.nodes[parent].parent;
+	s32 sibling 	= tree.nodes[parent].child1 == leaf ? tree.nodes[parent].child2 : tree.nodes[parent].child1;
+
+	dynamic_aabb_tree_replace_child(tree, grandParent, parent, sibling);
+	tree.nodes[sibling].parent = grandParent;
+	dynamic_aabb_tree_free_node(tree, parent);
+
+	dynamic_aabb_tree_refit_to_root(tree, grandParent);
+}
+
+/// ---------- PROXIES -------------
+
+internal s32 dynamic_aabb_tree_create_proxy(DynamicAABBTree & tree, AABB3D aabb, s32 userData)
+{
+	s32 proxy 					= dynamic_aabb_tree_allocate_node(tree);
+	tree.nodes[proxy].aabb 		= aabb_3d_expand(aabb, dynamic_aabb_tree_margin);
+	tree.nodes[proxy].userData 	= userData;
+
+	dynamic_aabb_tree_insert_leaf(tree, proxy);
+
+	return proxy;
+}
+
+internal void dynamic_aabb_tree_destroy_proxy(DynamicAABBTree & tree, s32 proxy)
+{
+	dynamic_aabb_tree_remove_leaf(tree, proxy);
+	dynamic_aabb_tree_free_node(tree, proxy);
+}
+
+/*
+Note(Leo): 'aabb' is collider's exact box, and 'displacement' is how much it moved since last time.
+Returns true if proxy was reinserted, which only happens when collider is no longer inside its fat
+box, or fat box is much too big, so most of the time this does nothing.
+*/
+internal bool32 dynamic_aabb_tree_move_proxy(DynamicAABBTree & tree, s32 proxy, AABB3D aabb, v3 displacement)
+{
+	AABB3D fatAABB 	= aabb_3d_expand(aabb, dynamic_aabb_tree_margin);
+
+	// Note(Leo): Predict movement, so that steadily moving colliders are not reinserted every frame
+	v3 d = displacement * dynamic_aabb_tree_displacement_multiplier;
+	fatAABB.min = {fatAABB.min.x + f32_min(d.x, 0), fatAABB.min.y + f32_min(d.y, 0), fatAABB.min.z + f32_min(d.z, 0)};
+	fatAABB.max = {fatAABB.max.x + f32_max(d.x, 0), fatAABB.max.y + f32_max(d.y, 0), fatAABB.max.z + f32_max(d.z, 0)};
+
+	AABB3D const & treeAABB = tree.nodes[proxy].aabb;
+	if (aabb_3d_contains(treeAABB, aabb))
+	{
+		// Note(Leo): If collider stopped after moving fast, fat box is big, and it is better to shrink it
+		AABB3D hugeAABB = aabb_3d_expand(fatAABB, 4 * dynamic_aabb_tree_margin);
+		if (aabb_3d_contains(hugeAABB, treeAABB))
+		{
+			return false;
+		}
+	}
+
+	dynamic_aabb_tree_remove_leaf(tree, proxy);
+	tree.nodes[proxy].aabb = fatAABB;
+	dynamic_aabb_tree_insert_leaf(tree, proxy);
+
+	return true;
+}
+
+/*
+Note(Leo): Unlike dynamic_aabb_tree_move_proxy, this never reinserts proxy. If 'aabb' is not inside
+proxy's fat box, box is made to fit it again, and boxes above are refit up to first one that does not
+change. This is for colliders that change only a little at a time and stay near their siblings, so
+tree stays good without restructuring. Returns true if tree changed.
+*/
+internal bool32 dynamic_aabb_tree_refit_proxy(DynamicAABBTree & tree, s32 proxy, AABB3D aabb)
+{
+	if (aabb_3d_contains(tree.nodes[proxy].aabb, aabb))
+	{
+		return false;
+	}
+
+	tree.nodes[proxy].aabb = aabb_3d_expand(aabb, dynamic_aabb_tree_margin);
+
+	for (s32 index = tree.nodes[proxy].parent; index != dynamic_aabb_tree_null; index = tree.nodes[index].parent)
+	{
+		DynamicAABBTreeNode & node 	= tree.nodes[index];
+		AABB3D refit 				= aabb_3d_union(tree.nodes[node.child1].aabb, tree.nodes[node.child2].aabb);
+
+		if (aabb_3d_contains(node.aabb, refit) && aabb_3d_contains(refit, node.aabb))
+		{
+			break;
+		}
+
+		node.aabb = refit;
+	}
+
+	return true;
+}
+
+/// ---------- QUERIES -------------
+
+// Note(Leo): Calls 'func(userData)' for every proxy whose fat box overlaps 'aabb'
+template<typename TFunc>
+internal void dynamic_aabb_tree_query_aabb(DynamicAABBTree const & tree, AABB3D aabb, TFunc func)
+{
+	if (tree.root == dynamic_aabb_tree_null)
+	{
+		return;
+	}
+
+	s32 stack [dynamic_aabb_tree_max_stack_size];
+	s32 stackCount = 0;
+
+	stack[stackCount++] = tree.root;
+
+	while (stackCount > 0)
+	{
+		DynamicAABBTreeNode const & node = tree.nodes[stack[--stackCount]];
+
+		if (aabb_3d_overlaps(node.aabb, aabb) == false)
+		{
+			continue;
+		}
+
+		if (node.child1 == dynamic_aabb_tree_null)
+		{
+			func(node.userData);
+		}
+		else
+		{
+			Assert(stackCount + 2 <= dynamic_aabb_tree_max_stack_size);
+			stack[stackCount++] = node.child1;
+			stack[stackCount++] = node.child2;
+		}
+	}
+}
+
+/*
+Note(Leo): Works like ray_collision_bvh in CollisionBVH.cpp: 'test_proxy' is called as
+test_proxy(s32 userData, f32 closestDistance), and it must return distance to hit if it is closer
+than 'closestDistance', and highest_f32 otherwise. Returns distance to closest hit or highest_f32.
+*/
+template<typename TTestFunc>
+internal f32 dynamic_aabb_tree_raycast(DynamicAABBTree const & tree, v3 rayStart, v3 rayDirection, f32 maxDistance, TTestFunc test_proxy)
+{
+	if (tree.root == dynamic_aabb_tree_null)
+	{
+		return highest_f32;
+	}
+
+	v3 inverseDirection = {1.0f / rayDirection.x, 1.0f / rayDirection.y, 1.0f / rayDirection.z};
+	f32 closestDistance = maxDistance;
+	f32 hitDistance 	= highest_f32;
+
+	struct StackEntry
+	{
+		s32 nodeIndex;
+		f32 distance;
+	};
+
+	StackEntry stack [dynamic_aabb_tree_max_stack_size];
+	s32 stackCount = 0;
+
+	f32 rootDistance = ray_aabb_3d_distance(rayStart, inverseDirection, closestDistance, tree.nodes[tree.root].aabb);
+	if (rootDistance != highest_f32)
+	{
+		stack[stackCount++] = {tree.root, rootDistance};
+	}
+
+	while (stackCount > 0)
+	{
+		StackEntry entry = stack[--stackCount];
+		if (entry.distance >= closestDistance)
+		{
+			continue;
+		}
+
+		DynamicAABBTreeNode const & node = tree.nodes[entry.nodeIndex];
+
+		if (node.child1 == dynamic_aabb_tree_null)
+		{
+			f32 distance = test_proxy(node.userData, closestDistance);
+			if (distance < closestDistance)
+			{
+				closestDistance = distance;
+				hitDistance 	= distance;
+			}
+			continue;
+		}
+
+		f32 distance1 = ray_aabb_3d_distance(rayStart, inverseDirection, closestDistance, tree.nodes[node.child1].aabb);
+		f32 distance2 = ray_aabb_3d_distance(rayStart, inverseDirection, closestDistance, tree.nodes[node.child2].aabb);
+
+		// Note(Leo): Push far child first, so that near one is popped first
+		StackEntry near = {node.child1, distance1};
+		StackEntry far 	= {node.child2, distance2};
+		if (distance2 < distance1)
+		{
+			memory_swap(near, far);
+		}
+
+		Assert(stackCount + 2 <= dynamic_aabb_tree_max_stack_size);
+		if (far.distance != highest_f32)
+		{
+			stack[stackCount++] = far;
+		}
+		if (near.distance != highest_f32)
+		{
+			stack[stackCount++] = near;
+		}
+	}
+
+	return hitDistance;
+}
@@ -0,0 +1,357 @@
+/*
+Leo Tamminen
+
+Raycasts against terrain height map. Height map cells are bilinear patches between four grid
+values, same as get_height_at samples them. Pyramid of minimum and maximum heights is built once,
+so that rays can skip big areas they pass above (or below) at once.
+
+Rays go down the pyramid front to back: each node's children are visited in the order ray
+crosses them, and node is skipped if ray's height range over its part of ray does not overlap
+node's height range. At bottom, cells are intersected exactly, and first hit is closest one.
+
+Reference:
+	Tevs, Ihrke, Seidel: Maximum Mipmaps for Fast, Accurate, and Scalable Dynamic Height Field Rendering (2008)
+*/
+
+constexpr s32 height_map_pyramid_max_levels 	= 16;
+constexpr s32 height_map_pyramid_max_stack_size = 64;
+
+/*
+Note(Leo): Ray's height range is compared to min and max heights with this much slack, so that
+rays that hit flat areas exactly at minimum or maximum height are not culled by rounding errors.
+*/
+constexpr f32 height_map_pyramid_height_tolerance = 0.001f;
+
+struct HeightMapMinMax
+{
+	f32 min;
+	f32 max;
+};
+
+/*
+Note(Leo): Level 0 is height map's cells themselves, and its min and max are computed from cell's
+corners when needed, so it is not stored. Each next level's cell covers 2x2 cells of previous level,
+and top level has only one cell. Cells are in rows, like height map values.
+*/
+struct HeightMapPyramid
+{
+	s32 				levelCount;
+	s32 				cellCounts [height_map_pyramid_max_levels];
+	HeightMapMinMax * 	levels [height_map_pyramid_max_levels];
+};
+
+internal f32 height_map_get_grid_height(HeightMap const & map, s32 x, s32 y)
+{
+	f32 value = map.values[x + y * map.gridSize];
+	return f32_lerp(map.minHeight, map.maxHeight, value);
+}
+
+internal HeightMapMinMax height_map_get_cell_min_max(HeightMap const & map, s32 x, s32 y)
+{
+	f32 h00 = height_map_get_grid_height(map, x, y);
+	f32 h10 = height_map_get_grid_height(map, x + 1, y);
+	f32 h01 = height_map_get_grid_height(map, x, y + 1);
+	f32 h11 = height_map_get_grid_height(map, x + 1, y + 1);
+
+	HeightMapMinMax result =
+	{
+		f32_min(f32_min(h00, h10), f32_min(h01, h11)),
+		f32_max(f32_max(h00, h10), f32_max(h01, h11)),
+	};
+	return result;
+}
+
+internal HeightMapPyramid make_height_map_pyramid(MemoryArena & allocator, HeightMap const & map)
+{
+	HeightMapPyramid pyramid = {};
+
+	if (map.gridSize < 2)
+	{
+		return pyramid;
+	}
+
+	pyramid.levelCount 		= 1;
+	pyramid.cellCounts[0] 	= map.gridSize - 1;
+	pyramid.levels[0] 		= nullptr;
+
+	while (pyramid.cellCounts[pyramid.levelCount - 1] > 1)
+	{
+		AssertRelease(pyramid.levelCount < height_map_pyramid_max_levels, "Height map is too big for pyramid");
+
+		s32 level 			= pyramid.levelCount++;
+		s32 previousCount 	= pyramid.cellCounts[level - 1];
+		s32 count 			= (previousCount + 1) / 2;
+
+		pyramid.cellCounts[level] 	= count;
+		pyramid.levels[level] 		= push_memory<HeightMapMinMax>(allocator, count * count, ALLOC_GARBAGE);
+
+		for (s32 y = 0; y < count; ++y)
+		{
+			for (s32 x = 0; x < count; ++x)
+			{
+				HeightMapMinMax minMax = {highest_f32, lowest_f32};
+
+				for (s32 child = 0; child < 4; ++child)
+				{
+					s32 childX = 2 * x + (child & 1);
+					s32 childY = 2 * y + (child >> 1);
+
+					if (childX >= previousCount || childY >= previousCount)
+					{
+						continue;
+					}
+
+					HeightMapMinMax childMinMax = level == 1
+												? height_map_get_cell_min_max(map, childX, childY)
+												: pyramid.levels[level - 1][childX + childY * previousCount];
+
+					minMax.min = f32_min(minMax.min, childMinMax.min);
+					minMax.max = f32_max(minMax.max, childMinMax.max);
+				}
+
+				pyramid.levels[level][x + y * count] = minMax;
+			}
+		}
+	}
+
+	return pyramid;
+}
+
+/*
+Note(Leo): Exact intersection of ray and one cell's bilinear patch, between distances 'segmentStart'
+and 'segmentEnd' along ray, which is where ray is over this cell. Ray is in grid space here: xy are
+in cells, z and distances are world units.
+
+Patch height is h(u,v) = h00 + a*u + b*v + c*u*v, and u and v are linear along ray, so difference
+between ray's and patch's height is quadratic along ray.
+*/
+internal bool32 ray_height_map_cell_collision(	HeightMap const & map,
+												s32 cellX, s32 cellY,
+												v3 gridRayStart, v3 gridRayDirection,
+												f32 segmentStart, f32 segmentEnd,
+												f32 * outDistance, v3 * outNormal)
+{
+	f32 h00 = height_map_get_grid_height(map, cellX, cellY);
+	f32 h10 = height_map_get_grid_height(map, cellX + 1, cellY);
+	f32 h01 = height_map_get_grid_height(map, cellX, cellY + 1);
+	f32 h11 = height_map_get_grid_height(map, cellX + 1, cellY + 1);
+
+	f32 a = h10 - h00;
+	f32 b = h01 - h00;
+	f32 c = h00 - h10 - h01 + h11;
+
+	// Note(Leo): Measure from segment start, so that numbers stay small even far away on long rays
+	f32 u0 = gridRayStart.x + gridRayDirection.x * segmentStart - cellX;
+	f32 v0 = gridRayStart.y + gridRayDirection.y * segmentStart - cellY;
+	f32 z0 = gridRayStart.z + gridRayDirection.z * segmentStart;
+
+	f32 du = gridRayDirection.x;
+	f32 dv = gridRayDirection.y;
+
+	f32 patchHeight0 = h00 + a * u0 + b * v0 + c * u0 * v0;
+	f32 patchHeight1 = a * du + b * dv + c * (u0 * dv + v0 * du);
+	f32 patchHeight2 = c * du * dv;
+
+	// Note(Leo): Solve A*t^2 + B*t + C = 0, ray height minus patch height
+	f32 A = -patchHeight2;
+	f32 B = gridRayDirection.z - patchHeight1;
+	f32 C = z0 - patchHeight0;
+
+	// Note(Leo): Allow a little slack, so that hits exactly on cell borders do not fall between cells
+	constexpr f32 epsilon = 0.00001f;
+	f32 segmentLength = segmentEnd - segmentStart;
+
+	f32 t = highest_f32;
+
+	auto try_root = [&](f32 root)
+	{
+		if (root >= -epsilon && root <= segmentLength + epsilon && root < t)
+		{
+			t = root;
+		}
+	};
+
+	if (abs_f32(A) < 0.000001f)
+	{
+		if (B != 0)
+		{
+			try_root(-C / B);
+		}
+	}
+	else
+	{
+		f32 D = B * B - 4 * A * C;
+		if (D < 0)
+		{
+			return false;
+		}
+
+		// Note(Leo): Numerically stable form, this avoids subtracting nearly equal numbers
+		f32 q = -0.5f * (B + sign_f32(B) * f32_sqr_root(D));
+		try_root(q / A);
+		if (q != 0)
+		{
+			try_root(C / q);
+		}
+	}
+
+	if (t == highest_f32)
+	{
+		return false;
+	}
+
+	t = f32_max(t, 0);
+
+	f32 u = u0 + du * t;
+	f32 v = v0 + dv * t;
+
+	*outDistance 	= segmentStart + t;
+	*outNormal 		= {-(a + c * v), -(b + c * u), 1};
+
+	return true;
+}
+
+/*
+Note(Leo): 'offset' is world position of height map's grid point 0,0. Returns hit only if it is
+closer than 'maxDistance'. Outside height map, there is no terrain for rays, though get_height_at
+returns 0 there. 'outCellIndex' is index of hit cell, x + y * cell count.
+*/
+internal bool32 ray_height_map_collision(	HeightMap const & map,
+											HeightMapPyramid const & pyramid,
+											v3 offset,
+											Ray ray,
+											f32 maxDistance,
+											f32 * outDistance,
+											v3 * outNormal,
+											s32 * outCellIndex)
+{
+	if (pyramid.levelCount == 0)
+	{
+		return false;
+	}
+
+	f32 gridScale = map.gridSize / map.worldSize;
+
+	// Note(Leo): xy scaled to grid cells, but z and distance along ray are kept in world units
+	v3 gridRayStart 	= {(ray.start.x - offset.x) * gridScale, (ray.start.y - offset.y) * gridScale, ray.start.z};
+	v3 gridRayDirection = {ray.direction.x * gridScale, ray.direction.y * gridScale, ray.direction.z};
+	v3 inverseDirection = {1.0f / gridRayDirection.x, 1.0f / gridRayDirection.y, 1.0f / gridRayDirection.z};
+
+	s32 topLevel 				= pyramid.levelCount - 1;
+	HeightMapMinMax topMinMax 	= topLevel == 0
+								? height_map_get_cell_min_max(map, 0, 0)
+								: pyramid.levels[topLevel][0];
+
+	// Note(Leo): Clip ray to whole height map's box
+	f32 baseCellCount = (f32)pyramid.cellCounts[0];
+	f32 rayStart 	= 0;
+	f32 rayEnd 		= maxDistance;
+	{
+		f32 x0 = (0 - gridRayStart.x) * inverseDirection.x;
+		f32 x1 = (baseCellCount - gridRayStart.x) * inverseDirection.x;
+		f32 y0 = (0 - gridRayStart.y) * inverseDirection.y;
+		f32 y1 = (baseCellCount - gridRayStart.y) * inverseDirection.y;
+		f32 z0 = (topMinMax.min - height_map_pyramid_height_tolerance - gridRayStart.z) * inverseDirection.z;
+		f32 z1 = (topMinMax.max + height_map_pyramid_height_tolerance - gridRayStart.z) * inverseDirection.z;
+
+		rayStart 	= f32_max(f32_max(f32_max(f32_min(x0, x1), f32_min(y0, y1)), f32_min(z0, z1)), rayStart);
+		rayEnd 		= f32_min(f32_min(f32_min(f32_max(x0, x1), f32_max(y0, y1)), f32_max(z0, z1)), rayEnd);
+
+		// Note(Leo): This is also false for NaNs from rays that go along box's sides, which is fine
+		if ((rayStart <= rayEnd) == false)
+		{
+			return false;
+		}
+	}
+
+	struct StackEntry
+	{
+		s32 level;
+		s32 x;
+		s32 y;
+		f32 start;
+		f32 end;
+	};
+
+	StackEntry stack [height_map_pyramid_max_stack_size];
+	s32 stackCount = 0;
+
+	stack[stackCount++] = {topLevel, 0, 0, rayStart, rayEnd};
+
+	while (stackCount > 0)
+	{
+		StackEntry node = stack[--stackCount];
+
+		if (node.level == 0)
+		{
+			f32 distance;
+			v3 normal;
+			if (ray_height_map_cell_collision(map, node.x, node.y, gridRayStart, gridRayDirection, node.start, node.end, &distance, &normal)
+				&& distance > 0.00001f && distance < maxDistance)
+			{
+				*outDistance 	= distance;
+				*outNormal 		= v3_normalize({normal.x * gridScale, normal.y * gridScale, normal.z});
+				*outCellIndex 	= node.x + node.y * pyramid.cellCounts[0];
+				return true;
+			}
+			continue;
+		}
+
+		// Note(Leo): Skip node if ray is above or below it all the way over it
+		{
+			HeightMapMinMax minMax 	= pyramid.levels[node.level][node.x + node.y * pyramid.cellCounts[node.level]];
+			f32 startHeight 		= gridRayStart.z + gridRayDirection.z * node.start;
+			f32 endHeight 			= gridRayStart.z + gridRayDirection.z * node.end;
+
+			if (f32_min(startHeight, endHeight) > minMax.max + height_map_pyramid_height_tolerance
+				|| f32_max(startHeight, endHeight) < minMax.min - height_map_pyramid_height_tolerance)
+			{
+				continue;
+			}
+		}
+
+		/*
+		Note(Leo): Ray crosses node's middle lines at most once each, so it goes through at most
+		three of its children. Find those parts of ray, and push them so that nearest is on top.
+		*/
+		s32 childLevel 		= node.level - 1;
+		s32 childCellCount 	= pyramid.cellCounts[childLevel];
+		f32 childSize 		= (f32)(1 << childLevel);
+
+		f32 middleX = (2 * node.x + 1) * childSize;
+		f32 middleY = (2 * node.y + 1) * childSize;
+
+		f32 crossX = (middleX - gridRayStart.x) * inverseDirection.x;
+		f32 crossY = (middleY - gridRayStart.y) * inverseDirection.y;
+
+		f32 splits [4] = {node.start, f32_min(crossX, crossY), f32_max(crossX, crossY), node.end};
+		splits[1] = f32_min(f32_max(splits[1], node.start), node.end);
+		splits[2] = f32_min(f32_max(splits[2], node.start), node.end);
+
+		for (s32 i = 2; i >= 0; --i)
+		{
+			f32 start 	= splits[i];
+			f32 end 	= splits[i + 1];
+
+			// Note(Leo): This also skips NaN crossings of rays parallel to middle lines
+			if ((start < end) == false)
+			{
+				continue;
+			}
+
+			f32 middle = (start + end) * 0.5f;
+			s32 childX = 2 * node.x + (gridRayStart.x + gridRayDirection.x * middle >= middleX ? 1 : 0);
+			s32 childY = 2 * node.y + (gridRayStart.y + gridRayDirection.y * middle >= middleY ? 1 : 0);
+
+			if (childX >= childCellCount || childY >= childCellCount)
+			{
+				continue;
+			}
+
+			Assert(stackCount < height_map_pyramid_max_stack_size);
+			stack[stackCount++] = {childLevel, childX, childY, start, end};
+		}
+	}
+
+	return false;
+}
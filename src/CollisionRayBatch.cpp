@@ -0,0 +1,615 @@
+/*
+Leo Tamminen
+
+Batched raycasts against CollisionSystem3D. Rays are given in a packet as structure of arrays,
+and they are tested four at a time with SSE against boxes and cylinders, so that each collider
+is loaded once for all rays. Colliders are searched once for whole packet with packet's bounding
+box from the same trees raycast_3d uses, so this suits short rays near each other, like the ones
+character motor uses. Triangles, triangle meshes and capsule trees are tested one ray at a time. Results are same
+as calling raycast_3d for each ray.
+
+SSE2 is always there on x86-64, so this needs no extra compiler flags. AVX would need -mavx, and
+our packets are only a few rays wide anyway.
+*/
+
+#include <immintrin.h>
+
+constexpr s32 ray_packet_lane_count = 4;
+constexpr s32 ray_packet_capacity 	= 16;
+constexpr s32 ray_packet_max_groups = ray_packet_capacity / ray_packet_lane_count;
+
+static_assert(ray_packet_capacity % ray_packet_lane_count == 0, "Ray packet capacity must be multiple of lane count");
+static_assert(ray_packet_capacity <= 32, "Ray packet hits are returned as bits of u32");
+
+struct RayPacket
+{
+	s32 count;
+
+	alignas(16) f32 startX [ray_packet_capacity];
+	alignas(16) f32 startY [ray_packet_capacity];
+	alignas(16) f32 startZ [ray_packet_capacity];
+
+	// Note(Leo): keep these always normalized, like Ray::direction
+	alignas(16) f32 directionX [ray_packet_capacity];
+	alignas(16) f32 directionY [ray_packet_capacity];
+	alignas(16) f32 directionZ [ray_packet_capacity];
+
+	alignas(16) f32 length [ray_packet_capacity];
+};
+
+// Note(Leo): Returns index of ray in packet, which is also its bit in raycast_3d_batch's return value
+internal s32 ray_packet_add(RayPacket & packet, v3 start, v3 normalizedDirection, f32 length)
+{
+	Assert(packet.count < ray_packet_capacity);
+
+	s32 index = packet.count++;
+
+	packet.startX[index] 		= start.x;
+	packet.startY[index] 		= start.y;
+	packet.startZ[index] 		= start.z;
+	packet.directionX[index] 	= normalizedDirection.x;
+	packet.directionY[index] 	= normalizedDirection.y;
+	packet.directionZ[index] 	= normalizedDirection.z;
+	packet.length[index] 		= length;
+
+	return index;
+}
+
+internal Ray ray_packet_get_ray(RayPacket const & packet, s32 index)
+{
+	Ray ray =
+	{
+		.start 		= {packet.startX[index], packet.startY[index], packet.startZ[index]},
+		.direction 	= {packet.directionX[index], packet.directionY[index], packet.directionZ[index]},
+		.length 	= packet.length[index]
+	};
+	return ray;
+}
+
+/// ---------- CANDIDATES -------------
+
+// Note(Leo): Packets with more possible colliders than this are cast one ray at a time
+constexpr s32 ray_packet_max_candidates = 256;
+
+struct RayPacketCandidates
+{
+	s32 boxCount;
+	s32 cylinderCount;
+	s32 triangleCount;
+	s32 triangleMeshCount;
+	s32 capsuleTreeCount;
+	bool32 overflow;
+
+	ColliderReference boxes [ray_packet_max_candidates];
+	ColliderReference cylinders [ray_packet_max_candidates];
+	ColliderReference triangles [ray_packet_max_candidates];
+	ColliderReference triangleMeshes [ray_packet_max_candidates];
+	ColliderReference capsuleTrees [ray_packet_max_candidates];
+};
+
+internal void ray_packet_add_candidate(ColliderReference * candidates, s32 & count, bool32 & overflow, ColliderReference collider)
+{
+	if (count < ray_packet_max_candidates)
+	{
+		candidates[count++] = collider;
+	}
+	else
+	{
+		overflow = true;
+	}
+}
+
+internal void ray_packet_find_candidates(	CollisionSystem3D const & system,
+											AABB3D packetAABB,
+											CollisionLayerFlags layers,
+											RayPacketCandidates & candidates)
+{
+	if (layers & CollisionLayer_submitted)
+	{
+		dynamic_aabb_tree_query_aabb(system.submittedTree, packetAABB, [&](s32 userData)
+		{
+			SubmittedColliderType type 	= collision_system_submitted_type(userData);
+			s32 index 					= collision_system_submitted_index(userData);
+
+			if (type == SubmittedColliderType_box && (layers & CollisionLayer_submitted_box))
+			{
+				ray_packet_add_candidate(candidates.boxes, candidates.boxCount, candidates.overflow, {ColliderType_submitted_box, index});
+			}
+			else if (type == SubmittedColliderType_cylinder && (layers & CollisionLayer_submitted_cylinder))
+			{
+				ray_packet_add_candidate(candidates.cylinders, candidates.cylinderCount, candidates.overflow, {ColliderType_submitted_cylinder, index});
+			}
+			else if (type == SubmittedColliderType_triangle_mesh && (layers & CollisionLayer_submitted_triangle_mesh))
+			{
+				ray_packet_add_candidate(candidates.triangleMeshes, candidates.triangleMeshCount, candidates.overflow, {ColliderType_submitted_triangle_mesh, index});
+			}
+			else if (type == SubmittedColliderType_capsule_tree && (layers & CollisionLayer_submitted_capsule_tree))
+			{
+				ray_packet_add_candidate(candidates.capsuleTrees, candidates.capsuleTreeCount, candidates.overflow, {ColliderType_submitted_capsule_tree, index});
+			}
+		});
+	}
+
+	if (layers & CollisionLayer_static_triangle_mesh)
+	{
+		for (s32 i = 0; i < system.staticTriangleMeshes.count; ++i)
+		{
+			if (aabb_3d_overlaps(system.staticTriangleMeshes.memory[i].aabb, packetAABB))
+			{
+				ray_packet_add_candidate(candidates.triangleMeshes, candidates.triangleMeshCount, candidates.overflow, {ColliderType_static_triangle_mesh, i});
+			}
+		}
+	}
+
+	if (layers & CollisionLayer_static_cylinder)
+	{
+		for (s32 i = 0; i < system.staticCylinderColliders.count; ++i)
+		{
+			ray_packet_add_candidate(candidates.cylinders, candidates.cylinderCount, candidates.overflow, {ColliderType_static_cylinder, i});
+		}
+	}
+
+	bool32 useBoxes 	= (layers & CollisionLayer_static_box) != 0;
+	bool32 useTriangles = (layers & CollisionLayer_triangle) != 0;
+
+	if (useBoxes || useTriangles)
+	{
+		collision_bvh_query_aabb(system.staticBVH, packetAABB, [&](StaticColliderReference reference)
+		{
+			if (reference.type == StaticColliderType_box && useBoxes)
+			{
+				ray_packet_add_candidate(candidates.boxes, candidates.boxCount, candidates.overflow, {ColliderType_static_box, reference.index});
+			}
+			else if (reference.type == StaticColliderType_triangle && useTriangles)
+			{
+				ray_packet_add_candidate(candidates.triangles, candidates.triangleCount, candidates.overflow, {ColliderType_triangle, reference.index});
+			}
+		});
+	}
+
+	// Note(Leo): Same as in ray_static_collisions, these were pushed after building bvh
+	for (s32 i = system.staticBVH.boxCount; useBoxes && i < system.staticBoxColliders.count; ++i)
+	{
+		ray_packet_add_candidate(candidates.boxes, candidates.boxCount, candidates.overflow, {ColliderType_static_box, i});
+	}
+
+	for (s32 i = system.staticBVH.triangleCount; useTriangles && i < system.triangleColliders.count; ++i)
+	{
+		ray_packet_add_candidate(candidates.triangles, candidates.triangleCount, candidates.overflow, {ColliderType_triangle, i});
+	}
+}
+
+internal PrecomputedBoxCollider const & ray_packet_get_box(CollisionSystem3D const & system, ColliderReference collider)
+{
+	if (collider.type == ColliderType_submitted_box)
+	{
+		return system.submittedBoxColliders.memory[collider.index].precomputed;
+	}
+	return system.staticBoxColliders.memory[collider.index];
+}
+
+internal TriangleMeshInstance const & ray_packet_get_triangle_mesh(CollisionSystem3D const & system, ColliderReference collider)
+{
+	if (collider.type == ColliderType_submitted_triangle_mesh)
+	{
+		return system.submittedTriangleMeshColliders.memory[collider.index].instance;
+	}
+	return system.staticTriangleMeshes.memory[collider.index];
+}
+
+internal CylinderCollider const & ray_packet_get_cylinder(CollisionSystem3D const & system, ColliderReference collider)
+{
+	if (collider.type == ColliderType_submitted_cylinder)
+	{
+		return system.submittedCylinderColliders.memory[collider.index].collider;
+	}
+	return system.staticCylinderColliders.memory[collider.index];
+}
+
+/// ---------- SSE TESTS -------------
+
+struct RayPacketLanes
+{
+	__m128 startX [ray_packet_max_groups];
+	__m128 startY [ray_packet_max_groups];
+	__m128 startZ [ray_packet_max_groups];
+
+	__m128 directionX [ray_packet_max_groups];
+	__m128 directionY [ray_packet_max_groups];
+	__m128 directionZ [ray_packet_max_groups];
+
+	// Note(Leo): Distance to closest hit so far, or ray length. Empty lanes are 0 so they never hit.
+	__m128 closestDistance [ray_packet_max_groups];
+
+	s32 groupCount;
+};
+
+/*
+Note(Leo): Same slab test as ray_box_collision, but for four rays. Comparisons are kept in same
+order as there, so that rays that graze edges get same result. Returns mask of lanes that hit
+closer than their closest distance so exitDistance and their distances in 'outDistance'.
+*/
+internal __m128 ray_box_collision_4(PrecomputedBoxCollider const & collider, RayPacketLanes const & lanes, s32 group, __m128 * outDistance)
+{
+	m44 const & m = collider.inverseTransform;
+
+	__m128 const sx = lanes.startX[group];
+	__m128 const sy = lanes.startY[group];
+	__m128 const sz = lanes.startZ[group];
+	__m128 const dx = lanes.directionX[group];
+	__m128 const dy = lanes.directionY[group];
+	__m128 const dz = lanes.directionZ[group];
+
+	// Note(Leo): Box transforms are affine, so we skip w division that multiply_point does
+	auto transform_point = [&](f32 x, f32 y, f32 z, f32 w)
+	{
+		__m128 result = _mm_mul_ps(_mm_set1_ps(x), sx);
+		result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(y), sy));
+		result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(z), sz));
+		result = _mm_add_ps(result, _mm_set1_ps(w));
+		return result;
+	};
+
+	auto transform_direction = [&](f32 x, f32 y, f32 z)
+	{
+		__m128 result = _mm_mul_ps(_mm_set1_ps(x), dx);
+		result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(y), dy));
+		result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(z), dz));
+		return result;
+	};
+
+	__m128 const one 		= _mm_set1_ps(1.0f);
+	__m128 const minusOne 	= _mm_set1_ps(-1.0f);
+	__m128 const zero 		= _mm_setzero_ps();
+
+	// Note(Leo): Distances to slabs sorted so that 'enterDistance' is where ray enters slab
+	auto slab = [&](__m128 start, __m128 direction, __m128 & enterDistance, __m128 & exitDistance)
+	{
+		__m128 inverseDirection = _mm_div_ps(one, direction);
+		__m128 toMin 			= _mm_mul_ps(_mm_sub_ps(minusOne, start), inverseDirection);
+		__m128 toMax 			= _mm_mul_ps(_mm_sub_ps(one, start), inverseDirection);
+		__m128 swap 			= _mm_cmplt_ps(inverseDirection, zero);
+
+		enterDistance 	= _mm_or_ps(_mm_and_ps(swap, toMax), _mm_andnot_ps(swap, toMin));
+		exitDistance 	= _mm_or_ps(_mm_and_ps(swap, toMin), _mm_andnot_ps(swap, toMax));
+	};
+
+	__m128 xEnter, xExit, yEnter, yExit, zEnter, zExit;
+	slab(transform_point(m[0].x, m[1].x, m[2].x, m[3].x), transform_direction(m[0].x, m[1].x, m[2].x), xEnter, xExit);
+	slab(transform_point(m[0].y, m[1].y, m[2].y, m[3].y), transform_direction(m[0].y, m[1].y, m[2].y), yEnter, yExit);
+	slab(transform_point(m[0].z, m[1].z, m[2].z, m[3].z), transform_direction(m[0].z, m[1].z, m[2].z), zEnter, zExit);
+
+	__m128 miss = _mm_or_ps(_mm_cmpgt_ps(xEnter, yExit), _mm_cmpgt_ps(yEnter, xExit));
+
+	__m128 enterDistance 	= _mm_max_ps(xEnter, yEnter);
+	__m128 exitDistance 	= _mm_min_ps(xExit, yExit);
+
+	miss 			= _mm_or_ps(miss, _mm_or_ps(_mm_cmpgt_ps(enterDistance, zExit), _mm_cmpgt_ps(zEnter, exitDistance)));
+	enterDistance 	= _mm_max_ps(enterDistance, zEnter);
+
+	__m128 hit = _mm_and_ps(_mm_cmplt_ps(_mm_set1_ps(0.00001f), enterDistance), _mm_cmplt_ps(enterDistance, lanes.closestDistance[group]));
+	hit = _mm_andnot_ps(miss, hit);
+
+	*outDistance = enterDistance;
+	return hit;
+}
+
+// Note(Leo): Same as ray_cylinder_collision, but for four rays. See ray_box_collision_4.
+internal __m128 ray_cylinder_collision_4(CylinderCollider const & collider, RayPacketLanes const & lanes, s32 group, __m128 * outDistance)
+{
+	__m128 const epsilon 		= _mm_set1_ps(0.00001f);
+	__m128 const halfHeight 	= _mm_set1_ps(collider.halfHeight);
+	__m128 const minusHalfHeight = _mm_set1_ps(-collider.halfHeight);
+	__m128 const radius 		= _mm_set1_ps(collider.radius);
+
+	__m128 const px = _mm_sub_ps(lanes.startX[group], _mm_set1_ps(collider.center.x));
+	__m128 const py = _mm_sub_ps(lanes.startY[group], _mm_set1_ps(collider.center.y));
+	__m128 const pz = _mm_sub_ps(lanes.startZ[group], _mm_set1_ps(collider.center.z));
+	__m128 const vx = lanes.directionX[group];
+	__m128 const vy = lanes.directionY[group];
+	__m128 const vz = lanes.directionZ[group];
+
+	__m128 closestDistance = lanes.closestDistance[group];
+
+	// Note(Leo): Caps
+	__m128 vt0 		= _mm_div_ps(_mm_sub_ps(halfHeight, pz), vz);
+	__m128 vt1 		= _mm_div_ps(_mm_sub_ps(minusHalfHeight, pz), vz);
+	__m128 vtMin 	= _mm_min_ps(vt0, vt1);
+
+	__m128 capX 			= _mm_add_ps(px, _mm_mul_ps(vx, vtMin));
+	__m128 capY 			= _mm_add_ps(py, _mm_mul_ps(vy, vtMin));
+	__m128 capDistance 		= _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(capX, capX), _mm_mul_ps(capY, capY)));
+
+	__m128 capHit 	= _mm_and_ps(_mm_cmpgt_ps(vtMin, epsilon), _mm_cmplt_ps(vtMin, closestDistance));
+	capHit 			= _mm_and_ps(capHit, _mm_cmplt_ps(capDistance, radius));
+
+	closestDistance = _mm_or_ps(_mm_and_ps(capHit, vtMin), _mm_andnot_ps(capHit, closestDistance));
+
+	// Note(Leo): Sides, quadratic form as in ray_cylinder_collision
+	__m128 a 	= _mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy));
+	__m128 b 	= _mm_mul_ps(_mm_set1_ps(2.0f), _mm_add_ps(_mm_mul_ps(px, vx), _mm_mul_ps(py, vy)));
+	__m128 c 	= _mm_add_ps(_mm_mul_ps(px, px), _mm_mul_ps(py, py));
+	__m128 cr2 	= _mm_sub_ps(c, _mm_mul_ps(radius, radius));
+	__m128 D 	= _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(4.0f), a), cr2));
+
+	__m128 absA 	= _mm_andnot_ps(_mm_set1_ps(-0.0f), a);
+	__m128 sideHit 	= _mm_and_ps(_mm_cmpnlt_ps(absA, epsilon), _mm_cmpnlt_ps(D, epsilon));
+
+	__m128 sqrtD 	= _mm_sqrt_ps(D);
+	__m128 twoA 	= _mm_mul_ps(_mm_set1_ps(2.0f), a);
+	__m128 minusB 	= _mm_sub_ps(_mm_setzero_ps(), b);
+	__m128 ht0 		= _mm_div_ps(_mm_sub_ps(minusB, sqrtD), twoA);
+	__m128 ht1 		= _mm_div_ps(_mm_add_ps(minusB, sqrtD), twoA);
+	__m128 ht 		= _mm_min_ps(ht0, ht1);
+
+	__m128 sideZ = _mm_add_ps(pz, _mm_mul_ps(vz, ht));
+
+	sideHit = _mm_and_ps(sideHit, _mm_and_ps(_mm_cmpgt_ps(ht, epsilon), _mm_cmplt_ps(ht, closestDistance)));
+	sideHit = _mm_and_ps(sideHit, _mm_and_ps(_mm_cmpgt_ps(sideZ, minusHalfHeight), _mm_cmplt_ps(sideZ, halfHeight)));
+
+	*outDistance = _mm_or_ps(_mm_and_ps(sideHit, ht), _mm_andnot_ps(sideHit, closestDistance));
+	return _mm_or_ps(capHit, sideHit);
+}
+
+/// ---------- BATCH RAYCAST -------------
+
+/*
+Note(Leo): Casts all rays in packet and returns bitmask of rays that hit something. Closest hit
+of each ray that hit is written to 'outResults' at ray's index, others are left untouched. Only
+colliders on 'layers' are tested, like with raycast_3d.
+*/
+internal u32 raycast_3d_batch(	CollisionSystem3D * system,
+								RayPacket const & packet,
+								RaycastResult * outResults = nullptr,
+								CollisionLayerFlags layers = CollisionLayer_all)
+{
+	if (packet.count == 0)
+	{
+		return 0;
+	}
+
+	AABB3D packetAABB = aabb_3d_empty();
+	for (s32 i = 0; i < packet.count; ++i)
+	{
+		Ray ray 	= ray_packet_get_ray(packet, i);
+		packetAABB 	= aabb_3d_grow(packetAABB, ray.start);
+		packetAABB 	= aabb_3d_grow(packetAABB, ray.start + ray.direction * ray.length);
+	}
+
+	// Note(Leo): This is few kilobytes, but it is on stack so that this can be called from jobs
+	RayPacketCandidates candidates;
+	candidates.boxCount 		= 0;
+	candidates.cylinderCount 	= 0;
+	candidates.triangleCount 	= 0;
+	candidates.triangleMeshCount = 0;
+	candidates.capsuleTreeCount = 0;
+	candidates.overflow 		= false;
+
+	ray_packet_find_candidates(*system, packetAABB, layers, candidates);
+
+	u32 hits = 0;
+
+	if (candidates.overflow)
+	{
+		for (s32 i = 0; i < packet.count; ++i)
+		{
+			Ray ray = ray_packet_get_ray(packet, i);
+			if (raycast_3d(system, ray.start, ray.direction, ray.length, outResults != nullptr ? &outResults[i] : nullptr, layers))
+			{
+				hits |= 1 << i;
+			}
+		}
+		return hits;
+	}
+
+	RayPacketLanes lanes;
+	lanes.groupCount = (packet.count + ray_packet_lane_count - 1) / ray_packet_lane_count;
+
+	for (s32 group = 0; group < lanes.groupCount; ++group)
+	{
+		s32 first = group * ray_packet_lane_count;
+
+		lanes.startX[group] 	= _mm_load_ps(packet.startX + first);
+		lanes.startY[group] 	= _mm_load_ps(packet.startY + first);
+		lanes.startZ[group] 	= _mm_load_ps(packet.startZ + first);
+		lanes.directionX[group] = _mm_load_ps(packet.directionX + first);
+		lanes.directionY[group] = _mm_load_ps(packet.directionY + first);
+		lanes.directionZ[group] = _mm_load_ps(packet.directionZ + first);
+
+		// Note(Leo): Lanes past packet's count may have anything, so their length is set to 0
+		__m128 laneIndex 				= _mm_setr_ps(first + 0, first + 1, first + 2, first + 3);
+		__m128 isUsed 					= _mm_cmplt_ps(laneIndex, _mm_set1_ps((f32)packet.count));
+		lanes.closestDistance[group] 	= _mm_and_ps(isUsed, _mm_load_ps(packet.length + first));
+	}
+
+	ColliderReference hitCollider [ray_packet_capacity] = {};
+
+	auto update_closest = [&](s32 group, __m128 hit, __m128 distance, ColliderReference collider)
+	{
+		s32 mask = _mm_movemask_ps(hit);
+		if (mask != 0)
+		{
+			lanes.closestDistance[group] = _mm_or_ps(_mm_and_ps(hit, distance), _mm_andnot_ps(hit, lanes.closestDistance[group]));
+
+			for (s32 lane = 0; lane < ray_packet_lane_count; ++lane)
+			{
+				if (mask & (1 << lane))
+				{
+					hitCollider[group * ray_packet_lane_count + lane] = collider;
+				}
+			}
+		}
+	};
+
+	for (s32 i = 0; i < candidates.boxCount; ++i)
+	{
+		PrecomputedBoxCollider const & collider = ray_packet_get_box(*system, candidates.boxes[i]);
+
+		for (s32 group = 0; group < lanes.groupCount; ++group)
+		{
+			__m128 distance;
+			__m128 hit = ray_box_collision_4(collider, lanes, group, &distance);
+			update_closest(group, hit, distance, candidates.boxes[i]);
+		}
+	}
+
+	for (s32 i = 0; i < candidates.cylinderCount; ++i)
+	{
+		CylinderCollider const & collider = ray_packet_get_cylinder(*system, candidates.cylinders[i]);
+
+		for (s32 group = 0; group < lanes.groupCount; ++group)
+		{
+			__m128 distance;
+			__m128 hit = ray_cylinder_collision_4(collider, lanes, group, &distance);
+			update_closest(group, hit, distance, candidates.cylinders[i]);
+		}
+	}
+
+	alignas(16) f32 closestDistance [ray_packet_capacity];
+	for (s32 group = 0; group < lanes.groupCount; ++group)
+	{
+		_mm_store_ps(closestDistance + group * ray_packet_lane_count, lanes.closestDistance[group]);
+	}
+
+	// Note(Leo): Triangles are few and their test branches a lot, so they are tested one ray at a time
+	for (s32 rayIndex = 0; rayIndex < packet.count; ++rayIndex)
+	{
+		Ray ray = ray_packet_get_ray(packet, rayIndex);
+
+		for (s32 i = 0; i < candidates.triangleCount; ++i)
+		{
+			RaycastResult triangleResult;
+			TriangleCollider const & collider = system->triangleColliders.memory[candidates.triangles[i].index];
+
+			if (ray_triangle_collision(ray, collider.vertices, &triangleResult))
+			{
+				f32 distance = v3_dot(triangleResult.hitPosition - ray.start, ray.direction);
+				if (distance < closestDistance[rayIndex])
+				{
+					closestDistance[rayIndex] 	= distance;
+					hitCollider[rayIndex] 		= candidates.triangles[i];
+				}
+			}
+		}
+
+		for (s32 i = 0; i < candidates.triangleMeshCount; ++i)
+		{
+			f32 distance;
+			v3 normal;
+
+			TriangleMeshInstance const & instance = ray_packet_get_triangle_mesh(*system, candidates.triangleMeshes[i]);
+			if (ray_triangle_mesh_collision(instance, ray.start, ray.direction, closestDistance[rayIndex], &distance, &normal))
+			{
+				closestDistance[rayIndex] 	= distance;
+				hitCollider[rayIndex] 		= candidates.triangleMeshes[i];
+			}
+		}
+
+		for (s32 i = 0; i < candidates.capsuleTreeCount; ++i)
+		{
+			f32 distance;
+			v3 normal;
+
+			SubmittedCapsuleTreeCollider const & submitted = system->submittedCapsuleTreeColliders.memory[candidates.capsuleTrees[i].index];
+			if (ray_capsule_tree_collision(*submitted.collider, submitted.position, ray.start, ray.direction, closestDistance[rayIndex], &distance, &normal))
+			{
+				closestDistance[rayIndex] 	= distance;
+				hitCollider[rayIndex] 		= candidates.capsuleTrees[i];
+			}
+		}
+	}
+
+	/*
+	Note(Leo): Normals are only computed for the closest hits, by testing that one collider again
+	with scalar version. It should always agree, but if it does not, we cast ray normally.
+	*/
+	for (s32 rayIndex = 0; rayIndex < packet.count; ++rayIndex)
+	{
+		Ray ray = ray_packet_get_ray(packet, rayIndex);
+
+		// Note(Leo): Terrain is tested one ray at a time too, only up to closest collider hit
+		RaycastResult terrainResult;
+		if (ray_terrain_collision(*system, ray, layers, &terrainResult, &closestDistance[rayIndex]))
+		{
+			hits |= 1 << rayIndex;
+
+			if (outResults != nullptr)
+			{
+				outResults[rayIndex] = terrainResult;
+			}
+			continue;
+		}
+
+		ColliderReference collider = hitCollider[rayIndex];
+
+		if (collider.type == ColliderType_none)
+		{
+			continue;
+		}
+
+		RaycastResult result;
+		bool32 confirmed = false;
+
+		f32 distance;
+		v3 normal;
+
+		switch (collider.type)
+		{
+			case ColliderType_submitted_box:
+			case ColliderType_static_box:
+				confirmed = ray_box_collision(ray_packet_get_box(*system, collider), ray.start, ray.direction, ray.length, &distance, &normal);
+				break;
+
+			case ColliderType_submitted_cylinder:
+			case ColliderType_static_cylinder:
+				confirmed = ray_cylinder_collision(ray_packet_get_cylinder(*system, collider), ray, &distance, &normal);
+				break;
+
+			case ColliderType_triangle:
+			{
+				RaycastResult triangleResult;
+				confirmed = ray_triangle_collision(ray, system->triangleColliders.memory[collider.index].vertices, &triangleResult);
+				if (confirmed)
+				{
+					distance 	= v3_dot(triangleResult.hitPosition - ray.start, ray.direction);
+					normal 		= triangleResult.hitNormal;
+				}
+			} break;
+
+			case ColliderType_submitted_triangle_mesh:
+			case ColliderType_static_triangle_mesh:
+				confirmed = ray_triangle_mesh_collision(ray_packet_get_triangle_mesh(*system, collider), ray.start, ray.direction, ray.length, &distance, &normal);
+				break;
+
+			case ColliderType_submitted_capsule_tree:
+			{
+				SubmittedCapsuleTreeCollider const & submitted = system->submittedCapsuleTreeColliders.memory[collider.index];
+				confirmed = ray_capsule_tree_collision(*submitted.collider, submitted.position, ray.start, ray.direction, ray.length, &distance, &normal);
+			} break;
+
+			default:
+				break;
+		}
+
+		if (confirmed)
+		{
+			result = make_raycast_result(*system, ray, distance, normal, collider);
+		}
+		else
+		{
+			confirmed = raycast_3d(system, ray.start, ray.direction, ray.length, &result, layers);
+		}
+
+		if (confirmed)
+		{
+			hits |= 1 << rayIndex;
+
+			if (outResults != nullptr)
+			{
+				outResults[rayIndex] = result;
+			}
+		}
+	}
+
+	return hits;
+}
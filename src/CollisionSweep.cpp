@@ -0,0 +1,968 @@
+/*
+Leo Tamminen
+
+Sphere and capsule sweeps. Capsule is a line segment with radius, and sphere is a capsule whose
+segment has zero length, so spheres are swept with capsule_sweep_3d with same point as both ends.
+Sweep moves capsule along a direction and finds first distance where it touches something, and the
+contact normal there.
+
+Distance between capsule's segment and a convex collider is found with GJK, which only needs a
+support function from collider: the point that is furthest in given direction. Boxes, cylinders,
+triangles and terrain cells as triangles all work same way.
+
+Time of impact is found with conservative advancement: closest points give a separating plane, and
+capsule can safely move until it would reach that plane. This is repeated until gap is less than
+tolerance, or capsule moves away from plane, in which case it never hits.
+
+References:
+	Gilbert, Johnson, Keerthi: A fast procedure for computing the distance between complex objects in three-dimensional space (1988)
+	Ericson: Real-Time Collision Detection, chapter 5.1 and 9.5 (2005)
+	Mirtich: Impulse-based Dynamic Simulation of Rigid Body Systems, chapter 2.3 (1996)
+*/
+
+constexpr s32 gjk_max_iterations 			= 32;
+constexpr f32 gjk_relative_tolerance 		= 0.00001f;
+constexpr f32 gjk_overlap_sqr_distance 		= 0.0000000001f;
+
+constexpr s32 sweep_max_iterations 			= 32;
+
+// Note(Leo): Sweep stops when capsule is this close to collider
+constexpr f32 sweep_contact_tolerance 		= 0.001f;
+
+struct CapsuleSweep
+{
+	// Note(Leo): Capsule's segment at start of sweep
+	v3 	start0;
+	v3 	start1;
+	f32 radius;
+
+	v3 	direction; 	// Note(Leo): keep this always normalized
+	f32 length;
+
+	// Note(Leo): Capsule's bounding box at start of sweep, for quickly rejecting colliders
+	v3 	center;
+	v3 	halfSize;
+	v3 	inverseDirection;
+};
+
+internal CapsuleSweep make_capsule_sweep(v3 start0, v3 start1, f32 radius, v3 normalizedDirection, f32 length)
+{
+	CapsuleSweep sweep 		= {};
+	sweep.start0 			= start0;
+	sweep.start1 			= start1;
+	sweep.radius 			= radius;
+	sweep.direction 		= normalizedDirection;
+	sweep.length 			= length;
+
+	sweep.center 			= (start0 + start1) * 0.5f;
+	sweep.halfSize 			= {	abs_f32(start1.x - start0.x) * 0.5f + radius,
+								abs_f32(start1.y - start0.y) * 0.5f + radius,
+								abs_f32(start1.z - start0.z) * 0.5f + radius };
+	sweep.inverseDirection 	= {1.0f / normalizedDirection.x, 1.0f / normalizedDirection.y, 1.0f / normalizedDirection.z};
+
+	return sweep;
+}
+
+/// ----------- SUPPORT FUNCTIONS ---------------
+
+// Note(Leo): Box is unit cube transformed, so furthest corner is found from signs in box's space
+internal v3 box_collider_support(PrecomputedBoxCollider const & collider, v3 direction)
+{
+	m44 const & transform = collider.transform;
+
+	v3 result = transform[3].xyz;
+	for (s32 axis = 0; axis < 3; ++axis)
+	{
+		v3 axisVector 	= transform[axis].xyz;
+		result 			+= v3_dot(axisVector, direction) >= 0 ? axisVector : -axisVector;
+	}
+	return result;
+}
+
+internal v3 cylinder_collider_support(CylinderCollider const & collider, v3 direction)
+{
+	v3 result = collider.center;
+
+	f32 xyLength = v2_length(direction.xy);
+	if (xyLength > 0.00001f)
+	{
+		result.x += direction.x / xyLength * collider.radius;
+		result.y += direction.y / xyLength * collider.radius;
+	}
+
+	result.z += direction.z >= 0 ? collider.halfHeight : -collider.halfHeight;
+	return result;
+}
+
+internal v3 triangle_support(v3 const vertices [3], v3 direction)
+{
+	f32 dot0 = v3_dot(vertices[0], direction);
+	f32 dot1 = v3_dot(vertices[1], direction);
+	f32 dot2 = v3_dot(vertices[2], direction);
+
+	if (dot0 >= dot1 && dot0 >= dot2)
+	{
+		return vertices[0];
+	}
+	return dot1 >= dot2 ? vertices[1] : vertices[2];
+}
+
+internal v3 segment_support(v3 start, v3 end, v3 direction)
+{
+	return v3_dot(end - start, direction) >= 0 ? end : start;
+}
+
+/// ----------- GJK ---------------
+
+/*
+Note(Leo): Simplex points are on Minkowski difference of segment and shape, and for each we also
+store points on segment and shape they came from, so that closest points can be found from weights.
+*/
+struct GJKSimplex
+{
+	s32 count;
+	v3 	points [4];
+	v3 	segmentPoints [4];
+	v3 	shapePoints [4];
+	f32 weights [4];
+};
+
+// Note(Leo): Part of simplex that has point closest to origin, as indices to simplex and weights
+struct GJKSubSimplex
+{
+	s32 count;
+	s32 indices [3];
+	f32 weights [3];
+};
+
+struct GJKDistance
+{
+	f32 distance;
+	v3 	segmentPoint;
+	v3 	shapePoint;
+};
+
+internal v3 gjk_sub_simplex_point(v3 const * points, GJKSubSimplex const & subSimplex)
+{
+	v3 result = {};
+	for (s32 i = 0; i < subSimplex.count; ++i)
+	{
+		result += points[subSimplex.indices[i]] * subSimplex.weights[i];
+	}
+	return result;
+}
+
+internal GJKSubSimplex gjk_closest_on_segment(v3 const * points, s32 i0, s32 i1)
+{
+	v3 a 	= points[i0];
+	v3 ab 	= points[i1] - a;
+
+	f32 sqrLength = v3_sqr_length(ab);
+	f32 t = sqrLength > 0 ? -v3_dot(a, ab) / sqrLength : 0;
+
+	if (t <= 0)
+	{
+		return {1, {i0}, {1}};
+	}
+	if (t >= 1)
+	{
+		return {1, {i1}, {1}};
+	}
+	return {2, {i0, i1}, {1 - t, t}};
+}
+
+// Note(Leo): Ericson's closest point on triangle, with point being origin
+internal GJKSubSimplex gjk_closest_on_triangle(v3 const * points, s32 i0, s32 i1, s32 i2)
+{
+	v3 a = points[i0];
+	v3 b = points[i1];
+	v3 c = points[i2];
+
+	v3 ab = b - a;
+	v3 ac = c - a;
+
+	f32 d1 = -v3_dot(ab, a);
+	f32 d2 = -v3_dot(ac, a);
+	if (d1 <= 0 && d2 <= 0)
+	{
+		return {1, {i0}, {1}};
+	}
+
+	f32 d3 = -v3_dot(ab, b);
+	f32 d4 = -v3_dot(ac, b);
+	if (d3 >= 0 && d4 <= d3)
+	{
+		return {1, {i1}, {1}};
+	}
+
+	f32 vc = d1 * d4 - d3 * d2;
+	if (vc <= 0 && d1 >= 0 && d3 <= 0)
+	{
+		f32 v = d1 / (d1 - d3);
+		return {2, {i0, i1}, {1 - v, v}};
+	}
+
+	f32 d5 = -v3_dot(ab, c);
+	f32 d6 = -v3_dot(ac, c);
+	if (d6 >= 0 && d5 <= d6)
+	{
+		return {1, {i2}, {1}};
+	}
+
+	f32 vb = d5 * d2 - d1 * d6;
+	if (vb <= 0 && d2 >= 0 && d6 <= 0)
+	{
+		f32 w = d2 / (d2 - d6);
+		return {2, {i0, i2}, {1 - w, w}};
+	}
+
+	f32 va = d3 * d6 - d5 * d4;
+	if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0)
+	{
+		f32 w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+		return {2, {i1, i2}, {1 - w, w}};
+	}
+
+	f32 denominator = va + vb + vc;
+	if (denominator <= 0)
+	{
+		// Note(Leo): Triangle is degenerate, so closest point is on one of its edges
+		GJKSubSimplex edges [] =
+		{
+			gjk_closest_on_segment(points, i0, i1),
+			gjk_closest_on_segment(points, i1, i2),
+			gjk_closest_on_segment(points, i2, i0),
+		};
+
+		GJKSubSimplex best 	= edges[0];
+		f32 bestSqrDistance = highest_f32;
+		for (GJKSubSimplex const & edge : edges)
+		{
+			f32 sqrDistance = v3_sqr_length(gjk_sub_simplex_point(points, edge));
+			if (sqrDistance < bestSqrDistance)
+			{
+				best 			= edge;
+				bestSqrDistance = sqrDistance;
+			}
+		}
+		return best;
+	}
+
+	f32 v = vb / denominator;
+	f32 w = vc / denominator;
+	return {3, {i0, i1, i2}, {1 - v - w, v, w}};
+}
+
+internal void gjk_simplex_reduce(GJKSimplex & simplex, GJKSubSimplex const & subSimplex)
+{
+	GJKSimplex reduced 	= {};
+	reduced.count 		= subSimplex.count;
+
+	for (s32 i = 0; i < subSimplex.count; ++i)
+	{
+		s32 index 					= subSimplex.indices[i];
+		reduced.points[i] 			= simplex.points[index];
+		reduced.segmentPoints[i] 	= simplex.segmentPoints[index];
+		reduced.shapePoints[i] 		= simplex.shapePoints[index];
+		reduced.weights[i] 			= subSimplex.weights[i];
+	}
+
+	simplex = reduced;
+}
+
+/*
+Note(Leo): Reduces simplex to smallest part that has point closest to origin, and returns that point.
+Returns false if simplex is a tetrahedron with origin inside, then shapes overlap.
+*/
+internal bool32 gjk_simplex_solve(GJKSimplex & simplex, v3 * outClosestPoint)
+{
+	GJKSubSimplex subSimplex;
+
+	if (simplex.count == 1)
+	{
+		subSimplex = {1, {0}, {1}};
+	}
+	else if (simplex.count == 2)
+	{
+		subSimplex = gjk_closest_on_segment(simplex.points, 0, 1);
+	}
+	else if (simplex.count == 3)
+	{
+		subSimplex = gjk_closest_on_triangle(simplex.points, 0, 1, 2);
+	}
+	else
+	{
+		// Note(Leo): Faces, and the vertex that is not on each face
+		constexpr s32 faces [4][4] =
+		{
+			{0, 1, 2, 3},
+			{0, 2, 3, 1},
+			{0, 3, 1, 2},
+			{1, 3, 2, 0},
+		};
+
+		v3 const * points 	= simplex.points;
+		f32 bestSqrDistance = highest_f32;
+		bool32 isOutside 	= false;
+
+		for (auto const & face : faces)
+		{
+			v3 a = points[face[0]];
+			v3 normal = v3_cross(points[face[1]] - a, points[face[2]] - a);
+
+			f32 originSide 	= -v3_dot(a, normal);
+			f32 otherSide 	= v3_dot(points[face[3]] - a, normal);
+
+			// Note(Leo): Flat tetrahedron does not have an inside, so test all its faces
+			bool32 isFlat = abs_f32(otherSide) < 0.0000001f;
+			if (isFlat == false && originSide * otherSide >= 0)
+			{
+				continue;
+			}
+
+			isOutside = true;
+
+			GJKSubSimplex faceSubSimplex 	= gjk_closest_on_triangle(points, face[0], face[1], face[2]);
+			f32 sqrDistance 				= v3_sqr_length(gjk_sub_simplex_point(points, faceSubSimplex));
+
+			if (sqrDistance < bestSqrDistance)
+			{
+				bestSqrDistance = sqrDistance;
+				subSimplex 		= faceSubSimplex;
+			}
+		}
+
+		if (isOutside == false)
+		{
+			return false;
+		}
+	}
+
+	*outClosestPoint = gjk_sub_simplex_point(simplex.points, subSimplex);
+	gjk_simplex_reduce(simplex, subSimplex);
+
+	return true;
+}
+
+/*
+Note(Leo): Distance between line segment and convex shape, whose support point is given by
+'support_shape(v3 direction) -> v3'. Distance is 0 when they overlap, and points are not meaningful
+then. 'searchDirection' is a guess of direction from segment towards shape, good guess saves
+iterations.
+*/
+template<typename TSupportFunc>
+internal GJKDistance gjk_segment_distance(v3 segmentStart, v3 segmentEnd, v3 searchDirection, TSupportFunc support_shape)
+{
+	GJKSimplex simplex = {};
+
+	auto add_support_point = [&](v3 direction)
+	{
+		s32 index 						= simplex.count++;
+		simplex.segmentPoints[index] 	= v3_dot(segmentStart, direction) >= v3_dot(segmentEnd, direction) ? segmentStart : segmentEnd;
+		simplex.shapePoints[index] 		= support_shape(-direction);
+		simplex.points[index] 			= simplex.segmentPoints[index] - simplex.shapePoints[index];
+		simplex.weights[index] 			= 1;
+	};
+
+	add_support_point(searchDirection);
+
+	v3 closestPoint 	= simplex.points[0];
+	f32 sqrDistance 	= v3_sqr_length(closestPoint);
+	bool32 isOverlapping = false;
+
+	for (s32 iteration = 0; iteration < gjk_max_iterations; ++iteration)
+	{
+		if (sqrDistance < gjk_overlap_sqr_distance)
+		{
+			isOverlapping = true;
+			break;
+		}
+
+		GJKSimplex previous = simplex;
+		add_support_point(-closestPoint);
+
+		// Note(Leo): New point is not further than closest point towards origin, so we are done
+		v3 newPoint = simplex.points[simplex.count - 1];
+		if (sqrDistance - v3_dot(closestPoint, newPoint) <= gjk_relative_tolerance * sqrDistance)
+		{
+			simplex = previous;
+			break;
+		}
+
+		if (gjk_simplex_solve(simplex, &closestPoint) == false)
+		{
+			isOverlapping = true;
+			break;
+		}
+
+		f32 newSqrDistance = v3_sqr_length(closestPoint);
+
+		// Note(Leo): No progress, so rounding errors are in charge now
+		if (newSqrDistance >= sqrDistance)
+		{
+			simplex = previous;
+			break;
+		}
+
+		sqrDistance = newSqrDistance;
+	}
+
+	GJKDistance result = {};
+
+	if (isOverlapping)
+	{
+		return result;
+	}
+
+	for (s32 i = 0; i < simplex.count; ++i)
+	{
+		result.segmentPoint += simplex.segmentPoints[i] * simplex.weights[i];
+		result.shapePoint 	+= simplex.shapePoints[i] * simplex.weights[i];
+	}
+	result.distance = v3_length(result.segmentPoint - result.shapePoint);
+
+	return result;
+}
+
+/// ----------- SWEEPS ---------------
+
+/*
+Note(Leo): Sweep against single convex shape, see gjk_segment_distance. Finds only hits that are
+closer than 'maxDistance'. Normal points from shape towards capsule, and contact is point on shape.
+If capsule starts overlapping with shape, hit is at distance 0, and normal is against direction if
+capsule's segment is inside shape.
+*/
+template<typename TSupportFunc>
+internal bool32 capsule_convex_sweep(	CapsuleSweep const & sweep,
+										f32 maxDistance,
+										TSupportFunc support_shape,
+										f32 * outDistance,
+										v3 * outNormal,
+										v3 * outContact)
+{
+	f32 distance 		= 0;
+	v3 searchDirection 	= sweep.direction;
+
+	for (s32 iteration = 0; iteration < sweep_max_iterations; ++iteration)
+	{
+		v3 offset 			= sweep.direction * distance;
+		GJKDistance closest = gjk_segment_distance(sweep.start0 + offset, sweep.start1 + offset, searchDirection, support_shape);
+
+		f32 gap = closest.distance - sweep.radius;
+		if (gap < sweep_contact_tolerance)
+		{
+			if (closest.distance > 0)
+			{
+				*outNormal 	= (closest.segmentPoint - closest.shapePoint) / closest.distance;
+				*outContact = closest.shapePoint;
+			}
+			else
+			{
+				*outNormal 	= -sweep.direction;
+				*outContact = sweep.start0 + offset;
+			}
+
+			*outDistance = distance;
+			return true;
+		}
+
+		v3 normal 			= (closest.segmentPoint - closest.shapePoint) / closest.distance;
+		f32 approachSpeed 	= -v3_dot(sweep.direction, normal);
+
+		// Note(Leo): Capsule moves away from separating plane, so it will never hit
+		if (approachSpeed <= 0)
+		{
+			return false;
+		}
+
+		distance += gap / approachSpeed;
+		if (distance >= maxDistance)
+		{
+			return false;
+		}
+
+		// Note(Leo): Closest points move only a little between iterations, so start from last ones
+		searchDirection = -normal;
+	}
+
+	/* Note(Leo): Very grazing sweeps may take a lot of iterations. We are not quite touching yet, but
+	it is safer to stop here than to let capsule go through. */
+	v3 offset 			= sweep.direction * distance;
+	GJKDistance closest = gjk_segment_distance(sweep.start0 + offset, sweep.start1 + offset, searchDirection, support_shape);
+
+	*outDistance 	= distance;
+	*outNormal 		= closest.distance > 0 ? (closest.segmentPoint - closest.shapePoint) / closest.distance : -sweep.direction;
+	*outContact 	= closest.shapePoint;
+	return true;
+}
+
+/*
+Note(Leo): Tests if capsule's bounding box hits collider's bounding box before 'maxDistance'. This is
+much cheaper than sweeping, and trees only give colliders that overlap whole sweep's bounding box.
+*/
+internal bool32 capsule_sweep_may_hit(CapsuleSweep const & sweep, AABB3D colliderAABB, f32 maxDistance)
+{
+	AABB3D expanded = {colliderAABB.min - sweep.halfSize, colliderAABB.max + sweep.halfSize};
+	return ray_aabb_3d_distance(sweep.center, sweep.inverseDirection, maxDistance, expanded) != highest_f32;
+}
+
+internal AABB3D compute_triangle_aabb(v3 const vertices [3])
+{
+	AABB3D aabb = aabb_3d_empty();
+	aabb 		= aabb_3d_grow(aabb, vertices[0]);
+	aabb 		= aabb_3d_grow(aabb, vertices[1]);
+	aabb 		= aabb_3d_grow(aabb, vertices[2]);
+	return aabb;
+}
+
+internal AABB3D compute_capsule_sweep_aabb(CapsuleSweep const & sweep)
+{
+	v3 end0 = sweep.start0 + sweep.direction * sweep.length;
+	v3 end1 = sweep.start1 + sweep.direction * sweep.length;
+
+	AABB3D aabb = aabb_3d_empty();
+	aabb 		= aabb_3d_grow(aabb, sweep.start0);
+	aabb 		= aabb_3d_grow(aabb, sweep.start1);
+	aabb 		= aabb_3d_grow(aabb, end0);
+	aabb 		= aabb_3d_grow(aabb, end1);
+
+	return aabb_3d_expand(aabb, sweep.radius);
+}
+
+/*
+Note(Leo): Sweep's bounding box is transformed to mesh space to find triangles from mesh's tree, but
+triangles are swept in world space, since capsule would not stay a capsule in mesh space if transform
+has non uniform scale.
+*/
+internal bool32 sweep_triangle_mesh_collision(	TriangleMeshInstance const & instance,
+												CapsuleSweep const & sweep,
+												AABB3D sweepAABB,
+												f32 maxDistance,
+												f32 * outDistance,
+												v3 * outNormal,
+												v3 * outContact)
+{
+	if (aabb_3d_overlaps(instance.aabb, sweepAABB) == false)
+	{
+		return false;
+	}
+
+	AABB3D localAABB 	= compute_transformed_aabb(sweepAABB, instance.inverseTransform);
+	f32 closestDistance = maxDistance;
+	bool32 hit 			= false;
+
+	m44 const & transform = instance.transform;
+
+	// Note(Leo): Transforms are affine, so this skips w division that multiply_point does
+	auto to_world = [&transform](v3 point)
+	{
+		return transform[0].xyz * point.x + transform[1].xyz * point.y + transform[2].xyz * point.z + transform[3].xyz;
+	};
+
+	triangle_mesh_query_aabb(*instance.mesh, localAABB, [&](s32 triangle)
+	{
+		v3 vertices [3];
+		triangle_mesh_get_triangle(*instance.mesh, triangle, vertices);
+
+		vertices[0] = to_world(vertices[0]);
+		vertices[1] = to_world(vertices[1]);
+		vertices[2] = to_world(vertices[2]);
+
+		if (capsule_sweep_may_hit(sweep, compute_triangle_aabb(vertices), closestDistance) == false)
+		{
+			return;
+		}
+
+		auto support = [&vertices](v3 direction) { return triangle_support(vertices, direction); };
+
+		if (capsule_convex_sweep(sweep, closestDistance, support, outDistance, outNormal, outContact))
+		{
+			hit 			= true;
+			closestDistance = *outDistance;
+		}
+	});
+
+	return hit;
+}
+
+/*
+Note(Leo): Sweeping capsule against capsule is same as sweeping capsule with both radii against other
+capsule's segment, so GJK only needs segment's support. Contact is then moved from segment to surface.
+*/
+internal bool32 sweep_capsule_tree_collision(	CapsuleTreeCollider const & collider,
+												v3 position,
+												CapsuleSweep const & sweep,
+												AABB3D sweepAABB,
+												f32 maxDistance,
+												f32 * outDistance,
+												v3 * outNormal,
+												v3 * outContact)
+{
+	f32 closestDistance = maxDistance;
+	bool32 hit 			= false;
+
+	capsule_tree_collider_query_aabb(collider, position, sweepAABB, [&](s32 capsuleIndex)
+	{
+		CapsuleCollider const & capsule = collider.capsules.memory[capsuleIndex];
+
+		v3 start 	= capsule.start + position;
+		v3 end 		= capsule.end + position;
+
+		if (capsule_sweep_may_hit(sweep, compute_capsule_collider_aabb({start, end, capsule.radius}), closestDistance) == false)
+		{
+			return;
+		}
+
+		CapsuleSweep inflated 	= make_capsule_sweep(sweep.start0, sweep.start1, sweep.radius + capsule.radius, sweep.direction, sweep.length);
+		auto support 			= [start, end](v3 direction) { return segment_support(start, end, direction); };
+
+		if (capsule_convex_sweep(inflated, closestDistance, support, outDistance, outNormal, outContact))
+		{
+			hit 			= true;
+			closestDistance = *outDistance;
+			*outContact 	+= *outNormal * capsule.radius;
+		}
+	});
+
+	return hit;
+}
+
+internal RaycastResult make_sweep_result(CollisionSystem3D const & system, f32 distance, v3 normal, v3 contact, ColliderReference collider)
+{
+	RaycastResult result 	= {};
+	result.hitPosition 		= contact;
+	result.hitNormal 		= normal;
+	result.distance 		= distance;
+	result.collider 		= collider;
+	result.entity 			= collision_system_get_entity(system, collider);
+	return result;
+}
+
+/*
+Note(Leo): These work like ray_*_collisions: only hits closer than 'closestDistance' are found, and
+it is updated when they are. Candidates come from trees with sweep's bounding box, so these are
+meant for short sweeps, like character's movement during one frame.
+*/
+
+internal bool32 sweep_submitted_collisions(	CollisionSystem3D const & system,
+											CapsuleSweep const & sweep,
+											AABB3D sweepAABB,
+											CollisionLayerFlags layers,
+											RaycastResult * outResult,
+											f32 * closestDistance)
+{
+	if ((layers & CollisionLayer_submitted) == 0)
+	{
+		return false;
+	}
+
+	bool32 hit = false;
+
+	auto test_proxy = [&](s32 userData)
+	{
+		SubmittedColliderType type 	= collision_system_submitted_type(userData);
+		s32 index 					= collision_system_submitted_index(userData);
+
+		f32 distance;
+		v3 normal;
+		v3 contact;
+		bool32 proxyHit = false;
+
+		ColliderReference collider;
+
+		if (type == SubmittedColliderType_box)
+		{
+			collider = {ColliderType_submitted_box, index};
+
+			SubmittedBoxCollider const & submitted = system.submittedBoxColliders.memory[index];
+			if ((layers & CollisionLayer_submitted_box) && capsule_sweep_may_hit(sweep, submitted.aabb, *closestDistance))
+			{
+				PrecomputedBoxCollider const & box = submitted.precomputed;
+				auto support = [&box](v3 direction) { return box_collider_support(box, direction); };
+
+				proxyHit = capsule_convex_sweep(sweep, *closestDistance, support, &distance, &normal, &contact);
+			}
+		}
+		else if (type == SubmittedColliderType_cylinder)
+		{
+			collider = {ColliderType_submitted_cylinder, index};
+
+			CylinderCollider const & cylinder = system.submittedCylinderColliders.memory[index].collider;
+			if ((layers & CollisionLayer_submitted_cylinder) && capsule_sweep_may_hit(sweep, compute_cylinder_collider_aabb(cylinder), *closestDistance))
+			{
+				auto support = [&cylinder](v3 direction) { return cylinder_collider_support(cylinder, direction); };
+
+				proxyHit = capsule_convex_sweep(sweep, *closestDistance, support, &distance, &normal, &contact);
+			}
+		}
+		else if (type == SubmittedColliderType_triangle_mesh)
+		{
+			collider = {ColliderType_submitted_triangle_mesh, index};
+
+			if (layers & CollisionLayer_submitted_triangle_mesh)
+			{
+				TriangleMeshInstance const & instance = system.submittedTriangleMeshColliders.memory[index].instance;
+				proxyHit = sweep_triangle_mesh_collision(instance, sweep, sweepAABB, *closestDistance, &distance, &normal, &contact);
+			}
+		}
+		else
+		{
+			collider = {ColliderType_submitted_capsule_tree, index};
+
+			SubmittedCapsuleTreeCollider const & submitted = system.submittedCapsuleTreeColliders.memory[index];
+			if ((layers & CollisionLayer_submitted_capsule_tree) && capsule_sweep_may_hit(sweep, submitted.aabb, *closestDistance))
+			{
+				proxyHit = sweep_capsule_tree_collision(*submitted.collider, submitted.position, sweep, sweepAABB, *closestDistance, &distance, &normal, &contact);
+			}
+		}
+
+		if (proxyHit)
+		{
+			hit 				= true;
+			*closestDistance 	= distance;
+
+			if (outResult != nullptr)
+			{
+				*outResult = make_sweep_result(system, distance, normal, contact, collider);
+			}
+		}
+	};
+
+	dynamic_aabb_tree_query_aabb(system.submittedTree, sweepAABB, test_proxy);
+
+	return hit;
+}
+
+internal bool32 sweep_static_collisions(	CollisionSystem3D const & system,
+											CapsuleSweep const & sweep,
+											AABB3D sweepAABB,
+											CollisionLayerFlags layers,
+											RaycastResult * outResult,
+											f32 * closestDistance)
+{
+	bool32 hit = false;
+
+	auto report_hit = [&](f32 distance, v3 normal, v3 contact, ColliderReference collider)
+	{
+		hit 				= true;
+		*closestDistance 	= distance;
+
+		if (outResult != nullptr)
+		{
+			*outResult = make_sweep_result(system, distance, normal, contact, collider);
+		}
+	};
+
+	if (layers & CollisionLayer_static_cylinder)
+	{
+		for (s32 i = 0; i < system.staticCylinderColliders.count; ++i)
+		{
+			CylinderCollider const & cylinder = system.staticCylinderColliders.memory[i];
+			if (capsule_sweep_may_hit(sweep, compute_cylinder_collider_aabb(cylinder), *closestDistance) == false)
+			{
+				continue;
+			}
+
+			auto support = [&cylinder](v3 direction) { return cylinder_collider_support(cylinder, direction); };
+
+			f32 distance;
+			v3 normal;
+			v3 contact;
+			if (capsule_convex_sweep(sweep, *closestDistance, support, &distance, &normal, &contact))
+			{
+				report_hit(distance, normal, contact, {ColliderType_static_cylinder, i});
+			}
+		}
+	}
+
+	if (layers & CollisionLayer_static_triangle_mesh)
+	{
+		for (s32 i = 0; i < system.staticTriangleMeshes.count; ++i)
+		{
+			f32 distance;
+			v3 normal;
+			v3 contact;
+			if (sweep_triangle_mesh_collision(system.staticTriangleMeshes.memory[i], sweep, sweepAABB, *closestDistance, &distance, &normal, &contact))
+			{
+				report_hit(distance, normal, contact, {ColliderType_static_triangle_mesh, i});
+			}
+		}
+	}
+
+	if ((layers & (CollisionLayer_static_box | CollisionLayer_triangle)) == 0)
+	{
+		return hit;
+	}
+
+	auto test_reference = [&](StaticColliderReference reference)
+	{
+		f32 distance;
+		v3 normal;
+		v3 contact;
+
+		if (reference.type == StaticColliderType_box)
+		{
+			PrecomputedBoxCollider const & box = system.staticBoxColliders.memory[reference.index];
+			if ((layers & CollisionLayer_static_box) && capsule_sweep_may_hit(sweep, compute_box_collider_aabb(box), *closestDistance))
+			{
+				auto support = [&box](v3 direction) { return box_collider_support(box, direction); };
+
+				if (capsule_convex_sweep(sweep, *closestDistance, support, &distance, &normal, &contact))
+				{
+					report_hit(distance, normal, contact, {ColliderType_static_box, reference.index});
+				}
+			}
+		}
+		else if (layers & CollisionLayer_triangle)
+		{
+			v3 const * vertices = system.triangleColliders.memory[reference.index].vertices;
+			if (capsule_sweep_may_hit(sweep, compute_triangle_aabb(vertices), *closestDistance) == false)
+			{
+				return;
+			}
+
+			auto support = [vertices](v3 direction) { return triangle_support(vertices, direction); };
+
+			if (capsule_convex_sweep(sweep, *closestDistance, support, &distance, &normal, &contact))
+			{
+				report_hit(distance, normal, contact, {ColliderType_triangle, reference.index});
+			}
+		}
+	};
+
+	CollisionBVH const & bvh = system.staticBVH;
+	collision_bvh_query_aabb(bvh, sweepAABB, test_reference);
+
+	for (s32 i = bvh.boxCount; i < system.staticBoxColliders.count; ++i)
+	{
+		test_reference({StaticColliderType_box, i});
+	}
+
+	for (s32 i = bvh.triangleCount; i < system.triangleColliders.count; ++i)
+	{
+		test_reference({StaticColliderType_triangle, i});
+	}
+
+	return hit;
+}
+
+/*
+Note(Leo): Terrain cells are swept as two triangles each, so this is not exactly same surface that
+rays and get_height_at see, but close enough for moving things against it. Cells whose height range
+does not overlap sweep's bounding box are skipped.
+*/
+internal bool32 sweep_terrain_collision(	CollisionSystem3D const & system,
+											CapsuleSweep const & sweep,
+											AABB3D sweepAABB,
+											CollisionLayerFlags layers,
+											RaycastResult * outResult,
+											f32 * closestDistance)
+{
+	HeightMap const & map = system.terrainCollider;
+
+	if ((layers & CollisionLayer_terrain) == 0 || map.gridSize < 2)
+	{
+		return false;
+	}
+
+	f32 cellSize 	= map.worldSize / map.gridSize;
+	s32 cellCount 	= map.gridSize - 1;
+	v3 offset 		= system.terrainOffset;
+
+	if (sweepAABB.max.x < offset.x || sweepAABB.min.x > offset.x + cellCount * cellSize
+		|| sweepAABB.max.y < offset.y || sweepAABB.min.y > offset.y + cellCount * cellSize)
+	{
+		return false;
+	}
+
+	s32 minX = s32_clamp((s32)floor_f32((sweepAABB.min.x - offset.x) / cellSize), 0, cellCount - 1);
+	s32 minY = s32_clamp((s32)floor_f32((sweepAABB.min.y - offset.y) / cellSize), 0, cellCount - 1);
+	s32 maxX = s32_clamp((s32)floor_f32((sweepAABB.max.x - offset.x) / cellSize), 0, cellCount - 1);
+	s32 maxY = s32_clamp((s32)floor_f32((sweepAABB.max.y - offset.y) / cellSize), 0, cellCount - 1);
+
+	bool32 hit = false;
+
+	for (s32 y = minY; y <= maxY; ++y)
+	{
+		for (s32 x = minX; x <= maxX; ++x)
+		{
+			HeightMapMinMax minMax = height_map_get_cell_min_max(map, x, y);
+			if (minMax.max < sweepAABB.min.z || minMax.min > sweepAABB.max.z)
+			{
+				continue;
+			}
+
+			v3 corner00 = {offset.x + x * cellSize, offset.y + y * cellSize, height_map_get_grid_height(map, x, y)};
+			v3 corner10 = {offset.x + (x + 1) * cellSize, offset.y + y * cellSize, height_map_get_grid_height(map, x + 1, y)};
+			v3 corner01 = {offset.x + x * cellSize, offset.y + (y + 1) * cellSize, height_map_get_grid_height(map, x, y + 1)};
+			v3 corner11 = {offset.x + (x + 1) * cellSize, offset.y + (y + 1) * cellSize, height_map_get_grid_height(map, x + 1, y + 1)};
+
+			v3 triangles [2][3] =
+			{
+				{corner00, corner10, corner11},
+				{corner00, corner11, corner01},
+			};
+
+			for (v3 const * vertices : triangles)
+			{
+				auto support = [vertices](v3 direction) { return triangle_support(vertices, direction); };
+
+				f32 distance;
+				v3 normal;
+				v3 contact;
+				if (capsule_convex_sweep(sweep, *closestDistance, support, &distance, &normal, &contact))
+				{
+					hit 				= true;
+					*closestDistance 	= distance;
+
+					if (outResult != nullptr)
+					{
+						*outResult = make_sweep_result(system, distance, normal, contact, {ColliderType_terrain, x + y * cellCount});
+					}
+				}
+			}
+		}
+	}
+
+	return hit;
+}
+
+/*
+Note(Leo): Sweeps capsule from 'capsuleStart' to 'capsuleEnd' with 'radius' along direction, and
+finds closest hit among all colliders on 'layers'. Result's distance is how far capsule can move
+before touching, hit position is contact point on collider and normal points towards capsule.
+*/
+internal bool32
+capsule_sweep_3d(	CollisionSystem3D * system,
+					v3 capsuleStart,
+					v3 capsuleEnd,
+					f32 radius,
+					v3 normalizedDirection,
+					f32 length,
+					RaycastResult * outResult = nullptr,
+					CollisionLayerFlags layers = CollisionLayer_all)
+{
+	CapsuleSweep sweep = make_capsule_sweep(capsuleStart, capsuleEnd, radius, normalizedDirection, length);
+
+	AABB3D sweepAABB 	= compute_capsule_sweep_aabb(sweep);
+	f32 closestDistance = length;
+	bool32 hit 			= false;
+
+	if (sweep_submitted_collisions(*system, sweep, sweepAABB, layers, outResult, &closestDistance))
+	{
+		hit = true;
+	}
+
+	if (sweep_static_collisions(*system, sweep, sweepAABB, layers, outResult, &closestDistance))
+	{
+		hit = true;
+	}
+
+	if (sweep_terrain_collision(*system, sweep, sweepAABB, layers, outResult, &closestDistance))
+	{
+		hit = true;
+	}
+
+	return hit;
+}
+
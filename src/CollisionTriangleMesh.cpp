@@ -0,0 +1,465 @@
+/*
+Leo Tamminen
+
+Triangle mesh colliders, built from mesh assets when they are loaded. Mesh has its own compact
+bounding volume hierarchy, where node bounds are quantized to 16 bits inside mesh's bounds, and
+leaves only refer to a range of triangles, whose indices are reordered so that each leaf's
+triangles are next to each other.
+
+Mesh is in its own local space, and TriangleMeshInstance places it in world with a transform, so
+that same mesh and its tree is shared by all places it is used. Rays are transformed to mesh space
+instead of transforming mesh, and further to quantized space, where node bounds can be used as is.
+Transforms are affine, so distance along ray is same in all these spaces.
+*/
+
+// Note(Leo): 16 bytes, four nodes per cache line
+struct TriangleMeshBVHNode
+{
+	u16 min [3];
+	u16 max [3];
+
+	// Note(Leo): Leaf: first triangle and triangle count, inner node: right child and 0. Left child is next node.
+	u32 indexAndCount;
+};
+
+static_assert(sizeof(TriangleMeshBVHNode) == 16, "TriangleMeshBVHNode should be 16 bytes");
+
+constexpr s32 triangle_mesh_bvh_count_bits 	= 8;
+constexpr u32 triangle_mesh_bvh_count_mask 	= (1 << triangle_mesh_bvh_count_bits) - 1;
+constexpr s32 triangle_mesh_bvh_max_index 	= (1 << (32 - triangle_mesh_bvh_count_bits)) - 1;
+constexpr f32 triangle_mesh_quantized_max 	= 65535.0f;
+
+internal s32 triangle_mesh_bvh_node_index(TriangleMeshBVHNode const & node)
+{
+	return (s32)(node.indexAndCount >> triangle_mesh_bvh_count_bits);
+}
+
+internal s32 triangle_mesh_bvh_node_count(TriangleMeshBVHNode const & node)
+{
+	return (s32)(node.indexAndCount & triangle_mesh_bvh_count_mask);
+}
+
+struct TriangleMeshCollider
+{
+	s32 	vertexCount;
+	v3 * 	vertices;
+
+	// Note(Leo): Three indices per triangle, in same order as bvh leaves refer to them
+	s32 	triangleCount;
+	u16 * 	indices;
+
+	s32 					nodeCount;
+	TriangleMeshBVHNode * 	nodes;
+
+	// Note(Leo): Quantized node bounds are steps of 'quantizeStep' from 'bounds.min'
+	AABB3D 	bounds;
+	v3 		quantizeStep;
+	v3 		inverseQuantizeStep;
+};
+
+internal v3 triangle_mesh_quantize(TriangleMeshCollider const & mesh, v3 position)
+{
+	v3 result = position - mesh.bounds.min;
+	result.x *= mesh.inverseQuantizeStep.x;
+	result.y *= mesh.inverseQuantizeStep.y;
+	result.z *= mesh.inverseQuantizeStep.z;
+	return result;
+}
+
+internal AABB3D triangle_mesh_bvh_node_bounds(TriangleMeshBVHNode const & node)
+{
+	AABB3D result =
+	{
+		{(f32)node.min[0], (f32)node.min[1], (f32)node.min[2]},
+		{(f32)node.max[0], (f32)node.max[1], (f32)node.max[2]}
+	};
+	return result;
+}
+
+/*
+Note(Leo): Tree is built with same builder as static collider bvh, using transient memory, and then
+copied to compact form to 'allocator'. Vertices and indices are copied too, so 'meshData' can be
+in transient memory. Only 16 bit indices are supported, as are all our meshes for now.
+*/
+internal TriangleMeshCollider make_triangle_mesh_collider(MemoryArena & allocator, MeshAssetData const & meshData)
+{
+	Assert(meshData.indexType == MeshIndexType_uint16);
+	Assert(&allocator != global_transientMemory && "Triangle mesh collider is built using transient memory, so it cannot be allocated from there");
+
+	TriangleMeshCollider mesh 	= {};
+	mesh.vertexCount 			= (s32)meshData.vertexCount;
+	mesh.triangleCount 			= (s32)(meshData.indexCount / 3);
+
+	Assert(mesh.triangleCount <= triangle_mesh_bvh_max_index);
+
+	mesh.vertices 	= push_memory<v3>(allocator, mesh.vertexCount, ALLOC_GARBAGE);
+	mesh.indices 	= push_memory<u16>(allocator, mesh.triangleCount * 3, ALLOC_GARBAGE);
+
+	mesh.bounds = aabb_3d_empty();
+	for (s32 i = 0; i < mesh.vertexCount; ++i)
+	{
+		mesh.vertices[i] 	= meshData.vertices[i].position;
+		mesh.bounds 		= aabb_3d_grow(mesh.bounds, mesh.vertices[i]);
+	}
+
+	if (mesh.triangleCount == 0)
+	{
+		return mesh;
+	}
+
+	// Note(Leo): Grow bounds a little, so that quantized bounds never end up inside actual bounds from rounding
+	v3 margin 		= (mesh.bounds.max - mesh.bounds.min) * 0.001f + v3{0.001f, 0.001f, 0.001f};
+	mesh.bounds.min -= margin;
+	mesh.bounds.max += margin;
+
+	mesh.quantizeStep 			= (mesh.bounds.max - mesh.bounds.min) * (1.0f / triangle_mesh_quantized_max);
+	mesh.inverseQuantizeStep 	= {1.0f / mesh.quantizeStep.x, 1.0f / mesh.quantizeStep.y, 1.0f / mesh.quantizeStep.z};
+
+	auto checkpoint = memory_push_checkpoint(*global_transientMemory);
+	{
+		Array<TriangleCollider> triangles = push_array<TriangleCollider>(*global_transientMemory, mesh.triangleCount, ALLOC_GARBAGE);
+		for (s32 i = 0; i < mesh.triangleCount; ++i)
+		{
+			TriangleCollider triangle;
+			triangle.vertices[0] = mesh.vertices[meshData.indices[i * 3 + 0]];
+			triangle.vertices[1] = mesh.vertices[meshData.indices[i * 3 + 1]];
+			triangle.vertices[2] = mesh.vertices[meshData.indices[i * 3 + 2]];
+			triangles.push(triangle);
+		}
+
+		Array<PrecomputedBoxCollider> noBoxes = {};
+		CollisionBVH bvh = make_collision_bvh(*global_transientMemory, noBoxes, triangles);
+
+		mesh.nodeCount 	= (s32)bvh.nodes.count;
+		mesh.nodes 		= push_memory<TriangleMeshBVHNode>(allocator, mesh.nodeCount, ALLOC_GARBAGE);
+
+		Assert(mesh.nodeCount <= triangle_mesh_bvh_max_index);
+
+		for (s32 i = 0; i < mesh.nodeCount; ++i)
+		{
+			CollisionBVHNode const & node = bvh.nodes[i];
+
+			// Note(Leo): Round outwards, so that quantized bounds always contain actual bounds
+			v3 min = triangle_mesh_quantize(mesh, node.min);
+			v3 max = triangle_mesh_quantize(mesh, node.max);
+
+			TriangleMeshBVHNode & compact = mesh.nodes[i];
+			for (s32 axis = 0; axis < 3; ++axis)
+			{
+				compact.min[axis] = (u16)f32_clamp(floor_f32(v3_component(min, axis)), 0, triangle_mesh_quantized_max);
+				compact.max[axis] = (u16)f32_clamp(ceil_f32(v3_component(max, axis)), 0, triangle_mesh_quantized_max);
+			}
+
+			Assert(node.count <= (s32)triangle_mesh_bvh_count_mask);
+			compact.indexAndCount = ((u32)node.index << triangle_mesh_bvh_count_bits) | (u32)node.count;
+		}
+
+		// Note(Leo): References are in leaf order, so triangles are copied in that order
+		for (s32 i = 0; i < mesh.triangleCount; ++i)
+		{
+			s32 triangle = bvh.references[i].index;
+
+			mesh.indices[i * 3 + 0] = meshData.indices[triangle * 3 + 0];
+			mesh.indices[i * 3 + 1] = meshData.indices[triangle * 3 + 1];
+			mesh.indices[i * 3 + 2] = meshData.indices[triangle * 3 + 2];
+		}
+	}
+	memory_pop_checkpoint(*global_transientMemory, checkpoint);
+
+	return mesh;
+}
+
+internal void triangle_mesh_get_triangle(TriangleMeshCollider const & mesh, s32 triangle, v3 * outVertices)
+{
+	outVertices[0] = mesh.vertices[mesh.indices[triangle * 3 + 0]];
+	outVertices[1] = mesh.vertices[mesh.indices[triangle * 3 + 1]];
+	outVertices[2] = mesh.vertices[mesh.indices[triangle * 3 + 2]];
+}
+
+/*
+Note(Leo): Two sided Möller-Trumbore. Direction does not need to be normalized, and distance is
+in units of direction. Normal is not normalized.
+*/
+internal bool32 ray_triangle_mesh_triangle(	v3 rayStart,
+											v3 rayDirection,
+											v3 const vertices [3],
+											f32 maxDistance,
+											f32 * outDistance,
+											v3 * outNormal)
+{
+	v3 edge01 = vertices[1] - vertices[0];
+	v3 edge02 = vertices[2] - vertices[0];
+
+	v3 p 		= v3_cross(rayDirection, edge02);
+	f32 det 	= v3_dot(edge01, p);
+
+	if (det == 0)
+	{
+		return false;
+	}
+
+	f32 inverseDet 	= 1.0f / det;
+	v3 toStart 		= rayStart - vertices[0];
+
+	f32 u = v3_dot(toStart, p) * inverseDet;
+	if (u < 0 || u > 1)
+	{
+		return false;
+	}
+
+	v3 q 	= v3_cross(toStart, edge01);
+	f32 v 	= v3_dot(rayDirection, q) * inverseDet;
+	if (v < 0 || u + v > 1)
+	{
+		return false;
+	}
+
+	f32 distance = v3_dot(edge02, q) * inverseDet;
+	if (distance < 0 || distance >= maxDistance)
+	{
+		return false;
+	}
+
+	*outDistance 	= distance;
+	*outNormal 		= v3_cross(edge01, edge02);
+	return true;
+}
+
+/*
+Note(Leo): Ray is in mesh space, and direction need not be normalized. Finds closest triangle
+before 'maxDistance', and gives its index and unnormalized mesh space normal.
+*/
+internal bool32 ray_triangle_mesh_local(TriangleMeshCollider const & mesh,
+										v3 rayStart,
+										v3 rayDirection,
+										f32 maxDistance,
+										f32 * outDistance,
+										v3 * outNormal)
+{
+	if (mesh.nodeCount == 0)
+	{
+		return false;
+	}
+
+	v3 quantizedStart 		= triangle_mesh_quantize(mesh, rayStart);
+	v3 quantizedDirection 	= {	rayDirection.x * mesh.inverseQuantizeStep.x,
+								rayDirection.y * mesh.inverseQuantizeStep.y,
+								rayDirection.z * mesh.inverseQuantizeStep.z };
+	v3 inverseDirection 	= {1.0f / quantizedDirection.x, 1.0f / quantizedDirection.y, 1.0f / quantizedDirection.z};
+
+	auto node_distance = [&](s32 nodeIndex, f32 closestDistance)
+	{
+		return ray_aabb_3d_distance(quantizedStart, inverseDirection, closestDistance, triangle_mesh_bvh_node_bounds(mesh.nodes[nodeIndex]));
+	};
+
+	f32 closestDistance = maxDistance;
+	bool32 hit 			= false;
+
+	// Note(Leo): Same traversal as in ray_collision_bvh
+	struct StackEntry
+	{
+		s32 nodeIndex;
+		f32 distance;
+	};
+
+	StackEntry stack [collision_bvh_max_depth];
+	s32 stackCount = 0;
+
+	if (node_distance(0, closestDistance) == highest_f32)
+	{
+		return false;
+	}
+
+	s32 nodeIndex = 0;
+	while(true)
+	{
+		TriangleMeshBVHNode const & node = mesh.nodes[nodeIndex];
+
+		s32 index = triangle_mesh_bvh_node_index(node);
+		s32 count = triangle_mesh_bvh_node_count(node);
+
+		if (count > 0)
+		{
+			for (s32 triangle = index; triangle < index + count; ++triangle)
+			{
+				v3 vertices [3];
+				triangle_mesh_get_triangle(mesh, triangle, vertices);
+
+				f32 distance;
+				v3 normal;
+				if (ray_triangle_mesh_triangle(rayStart, rayDirection, vertices, closestDistance, &distance, &normal))
+				{
+					hit 				= true;
+					closestDistance 	= distance;
+					*outDistance 		= distance;
+					*outNormal 			= normal;
+				}
+			}
+		}
+		else
+		{
+			s32 nearIndex 	= nodeIndex + 1;
+			s32 farIndex 	= index;
+
+			f32 nearDistance 	= node_distance(nearIndex, closestDistance);
+			f32 farDistance 	= node_distance(farIndex, closestDistance);
+
+			if (farDistance < nearDistance)
+			{
+				memory_swap(nearIndex, farIndex);
+				memory_swap(nearDistance, farDistance);
+			}
+
+			if (nearDistance != highest_f32)
+			{
+				if (farDistance != highest_f32)
+				{
+					stack[stackCount++] = {farIndex, farDistance};
+				}
+
+				nodeIndex = nearIndex;
+				continue;
+			}
+		}
+
+		bool32 foundNode = false;
+		while (stackCount > 0 && foundNode == false)
+		{
+			stackCount -= 1;
+			nodeIndex 	= stack[stackCount].nodeIndex;
+			foundNode 	= stack[stackCount].distance < closestDistance;
+		}
+
+		if (foundNode == false)
+		{
+			break;
+		}
+	}
+
+	return hit;
+}
+
+// Note(Leo): Calls 'func(s32 triangle)' for each triangle in leaves whose bounds overlap mesh space 'aabb'
+template<typename TFunc>
+internal void triangle_mesh_query_aabb(TriangleMeshCollider const & mesh, AABB3D aabb, TFunc func)
+{
+	if (mesh.nodeCount == 0)
+	{
+		return;
+	}
+
+	AABB3D quantizedAABB = {triangle_mesh_quantize(mesh, aabb.min), triangle_mesh_quantize(mesh, aabb.max)};
+
+	s32 stack [collision_bvh_max_depth];
+	s32 stackCount = 0;
+
+	stack[stackCount++] = 0;
+
+	while (stackCount > 0)
+	{
+		s32 nodeIndex 						= stack[--stackCount];
+		TriangleMeshBVHNode const & node 	= mesh.nodes[nodeIndex];
+
+		if (aabb_3d_overlaps(triangle_mesh_bvh_node_bounds(node), quantizedAABB) == false)
+		{
+			continue;
+		}
+
+		s32 index = triangle_mesh_bvh_node_index(node);
+		s32 count = triangle_mesh_bvh_node_count(node);
+
+		if (count > 0)
+		{
+			for (s32 triangle = index; triangle < index + count; ++triangle)
+			{
+				func(triangle);
+			}
+		}
+		else
+		{
+			Assert(stackCount + 2 <= collision_bvh_max_depth);
+			stack[stackCount++] = index;
+			stack[stackCount++] = nodeIndex + 1;
+		}
+	}
+}
+
+/// ---------- INSTANCES -------------
+
+struct TriangleMeshInstance
+{
+	TriangleMeshCollider const * mesh;
+
+	m44 	transform;
+	m44 	inverseTransform;
+	AABB3D 	aabb;
+};
+
+internal AABB3D compute_transformed_aabb(AABB3D aabb, m44 const & transform)
+{
+	AABB3D result = aabb_3d_empty();
+	for (s32 corner = 0; corner < 8; ++corner)
+	{
+		v3 point =
+		{
+			corner & 1 ? aabb.max.x : aabb.min.x,
+			corner & 2 ? aabb.max.y : aabb.min.y,
+			corner & 4 ? aabb.max.z : aabb.min.z
+		};
+		result = aabb_3d_grow(result, multiply_point(transform, point));
+	}
+	return result;
+}
+
+internal TriangleMeshInstance make_triangle_mesh_instance(TriangleMeshCollider const & mesh, m44 transform)
+{
+	TriangleMeshInstance instance 	= {};
+	instance.mesh 					= &mesh;
+	instance.transform 				= transform;
+	instance.inverseTransform 		= m44_inverse(transform);
+	instance.aabb 					= compute_transformed_aabb(mesh.bounds, transform);
+	return instance;
+}
+
+/*
+Note(Leo): Ray is world space, and its direction is transformed to mesh space without normalizing,
+so that distances are same in both spaces. Normal is transformed back with inverse transpose, so it
+stays perpendicular to surface with non uniform scale too, and it is turned to face ray.
+*/
+internal bool32 ray_triangle_mesh_collision(TriangleMeshInstance const & instance,
+											v3 rayStart,
+											v3 normalizedRayDirection,
+											f32 maxDistance,
+											f32 * outDistance,
+											v3 * outNormal)
+{
+	if (ray_aabb_3d_distance(rayStart, {1.0f / normalizedRayDirection.x, 1.0f / normalizedRayDirection.y, 1.0f / normalizedRayDirection.z}, maxDistance, instance.aabb) == highest_f32)
+	{
+		return false;
+	}
+
+	m44 const & inverse = instance.inverseTransform;
+
+	v3 localStart 		= multiply_point(inverse, rayStart);
+	v3 localDirection 	= multiply_direction(inverse, normalizedRayDirection);
+
+	f32 distance;
+	v3 localNormal = {};
+	if (ray_triangle_mesh_local(*instance.mesh, localStart, localDirection, maxDistance, &distance, &localNormal) == false)
+	{
+		return false;
+	}
+
+	v3 normal = v3_normalize({	v3_dot(inverse[0].xyz, localNormal),
+								v3_dot(inverse[1].xyz, localNormal),
+								v3_dot(inverse[2].xyz, localNormal) });
+
+	if (v3_dot(normal, normalizedRayDirection) > 0)
+	{
+		normal = -normal;
+	}
+
+	*outDistance 	= distance;
+	*outNormal 		= normal;
+	return true;
+}
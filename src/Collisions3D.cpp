@@ -12,10 +12,59 @@ struct Ray
 	f32 length;
 };
 
+enum ColliderType : s32
+{
+	ColliderType_none,
+
+	ColliderType_submitted_box,
+	ColliderType_submitted_cylinder,
+	ColliderType_static_box,
+	ColliderType_static_cylinder,
+	ColliderType_triangle,
+	ColliderType_submitted_triangle_mesh,
+	ColliderType_static_triangle_mesh,
+	ColliderType_submitted_capsule_tree,
+	ColliderType_terrain,
+};
+
+// Note(Leo): Index is to collider type's array in CollisionSystem3D, or terrain height map's cell
+struct ColliderReference
+{
+	ColliderType 	type;
+	s32 			index;
+};
+
+using CollisionLayerFlags = u32;
+
+// Note(Leo): Raycasts only test collider types whose layer is set
+enum CollisionLayer : CollisionLayerFlags
+{
+	CollisionLayer_submitted_box 		= 1 << ColliderType_submitted_box,
+	CollisionLayer_submitted_cylinder 	= 1 << ColliderType_submitted_cylinder,
+	CollisionLayer_static_box 			= 1 << ColliderType_static_box,
+	CollisionLayer_static_cylinder 		= 1 << ColliderType_static_cylinder,
+	CollisionLayer_triangle 			= 1 << ColliderType_triangle,
+	CollisionLayer_submitted_triangle_mesh 	= 1 << ColliderType_submitted_triangle_mesh,
+	CollisionLayer_static_triangle_mesh 	= 1 << ColliderType_static_triangle_mesh,
+	CollisionLayer_submitted_capsule_tree 	= 1 << ColliderType_submitted_capsule_tree,
+	CollisionLayer_terrain 				= 1 << ColliderType_terrain,
+
+	CollisionLayer_submitted 	= CollisionLayer_submitted_box | CollisionLayer_submitted_cylinder | CollisionLayer_submitted_triangle_mesh
+								| CollisionLayer_submitted_capsule_tree,
+	CollisionLayer_static 		= CollisionLayer_static_box | CollisionLayer_static_cylinder | CollisionLayer_triangle | CollisionLayer_static_triangle_mesh,
+	CollisionLayer_colliders 	= CollisionLayer_submitted | CollisionLayer_static,
+	CollisionLayer_all 			= CollisionLayer_colliders | CollisionLayer_terrain,
+};
+
 struct RaycastResult
 {
 	v3 hitPosition;
 	v3 hitNormal;
+
+	// Note(Leo): Distance along ray, and what was hit. Entity is none for static colliders.
+	f32 				distance;
+	ColliderReference 	collider;
+	EntityReference 	entity;
 };
 
 struct CylinderCollider
@@ -36,17 +85,99 @@ struct TriangleCollider
 	v3 vertices [3];
 };
 
+#include "CollisionBVH.cpp"
+#include "CollisionDynamicTree.cpp"
+#include "CollisionHeightMap.cpp"
+#include "CollisionTriangleMesh.cpp"
+#include "CollisionCapsuleTree.cpp"
+
+/*
+Note(Leo): Submitted colliders are kept from frame to frame. Each frame's submissions are matched
+to last frame's by order, so if same things are submitted in same order, only the ones that moved
+are updated, and only those that left their fat box are moved in the tree.
+*/
+struct SubmittedBoxCollider
+{
+	// Note(Leo): These are as submitted, to see if collider has moved
+	BoxCollider 			collider;
+	m44 					submittedTransform;
+	EntityReference 		entity;
+
+	PrecomputedBoxCollider 	precomputed;
+	AABB3D 					aabb;
+	s32 					proxy;
+};
+
+struct SubmittedCylinderCollider
+{
+	CylinderCollider 	collider;
+	EntityReference 	entity;
+	s32 				proxy;
+};
+
+// Note(Leo): Instance's transform is as submitted, so it is also used to see if collider has moved
+struct SubmittedTriangleMeshCollider
+{
+	TriangleMeshInstance 	instance;
+	EntityReference 		entity;
+	s32 					proxy;
+};
+
+/*
+Note(Leo): Collider is not copied, so it must stay where it is, and it can change between frames.
+Its root box is this collider's proxy, and 'aabb' is that box in world space, from last submission.
+*/
+struct SubmittedCapsuleTreeCollider
+{
+	CapsuleTreeCollider const * collider;
+	v3 							position;
+	AABB3D 						aabb;
+	EntityReference 			entity;
+	s32 						proxy;
+};
+
+enum SubmittedColliderType : s32
+{
+	SubmittedColliderType_box,
+	SubmittedColliderType_cylinder,
+	SubmittedColliderType_triangle_mesh,
+	SubmittedColliderType_capsule_tree,
+};
+
+constexpr s32 collision_system_submitted_collider_capacity = 1000;
+
 struct CollisionSystem3D
 {
 	Array<PrecomputedBoxCollider> 	staticBoxColliders;
 	Array<CylinderCollider> 		staticCylinderColliders;
 
-	Array<PrecomputedBoxCollider> 	submittedBoxColliders;
-	Array<CylinderCollider> 		submittedCylinderColliders;
+	Array<SubmittedBoxCollider> 			submittedBoxColliders;
+	Array<SubmittedCylinderCollider> 		submittedCylinderColliders;
+	Array<SubmittedTriangleMeshCollider> 	submittedTriangleMeshColliders;
+	Array<SubmittedCapsuleTreeCollider> 	submittedCapsuleTreeColliders;
+
+	// Note(Leo): Counts of this frame's submissions so far
+	s32 								submittedBoxCount;
+	s32 								submittedCylinderCount;
+	s32 								submittedTriangleMeshCount;
+	s32 								submittedCapsuleTreeCount;
+
+	// Note(Leo): Proxies of all submitted colliders, see collision_system_submitted_user_data
+	DynamicAABBTree 					submittedTree;
+
+	// Note(Leo): Stats of last submission, for seeing how much tree actually changes
+	s32 								submittedUpdatedCount;
+	s32 								submittedMovedProxyCount;
 
 
 	Array<TriangleCollider>			triangleColliders;
 
+	// Note(Leo): These are few, so they are tested one by one against their bounding boxes
+	Array<TriangleMeshInstance> 	staticTriangleMeshes;
+
+	// Note(Leo): Static boxes and triangles, build with collision_system_build_static_bvh after pushing them
+	CollisionBVH 					staticBVH;
+
 	v3 testTriangleCollider [3] =
 	{
 		{-10, 0, 50},
@@ -57,6 +188,9 @@ struct CollisionSystem3D
 
 	HeightMap 	terrainCollider;
 	v3 			terrainOffset;
+
+	// Note(Leo): For raycasts, build with collision_system_build_terrain_pyramid after setting terrain
+	HeightMapPyramid terrainPyramid;
 };
 
 internal CollisionSystem3D init_collision_system(MemoryArena & allocator)
@@ -66,8 +200,13 @@ internal CollisionSystem3D init_collision_system(MemoryArena & allocator)
 	system.staticBoxColliders = push_array<PrecomputedBoxCollider>(allocator, 100, ALLOC_GARBAGE);
 	// system.staticCylinderColliders = push_array<CylinderCollider>(allocator, 100, ALLOC_GARBAGE);
 
-	system.submittedBoxColliders 		= push_array<PrecomputedBoxCollider>(allocator, 1000, ALLOC_GARBAGE);
-	system.submittedCylinderColliders 	= push_array<CylinderCollider>(allocator, 1000, ALLOC_GARBAGE);
+	system.submittedBoxColliders 		= push_array<SubmittedBoxCollider>(allocator, collision_system_submitted_collider_capacity, ALLOC_GARBAGE);
+	system.submittedCylinderColliders 	= push_array<SubmittedCylinderCollider>(allocator, collision_system_submitted_collider_capacity, ALLOC_GARBAGE);
+	system.submittedTriangleMeshColliders = push_array<SubmittedTriangleMeshCollider>(allocator, collision_system_submitted_collider_capacity, ALLOC_GARBAGE);
+	system.submittedCapsuleTreeColliders = push_array<SubmittedCapsuleTreeCollider>(allocator, collision_system_submitted_collider_capacity, ALLOC_GARBAGE);
+	system.submittedTree 				= make_dynamic_aabb_tree(allocator, 4 * collision_system_submitted_collider_capacity);
+
+	system.staticTriangleMeshes = push_array<TriangleMeshInstance>(allocator, 100, ALLOC_GARBAGE);
 
 	return system;
 }
@@ -88,13 +227,86 @@ internal m44 compute_inverse_box_collider_transform(BoxCollider const & collider
 	return colliderMatrix * transformMatrix;
 }
 
-internal void collision_system_reset_submitted_colliders(CollisionSystem3D & system)
+// Note(Leo): Tree's user data has collider type in lowest two bits and index in submitted array in rest
+internal s32 collision_system_submitted_user_data(SubmittedColliderType type, s32 index)
 {
-	array_flush(system.submittedBoxColliders);
-	array_flush(system.submittedCylinderColliders);
+	return (index << 2) | type;
 }
 
-internal void submit_cylinder_collider(CollisionSystem3D & system, CylinderCollider collider, Transform3D const & transform)
+internal SubmittedColliderType collision_system_submitted_type(s32 userData)
+{
+	return static_cast<SubmittedColliderType>(userData & 3);
+}
+
+internal s32 collision_system_submitted_index(s32 userData)
+{
+	return userData >> 2;
+}
+
+internal AABB3D compute_box_collider_aabb(PrecomputedBoxCollider const & collider)
+{
+	/* Note(Leo): Box is unit cube transformed, so its corners are at +-1, and on each world axis
+	box reaches from center as far as its transformed axes together reach on that axis. */
+	m44 const & transform = collider.transform;
+
+	v3 center 	= transform[3].xyz;
+	v3 halfSize = {};
+	for (s32 axis = 0; axis < 3; ++axis)
+	{
+		v3 axisVector = transform[axis].xyz;
+		halfSize += {abs_f32(axisVector.x), abs_f32(axisVector.y), abs_f32(axisVector.z)};
+	}
+
+	return {center - halfSize, center + halfSize};
+}
+
+internal AABB3D compute_cylinder_collider_aabb(CylinderCollider const & collider)
+{
+	v3 halfSize = {collider.radius, collider.radius, collider.halfHeight};
+	return {collider.center - halfSize, collider.center + halfSize};
+}
+
+// Note(Leo): Call this before submitting this frame's colliders
+internal void collision_system_begin_submitted_colliders(CollisionSystem3D & system)
+{
+	system.submittedBoxCount 			= 0;
+	system.submittedCylinderCount 		= 0;
+	system.submittedTriangleMeshCount 	= 0;
+	system.submittedCapsuleTreeCount 	= 0;
+
+	system.submittedUpdatedCount 	= 0;
+	system.submittedMovedProxyCount = 0;
+}
+
+// Note(Leo): Call this after submitting this frame's colliders, colliders that were not submitted this frame are removed
+internal void collision_system_end_submitted_colliders(CollisionSystem3D & system)
+{
+	while (system.submittedBoxColliders.count > system.submittedBoxCount)
+	{
+		dynamic_aabb_tree_destroy_proxy(system.submittedTree, system.submittedBoxColliders[system.submittedBoxColliders.count - 1].proxy);
+		system.submittedBoxColliders.count -= 1;
+	}
+
+	while (system.submittedCylinderColliders.count > system.submittedCylinderCount)
+	{
+		dynamic_aabb_tree_destroy_proxy(system.submittedTree, system.submittedCylinderColliders[system.submittedCylinderColliders.count - 1].proxy);
+		system.submittedCylinderColliders.count -= 1;
+	}
+
+	while (system.submittedTriangleMeshColliders.count > system.submittedTriangleMeshCount)
+	{
+		dynamic_aabb_tree_destroy_proxy(system.submittedTree, system.submittedTriangleMeshColliders[system.submittedTriangleMeshColliders.count - 1].proxy);
+		system.submittedTriangleMeshColliders.count -= 1;
+	}
+
+	while (system.submittedCapsuleTreeColliders.count > system.submittedCapsuleTreeCount)
+	{
+		dynamic_aabb_tree_destroy_proxy(system.submittedTree, system.submittedCapsuleTreeColliders[system.submittedCapsuleTreeColliders.count - 1].proxy);
+		system.submittedCapsuleTreeColliders.count -= 1;
+	}
+}
+
+internal void submit_cylinder_collider(CollisionSystem3D & system, CylinderCollider collider, Transform3D const & transform, EntityReference entity = {})
 {
 	// Todo(Leo): we should assert these, but there are too many things, so I dont care today
 	// Assert(transform.rotation.w == 1 && "We do not currently support rotated cylinder colliders");
@@ -103,26 +315,185 @@ internal void submit_cylinder_collider(CollisionSystem3D & system, CylinderColli
 	collider.center 	+= transform.position;
 	collider.radius 	*= transform.scale.x;
 	collider.halfHeight *= transform.scale.z;
-	
-	system.submittedCylinderColliders.push(collider);
+
+	s32 index = system.submittedCylinderCount++;
+	AABB3D aabb = compute_cylinder_collider_aabb(collider);
+
+	if (index == system.submittedCylinderColliders.count)
+	{
+		s32 userData = collision_system_submitted_user_data(SubmittedColliderType_cylinder, index);
+		s32 proxy = dynamic_aabb_tree_create_proxy(system.submittedTree, aabb, userData);
+		system.submittedCylinderColliders.push({collider, entity, proxy});
+
+		system.submittedUpdatedCount += 1;
+		return;
+	}
+
+	SubmittedCylinderCollider & submitted = system.submittedCylinderColliders[index];
+	submitted.entity = entity;
+
+	if (memory_equals(&submitted.collider, &collider, sizeof(CylinderCollider)) == false)
+	{
+		v3 displacement 	= collider.center - submitted.collider.center;
+		submitted.collider 	= collider;
+
+		system.submittedUpdatedCount 	+= 1;
+		system.submittedMovedProxyCount += dynamic_aabb_tree_move_proxy(system.submittedTree, submitted.proxy, aabb, displacement) ? 1 : 0;
+	}
 }
 
-internal void submit_box_collider(CollisionSystem3D & system, BoxCollider collider, m44 & transformMatrix)
+internal void submit_box_collider(CollisionSystem3D & system, BoxCollider collider, m44 transformMatrix, EntityReference entity = {})
 {
+	s32 index = system.submittedBoxCount++;
+
+	bool32 isNew = index == system.submittedBoxColliders.count;
+	if (isNew)
+	{
+		system.submittedBoxColliders.push({});
+	}
+
+	SubmittedBoxCollider & submitted = system.submittedBoxColliders[index];
+	submitted.entity = entity;
+
+	bool32 hasChanged 	= isNew
+						|| memory_equals(&submitted.submittedTransform, &transformMatrix, sizeof(m44)) == false
+						|| memory_equals(&submitted.collider, &collider, sizeof(BoxCollider)) == false;
+
+	if (hasChanged == false)
+	{
+		return;
+	}
+
 	m44 colliderMatrix 			= transform_matrix(collider.center, collider.orientation, collider.extents);
 	m44 inverseColliderMatrix 	= inverse_transform_matrix(collider.center, collider.orientation, collider.extents);
 	m44 inverseTransformMatrix 	= m44_inverse(transformMatrix);
 
-	system.submittedBoxColliders.push({transformMatrix * colliderMatrix, inverseColliderMatrix * inverseTransformMatrix});
+	submitted.collider 				= collider;
+	submitted.submittedTransform 	= transformMatrix;
+	submitted.precomputed 			= {transformMatrix * colliderMatrix, inverseColliderMatrix * inverseTransformMatrix};
+
+	AABB3D aabb = compute_box_collider_aabb(submitted.precomputed);
+
+	if (isNew)
+	{
+		s32 userData 	= collision_system_submitted_user_data(SubmittedColliderType_box, index);
+		submitted.proxy = dynamic_aabb_tree_create_proxy(system.submittedTree, aabb, userData);
+	}
+	else
+	{
+		v3 displacement = aabb_3d_center(aabb) - aabb_3d_center(submitted.aabb);
+		system.submittedMovedProxyCount += dynamic_aabb_tree_move_proxy(system.submittedTree, submitted.proxy, aabb, displacement) ? 1 : 0;
+	}
+
+	submitted.aabb = aabb;
+	system.submittedUpdatedCount += 1;
 };
 
-internal void submit_box_collider(CollisionSystem3D & system, BoxCollider collider, Transform3D const & transform)
+internal void submit_box_collider(CollisionSystem3D & system, BoxCollider collider, Transform3D const & transform, EntityReference entity = {})
 {
-	m44 transformMatrix = compute_box_collider_transform(collider, transform);
-	m44 inverseMatrix 	= compute_inverse_box_collider_transform(collider, transform);
-	system.submittedBoxColliders.push({transformMatrix, inverseMatrix});
+	submit_box_collider(system, collider, transform_matrix(transform), entity);
 }	
 
+// Note(Leo): Mesh is not copied, and it must stay alive as long as collider is submitted
+internal void submit_triangle_mesh_collider(CollisionSystem3D & system, TriangleMeshCollider const & mesh, m44 transformMatrix, EntityReference entity = {})
+{
+	s32 index = system.submittedTriangleMeshCount++;
+
+	bool32 isNew = index == system.submittedTriangleMeshColliders.count;
+	if (isNew)
+	{
+		system.submittedTriangleMeshColliders.push({});
+	}
+
+	SubmittedTriangleMeshCollider & submitted = system.submittedTriangleMeshColliders[index];
+	submitted.entity = entity;
+
+	bool32 hasChanged 	= isNew
+						|| submitted.instance.mesh != &mesh
+						|| memory_equals(&submitted.instance.transform, &transformMatrix, sizeof(m44)) == false;
+
+	if (hasChanged == false)
+	{
+		return;
+	}
+
+	AABB3D previousAABB = submitted.instance.aabb;
+	submitted.instance 	= make_triangle_mesh_instance(mesh, transformMatrix);
+
+	if (isNew)
+	{
+		s32 userData 	= collision_system_submitted_user_data(SubmittedColliderType_triangle_mesh, index);
+		submitted.proxy = dynamic_aabb_tree_create_proxy(system.submittedTree, submitted.instance.aabb, userData);
+	}
+	else
+	{
+		v3 displacement = aabb_3d_center(submitted.instance.aabb) - aabb_3d_center(previousAABB);
+		system.submittedMovedProxyCount += dynamic_aabb_tree_move_proxy(system.submittedTree, submitted.proxy, submitted.instance.aabb, displacement) ? 1 : 0;
+	}
+
+	system.submittedUpdatedCount += 1;
+}
+
+/*
+Note(Leo): Collider is only in system's tree with its bounding box, so when its capsules change, this
+only needs to compare that box, and usually it stays inside its fat box. Empty colliders are not
+submitted at all.
+*/
+internal void submit_capsule_tree_collider(CollisionSystem3D & system, CapsuleTreeCollider const & collider, v3 position, EntityReference entity = {})
+{
+	if (collider.capsules.count == 0)
+	{
+		return;
+	}
+
+	s32 index = system.submittedCapsuleTreeCount++;
+
+	bool32 isNew = index == system.submittedCapsuleTreeColliders.count;
+	if (isNew)
+	{
+		system.submittedCapsuleTreeColliders.push({});
+	}
+
+	SubmittedCapsuleTreeCollider & submitted = system.submittedCapsuleTreeColliders[index];
+	submitted.collider 	= &collider;
+	submitted.entity 	= entity;
+
+	AABB3D bounds 	= capsule_tree_collider_bounds(collider);
+	AABB3D aabb 	= {bounds.min + position, bounds.max + position};
+
+	bool32 hasChanged 	= isNew
+						|| memory_equals(&submitted.aabb, &aabb, sizeof(AABB3D)) == false;
+
+	if (hasChanged == false)
+	{
+		return;
+	}
+
+	v3 displacement 	= position - submitted.position;
+	submitted.position 	= position;
+	submitted.aabb 		= aabb;
+
+	if (isNew)
+	{
+		s32 userData 	= collision_system_submitted_user_data(SubmittedColliderType_capsule_tree, index);
+		submitted.proxy = dynamic_aabb_tree_create_proxy(system.submittedTree, aabb, userData);
+	}
+	else
+	{
+		system.submittedMovedProxyCount += dynamic_aabb_tree_move_proxy(system.submittedTree, submitted.proxy, aabb, displacement) ? 1 : 0;
+	}
+
+	system.submittedUpdatedCount += 1;
+}
+
+// Note(Leo): Returns index of collider. Mesh is not copied.
+internal s32 push_static_triangle_mesh_collider(CollisionSystem3D & system, TriangleMeshCollider const & mesh, m44 transformMatrix)
+{
+	s32 index = system.staticTriangleMeshes.count;
+	system.staticTriangleMeshes.push(make_triangle_mesh_instance(mesh, transformMatrix));
+	return index;
+}
+
 internal void push_static_box_collider(CollisionSystem3D & system, BoxCollider collider, m44 & transformMatrix)
 {
 	m44 colliderMatrix 			= transform_matrix(collider.center, collider.orientation, collider.extents);
@@ -139,8 +510,18 @@ internal void push_static_box_collider(CollisionSystem3D & system, BoxCollider c
 	system.staticBoxColliders.push({transformMatrix, inverseMatrix});
 }	
 
+internal void collision_system_build_static_bvh(CollisionSystem3D & system, MemoryArena & allocator)
+{
+	system.staticBVH = make_collision_bvh(allocator, system.staticBoxColliders, system.triangleColliders);
+}
+
 /// -------------- TERRAIN ---------------
 
+internal void collision_system_build_terrain_pyramid(CollisionSystem3D & system, MemoryArena & allocator)
+{
+	system.terrainPyramid = make_height_map_pyramid(allocator, system.terrainCollider);
+}
+
 internal f32 get_terrain_height(CollisionSystem3D const & system, v2 position)
 {
 	position.x -= system.terrainOffset.x;
@@ -267,306 +648,548 @@ static bool ray_triangle_collision (Ray const & ray, v3 const triangleCorners[3]
 
 /// ----------- COLLISION MATH ---------------
 
-internal bool32 ray_box_collisions(	Array<PrecomputedBoxCollider> & colliders,
+/*
+Note(Leo): Distances here are along world space ray. Box's inverse transform scales ray direction,
+but not the parameter, so that same distance gives same point in both spaces.
+*/
+internal bool32 ray_box_collision(	PrecomputedBoxCollider const & collider,
 									v3 rayStart,
 									v3 normalizedRayDirection,
 									f32 rayLength,
-									RaycastResult * outResult,
-									f32 * rayHitSquareDistance)
+									f32 * outDistance,
+									v3 * outNormal)
 {
-	bool32 hit = false;
+	v3 colliderSpaceRayStart 		= multiply_point(collider.inverseTransform, rayStart);
+	v3 colliderSpaceRayDirection 	= multiply_direction(collider.inverseTransform, normalizedRayDirection);  
 
-	for (auto const & collider : colliders)
+	v3 min = {-1,-1,-1};
+	v3 max = {1,1,1};
+
+	v3 inverseDirection = 
 	{
-		v3 colliderSpaceRayStart 		= multiply_point(collider.inverseTransform, rayStart);
-		v3 colliderSpaceRayDirection 	= multiply_direction(collider.inverseTransform, normalizedRayDirection);  
+		1.0f / colliderSpaceRayDirection.x,
+		1.0f / colliderSpaceRayDirection.y,
+		1.0f / colliderSpaceRayDirection.z,
+	};
 
-		// Study(Leo): this seems to work, but I still have concerns
-		f32 colliderSpaceRayLength = rayLength;
-		{
-			v3 worldSpaceRay 		= normalizedRayDirection * rayLength;
-			v3 colliderSpaceRay 	= multiply_direction(collider.inverseTransform, worldSpaceRay);
-			colliderSpaceRayLength 	= v3_length(colliderSpaceRay);
-		}
 
-		v3 min = {-1,-1,-1};
-		v3 max = {1,1,1};
+	// Todo(Leo): remove swaps, just put assignements directly to if blocks
+	f32 xDistanceToMin = (min.x - colliderSpaceRayStart.x) * inverseDirection.x;
+	f32 xDistanceToMax = (max.x - colliderSpaceRayStart.x) * inverseDirection.x;
+	if (inverseDirection.x < 0)
+	{
+		memory_swap(xDistanceToMin, xDistanceToMax);
+	}
 
-		v3 inverseDirection = 
-		{
-			1.0f / colliderSpaceRayDirection.x,
-			1.0f / colliderSpaceRayDirection.y,
-			1.0f / colliderSpaceRayDirection.z,
-		};
+	f32 yDistanceToMin = (min.y - colliderSpaceRayStart.y) * inverseDirection.y;
+	f32 yDistanceToMax = (max.y - colliderSpaceRayStart.y) * inverseDirection.y;
+	if (inverseDirection.y < 0)
+	{
+		memory_swap(yDistanceToMin, yDistanceToMax);
+	}
+	
+	f32 zDistanceToMin = (min.z - colliderSpaceRayStart.z) * inverseDirection.z;
+	f32 zDistanceToMax = (max.z - colliderSpaceRayStart.z) * inverseDirection.z;
+	if (inverseDirection.z < 0)
+	{
+		memory_swap(zDistanceToMin, zDistanceToMax);
+	}
+
+	// Note(Leo): if any min distance is more than any max distance
+	if ((xDistanceToMin > yDistanceToMax) || (yDistanceToMin > xDistanceToMax))
+	{
+		// no collision
+		return false;
+	}			
+
+	f32 distanceToMin = f32_max(xDistanceToMin, yDistanceToMin);
+	f32 distanceToMax = f32_min(xDistanceToMax, yDistanceToMax);
+	
 
+	if ((distanceToMin > zDistanceToMax) || (zDistanceToMin > distanceToMax))
+	{
+		// no collision
+		return false;
+	}			
+
+	distanceToMin = f32_max(distanceToMin, zDistanceToMin);
+	distanceToMax = f32_min(distanceToMax, zDistanceToMax);
+
+	if (0.00001f < distanceToMin && distanceToMin < rayLength)
+	{
+		*outDistance = distanceToMin;
 
-		// Todo(Leo): remove swaps, just put assignements directly to if blocks
-		f32 xDistanceToMin = (min.x - colliderSpaceRayStart.x) * inverseDirection.x;
-		f32 xDistanceToMax = (max.x - colliderSpaceRayStart.x) * inverseDirection.x;
-		if (inverseDirection.x < 0)
+		// Note(Leo): Find maximum since biggest af smallest is the distance of hit
+		v3 colliderSpaceNormal;
+		if (xDistanceToMin > yDistanceToMin && xDistanceToMin > zDistanceToMin)
 		{
-			memory_swap(xDistanceToMin, xDistanceToMax);
+			colliderSpaceNormal = {-sign_f32(colliderSpaceRayDirection.x), 0, 0};
 		}
-
-		f32 yDistanceToMin = (min.y - colliderSpaceRayStart.y) * inverseDirection.y;
-		f32 yDistanceToMax = (max.y - colliderSpaceRayStart.y) * inverseDirection.y;
-		if (inverseDirection.y < 0)
+		else if (yDistanceToMin > zDistanceToMin)
 		{
-			memory_swap(yDistanceToMin, yDistanceToMax);
+			colliderSpaceNormal = {0, -sign_f32(colliderSpaceRayDirection.y), 0};
 		}
-		
-		f32 zDistanceToMin = (min.z - colliderSpaceRayStart.z) * inverseDirection.z;
-		f32 zDistanceToMax = (max.z - colliderSpaceRayStart.z) * inverseDirection.z;
-		if (inverseDirection.z < 0)
+		else
 		{
-			memory_swap(zDistanceToMin, zDistanceToMax);
+			colliderSpaceNormal = {0, 0, -sign_f32(colliderSpaceRayDirection.z)};
 		}
 
-		// Note(Leo): if any min distance is more than any max distance
-		if ((xDistanceToMin > yDistanceToMax) || (yDistanceToMin > xDistanceToMax))
-		{
-			// no collision
-			continue;
-		}			
+		// Note(Leo): This is only supporting axis-aligned colliders
+		*outNormal = v3_normalize(multiply_direction(collider.transform, colliderSpaceNormal));
 
-		f32 distanceToMin = f32_max(xDistanceToMin, yDistanceToMin);
-		f32 distanceToMax = f32_min(xDistanceToMax, yDistanceToMax);
-		
+		return true;
+	}
 
-		if ((distanceToMin > zDistanceToMax) || (zDistanceToMin > distanceToMax))
-		{
-			// no collision
-			continue;
-		}			
+	return false;
+}
 
-		distanceToMin = f32_max(distanceToMin, zDistanceToMin);
-		distanceToMax = f32_min(distanceToMax, zDistanceToMax);
+internal bool32 ray_cylinder_collision (CylinderCollider const & collider, Ray ray, f32 * outDistance, v3 * outNormal)
+{
+	v3 const center = collider.center;
+	v3 const p = ray.start - center;
+	v3 const v = ray.direction;
+	f32 const halfHeight = collider.halfHeight;
 
-		if (0.00001f < distanceToMin && distanceToMin < colliderSpaceRayLength)
+	f32 closestDistance = ray.length;
+	bool32 hit 			= false;
+
+	f32 vt0 = (halfHeight - p.z) / v.z;
+	f32 vt1 = (-halfHeight - p.z) / v.z;
+
+	f32 vtMin = f32_min(vt0, vt1);
+
+	if (vtMin > 0.00001f && vtMin < closestDistance)
+	{
+		v3 pAtVttMin = p + v * vtMin;
+		f32 distanceFromCenter = v2_length(pAtVttMin.xy);
+		if (distanceFromCenter < collider.radius)
 		{
-			hit = true;
+			hit 			= true;
+			closestDistance = vtMin;
 
-			v3 colliderSpaceHitPosition = colliderSpaceRayStart + colliderSpaceRayDirection * distanceToMin;
-			v3 hitPosition = multiply_point(collider.transform, colliderSpaceHitPosition);
-			f32 sqrDistance = v3_sqr_length(hitPosition - rayStart);
+			*outDistance 	= vtMin;
+			*outNormal 		= {0,0,1};
+		}
+	}
 
-			if (sqrDistance < *rayHitSquareDistance)
-			{
-				*rayHitSquareDistance = sqrDistance;
 
-				// Note(Leo): This is only supporting axis-aligned colliders
-				if (outResult != nullptr)
-				{
-					// Note(Leo): Find maximum since biggest af smallest is the distance of hit
-					if (xDistanceToMin > yDistanceToMin && xDistanceToMin > zDistanceToMin)
-					{
-						outResult->hitNormal = {-sign_f32(colliderSpaceRayDirection.x), 0, 0};
-					}
-					else if (yDistanceToMin > zDistanceToMin)
-					{
-						outResult->hitNormal = {0, -sign_f32(colliderSpaceRayDirection.y), 0};
-					}
-					else
-					{
-						outResult->hitNormal = {0, 0, -sign_f32(colliderSpaceRayDirection.z)};
-					}
-
-					outResult->hitPosition 	= 	colliderSpaceRayStart
-												+ colliderSpaceRayDirection
-												* distanceToMin;
-
-					outResult->hitPosition = multiply_point(collider.transform, outResult->hitPosition);
-
-					outResult->hitNormal = multiply_direction(collider.transform, outResult->hitNormal);
-					outResult->hitNormal = v3_normalize(outResult->hitNormal);
-				}
+	// Quadratic form for ray stuff
+	// Note(Leo): these seem like dot products
+	f32 a = square_f32(v.x) + square_f32(v.y);
+	f32 b = 2 * (p.x * v.x + p.y * v.y);
+	f32 c = square_f32(p.x) + square_f32(p.y);
 
-			}
 
-			// f32 sqrDistance = v3_sqr_length(outResult->hitPosition, rayStart);
-			// if (sqr)
-			// rayHitSquareDistance = 
-			// // return true;
+	// Undefined
+	if (abs_f32(a) < 0.00001f)
+	{
+		return hit;
+	}
+
+	// We are looking solutions for r2, not 0
+	f32 cr2 = c - square_f32(collider.radius);
+
+	// discriminant
+	f32 D = b * b - 4 * a * cr2;
+
+	// No roots no collisions
+	// Also one root, no collision
+	if (D < 0.00001f)
+	{
+		return hit;
+	}
+
+	f32 sqrtD = f32_sqr_root(D);
+	f32 ht0 = (-b - sqrtD) / (2 * a);
+	f32 ht1 = (-b + sqrtD) / (2 * a);
+
+	f32 ht = f32_min(ht0, ht1);
+
+	if (ht > 0.00001f && ht < closestDistance)
+	{
+		v3 pAtHtMin = p + v * ht;
+		if (pAtHtMin.z > -halfHeight && pAtHtMin.z < halfHeight)
+		{
+			hit = true;
+
+			// Note(Leo): Hitposition - center, is weird
+			v3 hitNormal 	= pAtHtMin;
+			hitNormal.z 	= 0;
+
+			*outDistance 	= ht;
+			*outNormal 		= v3_normalize(hitNormal);
 		}
 	}
+
 	return hit;
 }
 
-internal bool32 ray_cylinder_collisions (Array<CylinderCollider> colliders, Ray ray, RaycastResult * outResult, f32 * rayHitSquareDistance)
-{
-	bool32 hit = false;
+/// ----------- RAYCASTS ---------------
+
+/*
+Note(Leo): All of these find only hits that are closer than 'closestDistance', and update it when
+they do. That way each collider set after first one is pruned by what was already hit, and result
+is closest hit no matter which order sets are tested in. 'outResult' is only written when closer
+hit is found, and it can be null.
+*/
 
-	for (auto const & collider : colliders)
-	// for (s32 i = 0; i < count; ++i)
+internal EntityReference collision_system_get_entity(CollisionSystem3D const & system, ColliderReference collider)
+{
+	switch (collider.type)
 	{
-		// auto & collider = colliders[i];
+		case ColliderType_submitted_box: 		return system.submittedBoxColliders.memory[collider.index].entity;
+		case ColliderType_submitted_cylinder: 	return system.submittedCylinderColliders.memory[collider.index].entity;
+		case ColliderType_submitted_triangle_mesh: 	return system.submittedTriangleMeshColliders.memory[collider.index].entity;
+		case ColliderType_submitted_capsule_tree: 	return system.submittedCapsuleTreeColliders.memory[collider.index].entity;
 
-		v3 const center = collider.center;
-		v3 const p = ray.start - center;
-		v3 const v = ray.direction;
-		f32 const halfHeight = collider.halfHeight;
+		default:
+			return {};
+	}
+}
 
-		f32 vt0 = (halfHeight - p.z) / v.z;
-		f32 vt1 = (-halfHeight - p.z) / v.z;
+internal RaycastResult make_raycast_result(CollisionSystem3D const & system, Ray const & ray, f32 distance, v3 normal, ColliderReference collider)
+{
+	RaycastResult result 	= {};
+	result.hitPosition 		= ray.start + ray.direction * distance;
+	result.hitNormal 		= normal;
+	result.distance 		= distance;
+	result.collider 		= collider;
+	result.entity 			= collision_system_get_entity(system, collider);
+	return result;
+}
 
-		f32 vtMin = f32_min(vt0, vt1);
+// Note(Leo): Result's collider has 'colliderType' and index in 'colliders'
+internal bool32 ray_box_collisions(	Array<PrecomputedBoxCollider> const & colliders,
+									ColliderType colliderType,
+									Ray ray,
+									RaycastResult * outResult,
+									f32 * closestDistance)
+{
+	bool32 hit = false;
 
-		if (vtMin > 0.00001f && vtMin < ray.length)
+	for (s32 i = 0; i < colliders.count; ++i)
+	{
+		f32 distance;
+		v3 normal;
+
+		if (ray_box_collision(colliders.memory[i], ray.start, ray.direction, f32_min(ray.length, *closestDistance), &distance, &normal))
 		{
-			v3 pAtVttMin = p + v * vtMin;
-			f32 distanceFromCenter = v2_length(pAtVttMin.xy);
-			if (distanceFromCenter < collider.radius)
+			hit 				= true;
+			*closestDistance 	= distance;
+
+			if (outResult != nullptr)
 			{
-				hit = true;
+				*outResult = {ray.start + ray.direction * distance, normal, distance, {colliderType, i}, {}};
+			}
+		}
+	}
+	return hit;
+}
 
-				if (*rayHitSquareDistance > vtMin * vtMin)
-				{
-					*rayHitSquareDistance = vtMin * vtMin;					
+// Note(Leo): Result's collider has 'colliderType' and index in 'colliders'
+internal bool32 ray_cylinder_collisions (	Array<CylinderCollider> const & colliders,
+											ColliderType colliderType,
+											Ray ray,
+											RaycastResult * outResult,
+											f32 * closestDistance)
+{
+	bool32 hit = false;
 
-					outResult->hitPosition = pAtVttMin + center;
-					outResult->hitNormal = {0,0,1};
-				}
+	for (s32 i = 0; i < colliders.count; ++i)
+	{
+		f32 distance;
+		v3 normal;
+
+		if (ray_cylinder_collision(colliders.memory[i], {ray.start, ray.direction, f32_min(ray.length, *closestDistance)}, &distance, &normal))
+		{
+			hit 				= true;
+			*closestDistance 	= distance;
+
+			if (outResult != nullptr)
+			{
+				*outResult = {ray.start + ray.direction * distance, normal, distance, {colliderType, i}, {}};
 			}
 		}
+	}	
 
+	return hit;
+}
 
-		// Quadratic form for ray stuff
-		// Note(Leo): these seem like dot products
-		f32 a = square_f32(v.x) + square_f32(v.y);
-		f32 b = 2 * (p.x * v.x + p.y * v.y);
-		f32 c = square_f32(p.x) + square_f32(p.y);
+// Note(Leo): Submitted boxes, cylinders, triangle meshes and capsule trees, all are in same dynamic tree
+internal bool32 ray_submitted_collisions(	CollisionSystem3D const & system,
+											Ray ray,
+											CollisionLayerFlags layers,
+											RaycastResult * outResult,
+											f32 * closestDistance)
+{
+	if ((layers & CollisionLayer_submitted) == 0)
+	{
+		return false;
+	}
 
+	RaycastResult closestResult;
 
-		// Undefined
-		if (abs_f32(a) < 0.00001f)
-		{
-			continue;
-		}
+	auto test_proxy = [&](s32 userData, f32 closestDistance) -> f32
+	{
+		SubmittedColliderType type 	= collision_system_submitted_type(userData);
+		s32 index 					= collision_system_submitted_index(userData);
 
-		// We are looking solutions for r2, not 0
-		f32 cr2 = c - square_f32(collider.radius);
+		f32 distance;
+		v3 normal;
+		bool32 hit = false;
 
-		// discriminant
-		f32 D = b * b - 4 * a * cr2;
+		ColliderReference collider;
 
-		// No roots no collisions
-		// Also one root, no collision
-		if (D < 0.00001f)
+		if (type == SubmittedColliderType_box)
 		{
-			continue;
+			collider = {ColliderType_submitted_box, index};
+			if (layers & CollisionLayer_submitted_box)
+			{
+				hit = ray_box_collision(system.submittedBoxColliders.memory[index].precomputed, ray.start, ray.direction, closestDistance, &distance, &normal);
+			}
+		}
+		else if (type == SubmittedColliderType_cylinder)
+		{
+			collider = {ColliderType_submitted_cylinder, index};
+			if (layers & CollisionLayer_submitted_cylinder)
+			{
+				hit = ray_cylinder_collision(system.submittedCylinderColliders.memory[index].collider, {ray.start, ray.direction, closestDistance}, &distance, &normal);
+			}
+		}
+		else if (type == SubmittedColliderType_triangle_mesh)
+		{
+			collider = {ColliderType_submitted_triangle_mesh, index};
+			if (layers & CollisionLayer_submitted_triangle_mesh)
+			{
+				hit = ray_triangle_mesh_collision(system.submittedTriangleMeshColliders.memory[index].instance, ray.start, ray.direction, closestDistance, &distance, &normal);
+			}
+		}
+		else
+		{
+			collider = {ColliderType_submitted_capsule_tree, index};
+			if (layers & CollisionLayer_submitted_capsule_tree)
+			{
+				SubmittedCapsuleTreeCollider const & submitted = system.submittedCapsuleTreeColliders.memory[index];
+				hit = ray_capsule_tree_collision(*submitted.collider, submitted.position, ray.start, ray.direction, closestDistance, &distance, &normal);
+			}
 		}
 
-		f32 sqrtD = f32_sqr_root(D);
-		f32 ht0 = (-b - sqrtD) / (2 * a);
-		f32 ht1 = (-b + sqrtD) / (2 * a);
+		if (hit)
+		{
+			closestResult = make_raycast_result(system, ray, distance, normal, collider);
+			return distance;
+		}
 
-		f32 ht = f32_min(ht0, ht1);
+		return highest_f32;
+	};
 
-		if (ht > 0.00001f && ht < ray.length)
-		{
-			v3 pAtHtMin = p + v * ht;
-			if (pAtHtMin.z > -halfHeight && pAtHtMin.z < halfHeight)
-			{
-				hit = true;
-				if (*rayHitSquareDistance > ht*ht)
-				{
-					*rayHitSquareDistance = ht*ht;
+	f32 maxDistance = f32_min(ray.length, *closestDistance);
+	f32 distance 	= dynamic_aabb_tree_raycast(system.submittedTree, ray.start, ray.direction, maxDistance, test_proxy);
 
-					outResult->hitPosition = pAtHtMin + center;
+	if (distance == highest_f32)
+	{
+		return false;
+	}
 
-					// Note(Leo): Hitposition - center, is weird
-					v3 hitNormal = p + v * ht;
-					hitNormal.z = 0;
-					hitNormal = v3_normalize(hitNormal);
-					outResult->hitNormal = hitNormal;
-				}
-			}
-		}
-	}	
+	*closestDistance = distance;
+	if (outResult != nullptr)
+	{
+		*outResult = closestResult;
+	}
 
-	return hit;
+	return true;
 }
 
-internal bool32
-raycast_3d(	CollisionSystem3D * system,
-			v3 rayStart,
-			v3 normalizedRayDirection,
-			f32 rayLength,
-			RaycastResult * outResult = nullptr)
+/*
+Note(Leo): Static boxes and triangles that are in bvh are found from there, and ones pushed after
+building it are tested one by one. Static cylinders and triangle meshes are few, and they are also
+tested one by one.
+*/
+internal bool32 ray_static_collisions(	CollisionSystem3D const & system,
+										Ray ray,
+										CollisionLayerFlags layers,
+										RaycastResult * outResult,
+										f32 * closestDistance)
 {
-	// https://www.scratchapixel.com/lessons/3d-basic-rendering/minimal-ray-tracer-rendering-simple-shapes/ray-box-intersection
+	CollisionBVH const & bvh = system.staticBVH;
 
-	f32 rayHitSquareDistance 	= highest_f32;
-	bool32 hit 					= false;
+	bool32 hit = false;
 
-	hit = hit || ray_box_collisions(system->submittedBoxColliders, rayStart, normalizedRayDirection, rayLength, outResult, &rayHitSquareDistance);
-	hit = hit || ray_box_collisions(system->staticBoxColliders, rayStart, normalizedRayDirection, rayLength, outResult, &rayHitSquareDistance);
+	if (layers & CollisionLayer_static_cylinder)
+	{
+		hit = ray_cylinder_collisions(system.staticCylinderColliders, ColliderType_static_cylinder, ray, outResult, closestDistance);
+	}
 
-	hit = hit || ray_cylinder_collisions(	system->staticCylinderColliders,
-											{rayStart, normalizedRayDirection, rayLength},
-											outResult,
-											&rayHitSquareDistance);
+	if (layers & CollisionLayer_static_triangle_mesh)
+	{
+		for (s32 i = 0; i < system.staticTriangleMeshes.count; ++i)
+		{
+			f32 distance;
+			v3 normal;
 
-	hit = hit || ray_cylinder_collisions(	system->submittedCylinderColliders,
-											{rayStart, normalizedRayDirection, rayLength},
-											outResult,
-											&rayHitSquareDistance);
+			if (ray_triangle_mesh_collision(system.staticTriangleMeshes.memory[i], ray.start, ray.direction, f32_min(ray.length, *closestDistance), &distance, &normal))
+			{
+				hit 				= true;
+				*closestDistance 	= distance;
 
+				if (outResult != nullptr)
+				{
+					*outResult = make_raycast_result(system, ray, distance, normal, {ColliderType_static_triangle_mesh, i});
+				}
+			}
+		}
+	}
+
+	if ((layers & (CollisionLayer_static_box | CollisionLayer_triangle)) == 0)
 	{
-		Ray ray =
-		{
-			.start 		= rayStart,
-			.direction 	= normalizedRayDirection,
-			.length 	= rayLength
-		};
+		return hit;
+	}
 
-		for (TriangleCollider const & triangle : system->triangleColliders)
-		{
-			RaycastResult rayResult;
-			bool hit2 = ray_triangle_collision(ray, triangle.vertices, &rayResult);
+	RaycastResult closestResult;
 
-			if (hit2 && v3_sqr_length(rayStart - rayResult.hitPosition))
+	auto test_reference = [&](StaticColliderReference reference, f32 closestDistance) -> f32
+	{
+		f32 distance = highest_f32;
+
+		if (reference.type == StaticColliderType_box)
+		{
+			v3 normal;
+			if ((layers & CollisionLayer_static_box)
+				&& ray_box_collision(system.staticBoxColliders.memory[reference.index], ray.start, ray.direction, closestDistance, &distance, &normal))
 			{
-				*outResult 	= rayResult;
-				hit 		= hit2;
+				closestResult = make_raycast_result(system, ray, distance, normal, {ColliderType_static_box, reference.index});
+			}
+			else
+			{
+				distance = highest_f32;
+			}
+		}
+		else if (layers & CollisionLayer_triangle)
+		{
+			RaycastResult triangleResult;
+			if (ray_triangle_collision(ray, system.triangleColliders.memory[reference.index].vertices, &triangleResult))
+			{
+				f32 triangleDistance = v3_dot(triangleResult.hitPosition - ray.start, ray.direction);
+				if (triangleDistance < closestDistance)
+				{
+					distance 		= triangleDistance;
+					closestResult 	= make_raycast_result(system, ray, distance, triangleResult.hitNormal, {ColliderType_triangle, reference.index});
+				}
 			}
 		}
 
+		return distance;
+	};
+
+	f32 maxDistance = f32_min(ray.length, *closestDistance);
+	f32 distance 	= ray_collision_bvh(bvh, ray.start, ray.direction, maxDistance, test_reference);
+
+	for (s32 i = bvh.boxCount; i < system.staticBoxColliders.count; ++i)
+	{
+		f32 boxDistance = test_reference({StaticColliderType_box, i}, f32_min(distance, maxDistance));
+		distance 		= f32_min(distance, boxDistance);
+	}
+
+	for (s32 i = bvh.triangleCount; i < system.triangleColliders.count; ++i)
+	{
+		f32 triangleDistance 	= test_reference({StaticColliderType_triangle, i}, f32_min(distance, maxDistance));
+		distance 				= f32_min(distance, triangleDistance);
+	}
+
+	if (distance == highest_f32)
+	{
+		return hit;
+	}
+
+	*closestDistance = distance;
+	if (outResult != nullptr)
+	{
+		*outResult = closestResult;
+	}
 
-		// RaycastResult testTriangleResult;
-		// bool testTriangleHit 	= ray_triangle_collision(ray, system->testTriangleCollider, &testTriangleResult);
+	return true;
+}
 
+internal bool32 ray_terrain_collision(	CollisionSystem3D const & system,
+										Ray ray,
+										CollisionLayerFlags layers,
+										RaycastResult * outResult,
+										f32 * closestDistance)
+{
+	if ((layers & CollisionLayer_terrain) == 0)
+	{
+		return false;
+	}
 
+	f32 distance;
+	v3 normal;
+	s32 cellIndex;
 
+	f32 maxDistance = f32_min(ray.length, *closestDistance);
+	if (ray_height_map_collision(system.terrainCollider, system.terrainPyramid, system.terrainOffset, ray, maxDistance, &distance, &normal, &cellIndex))
+	{
+		*closestDistance = distance;
+		if (outResult != nullptr)
+		{
+			*outResult = make_raycast_result(system, ray, distance, normal, {ColliderType_terrain, cellIndex});
+		}
+		return true;
+	}
 
+	return false;
+}
 
-		// f32 sqrDistance 		= v3_sqr_length(ray.start - testTriangleResult.hitPosition);
+/*
+Note(Leo): Finds closest hit among all colliders on 'layers'. Result tells also which collider was
+hit, and which entity it belongs to, if it was submitted with one.
+*/
+internal bool32
+raycast_3d(	CollisionSystem3D * system,
+			v3 rayStart,
+			v3 normalizedRayDirection,
+			f32 rayLength,
+			RaycastResult * outResult = nullptr,
+			CollisionLayerFlags layers = CollisionLayer_all)
+{
+	// https://www.scratchapixel.com/lessons/3d-basic-rendering/minimal-ray-tracer-rendering-simple-shapes/ray-box-intersection
 
-		// if (testTriangleHit)
-		// {
-		// 	// log_debug("RAY HIT: ", f32_sqr_root(sqrDistance));
+	Ray ray =
+	{
+		.start 		= rayStart,
+		.direction 	= normalizedRayDirection,
+		.length 	= rayLength
+	};
 
-		// 	if (sqrDistance < rayHitSquareDistance)
-		// 	{
-		// 		*outResult 	= testTriangleResult;
-		// 		hit 		= testTriangleHit;
-		// 	}
-		// }
-		// else
-		// {
-		// 	log_debug("RAY MISS: ", f32_sqr_root(sqrDistance));
-		// }
+	f32 closestDistance = rayLength;
+	bool32 hit 			= false;
+
+	if (ray_submitted_collisions(*system, ray, layers, outResult, &closestDistance))
+	{
+		hit = true;
+	}
+
+	if (ray_static_collisions(*system, ray, layers, outResult, &closestDistance))
+	{
+		hit = true;
+	}
+
+	// Note(Leo): Terrain is last, because long rays are most expensive there, and others may shorten them
+	if (ray_terrain_collision(*system, ray, layers, outResult, &closestDistance))
+	{
+		hit = true;
 	}
 
 	return hit;
 }
 
+#include "CollisionRayBatch.cpp"
+#include "CollisionSweep.cpp"
 
 internal void collisions_debug_draw_colliders(CollisionSystem3D const & system)
 {
-	for (auto const & collider : system.submittedBoxColliders)
+	for (auto const & submitted : system.submittedBoxColliders)
 	{
-		debug_draw_box(collider.transform, colour_muted_green);
+		debug_draw_box(submitted.precomputed.transform, colour_muted_green);
 	}
 
 	for (auto const & collider : system.staticBoxColliders)
@@ -580,9 +1203,36 @@ internal void collisions_debug_draw_colliders(CollisionSystem3D const & system)
 		debug_draw_circle_xy(collider.center + v3{0, 0, collider.halfHeight}, collider.radius, colour_bright_green);
 	}
 
-	for (auto const & collider : system.submittedCylinderColliders)
+	for (auto const & submitted : system.submittedCylinderColliders)
 	{
+		CylinderCollider const & collider = submitted.collider;
 		debug_draw_circle_xy(collider.center - v3{0, 0, collider.halfHeight}, collider.radius, colour_bright_green);
 		debug_draw_circle_xy(collider.center + v3{0, 0, collider.halfHeight}, collider.radius, colour_bright_green);
 	}
+
+	// Note(Leo): Only mesh bounds, drawing all triangles would be too much
+	auto draw_triangle_mesh_bounds = [](TriangleMeshInstance const & instance, v4 colour)
+	{
+		AABB3D bounds = instance.mesh->bounds;
+		debug_draw_box(instance.transform * transform_matrix(aabb_3d_center(bounds), quaternion_identity, (bounds.max - bounds.min) * 0.5f), colour);
+	};
+
+	for (auto const & submitted : system.submittedTriangleMeshColliders)
+	{
+		draw_triangle_mesh_bounds(submitted.instance, colour_muted_green);
+	}
+
+	for (auto const & instance : system.staticTriangleMeshes)
+	{
+		draw_triangle_mesh_bounds(instance, colour_dark_green);
+	}
+
+	for (auto const & submitted : system.submittedCapsuleTreeColliders)
+	{
+		for (auto const & capsule : submitted.collider->capsules)
+		{
+			debug_draw_circle_xy(capsule.start + submitted.position, capsule.radius, colour_bright_green);
+			debug_draw_circle_xy(capsule.end + submitted.position, capsule.radius, colour_bright_green);
+		}
+	}
 }
@@ -20,6 +20,18 @@ s32 global_debugLevel = DEBUG_LEVEL_OFF;
 #define FS_DEBUG_NPC(op) 			FS_DEBUG(DEBUG_LEVEL_NPC, op)
 #define FS_DEBUG_BACKGROUND(op) 	FS_DEBUG(DEBUG_LEVEL_BACKGROUND, op)
 
+// Note(Leo): Frame systems draw debug lines from any worker thread, so submit them one thread at a time
+static std::atomic_flag global_debugDrawLock = ATOMIC_FLAG_INIT;
+
+internal void debug_submit_lines(s32 pointsCount, v3 * points, v4 color)
+{
+	while(global_debugDrawLock.test_and_set(std::memory_order_acquire))
+	{}
+
+	graphics_draw_lines(platformGraphics, pointsCount, points, color);
+	global_debugDrawLock.clear(std::memory_order_release);
+}
+
 
 internal void debug_draw_axes(m44 transform, float radius)
 {
@@ -32,13 +44,13 @@ internal void debug_draw_axes(m44 transform, float radius)
 	v3 points [2] = {rayStart};
 
 	points[1] = rayRight;
-	graphics_draw_lines(platformGraphics, 2, points, {1, 0, 0, 1});
+	debug_submit_lines(2, points, {1, 0, 0, 1});
 
 	points[1] = rayForward;
-	graphics_draw_lines(platformGraphics, 2, points, {0, 1, 0, 1});
+	debug_submit_lines(2, points, {0, 1, 0, 1});
 
 	points[1] = rayUp;
-	graphics_draw_lines(platformGraphics, 2, points, {0, 0, 1, 1});			
+	debug_submit_lines(2, points, {0, 0, 1, 1});			
 };
 
 internal void debug_draw_diamond(m44 transform, v4 color)
@@ -73,7 +85,7 @@ internal void debug_draw_diamond(m44 transform, v4 color)
 		zPos, yNeg,
 	};
 
-	graphics_draw_lines(platformGraphics, 24, points, color);
+	debug_submit_lines(24, points, color);
 }
 
 internal void debug_draw_circle_xy(v3 position, f32 radius, v4 color)
@@ -93,7 +105,7 @@ internal void debug_draw_circle_xy(v3 position, f32 radius, v4 color)
 		s32 next = (line + 1) % lineCount;
 		points[point + 1] = v3{f32_cos(next * angle) * radius, sine(next * angle) * radius} + position;
 	}
-	graphics_draw_lines(platformGraphics, 32, points, color);
+	debug_submit_lines(32, points, color);
 
 }
 
@@ -136,7 +148,7 @@ internal void debug_draw_diamond_xy(m44 transform, v4 color)
 		corners[3], corners[0],
 	};
 
-	graphics_draw_lines(platformGraphics, 8, points, color);
+	debug_submit_lines(8, points, color);
 }
 
 internal void debug_draw_diamond_xz(m44 transform, v4 color)
@@ -157,7 +169,7 @@ internal void debug_draw_diamond_xz(m44 transform, v4 color)
 		corners[3], corners[0],
 	};
 
-	graphics_draw_lines(platformGraphics, 8, points, color);
+	debug_submit_lines(8, points, color);
 }
 
 internal void debug_draw_diamond_yz(m44 transform, v4 color)
@@ -178,12 +190,12 @@ internal void debug_draw_diamond_yz(m44 transform, v4 color)
 		corners[3], corners[0],
 	};
 
-	graphics_draw_lines(platformGraphics, 8, points, color);
+	debug_submit_lines(8, points, color);
 }
 
 internal void debug_draw_lines(s32 pointsCount, v3 * points, v4 color)
 {
-	graphics_draw_lines(platformGraphics, pointsCount, points, color);
+	debug_submit_lines(pointsCount, points, color);
 }
 
 internal void debug_draw_vector(v3 position, v3 vector, v4 color)
@@ -207,7 +219,7 @@ internal void debug_draw_vector(v3 position, v3 vector, v4 color)
 		cornerA, cornerB
 	};
 
-	graphics_draw_lines(platformGraphics, 8, points, color);
+	debug_submit_lines(8, points, color);
 
 }
 
@@ -244,7 +256,7 @@ internal void debug_draw_box(m44 transform, v4 color)
 		corners[3], corners[7],
 	};
 
-	graphics_draw_lines(platformGraphics, 24, lines, color);
+	debug_submit_lines(24, lines, color);
 }
 
 internal void debug_draw_cross_xy(v3 position, f32 radius, v4 color)
@@ -257,11 +269,11 @@ internal void debug_draw_cross_xy(v3 position, f32 radius, v4 color)
 		position + v3{0, radius, 0}
 	};
 
-	graphics_draw_lines(platformGraphics, 4, points, color);
+	debug_submit_lines(4, points, color);
 }
 
 internal void debug_draw_line(v3 a, v3 b, v4 color)
 {
 	v3 points [] = {a, b};
-	graphics_draw_lines(platformGraphics, 2, points, color);	
+	debug_submit_lines(2, points, color);	
 }
\ No newline at end of file
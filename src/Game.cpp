@@ -11,40 +11,6 @@ Todo(leo): audio
 	clipping, compressor, dynamic gain, soft knee, hard knee
 */
 
-// Todo(Leo): maybe Actor? as opposed to static Scenery
-enum EntityType : s32
-{ 	
-	// Todo(Leo): none should be default value, but really it would be better to have it not
-	// contribute to count, basically be below 0 or above count
-	EntityType_none,
-	
-	EntityType_small_pot,
-	EntityType_big_pot,
-	EntityType_water,
-	EntityType_raccoon,
-	EntityType_tree_3,
-	EntityType_box,
-
-	EntityTypeCount
-};
-
-struct EntityReference
-{
-	EntityType 	type;
-	s32 		index;
-};
-
-bool operator == (EntityReference const & a, EntityReference const & b)
-{
-	bool result = a.type == b.type && a.index == b.index;
-	return result;
-}
-
-bool operator != (EntityReference const & a, EntityReference const & b)
-{
-	return !(a == b);
-}
-
 // Todo(Leo): Maybe try to get rid of this forward declaration
 // Should these be global variables or something
 struct Game;
@@ -131,6 +97,7 @@ struct Game
 
 	CollisionSystem3D 	collisionSystem;
 	PhysicsWorld 		physicsWorld;
+	EntitySpatialIndex 	entityIndex;
 
 	Camera 						worldCamera;
 	GameCameraController 		gameCamera;	
@@ -285,12 +252,16 @@ struct Game
 
 	// ----------------------------------------------
 
-	v3 castlePosition;
+	v3 						castlePosition;
+	TriangleMeshCollider 	castleCollider;
 
 	// ----------------------------------------------
 
 	Scene scene;
 
+	// Note(Leo): Shared by all building pipes, they are submitted every frame since they can be edited
+	TriangleMeshCollider buildingPipeCollider;
+
 	s64 selectedBuildingBlockIndex;
 	s64 selectedBuildingPipeIndex;
 
@@ -308,6 +279,10 @@ struct Game
 	v3 testRayPosition 	= {-10,0,45};
 	v3 testRayDirection = {0,1,0};
 	f32 testRayLength 	= 1;
+
+	// ----------------------------------------------
+
+	FrameSystemReport frameSystemReport;
 };
 
 internal v3 * entity_get_position(Game * game, EntityReference entity)
@@ -315,7 +290,7 @@ internal v3 * entity_get_position(Game * game, EntityReference entity)
 	switch(entity.type)
 	{
 		case EntityType_raccoon:	return &game->raccoonTransforms[entity.index].position;
-		case EntityType_water: 		return &game->waters.positions[entity.index];
+		case EntityType_water: 		return &game->waters.positions()[entity.index];
 		case EntityType_small_pot:	return &game->smallPots.transforms[entity.index].position;
 		case EntityType_tree_3: 	return &game->trees.array[entity.index].position;
 		case EntityType_box:		return &game->boxes.transforms[entity.index].position;
@@ -330,7 +305,7 @@ internal quaternion * entity_get_rotation(Game * game, EntityReference entity)
 	switch(entity.type)
 	{
 		case EntityType_raccoon:	return &game->raccoonTransforms[entity.index].rotation;
-		case EntityType_water: 		return &game->waters.rotations[entity.index];
+		case EntityType_water: 		return &game->waters.rotations()[entity.index];
 		case EntityType_small_pot:	return &game->smallPots.transforms[entity.index].rotation;
 		case EntityType_tree_3: 	return &game->trees.array[entity.index].rotation;
 		case EntityType_box:		return &game->boxes.transforms[entity.index].rotation;
@@ -342,6 +317,17 @@ internal quaternion * entity_get_rotation(Game * game, EntityReference entity)
 
 internal CollisionSystem3D & game_get_collision_system(Game * game) { return game->collisionSystem; }
 
+// Note(Leo): Waters keep their grid updated themselves, see Waters
+internal void game_update_entity_index(Game * game)
+{
+	EntitySpatialIndex & index = game->entityIndex;
+
+	entity_spatial_index_update_type(index, EntityType_box, game->boxes.count, [game](s32 i) { return game->boxes.transforms[i].position; });
+	entity_spatial_index_update_type(index, EntityType_small_pot, game->smallPots.count, [game](s32 i) { return game->smallPots.transforms[i].position; });
+	entity_spatial_index_update_type(index, EntityType_raccoon, game->raccoonCount, [game](s32 i) { return game->raccoonTransforms[i].position; });
+	entity_spatial_index_update_type(index, EntityType_tree_3, game->trees.array.count, [game](s32 i) { return game->trees.array[i].position; });
+}
+
 
 internal auto game_get_serialized_objects(Game & game)
 {
@@ -363,7 +349,7 @@ internal void game_spawn_water(Game & game, s32 count)
 
 	v2 center = game.player.characterTransform.position.xy;
 
-	count = f32_min(count, waters.capacity - waters.count);
+	count = f32_min(count, waters.data.capacity - waters.data.count);
 
 	for (s32 i = 0; i < count; ++i)
 	{
@@ -393,7 +379,14 @@ internal s32 game_spawn_tree(Game & game, v3 position, s32 treeTypeIndex, bool32
 	s32 index = game.trees.array.count++;
 	Tree & tree = game.trees.array[index];
 
-	reset_tree_3(tree, &game.trees.settings[treeTypeIndex], position);
+	// Note(Leo): Tree's random stream is seeded from spawn data only, so it does not depend on global random state
+	u32 randomSeed = random_hash(index);
+	randomSeed = random_hash_combine(randomSeed, treeTypeIndex);
+	randomSeed = random_hash_combine(randomSeed, memory_convert_bytes_to<u32>(reinterpret_cast<byte const*>(&position.x), 0));
+	randomSeed = random_hash_combine(randomSeed, memory_convert_bytes_to<u32>(reinterpret_cast<byte const*>(&position.y), 0));
+	randomSeed = random_hash_combine(randomSeed, memory_convert_bytes_to<u32>(reinterpret_cast<byte const*>(&position.z), 0));
+
+	reset_tree_3(tree, game.trees.memoryPool, &game.trees.settings[treeTypeIndex], position, randomSeed);
 
 	tree.typeIndex 	= treeTypeIndex;
 	tree.game 		= &game;
@@ -445,6 +438,8 @@ internal bool32 game_game_update(Game * 				game,
 								StereoSoundOutput *		soundOutput,
 								f32 					elapsedTimeSeconds)
 {
+	FS_PROFILE_FUNCTION();
+
 	struct SnapOnGround
 	{
 		CollisionSystem3D & collisionSystem;
@@ -524,8 +519,17 @@ internal bool32 game_game_update(Game * 				game,
 
 
 	/// *******************************************************************************************
+	/// FRAME SYSTEMS
+	/* Note(Leo): Systems are added in the same order they used to run one after another, and
+	they run after that concurrently where their declared reads and writes allow it, see
+	frame_systems.cpp. When adding things here, declare everything the system touches. */
 
+	FrameSystemGraph systems = {};
 
+	frame_systems_add(systems, "player",
+		FrameData_collision_system | FrameData_waters | FrameData_entity_index,
+		FrameData_player | FrameData_noble_person | FrameData_boxes | FrameData_small_pots | FrameData_raccoons | FrameData_trees | FrameData_physics_world,
+		[&](s32 workerIndex)
 	{
 		CharacterInput playerCharacterMotorInput = {};
 		PlayerInput playerInput = {};
@@ -549,6 +553,9 @@ internal bool32 game_game_update(Game * 				game,
 		f32 playerPickupDistance 	= 1.0f;
 		f32 playerInteractDistance 	= 1.0f;
 
+		auto entity_position 	= [game](EntityReference entity) { return *entity_get_position(game, entity); };
+		auto any_entity 		= [](EntityReference entity) { return true; };
+
 		/// PICKUP OR DROP
 		if (playerInput.pickupOrDrop)
 		{
@@ -558,90 +565,48 @@ internal bool32 game_game_update(Game * 				game,
 			{
 				case EntityType_none:
 				{
-					bool pickup = true;
+					/* Todo(Leo): Do this properly, taking into account player facing direction etc. Now types are
+					tried in order, and nearest of first type that has something in range is picked. */
+
+					EntityReference nearest;
 
-					if (pickup)
+					f32 boxPickupDistance = 0.5f + playerPickupDistance;
+					if (entity_spatial_index_find_nearest(	game->entityIndex, playerPosition, boxPickupDistance,
+															EntityTypeFlag_box, &nearest, entity_position, any_entity))
 					{
-						for(s32 i  = 0; i < game->boxes.count; ++i)
-						{
-							f32 boxPickupDistance = 0.5f + playerPickupDistance;
-							if (v3_length(playerPosition - game->boxes.transforms[i].position) < boxPickupDistance)
-							{
-								bool32 canPickInsides = game->boxes.carriedEntities[i].type != EntityType_none
-														&& game->boxes.states[i] == BoxState_open;
-
-								if (canPickInsides == false)
-								{
-									game->player.carriedEntity = {EntityType_box, i};
-								}
-								else
-								{
-									game->player.carriedEntity = game->boxes.carriedEntities[i];
-									game->boxes.carriedEntities[i] = {EntityType_none};
-								}
-
-								pickup = false;
-							}
-						}
-					}
+						s32 i = nearest.index;
 
-					v3 playerPosition = game->player.characterTransform.position;
+						bool32 canPickInsides = game->boxes.carriedEntities[i].type != EntityType_none
+												&& game->boxes.states[i] == BoxState_open;
 
-					/* Todo(Leo): Do this properly, taking into account player facing direction and distances etc. */
-					auto check_pickup = [&](s32 count, Transform3D const * transforms, EntityType entityType)
-					{
-						for (s32 i = 0; i < count; ++i)
+						if (canPickInsides == false)
 						{
-							if (v3_length(playerPosition - transforms[i].position) < playerPickupDistance)
-							{
-								game->player.carriedEntity = {entityType, i};
-								pickup = false;
-							}
+							game->player.carriedEntity = {EntityType_box, i};
 						}
-					};
-
-
-					if (pickup)
-					{
-						check_pickup(game->smallPots.count, game->smallPots.transforms, EntityType_small_pot);
-					}
-
-					if (pickup)
-					{
-						for (s32 i = 0; i < game->waters.count; ++i)
+						else
 						{
-							if (v3_length(playerPosition - game->waters.positions[i]) < playerPickupDistance)
-							{
-								game->player.carriedEntity = {EntityType_water, i};
-								pickup = false;
-							}
+							game->player.carriedEntity = game->boxes.carriedEntities[i];
+							game->boxes.carriedEntities[i] = {EntityType_none};
 						}
-
-
-					}
-
-
-					if (pickup)
-					{
-						check_pickup(game->raccoonCount, game->raccoonTransforms, EntityType_raccoon);
 					}
-
-					if (pickup)
+					else
 					{
-						for (s32 i = 0; i < game->trees.array.count; ++i)
+						EntityTypeFlags pickupOrder [] =
 						{
-							Tree & tree = game->trees.array[i];
+							EntityTypeFlag_small_pot,
+							EntityTypeFlag_water,
+							EntityTypeFlag_raccoon,
+							EntityTypeFlag_tree_3,
+						};
 
-							if (v3_length(playerPosition - game->trees.array[i].position) < playerPickupDistance)
+						for (EntityTypeFlags types : pickupOrder)
+						{
+							if (entity_spatial_index_find_nearest(	game->entityIndex, playerPosition, playerPickupDistance,
+																	types, &nearest, entity_position, any_entity))
 							{
-								// if (game->trees.array[i].planted == false)
-								{
-									game->player.carriedEntity = {EntityType_tree_3, i};
-								}
-
-								pickup = false;
+								game->player.carriedEntity = nearest;
+								break;
 							}
-
 						}
 					}
 
@@ -678,18 +643,20 @@ internal bool32 game_game_update(Game * 				game,
 			bool playerCarriesContainableEntity = 	game->player.carriedEntity.type != EntityType_none
 													&& game->player.carriedEntity.type != EntityType_box;
 
+			auto box_is_empty = [game](EntityReference box) { return game->boxes.carriedEntities[box.index].type == EntityType_none; };
+			auto pot_is_empty = [game](EntityReference pot) { return game->smallPots.carriedEntities[pot.index].type == EntityType_none; };
+
+			EntityReference nearest;
+
 			if (interact && playerCarriesContainableEntity)
 			{
-				for (s32 i = 0; i < game->boxes.count; ++i)
+				if (entity_spatial_index_find_nearest(	game->entityIndex, game->player.characterTransform.position, boxInteractDistance,
+														EntityTypeFlag_box, &nearest, entity_position, box_is_empty))
 				{
-					f32 distanceToBox = v3_length(game->boxes.transforms[i].position - game->player.characterTransform.position);
-					if (distanceToBox < boxInteractDistance && game->boxes.carriedEntities[i].type == EntityType_none)
-					{
-						game->boxes.carriedEntities[i] = game->player.carriedEntity;
-						game->player.carriedEntity = {EntityType_none};
+					game->boxes.carriedEntities[nearest.index] 	= game->player.carriedEntity;
+					game->player.carriedEntity 					= {EntityType_none};
 
-						interact = false;
-					}				
+					interact = false;
 				}
 			}
 
@@ -701,18 +668,15 @@ internal bool32 game_game_update(Game * 				game,
 			{
 				log_debug("Try put something to pot");
 
-				for (s32 i = 0; i < game->smallPots.count; ++i)
+				if (entity_spatial_index_find_nearest(	game->entityIndex, game->player.characterTransform.position, playerInteractDistance,
+														EntityTypeFlag_small_pot, &nearest, entity_position, pot_is_empty))
 				{
-					f32 distanceToPot = v3_length(game->smallPots.transforms[i].position - game->player.characterTransform.position);
-					if (distanceToPot < playerInteractDistance && game->smallPots.carriedEntities[i].type == EntityType_none)
-					{
-						log_debug(FILE_ADDRESS, "Stuff put into pot");
+					log_debug(FILE_ADDRESS, "Stuff put into pot");
 
-						game->smallPots.carriedEntities[i] = game->player.carriedEntity;
-						game->player.carriedEntity 	= {EntityType_none};
+					game->smallPots.carriedEntities[nearest.index] 	= game->player.carriedEntity;
+					game->player.carriedEntity 						= {EntityType_none};
 
-						interact = false;
-					}
+					interact = false;
 				}
 			}
 			
@@ -721,28 +685,27 @@ internal bool32 game_game_update(Game * 				game,
 
 			if (interact && playerCarriesNothing)
 			{
-				for (s32 i = 0; i < game->boxes.count; ++i)
+				entity_spatial_index_query_radius(	game->entityIndex, game->player.characterTransform.position, boxInteractDistance,
+													EntityTypeFlag_box, entity_position, [&](EntityReference box, f32 distance)
 				{
-					f32 distanceToBox = v3_length(game->boxes.transforms[i].position - game->player.characterTransform.position);
-					if (distanceToBox < boxInteractDistance)
+					s32 i = box.index;
+
+					if (game->boxes.states[i] == BoxState_closed)
 					{
-						if (game->boxes.states[i] == BoxState_closed)
-						{
-							game->boxes.states[i] 			= BoxState_opening;
-							game->boxes.openStates[i] 	= 0;
+						game->boxes.states[i] 			= BoxState_opening;
+						game->boxes.openStates[i] 	= 0;
 
-							interact = false;
-						}
+						interact = false;
+					}
 
-						else if (game->boxes.states[i] == BoxState_open)
-						{
-							game->boxes.states[i] 			= BoxState_closing;
-							game->boxes.openStates[i] 	= 0;
+					else if (game->boxes.states[i] == BoxState_open)
+					{
+						game->boxes.states[i] 			= BoxState_closing;
+						game->boxes.openStates[i] 	= 0;
 
-							interact = false;
-						}
+						interact = false;
 					}
-				}
+				});
 			}
 
 			// PLANT THE CARRIED TREE
@@ -769,84 +732,116 @@ internal bool32 game_game_update(Game * 				game,
 			FS_DEBUG_NPC(debug_draw_circle_xy(game->boxes.transforms[i].position + v3{0,0,0.6}, 1, colour));
 			FS_DEBUG_NPC(debug_draw_circle_xy(game->boxes.transforms[i].position + v3{0,0,0.6}, 1.5, colour_bright_cyan));
 		}
-	}
+	});
 
-	auto update_carried_entities_transforms = [&](	s32 				count,
-													Transform3D * 		transforms,
-													EntityReference * 	carriedEntities,
-													v3 					carriedOffset)
+	// Note(Leo): Carried entity can be anything that has a position
+	frame_systems_add(systems, "carried entities",
+		FrameData_player,
+		FrameData_boxes | FrameData_small_pots | FrameData_waters | FrameData_raccoons | FrameData_trees,
+		[&](s32 workerIndex)
 	{
-		for (s32 i = 0; i < count; ++i)
+		auto update_carried_entities_transforms = [&](	s32 				count,
+														Transform3D * 		transforms,
+														EntityReference * 	carriedEntities,
+														v3 					carriedOffset)
 		{
-			v3 carriedPosition 			= multiply_point(transform_matrix(transforms[i]), carriedOffset);
-			quaternion carriedRotation 	= transforms[i].rotation;
+			for (s32 i = 0; i < count; ++i)
+			{
+				v3 carriedPosition 			= multiply_point(transform_matrix(transforms[i]), carriedOffset);
+				quaternion carriedRotation 	= transforms[i].rotation;
 		
-			// Todo(Leo): maybe something like this??
-			// entity_set_position(game->player.carriedEntity, carriedPosition);
-			// entity_set_rotation(game->player.carriedEntity, carriedRotation);
-			// entity_set_state(game->player.carriedEntity, EntityState_carried_by_player);
+				// Todo(Leo): maybe something like this??
+				// entity_set_position(game->player.carriedEntity, carriedPosition);
+				// entity_set_rotation(game->player.carriedEntity, carriedRotation);
+				// entity_set_state(game->player.carriedEntity, EntityState_carried_by_player);
 
-			if (carriedEntities[i].type == EntityType_raccoon)
-			{
-				game->raccoonTransforms[carriedEntities[i].index].position 	= carriedPosition + v3{0,0,0.2};
+				if (carriedEntities[i].type == EntityType_raccoon)
+				{
+					game->raccoonTransforms[carriedEntities[i].index].position 	= carriedPosition + v3{0,0,0.2};
 
-				v3 right = quaternion_rotate_v3(carriedRotation, v3_right);
-				game->raccoonTransforms[carriedEntities[i].index].rotation 	= carriedRotation * quaternion_axis_angle(right, 1.4f);
-			}
-			else if (carriedEntities[i].type != EntityType_none)
-			{
-				// Todo(Leo): if we ever crash here start doing checks
-				*entity_get_position(game, carriedEntities[i]) = carriedPosition;
-				*entity_get_rotation(game, carriedEntities[i]) = carriedRotation;
+					v3 right = quaternion_rotate_v3(carriedRotation, v3_right);
+					game->raccoonTransforms[carriedEntities[i].index].rotation 	= carriedRotation * quaternion_axis_angle(right, 1.4f);
+				}
+				else if (carriedEntities[i].type != EntityType_none)
+				{
+					// Todo(Leo): if we ever crash here start doing checks
+					*entity_get_position(game, carriedEntities[i]) = carriedPosition;
+					*entity_get_rotation(game, carriedEntities[i]) = carriedRotation;
+
+					if (carriedEntities[i].type == EntityType_water)
+					{
+						spatial_hash_grid_move(game->waters.grid, carriedEntities[i].index, carriedPosition.xy);
+					}
+				}
 			}
-		}
-	};
+		};
 
-	update_carried_entities_transforms(1, &game->player.characterTransform, &game->player.carriedEntity, {0, 0.7, 0.7});
-	update_carried_entities_transforms(game->boxes.count, game->boxes.transforms, game->boxes.carriedEntities, {0, 0, 0.1});
-	update_carried_entities_transforms(game->smallPots.count, game->smallPots.transforms, game->smallPots.carriedEntities, {0, 0, 0.1});
+		update_carried_entities_transforms(1, &game->player.characterTransform, &game->player.carriedEntity, {0, 0.7, 0.7});
+		update_carried_entities_transforms(game->boxes.count, game->boxes.transforms, game->boxes.carriedEntities, {0, 0, 0.1});
+		update_carried_entities_transforms(game->smallPots.count, game->smallPots.transforms, game->smallPots.carriedEntities, {0, 0, 0.1});
+	});
 
-	// UPDATE BOX COVER
-	for (s32 i = 0; i < game->boxes.count; ++i)
+	frame_systems_add(systems, "box covers", FrameData_none, FrameData_boxes, [&](s32 workerIndex)
 	{
-		constexpr f32 openAngle 	= 5.0f/8.0f * π;
-		constexpr f32 openingTime 	= 0.7f;
-
-		if (game->boxes.states[i] == BoxState_opening)
+		for (s32 i = 0; i < game->boxes.count; ++i)
 		{
-			game->boxes.openStates[i] += scaledTime / openingTime;
+			constexpr f32 openAngle 	= 5.0f/8.0f * π;
+			constexpr f32 openingTime 	= 0.7f;
 
-			if (game->boxes.openStates[i] > 1.0f)
+			if (game->boxes.states[i] == BoxState_opening)
 			{
-				game->boxes.states[i] 			= BoxState_open;
-				game->boxes.openStates[i] 	= 1.0f;
-			}
+				game->boxes.openStates[i] += scaledTime / openingTime;
 
-			f32 angle = openAngle * game->boxes.openStates[i];
-			game->boxes.coverLocalTransforms[i].rotation = quaternion_axis_angle(v3_right, angle);
-		}
-		else if (game->boxes.states[i] == BoxState_closing)
-		{
-			game->boxes.openStates[i] += scaledTime / openingTime;
+				if (game->boxes.openStates[i] > 1.0f)
+				{
+					game->boxes.states[i] 			= BoxState_open;
+					game->boxes.openStates[i] 	= 1.0f;
+				}
 
-			if (game->boxes.openStates[i] > 1.0f)
-			{
-				game->boxes.states[i] 			= BoxState_closed;
-				game->boxes.openStates[i] 	= 1.0f;
+				f32 angle = openAngle * game->boxes.openStates[i];
+				game->boxes.coverLocalTransforms[i].rotation = quaternion_axis_angle(v3_right, angle);
 			}
+			else if (game->boxes.states[i] == BoxState_closing)
+			{
+				game->boxes.openStates[i] += scaledTime / openingTime;
 
-			f32 angle = openAngle * (1 - game->boxes.openStates[i]);
-			game->boxes.coverLocalTransforms[i].rotation = quaternion_axis_angle(v3_right, angle);
+				if (game->boxes.openStates[i] > 1.0f)
+				{
+					game->boxes.states[i] 			= BoxState_closed;
+					game->boxes.openStates[i] 	= 1.0f;
+				}
+
+				f32 angle = openAngle * (1 - game->boxes.openStates[i]);
+				game->boxes.coverLocalTransforms[i].rotation = quaternion_axis_angle(v3_right, angle);
+			}
 		}
-	}
+	});
 
-	update_waters(game->waters, scaledTime);
-	update_clouds(game->clouds, game->waters, game->physicsWorld, game->collisionSystem, scaledTime);
-	update_physics_world(game->physicsWorld, game, scaledTime);
+	frame_systems_add(systems, "waters", FrameData_none, FrameData_waters, [&](s32 workerIndex)
+	{
+		update_waters(game->waters, scaledTime);
+	});
+
+	frame_systems_add(systems, "clouds",
+		FrameData_collision_system | FrameData_physics_world,
+		FrameData_clouds | FrameData_waters | FrameData_random | FrameData_transient_memory,
+		[&](s32 workerIndex)
+	{
+		update_clouds(game->clouds, game->waters, game->physicsWorld, game->collisionSystem, scaledTime);
+	});
+
+	// Note(Leo): Physics world moves whatever entities have been dropped
+	frame_systems_add(systems, "physics world",
+		FrameData_collision_system,
+		FrameData_physics_world | FrameData_boxes | FrameData_small_pots | FrameData_waters | FrameData_raccoons | FrameData_trees,
+		[&](s32 workerIndex)
+	{
+		update_physics_world(game->physicsWorld, game, scaledTime);
+	});
 
-	
 	// -----------------------------------------------------------------------------------------------------------
 	/// TRAIN
+	frame_systems_add(systems, "train", FrameData_none, FrameData_train, [&](s32 workerIndex)
 	{
 		v3 trainWayPoints [] = 
 		{
@@ -903,10 +898,14 @@ internal bool32 game_game_update(Game * 				game,
 				game->trainCurrentDirection 		= v3_normalize(end - start);
 			}
 		}
-	}
+	});
 
 	// -----------------------------------------------------------------------------------------------------------
 	/// NOBLE PERSON CHARACTER
+	frame_systems_add(systems, "noble person",
+		FrameData_collision_system,
+		FrameData_noble_person | FrameData_random,
+		[&](s32 workerIndex)
 	{
 		CharacterInput nobleCharacterMotorInput = {};
 
@@ -955,25 +954,28 @@ internal bool32 game_game_update(Game * 				game,
 								game->collisionSystem,
 								scaledTime,
 								DEBUG_LEVEL_NPC);
-	}
+	});
 
 	// -----------------------------------------------------------------------------------------------------------
 	/// Update RACCOONS
+	frame_systems_add(systems, "raccoons",
+		FrameData_player | FrameData_boxes | FrameData_collision_system,
+		FrameData_raccoons | FrameData_small_pots | FrameData_random,
+		[&](s32 workerIndex)
 	{
-		// Note(Leo): +1 for player
-		s32 maxCarriedRaccoons = game->boxes.count + game->smallPots.count + 1;
-		Array<s32> carriedRaccoonIndices = push_array<s32>(*global_transientMemory, maxCarriedRaccoons, ALLOC_GARBAGE);
+		// Note(Leo): Carriers mark raccoons here, so that each raccoon needs only one lookup below
+		bool8 * raccoonIsCarried = push_memory<bool8>(jobs_get_scratch_memory(workerIndex), game->raccoonCount, ALLOC_ZERO_MEMORY);
 		{
 			if(game->player.carriedEntity.type == EntityType_raccoon)
 			{
-				carriedRaccoonIndices.push(game->player.carriedEntity.index);
+				raccoonIsCarried[game->player.carriedEntity.index] = true;
 			}
 			
 			for (s32 i = 0; i < game->boxes.count; ++i)
 			{
 				if (game->boxes.carriedEntities[i].type == EntityType_raccoon)
 				{
-					carriedRaccoonIndices.push(game->boxes.carriedEntities[i].index);
+					raccoonIsCarried[game->boxes.carriedEntities[i].index] = true;
 				}
 			}
 
@@ -988,7 +990,7 @@ internal bool32 game_game_update(Game * 				game,
 					}			
 					else
 					{
-						carriedRaccoonIndices.push(game->smallPots.carriedEntities[i].index);
+						raccoonIsCarried[game->smallPots.carriedEntities[i].index] = true;
 					}
 				}
 			}
@@ -1021,18 +1023,7 @@ internal bool32 game_game_update(Game * 				game,
 			raccoonCharacterMotorInput = {input, false, false};
 
 
-			bool isCarried = false;
-			for (s32 carriedRaccoonIndex : carriedRaccoonIndices)
-			{
-				if (carriedRaccoonIndex == i)
-				{
-					isCarried = true;
-					break;
-				}
-			}
-
-
-			if (isCarried == false)
+			if (raccoonIsCarried[i] == false)
 			{
 				update_character_motor( game->raccoonCharacterMotors[i],
 										raccoonCharacterMotorInput,
@@ -1045,7 +1036,7 @@ internal bool32 game_game_update(Game * 				game,
 		}
 
 
-	}
+	});
 
 	// -----------------------------------------------------------------------------------------------------------
 
@@ -1053,49 +1044,48 @@ internal bool32 game_game_update(Game * 				game,
 	/// SUBMIT COLLIDERS
 	// Note(Leo): These colliders are used mainly in next game loop, since we update them here after everything has moved
 	// Make a proper decision whether or not this is something we need
-	// Todo(Leo): most colliders are really static, so this is major stupid
+	// Note(Leo): Submitted colliders persist, and only ones that moved are updated, see CollisionSystem3D
+	frame_systems_add(systems, "submit colliders",
+		FrameData_boxes | FrameData_small_pots | FrameData_trees,
+		FrameData_collision_system | FrameData_imgui,
+		[&](s32 workerIndex)
 	{
-		collision_system_reset_submitted_colliders(game->collisionSystem);
+		collision_system_begin_submitted_colliders(game->collisionSystem);
 
 		monuments_submit_colliders(game->monuments, game->collisionSystem);
 
 		// Todo(Leo): Maybe make something like that these would have predetermined range, that is only updated when
 		// tree has grown a certain amount or somthing. These are kinda semi-permanent by nature.
 
-		auto submit_cylinder_colliders = [&collisionSystem = game->collisionSystem](f32 radius, f32 halfHeight, s32 count, Transform3D * transforms)
+		auto submit_cylinder_colliders = [&collisionSystem = game->collisionSystem](f32 radius, f32 halfHeight, s32 count, Transform3D * transforms, EntityType entityType)
 		{
 			for (s32 i = 0; i < count; ++i)
 			{
-				submit_cylinder_collider(collisionSystem, {radius, halfHeight, v3{0, 0, halfHeight}}, transforms[i]);
+				submit_cylinder_collider(collisionSystem, {radius, halfHeight, v3{0, 0, halfHeight}}, transforms[i], {entityType, i});
 			}
 		};
 
 		f32 smallPotColliderRadius = 0.3;
 		f32 smallPotColliderHeight = 0.58;
 		f32 smallPotHalfHeight = smallPotColliderHeight / 2;
-		submit_cylinder_colliders(smallPotColliderRadius, smallPotHalfHeight, game->smallPots.count, game->smallPots.transforms);
+		submit_cylinder_colliders(smallPotColliderRadius, smallPotHalfHeight, game->smallPots.count, game->smallPots.transforms, EntityType_small_pot);
 
 		f32 bigPotColliderRadius 	= 0.6;
 		f32 bigPotColliderHeight 	= 1.16;
 		f32 bigPotHalfHeight 		= bigPotColliderHeight / 2;
-		submit_cylinder_colliders(bigPotColliderRadius, bigPotHalfHeight, game->bigPotTransforms.count, game->bigPotTransforms.memory);
+		submit_cylinder_colliders(bigPotColliderRadius, bigPotHalfHeight, game->bigPotTransforms.count, game->bigPotTransforms.memory, EntityType_big_pot);
 
 
 		// NEW TREES 3
-		for (auto tree : game->trees.array)
+		// Note(Leo): Trees keep their branch capsules up to date when they grow, so this only checks their bounds
+		for (s32 treeIndex = 0; treeIndex < game->trees.array.count; ++treeIndex)
 		{
-			CylinderCollider collider =
-			{
-				.radius 	= tree.nodes[tree.branches[0].startNodeIndex].radius,
-				.halfHeight = 1.0f,
-				.center 	= {0,0,1}
-			};
-
-			submit_cylinder_collider(game->collisionSystem, collider, {tree.position, quaternion_identity, {1,1,1}});
+			Tree const & tree = game->trees.array[treeIndex];
+			submit_capsule_tree_collider(game->collisionSystem, tree.collider, tree.position, {EntityType_tree_3, treeIndex});
 		}
 
-		submit_box_collider(game->collisionSystem, {{0.5,0.5,0.5}, quaternion_identity, {0,0,0.5}}, game->boxes.transforms[0]);
-		submit_box_collider(game->collisionSystem, {{0.5,0.5,0.5}, quaternion_identity, {0,0,0.5}}, game->boxes.transforms[1]);
+		submit_box_collider(game->collisionSystem, {{0.5,0.5,0.5}, quaternion_identity, {0,0,0.5}}, game->boxes.transforms[0], {EntityType_box, 0});
+		submit_box_collider(game->collisionSystem, {{0.5,0.5,0.5}, quaternion_identity, {0,0,0.5}}, game->boxes.transforms[1], {EntityType_box, 1});
 
 		/// BUILDING BLOCKS
 		for (s32 i = 0; i < game->scene.buildingBlocks.count; ++i)
@@ -1105,9 +1095,11 @@ internal bool32 game_game_update(Game * 				game,
 
 		for (s32 i = 0; i < game->scene.buildingPipes.count; ++i)
 		{
-			// submit_cylinder_collider(game->)
+			submit_triangle_mesh_collider(game->collisionSystem, game->buildingPipeCollider, game->scene.buildingPipes[i]);
 		}
 
+		collision_system_end_submitted_colliders(game->collisionSystem);
+
 
 		ImGui::Begin("Test collider");
 		{
@@ -1123,11 +1115,23 @@ internal bool32 game_game_update(Game * 				game,
 			}
 			ImGui::DragFloat("ray length", &game->testRayLength, 0.1);
 		}
-		ImGui::End();
 
 		RaycastResult rayResult;
 		bool hit = raycast_3d(&game->collisionSystem, game->testRayPosition, game->testRayDirection, game->testRayLength, &rayResult);
 
+		if (hit)
+		{
+			ImGui::Text("hit distance %.3f, collider type %d index %d, entity type %d index %d",
+						rayResult.distance,
+						rayResult.collider.type, rayResult.collider.index,
+						rayResult.entity.type, rayResult.entity.index);
+		}
+		else
+		{
+			ImGui::Text("no hit");
+		}
+		ImGui::End();
+
 
 		if (hit)
 		{
@@ -1144,14 +1148,17 @@ internal bool32 game_game_update(Game * 				game,
 		FS_DEBUG_ALWAYS(debug_draw_line(game->collisionSystem.testTriangleCollider[0], game->collisionSystem.testTriangleCollider[1], colour_bright_green));
 		FS_DEBUG_ALWAYS(debug_draw_line(game->collisionSystem.testTriangleCollider[1], game->collisionSystem.testTriangleCollider[2], colour_bright_green));
 		FS_DEBUG_ALWAYS(debug_draw_line(game->collisionSystem.testTriangleCollider[2], game->collisionSystem.testTriangleCollider[0], colour_bright_green));
-	}
+	});
 
-	update_skeleton_animator(game->player.skeletonAnimator, scaledTime);
-	update_skeleton_animator(game->noblePersonSkeletonAnimator, scaledTime);
+	frame_systems_add(systems, "animators", FrameData_none, FrameData_player | FrameData_noble_person, [&](s32 workerIndex)
+	{
+		update_skeleton_animator(game->player.skeletonAnimator, scaledTime);
+		update_skeleton_animator(game->noblePersonSkeletonAnimator, scaledTime);
+	});
 	
 	/// GENERATE MESH IF ENABLED
-	{
-		if (game->drawMCStuff)
+	frame_systems_add(systems, "metaballs", FrameData_collision_system, FrameData_metaballs | FrameData_transient_memory, [&](s32 workerIndex)
+	{		if (game->drawMCStuff)
 		{
 			v3 position = multiply_point(game->metaballTransform, {0,0,0});
 
@@ -1223,25 +1230,55 @@ internal bool32 game_game_update(Game * 				game,
 
 			FS_DEBUG_ALWAYS(debug_draw_circle_xy(multiply_point(game->metaballTransform2, game->metaballVertices2[0].position), 5.0f, colour_bright_green));
 		}
-	}
+	});
 
 	/// UPDATE TREES
-	for (auto & tree : game->trees.array)
+	// Note(Leo): Spawning fruit trees pushes them to physics world. See game_trees.cpp for update phases.
+	/*
+	Note(Leo): Collision system keeps pointers to trees' capsule colliders, and this refits and reallocates
+	them, so this writes collision system too, and systems that raycast do not run at same time.
+	*/
+	frame_systems_add(systems, "trees",
+		FrameData_player,
+		FrameData_trees | FrameData_waters | FrameData_physics_world | FrameData_collision_system,
+		[&](s32 workerIndex)
 	{
 		GetWaterFunc get_water = {game->waters, game->player.carriedEntity.index, game->player.carriedEntity.type == EntityType_water };
-		update_tree_3(tree, scaledTime, get_water);
-		
-		tree.leaves.position = tree.position;
-		tree.leaves.rotation = tree.rotation;
-	}
+		trees_schedule_simulation(game->trees, scaledTime, game->worldCamera.position, game->worldCamera.direction);
+		trees_take_water(game->trees, get_water);
+
+		TreeMeshLodView & lodView 		= game->trees.meshLodView;
+		lodView.enabled 				= game->trees.meshLodEnabled;
+		lodView.cameraPosition 			= game->worldCamera.position;
+		lodView.pixelsAtUnitDistance 	= platform_window_get_height(platformWindow) / (2 * Tan(to_radians(game->worldCamera.verticalFieldOfView / 2)));
 
-	for (auto & tree : game->trees.array)
+		parallel_for(game->trees.array.count, 2, [game, scaledTime](s32 treeIndex, s32 workerIndex)
+		{
+			Tree & tree = game->trees.array[treeIndex];
+			update_tree_3(tree, game->trees.meshLodView);
+			
+			tree.leaves.position = tree.position;
+			tree.leaves.rotation = tree.rotation;
+		});
+
+		trees_spawn_fruit_trees(game->trees);
+	});
+
+	frame_systems_add(systems, "leaves", FrameData_none, FrameData_trees, [&](s32 workerIndex)
 	{
-		leaves_update(tree.leaves, scaledTime, tree.settings->leafSize);
-	}
+		parallel_for(game->trees.array.count, 8, [game, scaledTime](s32 treeIndex, s32 workerIndex)
+		{
+			Tree & tree = game->trees.array[treeIndex];
+			leaves_update(tree.leaves, jobs_get_scratch_memory(workerIndex), scaledTime, tree.settings->leafSize);
+		});
+	});
 
 	// ---------- PROCESS AUDIO -------------------------
 
+	frame_systems_add(systems, "audio mixing",
+		FrameData_player | FrameData_noble_person,
+		FrameData_audio | FrameData_random,
+		[&](s32 workerIndex)
 	{
 		local_persist f32 timeToSpawnAudioOnOtherGuy = 0;
 		timeToSpawnAudioOnOtherGuy -= scaledTime;
@@ -1282,7 +1319,18 @@ internal bool32 game_game_update(Game * 				game,
 				}
 			}
 		}
-	}
+	});
+
+	// Note(Leo): This is last, so that everything has moved, and index is up to date for next frame
+	frame_systems_add(systems, "entity index",
+		FrameData_boxes | FrameData_small_pots | FrameData_raccoons | FrameData_trees,
+		FrameData_entity_index,
+		[&](s32 workerIndex)
+	{
+		game_update_entity_index(game);
+	});
+
+	frame_systems_run(systems, &game->frameSystemReport);
 
 	// ------------------------------------------------------------------------
 
@@ -1486,6 +1534,7 @@ internal Game * game_load_game(MemoryArena & persistentMemory, PlatformFileHandl
 
 			game->collisionSystem.terrainCollider 	= heightmap;
 			game->collisionSystem.terrainOffset = {{-mapSize / 2, -mapSize / 2, 0}};
+			collision_system_build_terrain_pyramid(game->collisionSystem, persistentMemory);
 
 			MeshAssetData seaMeshAsset = {};
 			{
@@ -1766,11 +1815,9 @@ internal Game * game_load_game(MemoryArena & persistentMemory, PlatformFileHandl
 	// ----------------------------------------------------------------------------------
 	
 	{	
-		game->trees.array = push_array<Tree>(persistentMemory, 200, ALLOC_ZERO_MEMORY);
-		for (s32 i = 0; i < game->trees.array.capacity; ++i)
-		{
-			allocate_tree_memory(persistentMemory, game->trees.array.memory[i]);
-		}
+		// Note(Leo): Trees' memory is taken from pool as they grow, and returned when tree is reset
+		game->trees.array 		= push_array<Tree>(persistentMemory, 200, ALLOC_ZERO_MEMORY);
+		game->trees.memoryPool 	= memory_pool(persistentMemory, trees_default_memory_budget);
 		game->trees.selectedIndex = 0;
 	}
 
@@ -1796,6 +1843,21 @@ internal Game * game_load_game(MemoryArena & persistentMemory, PlatformFileHandl
 		game->boxes.carriedEntities[1] = {EntityType_tree_3, game_spawn_tree(*game, boxPosition0 + v3{0,0,0.1}, 1, false)};
 	}
 
+	/// ENTITY INDEX
+	{
+		// Note(Leo): Cell sizes are about pickup and interaction distances, so queries touch only few cells
+		f32 entityIndexCellSize = 2;
+
+		EntitySpatialIndex & index = game->entityIndex;
+		entity_spatial_index_add_type(index, EntityType_box, persistentMemory, game->boxes.count, entityIndexCellSize);
+		entity_spatial_index_add_type(index, EntityType_small_pot, persistentMemory, game->smallPots.capacity, entityIndexCellSize);
+		entity_spatial_index_add_type(index, EntityType_raccoon, persistentMemory, game->raccoonCount, entityIndexCellSize);
+		entity_spatial_index_add_type(index, EntityType_tree_3, persistentMemory, game->trees.array.capacity, entityIndexCellSize);
+		index.waterGrid = &game->waters.grid;
+
+		game_update_entity_index(game);
+	}
+
 
 	// ----------------------------------------------------------------------------------
 
@@ -1810,42 +1872,27 @@ internal Game * game_load_game(MemoryArena & persistentMemory, PlatformFileHandl
 	game->selectedBuildingBlockIndex = 0;
 	game->selectedBuildingPipeIndex = 0;
 
-	// ----------------------------------------------------------------------------------
-
 	{
-		// struct MeshAssetData
-		// {
-		// 	s64 				vertexCount;
-		// 	Vertex * 			vertices;
-		// 	VertexSkinData * 	skinning;
-
-		// 	s64 	indexCount;
-		// 	u16 * 	indices;
-
-		// 	MeshIndexType indexType = MeshIndexType_uint16;
+		auto checkpoint 			= memory_push_checkpoint(*global_transientMemory);
+		auto pipeMesh 				= assets_get_mesh_asset_data(game->assets, MeshAssetId_default_cylinder, *global_transientMemory);
+		game->buildingPipeCollider 	= make_triangle_mesh_collider(persistentMemory, pipeMesh);
+		memory_pop_checkpoint(*global_transientMemory, checkpoint);
+	}
 
+	// ----------------------------------------------------------------------------------
 
+	{
 		game->castlePosition = {70, 70, 20};
 
-		auto castleMesh 	= assets_get_mesh_asset_data(game->assets, MeshAssetId_castle_main, *global_transientMemory);
-		s64 triangleCount 	= castleMesh.indexCount / 3;
+		auto checkpoint 		= memory_push_checkpoint(*global_transientMemory);
+		auto castleMesh 		= assets_get_mesh_asset_data(game->assets, MeshAssetId_castle_main, *global_transientMemory);
+		game->castleCollider 	= make_triangle_mesh_collider(persistentMemory, castleMesh);
+		memory_pop_checkpoint(*global_transientMemory, checkpoint);
 
-		game->collisionSystem.triangleColliders = push_array<TriangleCollider>(persistentMemory, triangleCount, ALLOC_GARBAGE);
-
-		for (s64 i = 0; i < triangleCount; ++i)
-		{
-			s64 t0 = castleMesh.indices[i * 3 + 0];
-			s64 t1 = castleMesh.indices[i * 3 + 1];
-			s64 t2 = castleMesh.indices[i * 3 + 2];
-
-			TriangleCollider collider = {};
-			collider.vertices[0] = castleMesh.vertices[t0].position + game->castlePosition;
-			collider.vertices[1] = castleMesh.vertices[t1].position + game->castlePosition;
-			collider.vertices[2] = castleMesh.vertices[t2].position + game->castlePosition;
-
-			game->collisionSystem.triangleColliders.push(collider);
-		}
+		push_static_triangle_mesh_collider(game->collisionSystem, game->castleCollider, translation_matrix(game->castlePosition));
 
+		// Note(Leo): Castle is last static collider, so we can build this now. Its mesh has its own tree, so it is not in this one.
+		collision_system_build_static_bvh(game->collisionSystem, persistentMemory);
 	}
 	// ----------------------------------------------------------------------------------
 
@@ -1861,10 +1908,12 @@ internal Game * game_load_game(MemoryArena & persistentMemory, PlatformFileHandl
 	// ----------------------------------------------------------------------------------
 
 	log_application(0, "Game loaded, ", used_percent(*global_transientMemory) * 100, "% of transient memory used. ",
-					reverse_gigabytes(global_transientMemory->used), "/", reverse_gigabytes(global_transientMemory->size), " GB");
+					reverse_gigabytes(global_transientMemory->used), "/", reverse_gigabytes(global_transientMemory->committed), "/",
+					reverse_gigabytes(global_transientMemory->size), " GB used/committed/reserved");
 
-	log_application(0, "Game loaded, ", used_percent(persistentMemory) * 100, "% of transient memory used. ",
-					reverse_gigabytes(persistentMemory.used), "/", reverse_gigabytes(persistentMemory.size), " GB");
+	log_application(0, "Game loaded, ", used_percent(persistentMemory) * 100, "% of persistent memory used. ",
+					reverse_gigabytes(persistentMemory.used), "/", reverse_gigabytes(persistentMemory.committed), "/",
+					reverse_gigabytes(persistentMemory.size), " GB used/committed/reserved");
 
 	return game;
 }
@@ -46,6 +46,11 @@ internal void memory_set(void * memory, char  value, u64 size)
 	memset(memory, value, size);
 }
 
+internal bool32 memory_equals(void const * a, void const * b, u64 size)
+{
+	return memcmp(a, b, size) == 0;
+}
+
 template<typename T>
 T memory_convert_bytes_to(byte const * bytes, u64 offset)
 {
@@ -65,8 +70,210 @@ void memory_swap(T & a, T & b)
 	b 		= temp;
 }
 
+// ------------- MEMORY INSTRUMENTATION ----------------------------------------
+
+/*
+Note(Leo): Instrumented arenas record every allocation by callsite, so that when arena runs out, or
+we want to tune its size, we can see who used the space. This is only compiled in development, and
+even then only arenas that have 'instrumentation' set pay for it. In release MemoryCallsite is empty,
+so passing it around costs nothing.
+
+Allocating functions take callsite as last argument, which defaults to caller's file and line. Functions
+that allocate on behalf of their caller, like push_array, take it too and pass it on, so that allocation
+is recorded to their caller. Report and editor are on game side, see memory_instrumentation.cpp.
+*/
+#if defined FS_DEVELOPMENT
+	#define FS_MEMORY_INSTRUMENTATION_ENABLED
+#endif
+
+#if defined FS_MEMORY_INSTRUMENTATION_ENABLED
+
+	struct MemoryCallsite
+	{
+		char const * 	file;
+		s32 			line;
+
+		// Note(Leo): When this is used as default argument, these are evaluated where function is called
+		static MemoryCallsite here(char const * file = __builtin_FILE(), s32 line = __builtin_LINE())
+		{
+			return {file, line};
+		}
+	};
+
+#else
+
+	struct MemoryCallsite
+	{
+		static MemoryCallsite here() { return {}; }
+	};
+
+#endif
+
+#if defined FS_MEMORY_INSTRUMENTATION_ENABLED
+
+constexpr s32 memory_instrumentation_callsite_capacity 	= 1024;
+constexpr s32 memory_instrumentation_frame_history 		= 128;
+
+/*
+Note(Leo): 'bytes' is space that allocations took from arena, ie. 'requested' plus 'padding' plus
+'rounding' plus 'alignUpExtra', since last flush. 'padding' is where start was moved forward for types
+that need more than default alignment. 'rounding' is what is needed to round size up to default
+alignment, and 'alignUpExtra' is what memory_align_up adds on top of that, since it always adds one
+more alignment even if size was aligned already.
+
+Popping checkpoints does not remove allocations, so those are counted until flush.
+*/
+struct MemoryCallsiteStats
+{
+	char const * 	file;
+	s32 			line;
+
+	s64 	count;
+	u64 	bytes;
+	u64 	requested;
+	u64 	padding;
+	u64 	rounding;
+	u64 	alignUpExtra;
+
+	// Note(Leo): Largest 'bytes' before flush, and count since instrumentation was attached
+	u64 	peakBytes;
+	s64 	totalCount;
+};
+
+struct MemoryArena;
+using MemoryOutOfMemoryFunc = void(MemoryArena & arena, u64 size, MemoryCallsite callsite);
+
+struct MemoryArenaInstrumentation
+{
+	char name [32];
+
+	// Note(Leo): Open addressing table, callsites that do not fit go to 'overflow'
+	MemoryCallsiteStats callsites [memory_instrumentation_callsite_capacity];
+	s32 				callsiteCount;
+	MemoryCallsiteStats overflow;
+
+	// Note(Leo): Sums of all callsites
+	MemoryCallsiteStats total;
+
+	// Note(Leo): Largest 'used' of current frame, and of previous frames in ring buffer
+	s64 	frameIndex;
+	u64 	frameHighWaterMark;
+	u64 	frameHistory [memory_instrumentation_frame_history];
+	u64 	peakHighWaterMark;
+	s64 	peakFrameIndex;
+
+	// Note(Leo): Called before arena asserts that it is out of memory
+	MemoryOutOfMemoryFunc * outOfMemory;
+};
+
+internal u64 memory_instrumentation_callsite_hash(MemoryCallsite callsite)
+{
+	u64 hash = ((u64)callsite.file ^ ((u64)callsite.line << 40)) * 0x9e3779b97f4a7c15ull;
+	return hash >> 32;
+}
+
+internal MemoryCallsiteStats & memory_instrumentation_get_callsite(MemoryArenaInstrumentation & instrumentation, MemoryCallsite callsite)
+{
+	constexpr s32 mask = memory_instrumentation_callsite_capacity - 1;
+	static_assert((memory_instrumentation_callsite_capacity & mask) == 0);
+
+	s32 index = (s32)(memory_instrumentation_callsite_hash(callsite) & mask);
+
+	while (instrumentation.callsites[index].file != nullptr)
+	{
+		MemoryCallsiteStats & stats = instrumentation.callsites[index];
+		if (stats.file == callsite.file && stats.line == callsite.line)
+		{
+			return stats;
+		}
+
+		index = (index + 1) & mask;
+	}
+
+	// Note(Leo): Keep table at most 3/4 full, so that probing stays short
+	if (instrumentation.callsiteCount * 4 >= memory_instrumentation_callsite_capacity * 3)
+	{
+		return instrumentation.overflow;
+	}
+
+	instrumentation.callsiteCount += 1;
+	instrumentation.callsites[index].file = callsite.file;
+	instrumentation.callsites[index].line = callsite.line;
+
+	return instrumentation.callsites[index];
+}
+
+internal void memory_instrumentation_add(MemoryCallsiteStats & stats, u64 requested, u64 padding, u64 rounding, u64 alignUpExtra)
+{
+	stats.count 		+= 1;
+	stats.totalCount 	+= 1;
+	stats.requested 	+= requested;
+	stats.padding 		+= padding;
+	stats.rounding 		+= rounding;
+	stats.alignUpExtra 	+= alignUpExtra;
+	stats.bytes 		+= requested + padding + rounding + alignUpExtra;
+
+	if (stats.bytes > stats.peakBytes)
+	{
+		stats.peakBytes = stats.bytes;
+	}
+}
+
+internal void memory_instrumentation_record(MemoryArenaInstrumentation & instrumentation, MemoryCallsite callsite,
+											u64 requested, u64 padding, u64 rounding, u64 alignUpExtra, u64 used)
+{
+	memory_instrumentation_add(memory_instrumentation_get_callsite(instrumentation, callsite), requested, padding, rounding, alignUpExtra);
+	memory_instrumentation_add(instrumentation.total, requested, padding, rounding, alignUpExtra);
+
+	if (used > instrumentation.frameHighWaterMark)
+	{
+		instrumentation.frameHighWaterMark = used;
+	}
+}
+
+// Note(Leo): Call at start of each frame, 'used' is arena's current 'used'
+internal void memory_instrumentation_begin_frame(MemoryArenaInstrumentation & instrumentation, u64 used)
+{
+	if (instrumentation.frameHighWaterMark > instrumentation.peakHighWaterMark)
+	{
+		instrumentation.peakHighWaterMark 	= instrumentation.frameHighWaterMark;
+		instrumentation.peakFrameIndex 		= instrumentation.frameIndex;
+	}
+
+	instrumentation.frameHistory[instrumentation.frameIndex % memory_instrumentation_frame_history] = instrumentation.frameHighWaterMark;
+
+	instrumentation.frameIndex 			+= 1;
+	instrumentation.frameHighWaterMark 	= used;
+}
+
+internal void memory_instrumentation_flush(MemoryArenaInstrumentation & instrumentation)
+{
+	auto flush = [](MemoryCallsiteStats & stats)
+	{
+		stats.count 		= 0;
+		stats.bytes 		= 0;
+		stats.requested 	= 0;
+		stats.padding 		= 0;
+		stats.rounding 		= 0;
+		stats.alignUpExtra 	= 0;
+	};
+
+	for (MemoryCallsiteStats & stats : instrumentation.callsites)
+	{
+		flush(stats);
+	}
+	flush(instrumentation.overflow);
+	flush(instrumentation.total);
+}
+
+#endif
+
 // ------------- MEMORY ARENA ----------------------------------------
 
+// Note(Leo): Virtual memory functions for arenas whose memory is only reserved, see memory_arena_virtual
+using MemoryCommitFunc 		= bool32(void * memory, u64 size);
+using MemoryDecommitFunc 	= void(void * memory, u64 size);
+
 struct MemoryArena
 {
 	// Todo(Leo): Is this appropriate??
@@ -77,6 +284,26 @@ struct MemoryArena
 	u64 	used;
 
 	u64 	checkpoint;
+
+	// Note(Leo): Largest 'used' since last flush, so for transient arena this is peak of current frame
+	u64 	highWaterMark;
+
+	/*
+	Note(Leo): Only first 'committed' bytes of 'size' can be used. For normal arenas they are same, but
+	virtual arenas have only reserved 'size' bytes of address space, and commit more in steps of
+	'commitStep' when 'used' grows past 'committed'. If 'decommitOnFlush' is set, flushing decommits
+	everything but first step, so that memory is given back when arena is emptied.
+	*/
+	u64 					committed;
+	u64 					commitStep;
+	bool32 					decommitOnFlush;
+	MemoryCommitFunc * 		commit;
+	MemoryDecommitFunc * 	decommit;
+
+	#if defined FS_MEMORY_INSTRUMENTATION_ENABLED
+	// Note(Leo): Set this to record allocations, see MemoryArenaInstrumentation
+	MemoryArenaInstrumentation * instrumentation;
+	#endif
 };
 
 internal MemoryArena
@@ -87,25 +314,75 @@ memory_arena(byte * memory, u64 size)
 		.memory = memory,
 		.size = size,
 		.used = 0,
+		.committed = size,
 	};
 	return resultArena;
 }
 
-internal void *
-memory_arena_allocate(MemoryArena & allocator, u64 size)
+// Note(Leo): Commits at least up to 'used', rounded up to commit step
+internal void memory_arena_commit(MemoryArena & arena, u64 used)
 {
-	Assert((allocator.used + size) <= allocator.size);
+	Assert(arena.commit != nullptr && "Arena is out of memory, and it is not virtual");
+
+	u64 committed = ((used + arena.commitStep - 1) / arena.commitStep) * arena.commitStep;
+	committed 		= committed < arena.size ? committed : arena.size;
+
+	bool32 success = arena.commit(arena.memory + arena.committed, committed - arena.committed);
+	AssertRelease(success, "Failed to commit memory to arena");
+
+	arena.committed = committed;
+}
 
+internal void *
+memory_arena_allocate(MemoryArena & allocator, u64 size, u64 alignment = MemoryArena::defaultAlignment, MemoryCallsite callsite = MemoryCallsite::here())
+{
 	/*
 	Note(Leo): we align size, so start is always at aligned position.
 	Todo(Leo): this assumes that the original memory is at aligned position, which it maybe is not
+
+	Types that need more than default alignment, like ones with SSE members, also move start forward.
 	*/
 
 	u64 start 		= allocator.used;
+	if (alignment > MemoryArena::defaultAlignment)
+	{
+		start = (start + alignment - 1) & ~(alignment - 1);
+	}
+
+	#if defined FS_MEMORY_INSTRUMENTATION_ENABLED
+	if (allocator.instrumentation != nullptr && (start + size) > allocator.size && allocator.instrumentation->outOfMemory != nullptr)
+	{
+		allocator.instrumentation->outOfMemory(allocator, size, callsite);
+	}
+	#endif
+
+	Assert((start + size) <= allocator.size);
+
+	u64 requested 	= size;
 	size 			= memory_align_up(size, MemoryArena::defaultAlignment);
 	void * result 	= allocator.memory + start;
+
+	#if defined FS_MEMORY_INSTRUMENTATION_ENABLED
+	if (allocator.instrumentation != nullptr)
+	{
+		u64 roundedSize = (requested + MemoryArena::defaultAlignment - 1) & ~(MemoryArena::defaultAlignment - 1);
+		memory_instrumentation_record(*allocator.instrumentation, callsite, requested, start - allocator.used,
+									roundedSize - requested, size - roundedSize, start + size);
+	}
+	#endif
+
 	allocator.used 	= start + size;
 
+	if (allocator.used > allocator.committed)
+	{
+		memory_arena_commit(allocator, allocator.used);
+	}
+
+	if (allocator.used > allocator.highWaterMark)
+	{
+		allocator.highWaterMark = allocator.used;
+	}
+
 	return result;
 }
 
@@ -114,8 +391,22 @@ memory_arena_allocate(MemoryArena & allocator, u64 size)
 internal void
 flush_memory_arena(MemoryArena * arena)
 {
-	arena->used 		= 0;
-	arena->checkpoint 	= 0;
+	arena->used 			= 0;
+	arena->checkpoint 		= 0;
+	arena->highWaterMark 	= 0;
+
+	#if defined FS_MEMORY_INSTRUMENTATION_ENABLED
+	if (arena->instrumentation != nullptr)
+	{
+		memory_instrumentation_flush(*arena->instrumentation);
+	}
+	#endif
+
+	if (arena->decommitOnFlush && arena->committed > arena->commitStep)
+	{
+		arena->decommit(arena->memory + arena->commitStep, arena->committed - arena->commitStep);
+		arena->committed = arena->commitStep;
+	}
 }
 
 internal f32 used_percent(MemoryArena & arena)
@@ -179,10 +470,10 @@ enum AllocOperation : s32
 };
 
 template <typename T>
-internal T* push_memory(MemoryArena & arena, s32 count, AllocOperation options)
+internal T* push_memory(MemoryArena & arena, s32 count, AllocOperation options, MemoryCallsite callsite = MemoryCallsite::here())
 {
 	u64 size 	= sizeof(T) * count;
-	T * result 	= reinterpret_cast<T*>(memory_arena_allocate(arena, size));
+	T * result 	= reinterpret_cast<T*>(memory_arena_allocate(arena, size, alignof(T), callsite));
 
 	if (options == ALLOC_ZERO_MEMORY)
 	{
@@ -202,9 +493,9 @@ internal T* push_memory(MemoryArena & arena, s32 count, AllocOperation options)
 }
 
 template <typename T>
-internal T * push_and_copy_memory(MemoryArena & arena, s32 count, T const * source)
+internal T * push_and_copy_memory(MemoryArena & arena, s32 count, T const * source, MemoryCallsite callsite = MemoryCallsite::here())
 {
-	T * result = push_memory<T>(arena, count, ALLOC_GARBAGE);
+	T * result = push_memory<T>(arena, count, ALLOC_GARBAGE, callsite);
 	memory_copy(result, source, count * sizeof(T));
 	return result;
 };
@@ -223,5 +514,112 @@ internal void push_multiple_memories(MemoryArena & arena, s32 count, AllocOperat
 	}
 }
 
+/// ------------- MEMORY POOL ---------------------------------------
+
+/*
+Note(Leo): Pool of power of two sized blocks, for things that grow and shrink while game runs, like
+trees. Blocks are taken from backing arena only when there is no free block of that size, and freed
+blocks are kept in free lists per size to be reused. Pool never takes more than 'budget' bytes from
+backing arena, and allocating returns nullptr when that would happen.
+
+Backing arena must live as long as pool. This is not thread safe.
+*/
+
+constexpr s32 memory_pool_min_block_size_log2 	= 6;
+constexpr s32 memory_pool_size_class_count 		= 32;
+
+struct MemoryPoolFreeBlock
+{
+	MemoryPoolFreeBlock * next;
+};
+
+struct MemoryPool
+{
+	MemoryArena * 			backingArena;
+	u64 					budget;
+
+	// Note(Leo): 'reserved' is taken from backing arena, 'used' is in blocks that are not free
+	u64 					reserved;
+	u64 					used;
+
+	MemoryPoolFreeBlock * 	freeBlocks [memory_pool_size_class_count];
+};
+
+internal MemoryPool memory_pool(MemoryArena & backingArena, u64 budget)
+{
+	MemoryPool pool 	= {};
+	pool.backingArena 	= &backingArena;
+	pool.budget 		= budget;
+	return pool;
+}
+
+internal s32 memory_pool_size_class(u64 size)
+{
+	s32 sizeClass = 0;
+	while(((u64)1 << (sizeClass + memory_pool_min_block_size_log2)) < size)
+	{
+		sizeClass += 1;
+	}
+
+	Assert(sizeClass < memory_pool_size_class_count);
+	return sizeClass;
+}
+
+// Note(Leo): Actual size of block that is allocated for 'size', ie. how much of it can be used
+internal u64 memory_pool_block_size(u64 size)
+{
+	return (u64)1 << (memory_pool_size_class(size) + memory_pool_min_block_size_log2);
+}
+
+internal void * memory_pool_allocate(MemoryPool & pool, u64 size, MemoryCallsite callsite = MemoryCallsite::here())
+{
+	s32 sizeClass 	= memory_pool_size_class(size);
+	u64 blockSize 	= (u64)1 << (sizeClass + memory_pool_min_block_size_log2);
+	void * result 	= nullptr;
+
+	if (pool.freeBlocks[sizeClass] != nullptr)
+	{
+		MemoryPoolFreeBlock * block 	= pool.freeBlocks[sizeClass];
+		pool.freeBlocks[sizeClass] 		= block->next;
+		result 							= block;
+	}
+	else
+	{
+		MemoryArena & arena = *pool.backingArena;
+
+		bool32 fitsBudget 	= pool.reserved + blockSize <= pool.budget;
+		bool32 fitsArena 	= arena.used + blockSize <= arena.size;
+
+		if (fitsBudget == false || fitsArena == false)
+		{
+			return nullptr;
+		}
+
+		result 			= memory_arena_allocate(arena, blockSize, MemoryArena::defaultAlignment, callsite);
+		pool.reserved 	+= blockSize;
+	}
+
+	pool.used += blockSize;
+	return result;
+}
+
+// Note(Leo): 'size' must be same that was used to allocate 'memory'
+internal void memory_pool_free(MemoryPool & pool, void * memory, u64 size)
+{
+	if (memory == nullptr)
+	{
+		return;
+	}
+
+	s32 sizeClass 	= memory_pool_size_class(size);
+	u64 blockSize 	= (u64)1 << (sizeClass + memory_pool_min_block_size_log2);
+
+	MemoryPoolFreeBlock * block = reinterpret_cast<MemoryPoolFreeBlock*>(memory);
+	block->next 				= pool.freeBlocks[sizeClass];
+	pool.freeBlocks[sizeClass] 	= block;
+
+	pool.used -= blockSize;
+}
+
 // ----------------------------------------------------------------------------
 
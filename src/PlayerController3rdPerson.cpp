@@ -169,9 +169,9 @@ internal void player_update(Player & player, Game * game)
 
 				if (pickup)
 				{
-					for (s32 i = 0; i < game->waters.count; ++i)
+					for (s32 i = 0; i < game->waters.data.count; ++i)
 					{
-						if (v3_length(playerPosition - game->waters.positions[i]) < playerPickupDistance)
+						if (v3_length(playerPosition - game->waters.positions()[i]) < playerPickupDistance)
 						{
 							game->player.carriedEntity = {EntityType_water, i};
 							pickup = false;
@@ -5,28 +5,79 @@ Pseudo random generator. This is rather important for the game since levels
 are procedurally generated, so we will implement this ourselves.
 =============================================================================*/
 
+// Note(Leo): State is global instead of function statics, so that it can be seeded for replays
+struct RandomState
+{
+	u32 x;
+	u32 y;
+	u32 z;
+	u32 w;
+};
+
+static RandomState random_state = {123456789, 362436069, 521288629, 88675123};
+
+// Note(Leo): Seed 0 gives the original constants. Each word is different, so state never becomes all zeros.
+internal RandomState random_state_from_seed(u32 seed)
+{
+	RandomState state = {123456789 ^ seed, 362436069 ^ seed, 521288629 ^ seed, 88675123 ^ seed};
+	return state;
+}
+
+internal void random_set_seed(u32 seed)
+{
+	random_state = random_state_from_seed(seed);
+}
+
+// Note(Leo): Murmur3 finalizer, for making seeds from things that are close to each other, like positions
+internal u32 random_hash(u32 value)
+{
+	value ^= value >> 16;
+	value *= 0x85ebca6b;
+	value ^= value >> 13;
+	value *= 0xc2b2ae35;
+	value ^= value >> 16;
+	return value;
+}
+
+internal u32 random_hash_combine(u32 hash, u32 value)
+{
+	return random_hash(hash ^ (value + 0x9e3779b9 + (hash << 6) + (hash >> 2)));
+}
+
 // Note(Leo): From https://codingforspeed.com/using-faster-psudo-random-generator-xorshift/
-u32 xor128()
+u32 xor128(RandomState & state)
 {
-	static u32 x = 123456789;
-	static u32 y = 362436069;
-	static u32 z = 521288629;
-	static u32 w = 88675123;
+	u32 & x = state.x;
+	u32 & y = state.y;
+	u32 & z = state.z;
+	u32 & w = state.w;
 	u32 t;
 	t = x ^ (x << 11);   
 	x = y; y = z; z = w;   
 	return w = w ^ (w >> 19) ^ (t ^ (t >> 8));
 }
 
-internal f32 random_value()
+u32 xor128()
+{
+	return xor128(random_state);
+}
+
+/* Note(Leo): Functions that take RandomState use that stream instead of global one. Use them for things
+that are updated in parallel, or that must not depend on what else has taken random values before. */
+internal f32 random_value(RandomState & state)
 {
-	f32 value 	= static_cast<f32>(xor128());
+	f32 value 	= static_cast<f32>(xor128(state));
 	f32 max 	= static_cast<f32>(max_value_u32);
 	f32 result 	= value / max;
 
 	return result;	
 }
 
+internal f32 random_value()
+{
+	return random_value(random_state);
+}
+
 internal bool random_choice()
 {
 	return xor128() & 0x00000001;	
@@ -38,17 +89,22 @@ internal bool32 random_choice_probability(f32 probability)
 	return result;
 }
 
-internal f32 random_range(f32 min, f32 max)
+internal f32 random_range(RandomState & state, f32 min, f32 max)
 {
 	AssertMsg (min <= max, "'min' must be smaller than 'max'");
 
-	f32 value = static_cast<f32>(xor128()) / static_cast<f32>(max_value_u32);
+	f32 value = static_cast<f32>(xor128(state)) / static_cast<f32>(max_value_u32);
 	f32 range = max - min;
 	f32 result = min + (value * range);
 
 	return result;    
 }
 
+internal f32 random_range(f32 min, f32 max)
+{
+	return random_range(random_state, min, max);
+}
+
 internal v3 random_inside_unit_square()
 {
 	v3 result = {random_range(0,1), random_range(0,1), 0};
@@ -41,12 +41,59 @@ struct Array
 
 /// Todo(Leo): this is maybe stupid
 template<typename T>
-internal Array<T> push_array(MemoryArena & allocator, s64 capacity, AllocOperation options)
+internal Array<T> push_array(MemoryArena & allocator, s64 capacity, AllocOperation options, MemoryCallsite callsite = MemoryCallsite::here())
 {
-	Array<T> result = {capacity, 0, push_memory<T>(allocator, capacity, options)};
+	Array<T> result = {capacity, 0, push_memory<T>(allocator, capacity, options, callsite)};
 	return result;
 }
 
+/*
+Note(Leo): For arrays whose memory is from MemoryPool. Grows capacity to at least 'capacity', and at least
+doubles it, so that growing one by one is not slow. Existing elements are copied and new ones are zeroed.
+Returns false and leaves array as it was if pool is out of budget.
+*/
+template<typename T>
+internal bool32 array_reserve(MemoryPool & pool, Array<T> & array, s64 capacity, MemoryCallsite callsite = MemoryCallsite::here())
+{
+	if (capacity <= array.capacity)
+	{
+		return true;
+	}
+
+	s64 newCapacity = array.capacity * 2 > capacity ? array.capacity * 2 : capacity;
+	u64 blockSize 	= memory_pool_block_size(newCapacity * sizeof(T));
+	newCapacity 	= blockSize / sizeof(T);
+
+	T * newMemory = reinterpret_cast<T*>(memory_pool_allocate(pool, blockSize, callsite));
+	if (newMemory == nullptr)
+	{
+		return false;
+	}
+
+	memory_copy(newMemory, array.memory, array.count * sizeof(T));
+	memset(newMemory + array.count, 0, (newCapacity - array.count) * sizeof(T));
+
+	if (array.memory != nullptr)
+	{
+		memory_pool_free(pool, array.memory, array.capacity * sizeof(T));
+	}
+
+	array.memory 	= newMemory;
+	array.capacity 	= newCapacity;
+
+	return true;
+}
+
+template<typename T>
+internal void array_free(MemoryPool & pool, Array<T> & array)
+{
+	if (array.memory != nullptr)
+	{
+		memory_pool_free(pool, array.memory, array.capacity * sizeof(T));
+	}
+	array = {};
+}
+
 template<typename T>
 internal void array_clear(Array<T> & array)
 {
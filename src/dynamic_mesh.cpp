@@ -19,3 +19,15 @@ internal void flush_dynamic_mesh(DynamicMesh & mesh)
 	mesh.vertices.count = 0;
 	mesh.indices.count 	= 0;
 };
+
+// Note(Leo): For meshes whose memory is from MemoryPool, see array_reserve
+internal bool32 dynamic_mesh_reserve(MemoryPool & pool, DynamicMesh & mesh, s64 vertexCapacity, s64 indexCapacity)
+{
+	return array_reserve(pool, mesh.vertices, vertexCapacity) && array_reserve(pool, mesh.indices, indexCapacity);
+}
+
+internal void dynamic_mesh_free(MemoryPool & pool, DynamicMesh & mesh)
+{
+	array_free(pool, mesh.vertices);
+	array_free(pool, mesh.indices);
+}
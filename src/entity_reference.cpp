@@ -0,0 +1,40 @@
+/*
+Leo Tamminen
+
+Entity references. These are here and not in Game.cpp, so that systems included before game, like
+collisions, can tell which entity something belongs to.
+*/
+
+// Todo(Leo): maybe Actor? as opposed to static Scenery
+enum EntityType : s32
+{ 	
+	// Todo(Leo): none should be default value, but really it would be better to have it not
+	// contribute to count, basically be below 0 or above count
+	EntityType_none,
+	
+	EntityType_small_pot,
+	EntityType_big_pot,
+	EntityType_water,
+	EntityType_raccoon,
+	EntityType_tree_3,
+	EntityType_box,
+
+	EntityTypeCount
+};
+
+struct EntityReference
+{
+	EntityType 	type;
+	s32 		index;
+};
+
+bool operator == (EntityReference const & a, EntityReference const & b)
+{
+	bool result = a.type == b.type && a.index == b.index;
+	return result;
+}
+
+bool operator != (EntityReference const & a, EntityReference const & b)
+{
+	return !(a == b);
+}
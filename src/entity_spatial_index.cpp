@@ -0,0 +1,208 @@
+/*
+Leo Tamminen
+
+Spatial index for entities, so that pickup, interaction and such do not need to go through every
+entity of every type. There is one spatial hash grid per entity type, and entity index is also
+its item index in grid, so EntityReference maps directly to grid item.
+
+Waters keep their own grid in Waters, since they are added and removed all the time from several
+places, and here is only a pointer to it.
+
+Positions are not stored here, and queries take a 'get_position(EntityReference)' functor, so
+that this does not need to know about Game.
+*/
+
+using EntityTypeFlags = u32;
+enum EntityTypeFlag : EntityTypeFlags
+{
+	EntityTypeFlag_small_pot 	= 1 << EntityType_small_pot,
+	EntityTypeFlag_big_pot 		= 1 << EntityType_big_pot,
+	EntityTypeFlag_water 		= 1 << EntityType_water,
+	EntityTypeFlag_raccoon 		= 1 << EntityType_raccoon,
+	EntityTypeFlag_tree_3 		= 1 << EntityType_tree_3,
+	EntityTypeFlag_box 			= 1 << EntityType_box,
+
+	EntityTypeFlag_all 			= EntityTypeFlag_small_pot
+								| EntityTypeFlag_big_pot
+								| EntityTypeFlag_water
+								| EntityTypeFlag_raccoon
+								| EntityTypeFlag_tree_3
+								| EntityTypeFlag_box,
+};
+
+constexpr s32 entity_spatial_index_max_nearest_count = 16;
+
+struct EntitySpatialIndex
+{
+	// Note(Leo): Indexed by EntityType, grids for types that are not used have zero capacity
+	SpatialHashGrid grids [EntityTypeCount];
+	s32 			counts [EntityTypeCount];
+
+	SpatialHashGrid const * waterGrid;
+};
+
+internal void entity_spatial_index_add_type(	EntitySpatialIndex & index,
+												EntityType type,
+												MemoryArena & allocator,
+												s32 capacity,
+												f32 cellSize)
+{
+	Assert(type != EntityType_water && "Waters have their own grid");
+	index.grids[type] 	= make_spatial_hash_grid(allocator, capacity, cellSize);
+	index.counts[type] 	= 0;
+}
+
+internal SpatialHashGrid const * entity_spatial_index_get_grid(EntitySpatialIndex const & index, EntityType type)
+{
+	if (type == EntityType_water)
+	{
+		return index.waterGrid;
+	}
+
+	return index.grids[type].capacity > 0 ? &index.grids[type] : nullptr;
+}
+
+/*
+Note(Leo): Updates all entities of one type, and removes ones that no longer exist. Moving items
+that stayed in same cell costs only hashing the cell, and there are not many of these types.
+*/
+template<typename TGetPosition>
+internal void entity_spatial_index_update_type(EntitySpatialIndex & index, EntityType type, s32 count, TGetPosition get_position)
+{
+	SpatialHashGrid & grid = index.grids[type];
+	Assert(count <= grid.capacity);
+
+	for (s32 i = 0; i < count; ++i)
+	{
+		spatial_hash_grid_move(grid, i, get_position(i).xy);
+	}
+
+	for (s32 i = count; i < index.counts[type]; ++i)
+	{
+		spatial_hash_grid_remove(grid, i);
+	}
+
+	index.counts[type] = count;
+}
+
+/*
+Note(Leo): Calls 'func(EntityReference entity, f32 distance)' for every entity of given types
+that is closer than 'radius' to 'center'.
+*/
+template<typename TGetPosition, typename TFunc>
+internal void entity_spatial_index_query_radius(	EntitySpatialIndex const & index,
+													v3 center,
+													f32 radius,
+													EntityTypeFlags types,
+													TGetPosition get_position,
+													TFunc func)
+{
+	for (s32 type = 0; type < EntityTypeCount; ++type)
+	{
+		if ((types & (1 << type)) == 0)
+		{
+			continue;
+		}
+
+		SpatialHashGrid const * grid = entity_spatial_index_get_grid(index, (EntityType)type);
+		if (grid == nullptr)
+		{
+			continue;
+		}
+
+		spatial_hash_grid_query(*grid, center.xy, radius, [&](s32 item)
+		{
+			EntityReference entity 	= {(EntityType)type, item};
+			f32 distance 			= v3_length(get_position(entity) - center);
+
+			if (distance < radius)
+			{
+				func(entity, distance);
+			}
+		});
+	}
+}
+
+/*
+Note(Leo): Finds up to 'maxCount' nearest entities of given types closer than 'maxDistance', that
+'filter(EntityReference)' accepts, and writes them nearest first to 'results'. Search starts from
+small radius and grows it, so that lots of far away entities are not visited when there are enough
+near ones. Returns number of entities found.
+*/
+template<typename TGetPosition, typename TFilter>
+internal s32 entity_spatial_index_query_nearest(	EntitySpatialIndex const & index,
+													v3 center,
+													f32 maxDistance,
+													EntityTypeFlags types,
+													s32 maxCount,
+													EntityReference * results,
+													TGetPosition get_position,
+													TFilter filter)
+{
+	Assert(maxCount > 0 && maxCount <= entity_spatial_index_max_nearest_count);
+
+	f32 radius = maxDistance;
+	for (s32 type = 0; type < EntityTypeCount; ++type)
+	{
+		SpatialHashGrid const * grid = entity_spatial_index_get_grid(index, (EntityType)type);
+		if ((types & (1 << type)) && grid != nullptr)
+		{
+			radius = f32_min(radius, grid->cellSize);
+		}
+	}
+
+	// Note(Leo): Distances of results, kept sorted along with results
+	f32 distances [entity_spatial_index_max_nearest_count];
+
+	s32 count = 0;
+
+	while(true)
+	{
+		count = 0;
+
+		entity_spatial_index_query_radius(index, center, radius, types, get_position, [&](EntityReference entity, f32 distance)
+		{
+			if (count == maxCount && distance >= distances[count - 1])
+			{
+				return;
+			}
+
+			if (filter(entity) == false)
+			{
+				return;
+			}
+
+			s32 i = count < maxCount ? count++ : count - 1;
+			for (; i > 0 && distances[i - 1] > distance; --i)
+			{
+				distances[i] 	= distances[i - 1];
+				results[i] 		= results[i - 1];
+			}
+
+			distances[i] 	= distance;
+			results[i] 		= entity;
+		});
+
+		// Note(Leo): Everything not visited is farther than radius, so these are nearest ones
+		if (count == maxCount || radius >= maxDistance)
+		{
+			break;
+		}
+
+		radius = f32_min(radius * 2, maxDistance);
+	}
+
+	return count;
+}
+
+template<typename TGetPosition, typename TFilter>
+internal bool32 entity_spatial_index_find_nearest(	EntitySpatialIndex const & index,
+													v3 center,
+													f32 maxDistance,
+													EntityTypeFlags types,
+													EntityReference * result,
+													TGetPosition get_position,
+													TFilter filter)
+{
+	return entity_spatial_index_query_nearest(index, center, maxDistance, types, 1, result, get_position, filter) > 0;
+}
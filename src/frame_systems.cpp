@@ -0,0 +1,295 @@
+/*
+Leo Tamminen
+
+Frame systems. Game update is split into systems that declare which parts of game data they
+read and write. Systems are added each frame in the same order they would run in single
+threaded code, and dependency graph is built from that order: a system depends on every
+earlier system that writes something it reads or writes, or reads something it writes.
+
+Systems are then run as jobs as soon as all their dependencies are done, so that systems that
+do not conflict run concurrently, and systems that do, run in the order they were added.
+
+After running, per frame report is made with each system's timing and the critical path, ie.
+the longest chain of dependent systems, which is the limit of how fast the frame can go no
+matter how many workers there are.
+*/
+
+using FrameDataFlags = u32;
+
+// Note(Leo): Add more of these when systems need finer access. Anything not listed here must
+// not be written by systems.
+enum FrameData : FrameDataFlags
+{
+	FrameData_none 				= 0,
+
+	FrameData_player 			= 1 << 0,
+	FrameData_noble_person 		= 1 << 1,
+	FrameData_raccoons 			= 1 << 2,
+	FrameData_boxes 			= 1 << 3,
+	FrameData_small_pots 		= 1 << 4,
+	FrameData_waters 			= 1 << 5,
+	FrameData_clouds 			= 1 << 6,
+	FrameData_trees 			= 1 << 7,
+	FrameData_train 			= 1 << 8,
+	FrameData_metaballs 		= 1 << 9,
+	FrameData_audio 			= 1 << 10,
+	FrameData_physics_world 	= 1 << 11,
+	FrameData_collision_system 	= 1 << 12,
+	FrameData_entity_index 		= 1 << 13,
+
+	// Note(Leo): Shared globals. Random is written by anyone who takes random values, so that those
+	// systems keep their order and results stay deterministic.
+	FrameData_random 			= 1 << 14,
+	FrameData_transient_memory 	= 1 << 15,
+	FrameData_imgui 			= 1 << 16,
+};
+
+constexpr s32 frame_systems_max_count = 32;
+
+using FrameSystemFunc = void(void * data, s32 workerIndex);
+
+struct FrameSystem
+{
+	char const * 		name;
+	FrameDataFlags 		reads;
+	FrameDataFlags 		writes;
+
+	FrameSystemFunc * 	func;
+	void * 				data;
+
+	// Note(Leo): Dependants always have bigger index than their dependencies
+	s32 				dependencyCount;
+	std::atomic<s32> 	remainingDependencyCount;
+	s32 				dependantCount;
+	s32 				dependants [frame_systems_max_count];
+
+	s64 				startTime;
+	s64 				endTime;
+	s32 				workerIndex;
+};
+
+struct FrameSystemGraph;
+
+struct FrameSystemJob
+{
+	FrameSystemGraph * 	graph;
+	s32 				systemIndex;
+};
+
+struct FrameSystemGraph
+{
+	s32 			count;
+	FrameSystem 	systems [frame_systems_max_count];
+	FrameSystemJob 	jobs [frame_systems_max_count];
+
+	JobCounter 		counter;
+};
+
+struct FrameSystemReportEntry
+{
+	char const * 	name;
+	f32 			startMs;
+	f32 			durationMs;
+	s32 			workerIndex;
+	s32 			dependencyCount;
+	bool32 			isOnCriticalPath;
+};
+
+struct FrameSystemReport
+{
+	s32 					count;
+	FrameSystemReportEntry 	entries [frame_systems_max_count];
+
+	// Note(Leo): 'work' is sum of all systems' durations, 'wall' is from first start to last end
+	f32 					wallMs;
+	f32 					workMs;
+	f32 					criticalPathMs;
+
+	bool32 					logEachFrame;
+};
+
+template<typename TFunc>
+internal void frame_system_call(void * data, s32 workerIndex)
+{
+	(*reinterpret_cast<TFunc*>(data))(workerIndex);
+}
+
+/*
+Note(Leo): 'func' is called as func(workerIndex), and it is copied to transient memory, so it can
+be a lambda that captures things from game update by reference. Use worker's scratch memory
+instead of transient memory inside systems.
+*/
+template<typename TFunc>
+internal void frame_systems_add(FrameSystemGraph & graph, char const * name, FrameDataFlags reads, FrameDataFlags writes, TFunc func)
+{
+	static_assert(std::is_trivially_copyable<TFunc>::value, "Frame system functions are copied as bytes");
+	Assert(graph.count < frame_systems_max_count);
+
+	TFunc * data = reinterpret_cast<TFunc*>(push_memory<u8>(*global_transientMemory, sizeof(TFunc), ALLOC_GARBAGE));
+	memory_copy(data, &func, sizeof(TFunc));
+
+	s32 index 				= graph.count;
+	graph.count 			+= 1;
+
+	FrameSystem & system 	= graph.systems[index];
+	system.name 			= name;
+	system.reads 			= reads;
+	system.writes 			= writes;
+	system.func 			= frame_system_call<TFunc>;
+	system.data 			= data;
+	system.dependencyCount 	= 0;
+	system.dependantCount 	= 0;
+
+	for (s32 i = 0; i < index; ++i)
+	{
+		FrameSystem & earlier = graph.systems[i];
+
+		bool32 conflicts = 	(earlier.writes & (reads | writes))
+							|| (earlier.reads & writes);
+
+		if (conflicts)
+		{
+			earlier.dependants[earlier.dependantCount++] = index;
+			system.dependencyCount += 1;
+		}
+	}
+}
+
+internal void frame_systems_run_job(void * data, s32 workerIndex)
+{
+	FrameSystemJob * job 		= reinterpret_cast<FrameSystemJob*>(data);
+	FrameSystemGraph & graph 	= *job->graph;
+	FrameSystem & system 		= graph.systems[job->systemIndex];
+
+	system.workerIndex 	= workerIndex;
+	system.startTime 	= platform_time_now();
+	{
+		FS_PROFILE_SCOPE(system.name);
+		system.func(system.data, workerIndex);
+	}
+	system.endTime 		= platform_time_now();
+
+	// Note(Leo): This job is still counted in graph's counter, so it does not reach zero before dependants are submitted
+	for (s32 i = 0; i < system.dependantCount; ++i)
+	{
+		s32 dependantIndex = system.dependants[i];
+		if (graph.systems[dependantIndex].remainingDependencyCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			Job dependantJob = {frame_systems_run_job, &graph.jobs[dependantIndex]};
+			jobs_submit(platformJobs, 1, &dependantJob, &graph.counter);
+		}
+	}
+}
+
+internal void frame_systems_make_report(FrameSystemGraph & graph, FrameSystemReport & report)
+{
+	s64 frameStartTime 	= graph.systems[0].startTime;
+	s64 frameEndTime 	= graph.systems[0].endTime;
+
+	f32 pathMs 			[frame_systems_max_count];
+	s32 pathPrevious 	[frame_systems_max_count];
+
+	report.count 	= graph.count;
+	report.workMs 	= 0;
+
+	for (s32 i = 0; i < graph.count; ++i)
+	{
+		FrameSystem & system = graph.systems[i];
+
+		frameStartTime 	= system.startTime < frameStartTime ? system.startTime : frameStartTime;
+		frameEndTime 	= system.endTime > frameEndTime ? system.endTime : frameEndTime;
+
+		FrameSystemReportEntry & entry 	= report.entries[i];
+		entry.name 						= system.name;
+		entry.durationMs 				= platform_time_elapsed_seconds(system.startTime, system.endTime) * 1000;
+		entry.workerIndex 				= system.workerIndex;
+		entry.dependencyCount 			= system.dependencyCount;
+		entry.isOnCriticalPath 			= false;
+
+		report.workMs 	+= entry.durationMs;
+		pathMs[i] 		= entry.durationMs;
+		pathPrevious[i] = -1;
+	}
+
+	// Note(Leo): Longest path ending at each system. Dependencies have smaller index, so they are final when we reach them.
+	s32 criticalPathEnd = 0;
+	for (s32 i = 0; i < graph.count; ++i)
+	{
+		FrameSystem & system = graph.systems[i];
+		for (s32 d = 0; d < system.dependantCount; ++d)
+		{
+			s32 dependantIndex 	= system.dependants[d];
+			f32 throughThis 	= pathMs[i] + report.entries[dependantIndex].durationMs;
+
+			if (throughThis > pathMs[dependantIndex])
+			{
+				pathMs[dependantIndex] 			= throughThis;
+				pathPrevious[dependantIndex] 	= i;
+			}
+		}
+
+		report.entries[i].startMs = platform_time_elapsed_seconds(frameStartTime, system.startTime) * 1000;
+
+		if (pathMs[i] > pathMs[criticalPathEnd])
+		{
+			criticalPathEnd = i;
+		}
+	}
+
+	for (s32 i = criticalPathEnd; i >= 0; i = pathPrevious[i])
+	{
+		report.entries[i].isOnCriticalPath = true;
+	}
+
+	report.criticalPathMs 	= pathMs[criticalPathEnd];
+	report.wallMs 			= platform_time_elapsed_seconds(frameStartTime, frameEndTime) * 1000;
+
+	if (report.logEachFrame)
+	{
+		char pathMemory [512];
+		String path = {0, pathMemory};
+
+		for (s32 i = 0; i < report.count; ++i)
+		{
+			if (report.entries[i].isOnCriticalPath)
+			{
+				string_append_format(path, array_count(pathMemory), path.length > 0 ? " -> " : "", report.entries[i].name);
+			}
+		}
+
+		log_application(0, "Frame systems: wall ", report.wallMs, " ms, work ", report.workMs,
+							" ms, critical path ", report.criticalPathMs, " ms: ", path);
+	}
+}
+
+// Note(Leo): Runs all added systems and returns when all are done. Report is optional.
+internal void frame_systems_run(FrameSystemGraph & graph, FrameSystemReport * report)
+{
+	if (graph.count == 0)
+	{
+		return;
+	}
+
+	Job rootJobs [frame_systems_max_count];
+	s32 rootJobCount = 0;
+
+	for (s32 i = 0; i < graph.count; ++i)
+	{
+		graph.jobs[i] = {&graph, i};
+		graph.systems[i].remainingDependencyCount.store(graph.systems[i].dependencyCount, std::memory_order_relaxed);
+
+		if (graph.systems[i].dependencyCount == 0)
+		{
+			rootJobs[rootJobCount++] = {frame_systems_run_job, &graph.jobs[i]};
+		}
+	}
+
+	graph.counter.count.store(0, std::memory_order_relaxed);
+	jobs_submit(platformJobs, rootJobCount, rootJobs, &graph.counter);
+	jobs_wait(platformJobs, &graph.counter);
+
+	if (report != nullptr)
+	{
+		frame_systems_make_report(graph, *report);
+	}
+}
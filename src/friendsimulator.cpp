@@ -3,7 +3,8 @@ Leo Tamminen
 
 Friendsimulator game code main file.
 */
-#if defined FS_DEVELOPMENT
+// Note(Leo): Platform layers that compile game in directly (release, headless) have already included these
+#if defined FS_DEVELOPMENT && !defined FS_PLATFORM
 	#define _CRT_SECURE_NO_WARNINGS
 
 	#include <ImGui/imgui.h>
@@ -22,6 +23,7 @@ Friendsimulator game code main file.
 	#include "fs_standard_functions.h"
 	#include "fs_platform_interface.hpp"
 	#include "fs_logging.cpp"
+	#include "fs_profiler.cpp"
 
 	FS_GAME_API void game_set_platform_functions(PlatformApiDescription * apiDescripition, ImGuiContext * imguiContext)
 	{
@@ -62,7 +64,11 @@ static String push_temp_string_format(s32 capacity, TArgs ... args)
 
 constexpr f32 physics_gravity_acceleration = -9.81;
 
+#include "virtual_memory.cpp"
+#include "memory_instrumentation.cpp"
 #include "experimental.cpp"
+#include "jobs.cpp"
+#include "frame_systems.cpp"
 
 #include "colour.cpp"
 #include "Debug.cpp"
@@ -73,6 +79,9 @@ constexpr f32 physics_gravity_acceleration = -9.81;
 #include "Animator.cpp"
 #include "Skybox.cpp"
 #include "TerrainGenerator.cpp"
+#include "entity_reference.cpp"
+#include "spatial_hash_grid.cpp"
+#include "entity_spatial_index.cpp"
 #include "Collisions3D.cpp"
 
 #include "CameraController.cpp"
@@ -89,10 +98,15 @@ struct GameState
 {
 	/* Note(Leo): MEMORY
 	'persistentMemoryArena' is used to store things from frame to frame.
-	'transientMemoryArena' is intended to be used in asset loading etc. and is flushed each frame*/
+	'transientMemoryArena' is intended to be used in asset loading etc. and is flushed each frame.
+	Both are virtual arenas, so they only commit as much memory as is used. */
 	MemoryArena persistentMemoryArena;
 	MemoryArena transientMemoryArena;
 
+	// Note(Leo): Scratch memory for each job worker, these are flushed each frame like transient memory
+	s32 		workerCount;
+	MemoryArena workerScratchMemoryArenas[jobs_max_worker_count];
+
 	bool isInitialized;
 
 	Game * loadedGame;
@@ -101,6 +115,47 @@ struct GameState
 	GameAssets assets;
 };
 
+struct GameMemoryUsage
+{
+	u64 persistentUsed;
+	u64 persistentHighWaterMark;
+	u64 persistentCommitted;
+	u64 persistentSize;
+
+	u64 transientHighWaterMark;
+	u64 transientCommitted;
+	u64 transientSize;
+};
+
+// Note(Leo): For platform layers that compile game in directly, for measuring. Transient arena is
+// flushed at the start of each game_update, so call this after game_update to get that frame's peak.
+internal GameMemoryUsage game_get_memory_usage(MemoryBlock gameMemory)
+{
+	GameState * state = reinterpret_cast<GameState*>(gameMemory.memory);
+
+	GameMemoryUsage usage 			= {};
+	usage.persistentUsed 			= state->persistentMemoryArena.used;
+	usage.persistentHighWaterMark 	= state->persistentMemoryArena.highWaterMark;
+	usage.persistentCommitted 		= state->persistentMemoryArena.committed;
+	usage.persistentSize 			= state->persistentMemoryArena.size;
+	usage.transientHighWaterMark 	= state->transientMemoryArena.highWaterMark;
+	usage.transientCommitted 		= state->transientMemoryArena.committed;
+	usage.transientSize 			= state->transientMemoryArena.size;
+
+	return usage;
+}
+
+#if defined FS_MEMORY_INSTRUMENTATION_ENABLED
+// Note(Leo): For platform layers that compile game in directly, logs usage reports of instrumented arenas
+internal void game_log_memory_report(MemoryBlock gameMemory)
+{
+	GameState * state = reinterpret_cast<GameState*>(gameMemory.memory);
+
+	memory_instrumentation_log_report(state->persistentMemoryArena);
+	memory_instrumentation_log_report(state->transientMemoryArena);
+}
+#endif
+
 static Gui make_main_menu_gui(MemoryArena & allocator, GameAssets & assets)
 {
 	Gui gui 				= {};
@@ -125,17 +180,47 @@ static Gui make_main_menu_gui(MemoryArena & allocator, GameAssets & assets)
 
 static void game_init_state(GameState * state, MemoryBlock memory)
 {
+	/*
+	Note(Leo): Arenas are reserved only once and kept when game is initialized again after scene is
+	unloaded. Persistent arena decommits its memory when it is flushed then, and transient arena keeps
+	its memory, since it is flushed every frame.
+	*/
+	MemoryArena persistentMemoryArena 	= state->persistentMemoryArena;
+	MemoryArena transientMemoryArena 	= state->transientMemoryArena;
+
 	*state = {};
 
-	// // Note(Leo): Create persistent arena in the same memoryblock as game state, right after it.
+	if (persistentMemoryArena.memory == nullptr)
+	{
+		persistentMemoryArena 	= memory_arena_virtual(gigabytes(64), megabytes(4), true);
+		transientMemoryArena 	= memory_arena_virtual(gigabytes(16), megabytes(4), false);
+	}
+
+	state->persistentMemoryArena 	= persistentMemoryArena;
+	state->transientMemoryArena 	= transientMemoryArena;
+
+	// Note(Leo): Worker scratch arenas are in same memoryblock as game state, right after it.
 	u64 gameStateSize 				= memory_align_up(sizeof(GameState), MemoryArena::defaultAlignment);
-	byte * persistentMemory 		= reinterpret_cast<byte *>(memory.memory) + gameStateSize;
-	u64 persistentMemorySize 		= (memory.size / 2) - gameStateSize;
-	state->persistentMemoryArena 	= memory_arena(persistentMemory, persistentMemorySize); 
 
-	byte * transientMemory 			= reinterpret_cast<byte*>(memory.memory) + gameStateSize + persistentMemorySize;
-	u64 transientMemorySize 		= memory.size / 2;
-	state->transientMemoryArena 	= memory_arena(transientMemory, transientMemorySize);
+	#if defined FS_MEMORY_INSTRUMENTATION_ENABLED
+	{
+		// Note(Leo): Instrumentation is too big to be copied around with GameState, so it is between it and scratch arenas
+		auto * instrumentation = reinterpret_cast<MemoryArenaInstrumentation*>(reinterpret_cast<byte*>(memory.memory) + gameStateSize);
+		memory_instrumentation_attach(state->persistentMemoryArena, instrumentation[0], "persistent");
+		memory_instrumentation_attach(state->transientMemoryArena, instrumentation[1], "transient");
+
+		gameStateSize += 2 * sizeof(MemoryArenaInstrumentation);
+	}
+	#endif
+
+	state->workerCount 				= jobs_get_worker_count(platformJobs);
+	u64 workerScratchMemorySize 	= ((memory.size - gameStateSize) / state->workerCount) & ~(MemoryArena::defaultAlignment - 1);
+
+	byte * workerScratchMemory = reinterpret_cast<byte*>(memory.memory) + gameStateSize;
+	for (s32 i = 0; i < state->workerCount; ++i)
+	{
+		state->workerScratchMemoryArenas[i] = memory_arena(workerScratchMemory + i * workerScratchMemorySize, workerScratchMemorySize);
+	}
 
 	state->assets 	= init_game_assets(&state->persistentMemoryArena);
 	state->gui 		= make_main_menu_gui(state->persistentMemoryArena, state->assets);
@@ -150,19 +235,32 @@ FS_GAME_API bool32 game_update(	MemoryBlock 				gameMemory,
 								PlatformGraphics * 			graphics,
 								PlatformWindow * 			window,
 								PlatformAudio *				audio,
+								PlatformJobs * 				jobs,
 								f32 						elapsedTimeSeconds)
 {
 	platformGraphics 	= graphics;
 	platformWindow 		= window;
+	platformJobs 		= jobs;
 
 	/* Note(Leo): This is reinterpreted each frame, we don't know and don't care
 	if it has been moved or whatever in platform layer*/
-	GameState * state 		= reinterpret_cast<GameState*>(gameMemory.memory);
-	global_transientMemory 	= &state->transientMemoryArena;
+	GameState * state 			= reinterpret_cast<GameState*>(gameMemory.memory);
+	global_transientMemory 		= &state->transientMemoryArena;
+	global_workerScratchMemory 	= state->workerScratchMemoryArenas;
 
 	// Note(Leo): Free space for current frame.
 	flush_memory_arena(&state->transientMemoryArena);
 
+	for (s32 i = 0; i < state->workerCount; ++i)
+	{
+		flush_memory_arena(&state->workerScratchMemoryArenas[i]);
+	}
+
+	#if defined FS_MEMORY_INSTRUMENTATION_ENABLED
+	memory_instrumentation_begin_arena_frame(state->persistentMemoryArena);
+	memory_instrumentation_begin_arena_frame(state->transientMemoryArena);
+	#endif
+
 	if (state->isInitialized == false)
 	{
 		game_init_state (state, gameMemory);
@@ -0,0 +1,209 @@
+/*
+Leo Tamminen
+
+Input recording for platform layers. Each frame's input state and elapsed time are written to
+a file, so that same session can be played back later with bit-identical input, e.g. for
+comparing frame times before and after a change.
+
+File layout:
+	InputRecordingHeader
+	for each frame:
+		f32 	elapsedSeconds
+		u64 	buttonsDown 		(bit per InputButton)
+		u64 	buttonsChanged 		(bit per InputButton, set if button went down or up this frame)
+		u8 		devicesUsed 		(bit per InputDevice)
+		u8 		axesUsed 			(bit per InputAxis, set if value is not zero)
+		f32 	value for each set bit in axesUsed, in axis order
+
+Note(Leo): This only uses platform api functions, so it works with any platform's PlatformInput.
+*/
+
+static_assert(InputButtonCount <= 64, "Input recording stores buttons as bits in u64");
+static_assert(InputAxisCount <= 8, "Input recording stores used axes as bits in u8");
+
+constexpr u32 input_recording_magic 	= 0x52494653; // Note(Leo): "FSIR" in little endian
+constexpr u32 input_recording_version 	= 1;
+
+struct InputRecordingHeader
+{
+	u32 magic;
+	u32 version;
+
+	// Note(Leo): Random.cpp's xor128 is seeded with this before first frame
+	u32 randomSeed;
+	s32 frameCount;
+};
+
+struct InputRecordingFrame
+{
+	f32 elapsedSeconds;
+	u64 buttonsDown;
+	u64 buttonsChanged;
+	u8 	devicesUsed;
+	f32 axes[InputAxisCount];
+};
+
+struct InputRecording
+{
+	PlatformFileHandle 		file;
+	s64 					position;
+	s64 					fileSize;
+
+	s32 					frameIndex;
+	InputRecordingHeader 	header;
+};
+
+// Note(Leo): Fixed part of frame, without padding
+constexpr s64 input_recording_frame_fixed_size = sizeof(f32) + 2 * sizeof(u64) + 2 * sizeof(u8);
+constexpr s64 input_recording_frame_max_size = input_recording_frame_fixed_size + InputAxisCount * sizeof(f32);
+
+internal InputRecording input_recording_begin_write(char const * filename, u32 randomSeed)
+{
+	InputRecording recording 	= {};
+	recording.file 				= platform_file_open(filename, FileMode_write);
+	recording.header 			= {input_recording_magic, input_recording_version, randomSeed, 0};
+
+	// Note(Leo): Header is written again with correct frame count when recording ends
+	platform_file_write(recording.file, 0, sizeof(InputRecordingHeader), &recording.header);
+	recording.position = sizeof(InputRecordingHeader);
+
+	log_application(0, "Recording input to '", filename, "'");
+
+	return recording;
+}
+
+internal void input_recording_write_frame(InputRecording & recording, PlatformInput * input, f32 elapsedSeconds)
+{
+	InputRecordingFrame frame 	= {};
+	frame.elapsedSeconds 		= elapsedSeconds;
+
+	for (s32 i = 0; i < InputButtonCount; ++i)
+	{
+		InputButton button = static_cast<InputButton>(i);
+
+		if (input_button_is_down(input, button))
+		{
+			frame.buttonsDown |= (u64)1 << i;
+		}
+
+		if (input_button_went_down(input, button) || input_button_went_up(input, button))
+		{
+			frame.buttonsChanged |= (u64)1 << i;
+		}
+	}
+
+	frame.devicesUsed 	= (input_is_device_used(input, InputDevice_gamepad) ? 1 << InputDevice_gamepad : 0)
+						| (input_is_device_used(input, InputDevice_mouse_and_keyboard) ? 1 << InputDevice_mouse_and_keyboard : 0);
+
+	u8 buffer [input_recording_frame_max_size];
+	s64 size = input_recording_frame_fixed_size;
+
+	u8 axesUsed = 0;
+	for (s32 i = 0; i < InputAxisCount; ++i)
+	{
+		f32 value = input_axis_get_value(input, static_cast<InputAxis>(i));
+		if (value != 0)
+		{
+			axesUsed |= 1 << i;
+			memory_copy(buffer + size, &value, sizeof(f32));
+			size += sizeof(f32);
+		}
+	}
+
+	memory_copy(buffer, 										&frame.elapsedSeconds, sizeof(f32));
+	memory_copy(buffer + sizeof(f32), 							&frame.buttonsDown, sizeof(u64));
+	memory_copy(buffer + sizeof(f32) + sizeof(u64), 			&frame.buttonsChanged, sizeof(u64));
+	memory_copy(buffer + sizeof(f32) + 2 * sizeof(u64), 		&frame.devicesUsed, sizeof(u8));
+	memory_copy(buffer + sizeof(f32) + 2 * sizeof(u64) + 1, 	&axesUsed, sizeof(u8));
+
+	platform_file_write(recording.file, recording.position, size, buffer);
+	recording.position 			+= size;
+	recording.header.frameCount += 1;
+}
+
+internal void input_recording_end_write(InputRecording & recording)
+{
+	platform_file_write(recording.file, 0, sizeof(InputRecordingHeader), &recording.header);
+	platform_file_close(recording.file);
+
+	log_application(0, "Recorded ", recording.header.frameCount, " frames of input");
+
+	recording = {};
+}
+
+internal bool32 input_recording_begin_read(char const * filename, InputRecording & outRecording)
+{
+	outRecording = {};
+
+	PlatformFileHandle file = platform_file_open(filename, FileMode_read);
+	if (file == nullptr)
+	{
+		return false;
+	}
+
+	outRecording.file 		= file;
+	outRecording.fileSize 	= platform_file_get_size(file);
+
+	if (outRecording.fileSize < (s64)sizeof(InputRecordingHeader))
+	{
+		log_application(0, "Input recording '", filename, "' is too small");
+		platform_file_close(file);
+		return false;
+	}
+
+	platform_file_read(file, 0, sizeof(InputRecordingHeader), &outRecording.header);
+	outRecording.position = sizeof(InputRecordingHeader);
+
+	if (outRecording.header.magic != input_recording_magic || outRecording.header.version != input_recording_version)
+	{
+		log_application(0, "'", filename, "' is not a valid input recording");
+		platform_file_close(file);
+		return false;
+	}
+
+	log_application(0, "Replaying ", outRecording.header.frameCount, " frames of input from '", filename, "'");
+
+	return true;
+}
+
+// Note(Leo): Returns false when there are no more frames
+internal bool32 input_recording_read_frame(InputRecording & recording, InputRecordingFrame & outFrame)
+{
+	if (recording.frameIndex >= recording.header.frameCount
+		|| recording.position + input_recording_frame_fixed_size > recording.fileSize)
+	{
+		return false;
+	}
+
+	u8 buffer [input_recording_frame_fixed_size];
+	platform_file_read(recording.file, recording.position, input_recording_frame_fixed_size, buffer);
+	recording.position += input_recording_frame_fixed_size;
+
+	outFrame = {};
+	u8 axesUsed;
+
+	memory_copy(&outFrame.elapsedSeconds, 	buffer, 										sizeof(f32));
+	memory_copy(&outFrame.buttonsDown, 		buffer + sizeof(f32), 							sizeof(u64));
+	memory_copy(&outFrame.buttonsChanged, 	buffer + sizeof(f32) + sizeof(u64), 			sizeof(u64));
+	memory_copy(&outFrame.devicesUsed, 		buffer + sizeof(f32) + 2 * sizeof(u64), 		sizeof(u8));
+	memory_copy(&axesUsed, 					buffer + sizeof(f32) + 2 * sizeof(u64) + 1, 	sizeof(u8));
+
+	for (s32 i = 0; i < InputAxisCount; ++i)
+	{
+		if (axesUsed & (1 << i))
+		{
+			platform_file_read(recording.file, recording.position, sizeof(f32), &outFrame.axes[i]);
+			recording.position += sizeof(f32);
+		}
+	}
+
+	recording.frameIndex += 1;
+
+	return true;
+}
+
+internal void input_recording_end_read(InputRecording & recording)
+{
+	platform_file_close(recording.file);
+	recording = {};
+}
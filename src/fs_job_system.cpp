@@ -0,0 +1,281 @@
+/*
+Leo Tamminen
+
+Work stealing job system for platform layers. There is a fixed pool of worker threads, and each
+worker, including the main thread, has its own Chase-Lev deque of jobs. Owner pushes and pops
+jobs at the bottom of its deque, and other workers steal from the top when they run out of work.
+Finished jobs decrement their JobCounter, and threads waiting on a counter execute other jobs
+meanwhile, so jobs can also submit and wait more jobs.
+
+Reference:
+	Chase, Lev: Dynamic Circular Work-Stealing Deque (2005)
+	Lê, Pop, Cohen, Zappa Nardelli: Correct and Efficient Work-Stealing for Weak Memory Models (2013)
+
+Requires platform_thread_xxx and platform_semaphore_xxx functions from platform.
+*/
+
+// Note(Leo): Must be power of two, so that index wraps with mask
+constexpr s64 job_queue_capacity = 4096;
+static_assert((job_queue_capacity & (job_queue_capacity - 1)) == 0);
+
+struct JobQueue
+{
+	// Note(Leo): Separate cache lines, since thieves hammer 'top' and owner 'bottom'
+	alignas(64) std::atomic<s64> top;
+	alignas(64) std::atomic<s64> bottom;
+
+	/*
+	Note(Leo): Jobs are plain values. Owner never pushes more than capacity jobs ahead of top,
+	so slot that a thief reads is not overwritten before thief's compare exchange on top succeeds.
+	*/
+	Job jobs [job_queue_capacity];
+};
+
+struct JobWorkerStart
+{
+	PlatformJobs * 	jobs;
+	s32 			workerIndex;
+};
+
+struct PlatformJobs
+{
+	s32 				workerCount;
+	JobQueue 			queues [jobs_max_worker_count];
+
+	PlatformThread 		threads [jobs_max_worker_count];
+	JobWorkerStart 		workerStarts [jobs_max_worker_count];
+
+	// Note(Leo): Sleeping workers are woken with this when jobs are submitted
+	PlatformSemaphore 	wakeSemaphore;
+	std::atomic<bool> 	shouldQuit;
+};
+
+// Note(Leo): Main thread is worker 0, and threads started from here set their own index
+static thread_local s32 jobs_currentWorkerIndex = 0;
+
+/// ---------- CHASE-LEV DEQUE --------------------------
+
+internal bool32 job_queue_push(JobQueue & queue, Job job)
+{
+	s64 bottom 	= queue.bottom.load(std::memory_order_relaxed);
+	s64 top 	= queue.top.load(std::memory_order_acquire);
+
+	if (bottom - top >= job_queue_capacity)
+	{
+		return false;
+	}
+
+	queue.jobs[bottom & (job_queue_capacity - 1)] = job;
+	queue.bottom.store(bottom + 1, std::memory_order_release);
+
+	return true;
+}
+
+// Note(Leo): Only owner thread may pop
+internal bool32 job_queue_pop(JobQueue & queue, Job & outJob)
+{
+	s64 bottom = queue.bottom.load(std::memory_order_relaxed) - 1;
+	queue.bottom.store(bottom, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	s64 top = queue.top.load(std::memory_order_relaxed);
+
+	if (top > bottom)
+	{
+		// Note(Leo): Queue was empty
+		queue.bottom.store(bottom + 1, std::memory_order_relaxed);
+		return false;
+	}
+
+	outJob = queue.jobs[bottom & (job_queue_capacity - 1)];
+
+	if (top == bottom)
+	{
+		// Note(Leo): Last job, race against thieves for it
+		bool32 won = queue.top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+		queue.bottom.store(bottom + 1, std::memory_order_relaxed);
+		return won;
+	}
+
+	return true;
+}
+
+internal bool32 job_queue_steal(JobQueue & queue, Job & outJob)
+{
+	s64 top = queue.top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	s64 bottom = queue.bottom.load(std::memory_order_acquire);
+
+	if (top >= bottom)
+	{
+		return false;
+	}
+
+	outJob = queue.jobs[top & (job_queue_capacity - 1)];
+
+	bool32 won = queue.top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+	return won;
+}
+
+/// ---------- WORKERS --------------------------
+
+// Note(Leo): Own queue first, then try to steal from others starting from next worker
+internal bool32 jobs_find_job(PlatformJobs & jobs, s32 workerIndex, Job & outJob)
+{
+	if (job_queue_pop(jobs.queues[workerIndex], outJob))
+	{
+		return true;
+	}
+
+	for (s32 i = 1; i < jobs.workerCount; ++i)
+	{
+		s32 victimIndex = (workerIndex + i) % jobs.workerCount;
+		if (job_queue_steal(jobs.queues[victimIndex], outJob))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+internal void jobs_worker_thread(void * data)
+{
+	JobWorkerStart * start 	= reinterpret_cast<JobWorkerStart*>(data);
+	PlatformJobs & jobs 	= *start->jobs;
+	s32 workerIndex 		= start->workerIndex;
+
+	jobs_currentWorkerIndex = workerIndex;
+
+	while(jobs.shouldQuit.load(std::memory_order_acquire) == false)
+	{
+		Job job;
+		if (jobs_find_job(jobs, workerIndex, job))
+		{
+			job.func(job.data, workerIndex);
+		}
+		else
+		{
+			platform_semaphore_wait(jobs.wakeSemaphore);
+		}
+	}
+}
+
+/*
+Note(Leo): Queued jobs wrap submitted job and its counter, so that counter can be decremented
+after job is done. These live in submitting thread's ring below, and a slot is reused after
+'jobs_counted_job_capacity' more submits from same thread. Game waits its jobs long before that.
+*/
+struct CountedJob
+{
+	Job 			job;
+	JobCounter * 	counter;
+};
+
+constexpr s32 jobs_counted_job_capacity = job_queue_capacity;
+
+struct CountedJobRing
+{
+	CountedJob 	jobs [jobs_counted_job_capacity];
+	s64 		next;
+};
+
+static CountedJobRing jobs_countedJobRings [jobs_max_worker_count];
+
+internal void jobs_run_counted_job(void * data, s32 workerIndex)
+{
+	CountedJob * countedJob = reinterpret_cast<CountedJob*>(data);
+	countedJob->job.func(countedJob->job.data, workerIndex);
+	countedJob->counter->count.fetch_sub(1, std::memory_order_release);
+}
+
+/// ---------- PLATFORM API --------------------------
+
+static s32 jobs_get_worker_count(PlatformJobs * jobs)
+{
+	return jobs->workerCount;
+}
+
+static void jobs_submit(PlatformJobs * jobs, s32 count, Job const * submittedJobs, JobCounter * counter)
+{
+	s32 workerIndex 		= jobs_currentWorkerIndex;
+	JobQueue & queue 		= jobs->queues[workerIndex];
+	CountedJobRing & ring 	= jobs_countedJobRings[workerIndex];
+
+	counter->count.fetch_add(count, std::memory_order_relaxed);
+
+	s32 pushedCount = 0;
+	for (s32 i = 0; i < count; ++i)
+	{
+		CountedJob * countedJob = &ring.jobs[ring.next % jobs_counted_job_capacity];
+		ring.next 				+= 1;
+		*countedJob 			= {submittedJobs[i], counter};
+
+		if (job_queue_push(queue, {jobs_run_counted_job, countedJob}))
+		{
+			pushedCount += 1;
+		}
+		else
+		{
+			// Note(Leo): Queue is full, so do this one here
+			jobs_run_counted_job(countedJob, workerIndex);
+		}
+	}
+
+	platform_semaphore_signal(jobs->wakeSemaphore, s32_min(pushedCount, jobs->workerCount - 1));
+}
+
+static void jobs_wait(PlatformJobs * jobs, JobCounter * counter)
+{
+	s32 workerIndex = jobs_currentWorkerIndex;
+
+	while(counter->count.load(std::memory_order_acquire) > 0)
+	{
+		Job job;
+		if (jobs_find_job(*jobs, workerIndex, job))
+		{
+			job.func(job.data, workerIndex);
+		}
+		else
+		{
+			// Note(Leo): Remaining jobs are running on other threads
+			platform_thread_yield();
+		}
+	}
+}
+
+/// ---------- PLATFORM LAYER FUNCTIONS --------------------------
+
+// Note(Leo): Pass 0 for 'workerCount' to use one worker per processor
+internal void jobs_initialize(PlatformJobs & jobs, s32 workerCount)
+{
+	if (workerCount <= 0)
+	{
+		workerCount = platform_get_processor_count();
+	}
+
+	jobs.workerCount = s32_clamp(workerCount, 1, jobs_max_worker_count);
+	jobs.shouldQuit.store(false);
+
+	platform_semaphore_create(jobs.wakeSemaphore);
+
+	for (s32 i = 1; i < jobs.workerCount; ++i)
+	{
+		jobs.workerStarts[i] 	= {&jobs, i};
+		jobs.threads[i] 		= platform_thread_start(jobs_worker_thread, &jobs.workerStarts[i]);
+	}
+
+	log_application(0, "Started job system with ", jobs.workerCount, " workers");
+}
+
+internal void jobs_shutdown(PlatformJobs & jobs)
+{
+	jobs.shouldQuit.store(true, std::memory_order_release);
+	platform_semaphore_signal(jobs.wakeSemaphore, jobs.workerCount);
+
+	for (s32 i = 1; i < jobs.workerCount; ++i)
+	{
+		platform_thread_join(jobs.threads[i]);
+	}
+
+	platform_semaphore_destroy(jobs.wakeSemaphore);
+}
@@ -9,6 +9,8 @@ Interface definition between Platform and Game.
 // Todo(Leo): should this be header or should they just be here
 #include "platform_assets.cpp"
 
+#include <atomic>
+
 // Todo(Leo): these are actually platform assets as well
 #include "Camera.cpp"
 #include "Light.cpp"
@@ -65,6 +67,7 @@ struct PlatformGraphics;
 struct PlatformWindow;
 struct PlatformInput;
 struct PlatformAudio;
+struct PlatformJobs;
 // struct PlatformNetwork;
 
 struct PlatformApiDescription;
@@ -77,6 +80,28 @@ enum FileMode
 
 using PlatformFileHandle = void*;
 
+/// ***********************************************************************
+/// JOBS
+/* Note(Leo): Job system runs in platform layer, so that worker threads survive game code hot
+reloading. Game must wait all its jobs before returning from game_update. Calling thread is
+worker 0, and platform's worker threads are 1 ... count - 1. */
+
+constexpr s32 jobs_max_worker_count = 16;
+
+using JobFunc = void(void * data, s32 workerIndex);
+
+struct Job
+{
+	JobFunc * 	func;
+	void * 		data;
+};
+
+// Note(Leo): Counts jobs not yet finished. Submitting adds to it, and it must be zero before it is reused.
+struct JobCounter
+{
+	std::atomic<s32> count;
+};
+
 
 /// ***********************************************************************
 /// PLATFORM ENUMERATIONS
@@ -213,6 +238,7 @@ FS_GAME_API bool32 game_update( MemoryBlock,
 								PlatformGraphics *,
 								PlatformWindow *,
 								PlatformAudio*,
+								PlatformJobs*,
 								f32 elapsedSeconds);
 using GameUpdateFunc = decltype(game_update);
 
@@ -231,6 +257,13 @@ static void 				FS_PLATFORM_API(platform_log_write) (s32 count, char const * buf
 static s64 					FS_PLATFORM_API(platform_time_now) ();
 static f64 					FS_PLATFORM_API(platform_time_elapsed_seconds)(s64 start, s64 end);
 
+// Note(Leo): Reserved memory is only address space, and it must be committed before it is used. Committed memory is zeroed.
+static u64 					FS_PLATFORM_API(platform_memory_page_size) ();
+static void * 				FS_PLATFORM_API(platform_memory_reserve) (u64 size);
+static bool32 				FS_PLATFORM_API(platform_memory_commit) (void * memory, u64 size);
+static void 				FS_PLATFORM_API(platform_memory_decommit) (void * memory, u64 size);
+static void 				FS_PLATFORM_API(platform_memory_release) (void * memory, u64 size);
+
 static u32 					FS_PLATFORM_API(platform_window_get_width) (PlatformWindow const *);
 static u32 					FS_PLATFORM_API(platform_window_get_height) (PlatformWindow const *);
 
@@ -272,6 +305,22 @@ static void 				FS_PLATFORM_API(graphics_development_reload_shaders) (PlatformGr
 static StereoSoundOutput 	FS_PLATFORM_API(audio_get_output_buffer) (PlatformAudio*);
 static void 				FS_PLATFORM_API(audio_release_output_buffer) (PlatformAudio*, StereoSoundOutput);
 
+static s32 					FS_PLATFORM_API(jobs_get_worker_count) (PlatformJobs*);
+static void 				FS_PLATFORM_API(jobs_submit) (PlatformJobs*, s32 count, Job const * jobs, JobCounter * counter);
+// Note(Leo): Waiting thread executes other jobs until counter reaches zero
+static void 				FS_PLATFORM_API(jobs_wait) (PlatformJobs*, JobCounter * counter);
+
+// Note(Leo): Profiler is only available in development, see fs_profiler.cpp
+#if defined FS_DEVELOPMENT
+	#define FS_PROFILER_ENABLED
+
+	struct Profiler;
+	struct ProfilerThread;
+
+	static ProfilerThread * 	FS_PLATFORM_API(profiler_get_thread) ();
+	static Profiler * 			FS_PLATFORM_API(profiler_get) ();
+#endif
+
 #pragma endregion PLATFORM API
 
 // Todo(Leo): maybe add condition if not FS_RELEASE
@@ -288,6 +337,12 @@ struct PlatformApiDescription
 	FS_PLATFORM_FUNC_PTR(platform_time_now) timeNow;
 	FS_PLATFORM_FUNC_PTR(platform_time_elapsed_seconds) timeElapsedSeconds;
 
+	FS_PLATFORM_FUNC_PTR(platform_memory_page_size) memoryPageSize;
+	FS_PLATFORM_FUNC_PTR(platform_memory_reserve) memoryReserve;
+	FS_PLATFORM_FUNC_PTR(platform_memory_commit) memoryCommit;
+	FS_PLATFORM_FUNC_PTR(platform_memory_decommit) memoryDecommit;
+	FS_PLATFORM_FUNC_PTR(platform_memory_release) memoryRelease;
+
 	FS_PLATFORM_FUNC_PTR(platform_window_get_width) windowGetWidth;
 	FS_PLATFORM_FUNC_PTR(platform_window_get_height) windowGetHeight;
 	// FS_PLATFORM_FUNC_PTR(platform_window_get_fullscreen) windowIsFullscreen;
@@ -327,6 +382,15 @@ struct PlatformApiDescription
 
 	FS_PLATFORM_FUNC_PTR(audio_get_output_buffer) audioGetOutputBuffer;
 	FS_PLATFORM_FUNC_PTR(audio_release_output_buffer) audioReleaseOutputBuffer;
+
+	FS_PLATFORM_FUNC_PTR(jobs_get_worker_count) jobsGetWorkerCount;
+	FS_PLATFORM_FUNC_PTR(jobs_submit) jobsSubmit;
+	FS_PLATFORM_FUNC_PTR(jobs_wait) jobsWait;
+
+	#if defined FS_PROFILER_ENABLED
+	FS_PLATFORM_FUNC_PTR(profiler_get_thread) profilerGetThread;
+	FS_PLATFORM_FUNC_PTR(profiler_get) profilerGet;
+	#endif
 };
 
 void platform_set_api(PlatformApiDescription * api)
@@ -342,6 +406,12 @@ void platform_set_api(PlatformApiDescription * api)
 	FS_PLATFORM_API_SET_FUNCTION(platform_time_now, api->timeNow);
 	FS_PLATFORM_API_SET_FUNCTION(platform_time_elapsed_seconds, api->timeElapsedSeconds);
 
+	FS_PLATFORM_API_SET_FUNCTION(platform_memory_page_size, api->memoryPageSize);
+	FS_PLATFORM_API_SET_FUNCTION(platform_memory_reserve, api->memoryReserve);
+	FS_PLATFORM_API_SET_FUNCTION(platform_memory_commit, api->memoryCommit);
+	FS_PLATFORM_API_SET_FUNCTION(platform_memory_decommit, api->memoryDecommit);
+	FS_PLATFORM_API_SET_FUNCTION(platform_memory_release, api->memoryRelease);
+
 	FS_PLATFORM_API_SET_FUNCTION(platform_window_get_width, api->windowGetWidth);
 	FS_PLATFORM_API_SET_FUNCTION(platform_window_get_height, api->windowGetHeight);
 	// FS_PLATFORM_API_SET_FUNCTION(platform_window_get_fullscreen, api->windowIsFullscreen);
@@ -382,6 +452,15 @@ void platform_set_api(PlatformApiDescription * api)
 
 	FS_PLATFORM_API_SET_FUNCTION(audio_get_output_buffer, api->audioGetOutputBuffer);
 	FS_PLATFORM_API_SET_FUNCTION(audio_release_output_buffer, api->audioReleaseOutputBuffer);
+
+	FS_PLATFORM_API_SET_FUNCTION(jobs_get_worker_count, api->jobsGetWorkerCount);
+	FS_PLATFORM_API_SET_FUNCTION(jobs_submit, api->jobsSubmit);
+	FS_PLATFORM_API_SET_FUNCTION(jobs_wait, api->jobsWait);
+
+	#if defined FS_PROFILER_ENABLED
+	FS_PLATFORM_API_SET_FUNCTION(profiler_get_thread, api->profilerGetThread);
+	FS_PLATFORM_API_SET_FUNCTION(profiler_get, api->profilerGet);
+	#endif
 }
 
 #define FS_PLATFORM_INTERFACE_HPP
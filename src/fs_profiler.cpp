@@ -0,0 +1,396 @@
+/*
+Leo Tamminen
+
+Scoped cpu profiler.
+
+Zones are marked with FS_PROFILE_SCOPE("name") or FS_PROFILE_FUNCTION(), and they can be nested.
+Begin and end of each zone are written with a timestamp to current thread's ring buffer, which
+does not allocate anything. At the end of each frame platform reads all threads' buffers and
+aggregates them into per-zone stats, that game can show. Frames can also be written into a
+trace file, which can be opened in chrome://tracing or https://ui.perfetto.dev.
+
+Profiler is owned by platform. Game dll gets its thread buffers through platform api, so that
+zones in game and platform code nest properly.
+
+Everything here compiles to nothing in release builds.
+*/
+
+// Note(Leo): FS_PROFILER_ENABLED is defined in fs_platform_interface.hpp
+#if defined FS_PROFILER_ENABLED
+
+constexpr s32 profiler_max_threads 				= 16;
+constexpr s32 profiler_max_zone_depth 			= 32;
+constexpr s32 profiler_max_zones 				= 256;
+
+// Note(Leo): Must be power of two, so that index wraps with mask
+constexpr u64 profiler_thread_event_capacity 	= 1 << 16;
+static_assert((profiler_thread_event_capacity & (profiler_thread_event_capacity - 1)) == 0);
+
+struct ProfilerEvent
+{
+	// Note(Leo): nullptr marks end of latest open zone in this thread
+	char const * 	name;
+	s64 			time;
+};
+
+struct ProfilerOpenZone
+{
+	char const * 	name;
+	s64 			beginTime;
+	s64 			childTime;
+	s32 			zoneIndex;
+};
+
+struct ProfilerThread
+{
+	s32 threadIndex;
+
+	/*
+	Note(Leo): Only owning thread writes events and 'writeCount', platform reads them when frame
+	ends. If there are more than capacity events in a frame, oldest are lost.
+	*/
+	std::atomic<u64> 	writeCount;
+	ProfilerEvent 		events [profiler_thread_event_capacity];
+
+	// Note(Leo): These are only used by platform when reading events. Zones can stay open over frame end.
+	u64 				readCount;
+	s32 				openZoneCount;
+	s32 				openZoneOverflow;
+	ProfilerOpenZone 	openZones [profiler_max_zone_depth];
+};
+
+struct ProfilerZoneStats
+{
+	char const * 	name;
+	s32 			threadIndex;
+	s32 			parentIndex;
+	s32 			depth;
+
+	s32 			callCount;
+	s64 			totalTime;
+	s64 			selfTime;
+};
+
+struct Profiler
+{
+	ProfilerThread 		threads [profiler_max_threads];
+	std::atomic<s32> 	threadCount;
+
+	// Note(Leo): Aggregated stats of last completed frame. Times are in platform_time_now units.
+	s32 				zoneCount;
+	ProfilerZoneStats 	zones [profiler_max_zones];
+	s64 				frameTime;
+	s64 				lostEventCount;
+
+	// Note(Leo): Game sets this, and platform starts capturing at the start of next frame
+	s32 				traceFramesRequested;
+
+	s32 				traceFramesLeft;
+	PlatformFileHandle 	traceFile;
+	s64 				traceFilePosition;
+	s64 				traceStartTime; // Note(Leo): time of first event in trace
+	bool32 				traceHasEvents;
+	s32 				traceBufferLength;
+	char 				traceBuffer [64 * 1024];
+
+	s64 				frameStartTime;
+};
+
+/// ---------- PLATFORM API --------------------------
+// Note(Leo): These are declared in fs_platform_interface.hpp, and defined below for platform
+
+// Note(Leo): Each module caches its own pointer to thread buffer. Game dll's cache is reset on reload.
+static thread_local ProfilerThread * profiler_currentThread;
+
+inline ProfilerThread * profiler_get_current_thread()
+{
+	if (profiler_currentThread == nullptr)
+	{
+		profiler_currentThread = profiler_get_thread();
+	}
+	return profiler_currentThread;
+}
+
+inline void profiler_begin_zone(char const * name)
+{
+	ProfilerThread * thread = profiler_get_current_thread();
+	u64 index 				= thread->writeCount.load(std::memory_order_relaxed);
+
+	thread->events[index & (profiler_thread_event_capacity - 1)] = {name, platform_time_now()};
+	thread->writeCount.store(index + 1, std::memory_order_release);
+}
+
+inline void profiler_end_zone()
+{
+	ProfilerThread * thread = profiler_get_current_thread();
+	u64 index 				= thread->writeCount.load(std::memory_order_relaxed);
+
+	thread->events[index & (profiler_thread_event_capacity - 1)] = {nullptr, platform_time_now()};
+	thread->writeCount.store(index + 1, std::memory_order_release);
+}
+
+struct ProfilerScope
+{
+	ProfilerScope(char const * name) 	{ profiler_begin_zone(name); }
+	~ProfilerScope() 					{ profiler_end_zone(); }
+};
+
+#define FS_PROFILE_CONCAT_(a, b) a##b
+#define FS_PROFILE_CONCAT(a, b) FS_PROFILE_CONCAT_(a, b)
+
+// Note(Leo): Name must be a string literal or otherwise live at least until end of frame. It is also compared by address.
+#define FS_PROFILE_SCOPE(name) ProfilerScope FS_PROFILE_CONCAT(profilerScope_, __LINE__)(name)
+#define FS_PROFILE_FUNCTION() FS_PROFILE_SCOPE(__func__)
+
+internal void profiler_capture_trace(Profiler * profiler, s32 frameCount)
+{
+	profiler->traceFramesRequested = frameCount;
+}
+
+internal bool32 profiler_is_capturing_trace(Profiler * profiler)
+{
+	return profiler->traceFramesLeft > 0 || profiler->traceFramesRequested > 0;
+}
+
+/// ---------- PLATFORM IMPLEMENTATION --------------------------
+
+#if defined FS_PLATFORM
+
+constexpr char const * profiler_trace_file_name = "friendsimulator_trace.json";
+
+static Profiler global_profiler;
+
+static ProfilerThread * profiler_get_thread()
+{
+	local_persist thread_local ProfilerThread * thread = nullptr;
+
+	if (thread == nullptr)
+	{
+		s32 threadIndex = global_profiler.threadCount.fetch_add(1);
+		AssertRelease(threadIndex < profiler_max_threads, "Too many threads for profiler");
+
+		thread 				= &global_profiler.threads[threadIndex];
+		thread->threadIndex = threadIndex;
+	}
+
+	return thread;
+}
+
+static Profiler * profiler_get()
+{
+	return &global_profiler;
+}
+
+internal void profiler_trace_flush(Profiler & profiler)
+{
+	platform_file_write(profiler.traceFile, profiler.traceFilePosition, profiler.traceBufferLength, profiler.traceBuffer);
+	profiler.traceFilePosition 	+= profiler.traceBufferLength;
+	profiler.traceBufferLength 	= 0;
+}
+
+internal void profiler_trace_write_event(Profiler & profiler, char const * name, char phase, s32 threadIndex, s64 time)
+{
+	// Note(Leo): Keep room for closing "\n]" too, profiler_end_frame writes it without checking
+	constexpr s32 maxEventLength 	= 256;
+	constexpr s32 closingLength 	= 2;
+	if (profiler.traceBufferLength + maxEventLength + closingLength > (s32)array_count(profiler.traceBuffer))
+	{
+		profiler_trace_flush(profiler);
+	}
+
+	if (profiler.traceHasEvents == false)
+	{
+		profiler.traceStartTime = time;
+	}
+
+	f64 microseconds = platform_time_elapsed_seconds(profiler.traceStartTime, time) * 1'000'000;
+
+	// Note(Leo): End events do not need name, chrome matches them to latest begin on same thread
+	s32 length = snprintf(	profiler.traceBuffer + profiler.traceBufferLength, maxEventLength,
+							"%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":0,\"tid\":%d}",
+							profiler.traceHasEvents ? ",\n" : "",
+							name != nullptr ? name : "",
+							phase,
+							microseconds,
+							threadIndex);
+
+	profiler.traceBufferLength 	+= s32_min(length, maxEventLength - 1);
+	profiler.traceHasEvents 	= true;
+}
+
+// Note(Leo): Find or add zone stats matching open zone at 'depth', resolving also its parents
+internal s32 profiler_resolve_zone(Profiler & profiler, ProfilerThread & thread, s32 depth)
+{
+	ProfilerOpenZone & openZone = thread.openZones[depth];
+
+	if (openZone.zoneIndex >= 0)
+	{
+		return openZone.zoneIndex;
+	}
+
+	s32 parentIndex = depth > 0 ? profiler_resolve_zone(profiler, thread, depth - 1) : -1;
+
+	for (s32 i = 0; i < profiler.zoneCount; ++i)
+	{
+		ProfilerZoneStats & zone = profiler.zones[i];
+		if (zone.name == openZone.name && zone.parentIndex == parentIndex && zone.threadIndex == thread.threadIndex)
+		{
+			openZone.zoneIndex = i;
+			return i;
+		}
+	}
+
+	if (profiler.zoneCount < profiler_max_zones)
+	{
+		s32 zoneIndex 				= profiler.zoneCount++;
+		profiler.zones[zoneIndex] 	= {openZone.name, thread.threadIndex, parentIndex, depth};
+		openZone.zoneIndex 			= zoneIndex;
+	}
+
+	// Note(Leo): Zone table is full, stats for this zone are lost this frame
+	return openZone.zoneIndex;
+}
+
+internal void profiler_read_thread(Profiler & profiler, ProfilerThread & thread, bool32 writeTrace)
+{
+	u64 writeCount = thread.writeCount.load(std::memory_order_acquire);
+
+	if (writeCount - thread.readCount > profiler_thread_event_capacity)
+	{
+		// Note(Leo): Ring buffer was overwritten, so we cannot trust open zones either
+		profiler.lostEventCount += writeCount - thread.readCount - profiler_thread_event_capacity;
+		thread.readCount 		= writeCount - profiler_thread_event_capacity;
+		thread.openZoneCount 	= 0;
+		thread.openZoneOverflow = 0;
+	}
+
+	for (; thread.readCount < writeCount; ++thread.readCount)
+	{
+		ProfilerEvent event = thread.events[thread.readCount & (profiler_thread_event_capacity - 1)];
+
+		if (event.name != nullptr)
+		{
+			if (thread.openZoneCount < profiler_max_zone_depth)
+			{
+				thread.openZones[thread.openZoneCount++] = {event.name, event.time, 0, -1};
+			}
+			else
+			{
+				thread.openZoneOverflow += 1;
+			}
+
+			if (writeTrace)
+			{
+				profiler_trace_write_event(profiler, event.name, 'B', thread.threadIndex, event.time);
+			}
+		}
+		else
+		{
+			if (writeTrace)
+			{
+				profiler_trace_write_event(profiler, nullptr, 'E', thread.threadIndex, event.time);
+			}
+
+			if (thread.openZoneOverflow > 0)
+			{
+				thread.openZoneOverflow -= 1;
+				continue;
+			}
+
+			if (thread.openZoneCount == 0)
+			{
+				continue;
+			}
+
+			s32 depth 					= thread.openZoneCount - 1;
+			s32 zoneIndex 				= profiler_resolve_zone(profiler, thread, depth);
+			ProfilerOpenZone openZone 	= thread.openZones[depth];
+			thread.openZoneCount 		-= 1;
+
+			s64 duration = event.time - openZone.beginTime;
+
+			if (zoneIndex >= 0)
+			{
+				ProfilerZoneStats & zone = profiler.zones[zoneIndex];
+				zone.callCount 	+= 1;
+				zone.totalTime 	+= duration;
+				zone.selfTime 	+= duration - openZone.childTime;
+			}
+
+			if (depth > 0)
+			{
+				thread.openZones[depth - 1].childTime += duration;
+			}
+		}
+	}
+}
+
+// Note(Leo): Call once per frame after everything else, when no other thread is recording zones
+internal void profiler_end_frame(Profiler & profiler)
+{
+	s64 frameEndTime = platform_time_now();
+
+	if (profiler.traceFramesLeft == 0 && profiler.traceFramesRequested > 0)
+	{
+		// Note(Leo): Events already in buffers belong to this frame, so they are written too
+		profiler.traceFile 			= platform_file_open(profiler_trace_file_name, FileMode_write);
+		profiler.traceFilePosition 	= 0;
+		profiler.traceBufferLength 	= 0;
+		profiler.traceHasEvents 	= false;
+		profiler.traceFramesLeft 	= profiler.traceFramesRequested;
+		profiler.traceFramesRequested = 0;
+
+		profiler.traceBuffer[profiler.traceBufferLength++] = '[';
+
+		log_application(0, "Capturing ", profiler.traceFramesLeft, " frames to '", profiler_trace_file_name, "'");
+	}
+
+	bool32 writeTrace = profiler.traceFramesLeft > 0;
+
+	// Note(Leo): Open zones refer to last frame's zone table
+	profiler.zoneCount = 0;
+
+	s32 threadCount = profiler.threadCount.load(std::memory_order_acquire);
+	for (s32 i = 0; i < threadCount; ++i)
+	{
+		ProfilerThread & thread = profiler.threads[i];
+
+		for (s32 depth = 0; depth < thread.openZoneCount; ++depth)
+		{
+			thread.openZones[depth].zoneIndex = -1;
+		}
+
+		profiler_read_thread(profiler, thread, writeTrace);
+	}
+
+	profiler.frameTime 		= profiler.frameStartTime != 0 ? frameEndTime - profiler.frameStartTime : 0;
+	profiler.frameStartTime = frameEndTime;
+
+	if (writeTrace)
+	{
+		profiler.traceFramesLeft -= 1;
+
+		if (profiler.traceFramesLeft == 0)
+		{
+			profiler.traceBuffer[profiler.traceBufferLength++] = '\n';
+			profiler.traceBuffer[profiler.traceBufferLength++] = ']';
+			profiler_trace_flush(profiler);
+			platform_file_close(profiler.traceFile);
+
+			log_application(0, "Wrote trace to '", profiler_trace_file_name, "'");
+		}
+		else
+		{
+			profiler_trace_flush(profiler);
+		}
+	}
+}
+
+#endif // FS_PLATFORM
+
+#else
+
+#define FS_PROFILE_SCOPE(name)
+#define FS_PROFILE_FUNCTION()
+
+#endif // FS_PROFILER_ENABLED
@@ -50,18 +50,22 @@ constexpr u32 array_count(const _ (&array)[Count])
 #include <cmath>
 #include <limits>
 
+// Note(Leo): meta is used in templates in Memory.cpp, and only msvc-compatible compilers delay lookup there
+#include "meta.cpp"
+
 #include "Memory.cpp"
 #include "Math.cpp"
 
 #include "CStringUtility.cpp"
 #include "string.cpp"
-#include "meta.cpp"
 
 #include "Vectors.cpp"
 #include "Quaternion.cpp"
 #include "Matrices.cpp"
 
 #include "array.cpp"
+#include "mapped_array.cpp"
+#include "soa.cpp"
 #include "serialization.cpp"
 
 #define FS_STANDARD_LIBRARY_H
@@ -0,0 +1,2587 @@
+/*
+Leo Tamminen
+
+Micro-benchmarks for headless platform. These are run with '-benchmark <name>' instead of game,
+and they only log their results. Each benchmark gets its own memory, and sets transient memory
+for game code that uses it.
+
+Benchmarks:
+	raycast 	static collider bvh vs. linear scan, with 1k, 10k and 100k colliders
+	submitted 	persistent submitted colliders in dynamic tree vs. rebuilding arrays each frame
+	raybatch 	character motor like ray packets with raycast_3d_batch vs. raycast_3d for each ray
+	terrain 	long rays against 1024x1024 height map with min/max pyramid vs. cell by cell vs. marching
+	sweep 		character motor's capsule sweep vs. its ray fan, and how many thin colliders rays miss
+	entityindex pickup queries among 100k waters with entity spatial index vs. linear scan, while waters change
+	waters 		tree water lookups and rain cloud drop selection with waters' grid vs. linear scan
+	trianglemesh shared triangle mesh collider instances vs. their triangles copied to static bvh
+	treecapsules growing trees' branch capsules refit in place vs. rebuilt, and queries vs. linear scan
+	mappedarray insert, remove and iterate churn with slot map vs. linear free handle search, 10k to 1M items
+	hashmap 	robin hood hash map vs. std::unordered_map and linear key search, 1k to 1M keys, and its correctness
+	soa 		update_waters and leaves_update with SoA columns vs. separate arrays as they were before
+	virtualarena filling virtual arena that commits on demand vs. one committed up front, and decommitting on flush
+	arenainstrumentation pushes to instrumented arena vs. plain one, its callsite report and memory_align_up waste
+*/
+
+#include <unordered_map>
+
+struct HeadlessBenchmarkMemory
+{
+	MemoryArena persistent;
+	MemoryArena transient;
+};
+
+// Note(Leo): Global transient memory points to 'memory', so it must live as long as benchmark
+internal void fsheadless_benchmark_memory(HeadlessBenchmarkMemory & memory, u64 size)
+{
+	byte * block = reinterpret_cast<byte*>(mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0));
+	AssertRelease(block != MAP_FAILED, "Failed to allocate benchmark memory");
+
+	memory 				= {};
+	memory.persistent 	= memory_arena(block, size / 2);
+	memory.transient 	= memory_arena(block + size / 2, size / 2);
+
+	global_transientMemory = &memory.transient;
+}
+
+/// ---------- RAYCAST --------------------------
+
+/*
+Note(Leo): Half boxes and half triangles, randomly placed with roughly same density in all sizes,
+so that hit rate does not change. Rays are short, like the ones character motor uses. Linear
+scan is same ray_static_collisions without bvh, so that both find exactly same hits.
+*/
+internal void fsheadless_benchmark_raycast()
+{
+	HeadlessBenchmarkMemory memory;
+	fsheadless_benchmark_memory(memory, gigabytes(1));
+
+	s32 colliderCounts [] = {1000, 10000, 100000};
+
+	constexpr s32 bvh_ray_count 			= 100000;
+	constexpr s64 linear_tests_per_count 	= 20'000'000;
+	constexpr f32 ray_length 				= 10;
+
+	for (s32 colliderCount : colliderCounts)
+	{
+		flush_memory_arena(&memory.persistent);
+		flush_memory_arena(&memory.transient);
+
+		RandomState random = random_state_from_seed(colliderCount);
+
+		s32 boxCount 		= colliderCount / 2;
+		s32 triangleCount 	= colliderCount - boxCount;
+		f32 worldSize 		= f32_sqr_root((f32)colliderCount) * 4;
+
+		CollisionSystem3D system 	= {};
+		system.staticBoxColliders 	= push_array<PrecomputedBoxCollider>(memory.persistent, boxCount, ALLOC_GARBAGE);
+		system.triangleColliders 	= push_array<TriangleCollider>(memory.persistent, triangleCount, ALLOC_GARBAGE);
+
+		for (s32 i = 0; i < boxCount; ++i)
+		{
+			Transform3D transform 	= {};
+			transform.position 		= {random_range(random, 0, worldSize), random_range(random, 0, worldSize), random_range(random, 0, 5)};
+			transform.rotation 		= quaternion_axis_angle(v3_up, random_range(random, 0, 2 * π));
+
+			v3 extents 				= {random_range(random, 0.5, 2), random_range(random, 0.5, 2), random_range(random, 0.5, 2)};
+			BoxCollider collider 	= {extents, quaternion_identity, {0, 0, 0}};
+
+			push_static_box_collider(system, collider, transform);
+		}
+
+		for (s32 i = 0; i < triangleCount; ++i)
+		{
+			v3 center = {random_range(random, 0, worldSize), random_range(random, 0, worldSize), random_range(random, 0, 5)};
+
+			TriangleCollider triangle;
+			for (v3 & vertex : triangle.vertices)
+			{
+				vertex = center + v3{random_range(random, -2, 2), random_range(random, -2, 2), random_range(random, -2, 2)};
+			}
+			system.triangleColliders.push(triangle);
+		}
+
+		Ray * rays = push_memory<Ray>(memory.persistent, bvh_ray_count, ALLOC_GARBAGE);
+		for (s32 i = 0; i < bvh_ray_count; ++i)
+		{
+			v3 start 		= {random_range(random, 0, worldSize), random_range(random, 0, worldSize), random_range(random, 0, 5)};
+			v3 direction 	= {random_range(random, -1, 1), random_range(random, -1, 1), random_range(random, -1, 1)};
+			rays[i] 		= {start, v3_normalize(direction), ray_length};
+		}
+
+		f32 * bvhDistances 		= push_memory<f32>(memory.persistent, bvh_ray_count, ALLOC_GARBAGE);
+		f32 * linearDistances 	= push_memory<f32>(memory.persistent, bvh_ray_count, ALLOC_GARBAGE);
+
+		/// LINEAR
+		s32 linearRayCount = (s32)s64_clamp(linear_tests_per_count / colliderCount, 100, bvh_ray_count);
+
+		s64 linearStart = platform_time_now();
+		for (s32 i = 0; i < linearRayCount; ++i)
+		{
+			linearDistances[i] = highest_f32;
+			ray_static_collisions(system, rays[i], CollisionLayer_static, nullptr, &linearDistances[i]);
+		}
+		f64 linearSeconds = platform_time_elapsed_seconds(linearStart, platform_time_now());
+
+		/// BVH
+		s64 buildStart 		= platform_time_now();
+		collision_system_build_static_bvh(system, memory.persistent);
+		f64 buildSeconds 	= platform_time_elapsed_seconds(buildStart, platform_time_now());
+
+		s32 hitCount = 0;
+
+		s64 bvhStart = platform_time_now();
+		for (s32 i = 0; i < bvh_ray_count; ++i)
+		{
+			bvhDistances[i] = highest_f32;
+			hitCount 		+= ray_static_collisions(system, rays[i], CollisionLayer_static, nullptr, &bvhDistances[i]) ? 1 : 0;
+		}
+		f64 bvhSeconds = platform_time_elapsed_seconds(bvhStart, platform_time_now());
+
+		s32 mismatchCount = 0;
+		for (s32 i = 0; i < linearRayCount; ++i)
+		{
+			if (abs_f32(linearDistances[i] - bvhDistances[i]) > 0.0001f)
+			{
+				mismatchCount += 1;
+			}
+		}
+
+		f64 linearRaysPerSecond = linearRayCount / linearSeconds;
+		f64 bvhRaysPerSecond 	= bvh_ray_count / bvhSeconds;
+
+		log_application(0, "Raycast, ", colliderCount, " colliders: build ", (f32)(buildSeconds * 1000), " ms, ",
+							system.staticBVH.nodes.count, " nodes, hit rate ", (f32)hitCount / bvh_ray_count * 100, " %");
+		log_application(0, "\tlinear ", (f32)linearRaysPerSecond, " rays/s, bvh ", (f32)bvhRaysPerSecond, " rays/s, ",
+							(f32)(bvhRaysPerSecond / linearRaysPerSecond), "x, ", mismatchCount, "/", linearRayCount, " mismatching hits");
+	}
+}
+
+/// ---------- SUBMITTED COLLIDERS --------------------------
+
+/*
+Note(Leo): Like game, all colliders are submitted every frame, and few of them move. Rebuilding is
+what submitting used to be: all matrices computed again to flat arrays, and rays tested against all.
+*/
+internal void fsheadless_benchmark_submitted_colliders()
+{
+	HeadlessBenchmarkMemory memory;
+	fsheadless_benchmark_memory(memory, megabytes(256));
+
+	s32 colliderCounts [] = {200, 2000};
+
+	constexpr s32 frame_count 			= 200;
+	constexpr s32 rays_per_frame 		= 200;
+	constexpr f32 moving_fraction 		= 0.05f;
+	constexpr f32 ray_length 			= 10;
+
+	for (s32 colliderCount : colliderCounts)
+	{
+		flush_memory_arena(&memory.persistent);
+		flush_memory_arena(&memory.transient);
+
+		RandomState random = random_state_from_seed(colliderCount);
+
+		s32 boxCount 		= colliderCount / 2;
+		s32 cylinderCount 	= colliderCount - boxCount;
+		f32 worldSize 		= f32_sqr_root((f32)colliderCount) * 4;
+
+		Transform3D * boxTransforms 		= push_memory<Transform3D>(memory.persistent, boxCount, ALLOC_ZERO_MEMORY);
+		Transform3D * cylinderTransforms 	= push_memory<Transform3D>(memory.persistent, cylinderCount, ALLOC_ZERO_MEMORY);
+
+		for (s32 i = 0; i < boxCount; ++i)
+		{
+			boxTransforms[i] = {{random_range(random, 0, worldSize), random_range(random, 0, worldSize), 0}, quaternion_axis_angle(v3_up, random_range(random, 0, 2 * π)), {1,1,1}};
+		}
+
+		for (s32 i = 0; i < cylinderCount; ++i)
+		{
+			cylinderTransforms[i] = {{random_range(random, 0, worldSize), random_range(random, 0, worldSize), 0}, quaternion_identity, {1,1,1}};
+		}
+
+		BoxCollider boxCollider 			= {{0.5, 0.5, 0.5}, quaternion_identity, {0, 0, 0.5}};
+		CylinderCollider cylinderCollider 	= {0.3, 0.3, {0, 0, 0.3}};
+
+		CollisionSystem3D system = init_collision_system(memory.persistent);
+
+		Array<PrecomputedBoxCollider> rebuiltBoxes 		= push_array<PrecomputedBoxCollider>(memory.persistent, boxCount, ALLOC_GARBAGE);
+		Array<CylinderCollider> rebuiltCylinders 		= push_array<CylinderCollider>(memory.persistent, cylinderCount, ALLOC_GARBAGE);
+
+		f64 treeSubmitSeconds 		= 0;
+		f64 treeRaySeconds 			= 0;
+		f64 rebuildSubmitSeconds 	= 0;
+		f64 rebuildRaySeconds 		= 0;
+
+		s32 movedProxyCount = 0;
+		s32 mismatchCount 	= 0;
+
+		for (s32 frame = 0; frame < frame_count; ++frame)
+		{
+			for (s32 i = 0; i < boxCount; ++i)
+			{
+				if (random_value(random) < moving_fraction)
+				{
+					boxTransforms[i].position += v3{random_range(random, -0.1, 0.1), random_range(random, -0.1, 0.1), 0};
+				}
+			}
+
+			for (s32 i = 0; i < cylinderCount; ++i)
+			{
+				if (random_value(random) < moving_fraction)
+				{
+					cylinderTransforms[i].position += v3{random_range(random, -0.1, 0.1), random_range(random, -0.1, 0.1), 0};
+				}
+			}
+
+			/// TREE
+			s64 start = platform_time_now();
+			collision_system_begin_submitted_colliders(system);
+			for (s32 i = 0; i < boxCount; ++i)
+			{
+				submit_box_collider(system, boxCollider, boxTransforms[i]);
+			}
+			for (s32 i = 0; i < cylinderCount; ++i)
+			{
+				submit_cylinder_collider(system, cylinderCollider, cylinderTransforms[i]);
+			}
+			collision_system_end_submitted_colliders(system);
+			treeSubmitSeconds += platform_time_elapsed_seconds(start, platform_time_now());
+
+			movedProxyCount += system.submittedMovedProxyCount;
+
+			/// REBUILD
+			start = platform_time_now();
+			array_flush(rebuiltBoxes);
+			array_flush(rebuiltCylinders);
+			for (s32 i = 0; i < boxCount; ++i)
+			{
+				rebuiltBoxes.push({	compute_box_collider_transform(boxCollider, boxTransforms[i]),
+									compute_inverse_box_collider_transform(boxCollider, boxTransforms[i])});
+			}
+			for (s32 i = 0; i < cylinderCount; ++i)
+			{
+				CylinderCollider collider 	= cylinderCollider;
+				collider.center 			+= cylinderTransforms[i].position;
+				rebuiltCylinders.push(collider);
+			}
+			rebuildSubmitSeconds += platform_time_elapsed_seconds(start, platform_time_now());
+
+			/// RAYS
+			Ray rays [rays_per_frame];
+			for (Ray & ray : rays)
+			{
+				v3 rayStart 	= {random_range(random, 0, worldSize), random_range(random, 0, worldSize), random_range(random, 0, 1)};
+				v3 direction 	= {random_range(random, -1, 1), random_range(random, -1, 1), random_range(random, -0.2, 0.2)};
+				ray 			= {rayStart, v3_normalize(direction), ray_length};
+			}
+
+			f32 treeDistances [rays_per_frame];
+			start = platform_time_now();
+			for (s32 i = 0; i < rays_per_frame; ++i)
+			{
+				treeDistances[i] = highest_f32;
+				ray_submitted_collisions(system, rays[i], CollisionLayer_submitted, nullptr, &treeDistances[i]);
+			}
+			treeRaySeconds += platform_time_elapsed_seconds(start, platform_time_now());
+
+			f32 rebuildDistances [rays_per_frame];
+			start = platform_time_now();
+			for (s32 i = 0; i < rays_per_frame; ++i)
+			{
+				rebuildDistances[i] = highest_f32;
+				ray_box_collisions(rebuiltBoxes, ColliderType_submitted_box, rays[i], nullptr, &rebuildDistances[i]);
+				ray_cylinder_collisions(rebuiltCylinders, ColliderType_submitted_cylinder, rays[i], nullptr, &rebuildDistances[i]);
+			}
+			rebuildRaySeconds += platform_time_elapsed_seconds(start, platform_time_now());
+
+			for (s32 i = 0; i < rays_per_frame; ++i)
+			{
+				if (abs_f32(treeDistances[i] - rebuildDistances[i]) > 0.001f)
+				{
+					mismatchCount += 1;
+				}
+			}
+		}
+
+		log_application(0, "Submitted colliders, ", colliderCount, " colliders, ", (s32)(moving_fraction * 100), " % moving, ",
+							rays_per_frame, " rays per frame, proxies moved ", movedProxyCount / frame_count, " per frame");
+		log_application(0, "	submit: rebuild ", (f32)(rebuildSubmitSeconds / frame_count * 1000), " ms, tree ",
+							(f32)(treeSubmitSeconds / frame_count * 1000), " ms per frame");
+		log_application(0, "	rays: linear ", (f32)(rebuildRaySeconds / frame_count * 1000), " ms, tree ",
+							(f32)(treeRaySeconds / frame_count * 1000), " ms per frame, ", mismatchCount, "/", frame_count * rays_per_frame, " mismatching hits");
+	}
+}
+
+/// ---------- RAY BATCH --------------------------
+
+/*
+Note(Leo): Packets are like character motor's forward rays: five parallel short rays that start
+on half circle around character. Scene has all kinds of colliders raycast_3d tests: submitted
+boxes and cylinders and static boxes and triangles in bvh.
+*/
+internal void fsheadless_benchmark_ray_batch()
+{
+	// Note(Leo): Packets and both result arrays take about 185 MB
+	HeadlessBenchmarkMemory memory;
+	fsheadless_benchmark_memory(memory, gigabytes(1));
+
+	constexpr s32 collider_count 	= 2000;
+	constexpr s32 packet_count 		= 200000;
+	constexpr s32 rays_per_packet 	= 5;
+	constexpr f32 character_radius 	= 0.5;
+
+	RandomState random = random_state_from_seed(collider_count);
+
+	f32 worldSize = f32_sqr_root((f32)collider_count) * 4;
+
+	CollisionSystem3D system 	= init_collision_system(memory.persistent);
+	system.triangleColliders 	= push_array<TriangleCollider>(memory.persistent, collider_count / 4, ALLOC_GARBAGE);
+
+	auto random_transform = [&]() -> Transform3D
+	{
+		Transform3D transform 	= {};
+		transform.position 		= {random_range(random, 0, worldSize), random_range(random, 0, worldSize), 0};
+		transform.rotation 		= quaternion_axis_angle(v3_up, random_range(random, 0, 2 * π));
+		transform.scale 		= {1, 1, 1};
+		return transform;
+	};
+
+	BoxCollider boxCollider 			= {{0.5, 0.5, 0.5}, quaternion_identity, {0, 0, 0.5}};
+	CylinderCollider cylinderCollider 	= {0.3, 0.5, {0, 0, 0.5}};
+
+	collision_system_begin_submitted_colliders(system);
+	for (s32 i = 0; i < collider_count / 4; ++i)
+	{
+		submit_box_collider(system, boxCollider, random_transform());
+		submit_cylinder_collider(system, cylinderCollider, {random_transform().position, quaternion_identity, {1, 1, 1}});
+	}
+	collision_system_end_submitted_colliders(system);
+
+	system.staticBoxColliders = push_array<PrecomputedBoxCollider>(memory.persistent, collider_count / 4, ALLOC_GARBAGE);
+	for (s32 i = 0; i < collider_count / 4; ++i)
+	{
+		push_static_box_collider(system, boxCollider, random_transform());
+
+		v3 center = random_transform().position;
+		TriangleCollider triangle;
+		for (v3 & vertex : triangle.vertices)
+		{
+			vertex = center + v3{random_range(random, -1, 1), random_range(random, -1, 1), random_range(random, 0, 1)};
+		}
+		system.triangleColliders.push(triangle);
+	}
+	collision_system_build_static_bvh(system, memory.persistent);
+
+	RayPacket * packets = push_memory<RayPacket>(memory.persistent, packet_count, ALLOC_ZERO_MEMORY);
+	for (s32 i = 0; i < packet_count; ++i)
+	{
+		v3 position 	= {random_range(random, 0, worldSize), random_range(random, 0, worldSize), random_range(random, 0, 1)};
+		v3 forward 		= quaternion_rotate_v3(quaternion_axis_angle(v3_up, random_range(random, 0, 2 * π)), v3_forward);
+		v3 right 		= v3_cross(forward, v3_up);
+		f32 length 		= random_range(random, 0.05, 0.5);
+
+		for (s32 r = 0; r < rays_per_packet; ++r)
+		{
+			f32 angle = π * r / (rays_per_packet - 1);
+			v3 start = position + (right * f32_cos(angle) + forward * sine(angle)) * character_radius;
+			ray_packet_add(packets[i], start, forward, length);
+		}
+	}
+
+	RaycastResult * singleResults 	= push_memory<RaycastResult>(memory.persistent, packet_count * rays_per_packet, ALLOC_ZERO_MEMORY);
+	RaycastResult * batchResults 	= push_memory<RaycastResult>(memory.persistent, packet_count * rays_per_packet, ALLOC_ZERO_MEMORY);
+	u32 * singleHits 				= push_memory<u32>(memory.persistent, packet_count, ALLOC_ZERO_MEMORY);
+	u32 * batchHits 				= push_memory<u32>(memory.persistent, packet_count, ALLOC_ZERO_MEMORY);
+
+	s64 singleStart = platform_time_now();
+	for (s32 i = 0; i < packet_count; ++i)
+	{
+		for (s32 r = 0; r < packets[i].count; ++r)
+		{
+			Ray ray = ray_packet_get_ray(packets[i], r);
+			if (raycast_3d(&system, ray.start, ray.direction, ray.length, &singleResults[i * rays_per_packet + r]))
+			{
+				singleHits[i] |= 1 << r;
+			}
+		}
+	}
+	f64 singleSeconds = platform_time_elapsed_seconds(singleStart, platform_time_now());
+
+	s64 batchStart = platform_time_now();
+	for (s32 i = 0; i < packet_count; ++i)
+	{
+		batchHits[i] = raycast_3d_batch(&system, packets[i], &batchResults[i * rays_per_packet]);
+	}
+	f64 batchSeconds = platform_time_elapsed_seconds(batchStart, platform_time_now());
+
+	s32 hitCount 		= 0;
+	s32 mismatchCount 	= 0;
+	for (s32 i = 0; i < packet_count; ++i)
+	{
+		for (s32 r = 0; r < rays_per_packet; ++r)
+		{
+			bool32 singleHit 	= (singleHits[i] & (1 << r)) != 0;
+			bool32 batchHit 	= (batchHits[i] & (1 << r)) != 0;
+
+			hitCount += singleHit ? 1 : 0;
+
+			RaycastResult const & a = singleResults[i * rays_per_packet + r];
+			RaycastResult const & b = batchResults[i * rays_per_packet + r];
+
+			bool32 sameResult 	= v3_length(a.hitPosition - b.hitPosition) < 0.0001f
+								&& v3_length(a.hitNormal - b.hitNormal) < 0.0001f
+								&& a.collider.type == b.collider.type
+								&& a.collider.index == b.collider.index;
+
+			if (singleHit != batchHit || (singleHit && sameResult == false))
+			{
+				mismatchCount += 1;
+			}
+		}
+	}
+
+	s32 rayCount = packet_count * rays_per_packet;
+
+	log_application(0, "Ray batch, ", collider_count, " colliders, ", packet_count, " packets of ", rays_per_packet, " rays, hit rate ",
+						(f32)hitCount / rayCount * 100, " %");
+	log_application(0, "\tsingle ", (f32)(rayCount / singleSeconds), " rays/s, batch ", (f32)(rayCount / batchSeconds), " rays/s, ",
+						(f32)(singleSeconds / batchSeconds), "x, ", mismatchCount, "/", rayCount, " mismatching hits");
+}
+
+/// ---------- TERRAIN --------------------------
+
+// Note(Leo): Reference for pyramid: walk through every cell ray passes over, and test them exactly
+internal bool32 fsheadless_ray_height_map_cells(HeightMap const & map, v3 offset, Ray ray, f32 * outDistance)
+{
+	f32 gridScale 		= map.gridSize / map.worldSize;
+	v3 gridRayStart 	= {(ray.start.x - offset.x) * gridScale, (ray.start.y - offset.y) * gridScale, ray.start.z};
+	v3 gridRayDirection = {ray.direction.x * gridScale, ray.direction.y * gridScale, ray.direction.z};
+
+	s32 cellCount 		= map.gridSize - 1;
+	f32 inverseX 		= 1.0f / gridRayDirection.x;
+	f32 inverseY 		= 1.0f / gridRayDirection.y;
+
+	f32 x0 = (0 - gridRayStart.x) * inverseX;
+	f32 x1 = (cellCount - gridRayStart.x) * inverseX;
+	f32 y0 = (0 - gridRayStart.y) * inverseY;
+	f32 y1 = (cellCount - gridRayStart.y) * inverseY;
+
+	f32 start 	= f32_max(f32_max(f32_min(x0, x1), f32_min(y0, y1)), 0);
+	f32 end 	= f32_min(f32_min(f32_max(x0, x1), f32_max(y0, y1)), ray.length);
+
+	if ((start < end) == false)
+	{
+		return false;
+	}
+
+	f32 middle 	= f32_min(start + 0.0001f, (start + end) / 2);
+	s32 cellX 	= s32_clamp((s32)floor_f32(gridRayStart.x + gridRayDirection.x * middle), 0, cellCount - 1);
+	s32 cellY 	= s32_clamp((s32)floor_f32(gridRayStart.y + gridRayDirection.y * middle), 0, cellCount - 1);
+
+	s32 stepX 	= gridRayDirection.x > 0 ? 1 : -1;
+	s32 stepY 	= gridRayDirection.y > 0 ? 1 : -1;
+
+	auto next_crossing = [](f32 start, f32 inverseDirection, s32 cell, s32 step)
+	{
+		f32 border = (f32)(step > 0 ? cell + 1 : cell);
+		f32 result = (border - start) * inverseDirection;
+		return result == result ? result : highest_f32;
+	};
+
+	f32 cellStart = start;
+	while (cellStart < end)
+	{
+		f32 crossX 		= next_crossing(gridRayStart.x, inverseX, cellX, stepX);
+		f32 crossY 		= next_crossing(gridRayStart.y, inverseY, cellY, stepY);
+		f32 cellEnd 	= f32_min(f32_min(crossX, crossY), end);
+
+		f32 distance;
+		v3 normal;
+		if (ray_height_map_cell_collision(map, cellX, cellY, gridRayStart, gridRayDirection, cellStart, cellEnd, &distance, &normal)
+			&& distance > 0.00001f && distance < ray.length)
+		{
+			*outDistance = distance;
+			return true;
+		}
+
+		if (crossX < crossY) 	{ cellX += stepX; }
+		else 					{ cellY += stepY; }
+
+		if (cellX < 0 || cellX >= cellCount || cellY < 0 || cellY >= cellCount)
+		{
+			break;
+		}
+
+		cellStart = cellEnd;
+	}
+
+	return false;
+}
+
+/*
+Note(Leo): Height map is made from sines, it is same size as game's, but game's comes from texture
+asset which is not available here. Rays start above terrain and go long ways across map, mostly a
+little downwards, like camera or mouse pick rays. Marching is what one would do with only
+get_terrain_height: fixed steps and bisection after crossing ground.
+*/
+internal void fsheadless_benchmark_terrain()
+{
+	HeadlessBenchmarkMemory memory;
+	fsheadless_benchmark_memory(memory, megabytes(256));
+
+	constexpr s32 grid_size 		= 1024;
+	constexpr f32 map_size 			= 1200;
+	constexpr f32 min_height 		= -5;
+	constexpr f32 max_height 		= 100;
+	constexpr s32 ray_count 		= 20000;
+	constexpr f32 ray_length 		= 1500;
+	constexpr f32 march_step 		= 0.5f;
+
+	RandomState random = random_state_from_seed(grid_size);
+
+	HeightMap map 	= {};
+	map.values 		= push_memory<f32>(memory.persistent, grid_size * grid_size, ALLOC_GARBAGE);
+	map.gridSize 	= grid_size;
+	map.worldSize 	= map_size;
+	map.minHeight 	= min_height;
+	map.maxHeight 	= max_height;
+
+	constexpr s32 wave_count = 8;
+	v3 waves [wave_count];
+	for (v3 & wave : waves)
+	{
+		wave = {random_range(random, 0.002, 0.05), random_range(random, 0.002, 0.05), random_range(random, 0, 2 * π)};
+	}
+
+	for (s32 y = 0; y < grid_size; ++y)
+	{
+		for (s32 x = 0; x < grid_size; ++x)
+		{
+			f32 value = 0;
+			for (s32 i = 0; i < wave_count; ++i)
+			{
+				value += sine(x * waves[i].x + y * waves[i].y + waves[i].z) / (i + 1);
+			}
+			map.values[x + y * grid_size] = f32_clamp(value * 0.25f + 0.3f, 0, 1);
+		}
+	}
+
+	CollisionSystem3D system 	= {};
+	system.terrainCollider 		= map;
+	system.terrainOffset 		= {-map_size / 2, -map_size / 2, 0};
+
+	s64 buildStart = platform_time_now();
+	collision_system_build_terrain_pyramid(system, memory.persistent);
+	f64 buildSeconds = platform_time_elapsed_seconds(buildStart, platform_time_now());
+
+	Ray * rays = push_memory<Ray>(memory.persistent, ray_count, ALLOC_GARBAGE);
+	for (s32 i = 0; i < ray_count; ++i)
+	{
+		v2 position = {random_range(random, -map_size / 2, map_size / 2), random_range(random, -map_size / 2, map_size / 2)};
+		f32 height 	= get_terrain_height(system, position) + random_range(random, 1, 50);
+		f32 angle 	= random_range(random, 0, 2 * π);
+		v3 forward 	= {f32_cos(angle), sine(angle), random_range(random, -0.3, 0.02)};
+		rays[i] 	= {{position.x, position.y, height}, v3_normalize(forward), ray_length};
+	}
+
+	f32 * pyramidDistances 	= push_memory<f32>(memory.persistent, ray_count, ALLOC_GARBAGE);
+	f32 * cellDistances 	= push_memory<f32>(memory.persistent, ray_count, ALLOC_GARBAGE);
+	f32 * marchDistances 	= push_memory<f32>(memory.persistent, ray_count, ALLOC_GARBAGE);
+
+	s64 pyramidStart = platform_time_now();
+	for (s32 i = 0; i < ray_count; ++i)
+	{
+		pyramidDistances[i] = highest_f32;
+		ray_terrain_collision(system, rays[i], CollisionLayer_terrain, nullptr, &pyramidDistances[i]);
+	}
+	f64 pyramidSeconds = platform_time_elapsed_seconds(pyramidStart, platform_time_now());
+
+	s64 cellStart = platform_time_now();
+	for (s32 i = 0; i < ray_count; ++i)
+	{
+		cellDistances[i] = highest_f32;
+		fsheadless_ray_height_map_cells(map, system.terrainOffset, rays[i], &cellDistances[i]);
+	}
+	f64 cellSeconds = platform_time_elapsed_seconds(cellStart, platform_time_now());
+
+	s64 marchStart = platform_time_now();
+	for (s32 i = 0; i < ray_count; ++i)
+	{
+		marchDistances[i] = highest_f32;
+
+		auto above_ground = [&](f32 distance)
+		{
+			v3 position = rays[i].start + rays[i].direction * distance;
+			return position.z > get_terrain_height(system, position.xy);
+		};
+
+		for (f32 distance = march_step; distance < ray_length; distance += march_step)
+		{
+			if (above_ground(distance) == false)
+			{
+				f32 above = distance - march_step;
+				f32 below = distance;
+				for (s32 step = 0; step < 16; ++step)
+				{
+					f32 middle = (above + below) / 2;
+					if (above_ground(middle)) 	{ above = middle; }
+					else 						{ below = middle; }
+				}
+				marchDistances[i] = below;
+				break;
+			}
+		}
+	}
+	f64 marchSeconds = platform_time_elapsed_seconds(marchStart, platform_time_now());
+
+	s32 hitCount 			= 0;
+	s32 mismatchCount 		= 0;
+	s32 marchMismatchCount 	= 0;
+	for (s32 i = 0; i < ray_count; ++i)
+	{
+		hitCount += pyramidDistances[i] < highest_f32 ? 1 : 0;
+
+		if (abs_f32(pyramidDistances[i] - cellDistances[i]) > 0.001f)
+		{
+			mismatchCount += 1;
+		}
+
+		if (abs_f32(pyramidDistances[i] - marchDistances[i]) > 0.01f)
+		{
+			marchMismatchCount += 1;
+		}
+	}
+
+	log_application(0, "Terrain, ", grid_size, "x", grid_size, " height map, pyramid build ", (f32)(buildSeconds * 1000), " ms, ",
+						system.terrainPyramid.levelCount, " levels, ", ray_count, " rays of ", ray_length, " m, hit rate ", (f32)hitCount / ray_count * 100, " %");
+	log_application(0, "\tpyramid ", (f32)(ray_count / pyramidSeconds), " rays/s, cells ", (f32)(ray_count / cellSeconds), " rays/s, ",
+						(f32)(cellSeconds / pyramidSeconds), "x, ", mismatchCount, "/", ray_count, " mismatching hits");
+	log_application(0, "\tmarching ", march_step, " m steps ", (f32)(ray_count / marchSeconds), " rays/s, ",
+						(f32)(marchSeconds / pyramidSeconds), "x slower than pyramid, ", marchMismatchCount, "/", ray_count, " differ over 1 cm");
+}
+
+/// ---------- SWEEP --------------------------
+
+/*
+Note(Leo): Steps are like character motor's movement: capsule sweep from step height to climbing
+height vs. five rays on front half of character's circle at step height. Scene is like in ray batch,
+but half of submitted cylinders are thin poles and half of static boxes are thin boards, which rays
+can slip between. Sweeps are also compared to sweeping every collider without trees.
+*/
+internal void fsheadless_benchmark_sweep()
+{
+	// Note(Leo): Packets and both result arrays take about 185 MB
+	HeadlessBenchmarkMemory memory;
+	fsheadless_benchmark_memory(memory, gigabytes(1));
+
+	constexpr s32 collider_count 	= 2000;
+	constexpr s32 step_count 		= 100000;
+	constexpr s32 rays_per_fan 		= 5;
+	constexpr f32 character_radius 	= 0.25f;
+	constexpr f32 step_height 		= 0.25f;
+	constexpr f32 climb_height 		= 1.0f;
+	constexpr s32 timing_round_count = 5;
+
+	RandomState random = random_state_from_seed(collider_count);
+
+	f32 worldSize = f32_sqr_root((f32)collider_count) * 4;
+
+	CollisionSystem3D system 	= init_collision_system(memory.persistent);
+	system.triangleColliders 	= push_array<TriangleCollider>(memory.persistent, collider_count / 4, ALLOC_GARBAGE);
+
+	auto random_transform = [&]() -> Transform3D
+	{
+		Transform3D transform 	= {};
+		transform.position 		= {random_range(random, 0, worldSize), random_range(random, 0, worldSize), 0};
+		transform.rotation 		= quaternion_axis_angle(v3_up, random_range(random, 0, 2 * π));
+		transform.scale 		= {1, 1, 1};
+		return transform;
+	};
+
+	BoxCollider boxCollider 			= {{0.5, 0.5, 0.5}, quaternion_identity, {0, 0, 0.5}};
+	BoxCollider boardCollider 			= {{0.5, 0.01, 0.5}, quaternion_identity, {0, 0, 0.5}};
+	CylinderCollider cylinderCollider 	= {0.3, 0.5, {0, 0, 0.5}};
+	CylinderCollider poleCollider 		= {0.03, 0.5, {0, 0, 0.5}};
+
+	collision_system_begin_submitted_colliders(system);
+	for (s32 i = 0; i < collider_count / 4; ++i)
+	{
+		submit_box_collider(system, boxCollider, random_transform());
+		submit_cylinder_collider(system, i % 2 ? poleCollider : cylinderCollider, {random_transform().position, quaternion_identity, {1, 1, 1}});
+	}
+	collision_system_end_submitted_colliders(system);
+
+	system.staticBoxColliders = push_array<PrecomputedBoxCollider>(memory.persistent, collider_count / 4, ALLOC_GARBAGE);
+	for (s32 i = 0; i < collider_count / 4; ++i)
+	{
+		push_static_box_collider(system, i % 2 ? boardCollider : boxCollider, random_transform());
+
+		v3 center = random_transform().position;
+		TriangleCollider triangle;
+		for (v3 & vertex : triangle.vertices)
+		{
+			vertex = center + v3{random_range(random, -1, 1), random_range(random, -1, 1), random_range(random, 0, 1)};
+		}
+		system.triangleColliders.push(triangle);
+	}
+	collision_system_build_static_bvh(system, memory.persistent);
+
+	struct Step
+	{
+		v3 	position;
+		v3 	forward;
+		f32 length;
+	};
+
+	// Note(Leo): Packets first, push_memory does not align and packets need 16 byte alignment
+	RayPacket * fans 	= push_memory<RayPacket>(memory.persistent, step_count, ALLOC_ZERO_MEMORY);
+	Step * steps 		= push_memory<Step>(memory.persistent, step_count, ALLOC_GARBAGE);
+
+	for (s32 i = 0; i < step_count; ++i)
+	{
+		Step & step 	= steps[i];
+		step.position 	= {random_range(random, 0, worldSize), random_range(random, 0, worldSize), 0};
+		step.forward 	= quaternion_rotate_v3(quaternion_axis_angle(v3_up, random_range(random, 0, 2 * π)), v3_forward);
+		step.length 	= random_range(random, 0.05, 0.5);
+
+		v3 right = v3_cross(step.forward, v3_up);
+		for (s32 r = 0; r < rays_per_fan; ++r)
+		{
+			f32 angle 	= π * r / (rays_per_fan - 1);
+			v3 start 	= step.position + (right * f32_cos(angle) + step.forward * sine(angle)) * character_radius + v3_up * step_height;
+			ray_packet_add(fans[i], start, step.forward, step.length);
+		}
+	}
+
+	u32 * fanHits 					= push_memory<u32>(memory.persistent, step_count, ALLOC_ZERO_MEMORY);
+	RaycastResult * sweepResults 	= push_memory<RaycastResult>(memory.persistent, step_count, ALLOC_ZERO_MEMORY);
+	bool32 * sweepHits 				= push_memory<bool32>(memory.persistent, step_count, ALLOC_ZERO_MEMORY);
+
+	auto capsule_start 	= [](Step const & step) { return step.position + v3_up * (step_height + character_radius); };
+	auto capsule_end 	= [](Step const & step) { return step.position + v3_up * climb_height; };
+
+	/*
+	Note(Leo): Both fan and sweep spend most of their time finding candidates from same submitted tree
+	and static bvh, and only few steps have any candidates, so they take about same time and one
+	round is mostly noise. Fastest of several rounds is kept.
+	*/
+	f64 fanSeconds 		= highest_f32;
+	f64 sweepSeconds 	= highest_f32;
+
+	for (s32 round = 0; round < timing_round_count; ++round)
+	{
+		s64 fanStart = platform_time_now();
+		for (s32 i = 0; i < step_count; ++i)
+		{
+			fanHits[i] = raycast_3d_batch(&system, fans[i], nullptr, CollisionLayer_colliders);
+		}
+		f64 fanRoundSeconds = platform_time_elapsed_seconds(fanStart, platform_time_now());
+		fanSeconds 			= fanRoundSeconds < fanSeconds ? fanRoundSeconds : fanSeconds;
+
+		s64 sweepStart = platform_time_now();
+		for (s32 i = 0; i < step_count; ++i)
+		{
+			Step const & step = steps[i];
+			sweepHits[i] = capsule_sweep_3d(&system, capsule_start(step), capsule_end(step), character_radius, step.forward, step.length,
+											&sweepResults[i], CollisionLayer_colliders);
+		}
+		f64 sweepRoundSeconds 	= platform_time_elapsed_seconds(sweepStart, platform_time_now());
+		sweepSeconds 			= sweepRoundSeconds < sweepSeconds ? sweepRoundSeconds : sweepSeconds;
+	}
+
+	// Note(Leo): Reference is same sweep against every collider one by one
+	auto sweep_all_colliders = [&](Step const & step, f32 * outDistance) -> bool32
+	{
+		CapsuleSweep sweep 	= make_capsule_sweep(capsule_start(step), capsule_end(step), character_radius, step.forward, step.length);
+		f32 closestDistance = step.length;
+		bool32 hit 			= false;
+
+		auto test = [&](auto support)
+		{
+			f32 distance;
+			v3 normal;
+			v3 contact;
+			if (capsule_convex_sweep(sweep, closestDistance, support, &distance, &normal, &contact))
+			{
+				hit 			= true;
+				closestDistance = distance;
+			}
+		};
+
+		for (SubmittedBoxCollider const & box : system.submittedBoxColliders)
+		{
+			test([&box](v3 direction) { return box_collider_support(box.precomputed, direction); });
+		}
+		for (SubmittedCylinderCollider const & cylinder : system.submittedCylinderColliders)
+		{
+			test([&cylinder](v3 direction) { return cylinder_collider_support(cylinder.collider, direction); });
+		}
+		for (PrecomputedBoxCollider const & box : system.staticBoxColliders)
+		{
+			test([&box](v3 direction) { return box_collider_support(box, direction); });
+		}
+		for (TriangleCollider const & triangle : system.triangleColliders)
+		{
+			test([&triangle](v3 direction) { return triangle_support(triangle.vertices, direction); });
+		}
+
+		*outDistance = closestDistance;
+		return hit;
+	};
+
+	s32 fanHitCount 		= 0;
+	s32 sweepHitCount 		= 0;
+	s32 fanMissedCount 		= 0;
+	s32 sweepMissedCount 	= 0;
+	s32 mismatchCount 		= 0;
+
+	for (s32 i = 0; i < step_count; ++i)
+	{
+		bool32 fanHit = fanHits[i] != 0;
+
+		fanHitCount 		+= fanHit ? 1 : 0;
+		sweepHitCount 		+= sweepHits[i] ? 1 : 0;
+		fanMissedCount 		+= (sweepHits[i] && fanHit == false) ? 1 : 0;
+		sweepMissedCount 	+= (fanHit && sweepHits[i] == false) ? 1 : 0;
+
+		// Note(Leo): Brute force is slow, so check only part of steps
+		if (i % 10 == 0)
+		{
+			f32 referenceDistance;
+			bool32 referenceHit = sweep_all_colliders(steps[i], &referenceDistance);
+
+			if (referenceHit != sweepHits[i] || (referenceHit && abs_f32(referenceDistance - sweepResults[i].distance) > 0.0001f))
+			{
+				mismatchCount += 1;
+			}
+		}
+	}
+
+	log_application(0, "Sweep, ", collider_count, " colliders, ", step_count, " steps, fan hit rate ", (f32)fanHitCount / step_count * 100,
+						" %, sweep hit rate ", (f32)sweepHitCount / step_count * 100, " %");
+	log_application(0, "	fan of ", rays_per_fan, " rays ", (f32)(step_count / fanSeconds), " steps/s, sweep ", (f32)(step_count / sweepSeconds),
+						" steps/s, ", (f32)(fanSeconds / sweepSeconds), "x");
+	log_application(0, "	", fanMissedCount, " steps hit only by sweep, ", sweepMissedCount, " only by fan, ",
+						mismatchCount, "/", step_count / 10, " sweeps mismatch with sweeping every collider");
+}
+
+/*
+Note(Leo): Waters are removed, added and carried around between queries like in game, so that
+grid's incremental updates are checked too. Every query is compared against linear scan.
+*/
+internal void fsheadless_benchmark_entity_index()
+{
+	HeadlessBenchmarkMemory memory;
+	fsheadless_benchmark_memory(memory, megabytes(64));
+
+	constexpr s32 round_count 			= 1000;
+	constexpr s32 changes_per_round 	= 50;
+	constexpr s32 queries_per_round 	= 100;
+	constexpr f32 pickup_distance 		= 1.0f;
+
+	Waters waters;
+	initialize_waters(waters, memory.persistent);
+
+	RandomState random = random_state_from_seed(waters.data.capacity);
+
+	f32 worldSize = 500;
+	auto random_index = [&]() -> s32
+	{
+		return s32_min((s32)(random_value(random) * waters.data.count), waters.data.count - 1);
+	};
+
+	auto random_position = [&]() -> v3
+	{
+		return {random_range(random, 0, worldSize), random_range(random, 0, worldSize), random_range(random, 0, 1)};
+	};
+
+	for (s32 i = 0; i < waters.data.capacity; ++i)
+	{
+		waters_instantiate(waters, random_position(), 1);
+	}
+
+	EntitySpatialIndex index 	= {};
+	index.waterGrid 			= &waters.grid;
+
+	auto entity_position 	= [&waters](EntityReference entity) { return waters.positions()[entity.index]; };
+	auto any_entity 		= [](EntityReference entity) { return true; };
+
+	f64 linearSeconds 	= 0;
+	f64 indexSeconds 	= 0;
+	s32 hitCount 		= 0;
+	s32 mismatchCount 	= 0;
+
+	for (s32 round = 0; round < round_count; ++round)
+	{
+		for (s32 i = 0; i < changes_per_round; ++i)
+		{
+			waters_unordered_remove(waters, random_index());
+		}
+
+		for (s32 i = 0; i < changes_per_round; ++i)
+		{
+			s32 carriedIndex 				= random_index();
+			waters.positions()[carriedIndex] 	= random_position();
+			spatial_hash_grid_move(waters.grid, carriedIndex, waters.positions()[carriedIndex].xy);
+		}
+
+		for (s32 i = 0; i < changes_per_round; ++i)
+		{
+			waters_instantiate(waters, random_position(), 1);
+		}
+
+		v3 queryPositions [queries_per_round];
+		for (v3 & position : queryPositions)
+		{
+			position = random_position();
+		}
+
+		s32 linearResults [queries_per_round];
+		s64 linearStart = platform_time_now();
+		for (s32 q = 0; q < queries_per_round; ++q)
+		{
+			linearResults[q] 	= -1;
+			f32 nearestDistance = pickup_distance;
+			for (s32 i = 0; i < waters.data.count; ++i)
+			{
+				f32 distance = v3_length(queryPositions[q] - waters.positions()[i]);
+				if (distance < nearestDistance)
+				{
+					nearestDistance 	= distance;
+					linearResults[q] 	= i;
+				}
+			}
+		}
+		linearSeconds += platform_time_elapsed_seconds(linearStart, platform_time_now());
+
+		s32 indexResults [queries_per_round];
+		s64 indexStart = platform_time_now();
+		for (s32 q = 0; q < queries_per_round; ++q)
+		{
+			EntityReference nearest;
+			bool32 found 		= entity_spatial_index_find_nearest(index, queryPositions[q], pickup_distance, EntityTypeFlag_water,
+																	&nearest, entity_position, any_entity);
+			indexResults[q] 	= found ? nearest.index : -1;
+		}
+		indexSeconds += platform_time_elapsed_seconds(indexStart, platform_time_now());
+
+		for (s32 q = 0; q < queries_per_round; ++q)
+		{
+			hitCount 		+= linearResults[q] >= 0 ? 1 : 0;
+			mismatchCount 	+= linearResults[q] != indexResults[q] ? 1 : 0;
+		}
+	}
+
+	s32 queryCount = round_count * queries_per_round;
+
+	log_application(0, "Entity index, ", waters.data.count, " waters, ", queryCount, " pickup queries of ", pickup_distance, " m, ",
+						hitCount, " hits, ", mismatchCount, " mismatches");
+	log_application(0, "\tlinear ", (f32)(queryCount / linearSeconds), " queries/s, index ", (f32)(queryCount / indexSeconds),
+						" queries/s, ", (f32)(linearSeconds / indexSeconds), "x");
+}
+
+/*
+Note(Leo): Like trees taking water and clouds raining in game, with 100k waters. Tree lookups take and
+remove water, so both versions are run on their own copies and results are compared.
+*/
+internal void fsheadless_benchmark_waters()
+{
+	HeadlessBenchmarkMemory memory;
+	fsheadless_benchmark_memory(memory, megabytes(256));
+
+	constexpr s32 frame_count 			= 100;
+	constexpr s32 tree_count 			= 200;
+	constexpr s32 steps_per_tree 		= 4;
+	constexpr s32 cloud_count 			= 4;
+	constexpr f32 cloud_radius 			= 47;
+	constexpr f32 tree_water_distance 	= 2;
+	constexpr f32 water_taken_per_step 	= 0.05;
+
+	// Note(Leo): Same number of waters in bigger world, so that there are less drops under each cloud
+	f32 worldSizes [] = {500, 2000};
+	for (f32 worldSize : worldSizes)
+	{
+		Waters linearWaters;
+		Waters gridWaters;
+		initialize_waters(linearWaters, memory.persistent);
+		initialize_waters(gridWaters, memory.persistent);
+
+		RandomState random = random_state_from_seed(linearWaters.data.capacity);
+
+		auto random_position = [&]() -> v3
+		{
+			return {random_range(random, 0, worldSize), random_range(random, 0, worldSize), 0};
+		};
+
+		for (s32 i = 0; i < linearWaters.data.capacity; ++i)
+		{
+			v3 position = random_position();
+			f32 level 	= random_range(random, 0, 1.5);
+			waters_instantiate(linearWaters, position, level);
+			waters_instantiate(gridWaters, position, level);
+		}
+
+		v3 treePositions [tree_count];
+		for (v3 & position : treePositions)
+		{
+			position = random_position();
+		}
+
+		v2 cloudPositions [cloud_count];
+		for (v2 & position : cloudPositions)
+		{
+			position = random_position().xy;
+		}
+
+		Array<s32> linearSelected 	= push_array<s32>(memory.persistent, linearWaters.data.capacity, ALLOC_GARBAGE);
+		Array<s32> gridSelected 	= push_array<s32>(memory.persistent, gridWaters.data.capacity, ALLOC_GARBAGE);
+
+		f64 linearTreeSeconds 	= 0;
+		f64 gridTreeSeconds 	= 0;
+		f64 linearRainSeconds 	= 0;
+		f64 gridRainSeconds 	= 0;
+		s32 waterTakenCount 	= 0;
+		s32 selectedCount 		= 0;
+		s32 mismatchCount 		= 0;
+
+		for (s32 frame = 0; frame < frame_count; ++frame)
+		{
+			s32 linearTakenCount 	= 0;
+			s64 linearTreeStart 	= platform_time_now();
+			for (s32 step = 0; step < tree_count * steps_per_tree; ++step)
+			{
+				v3 position = treePositions[step % tree_count];
+
+				s32 nearestIndex 	= -1;
+				f32 nearestDistance = tree_water_distance;
+				for (s32 i = 0; i < linearWaters.data.count; ++i)
+				{
+					f32 distance = v3_length(linearWaters.positions()[i] - position);
+					if (distance < nearestDistance)
+					{
+						nearestDistance = distance;
+						nearestIndex 	= i;
+					}
+				}
+
+				if (nearestIndex >= 0)
+				{
+					linearTakenCount += 1;
+					linearWaters.levels()[nearestIndex] -= water_taken_per_step;
+					if (linearWaters.levels()[nearestIndex] < 0)
+					{
+						waters_unordered_remove(linearWaters, nearestIndex);
+					}
+				}
+			}
+			linearTreeSeconds += platform_time_elapsed_seconds(linearTreeStart, platform_time_now());
+
+			s32 gridTakenCount 	= 0;
+			s64 gridTreeStart 	= platform_time_now();
+			for (s32 step = 0; step < tree_count * steps_per_tree; ++step)
+			{
+				s32 nearestIndex = waters_find_nearest(gridWaters, treePositions[step % tree_count], tree_water_distance);
+				if (nearestIndex >= 0)
+				{
+					gridTakenCount += 1;
+					gridWaters.levels()[nearestIndex] -= water_taken_per_step;
+					if (gridWaters.levels()[nearestIndex] < 0)
+					{
+						waters_unordered_remove(gridWaters, nearestIndex);
+					}
+				}
+			}
+			gridTreeSeconds += platform_time_elapsed_seconds(gridTreeStart, platform_time_now());
+
+			waterTakenCount += linearTakenCount;
+			mismatchCount 	+= linearTakenCount != gridTakenCount ? 1 : 0;
+			mismatchCount 	+= linearWaters.data.count != gridWaters.data.count ? 1 : 0;
+
+			for (v2 cloudPosition : cloudPositions)
+			{
+				linearSelected.count = 0;
+				s64 linearRainStart = platform_time_now();
+				for (s32 i = 0; i < linearWaters.data.count; ++i)
+				{
+					if (v2_length(cloudPosition - linearWaters.positions()[i].xy) < cloud_radius && linearWaters.levels()[i] < 1)
+					{
+						linearSelected.push(i);
+					}
+				}
+				linearRainSeconds += platform_time_elapsed_seconds(linearRainStart, platform_time_now());
+
+				gridSelected.count = 0;
+				s64 gridRainStart = platform_time_now();
+				waters_query_disc(gridWaters, cloudPosition, cloud_radius, [&](s32 i)
+				{
+					if (gridWaters.levels()[i] < 1)
+					{
+						gridSelected.push(i);
+					}
+				});
+				gridRainSeconds += platform_time_elapsed_seconds(gridRainStart, platform_time_now());
+
+				// Note(Leo): Grid gives same drops in different order, and waters are in same order in both copies
+				u64 linearSum = 0;
+				u64 gridSum = 0;
+				for (s32 i : linearSelected) { linearSum += (u64)i * (u64)i; }
+				for (s32 i : gridSelected) { gridSum += (u64)i * (u64)i; }
+
+				selectedCount += linearSelected.count;
+				mismatchCount += linearSelected.count != gridSelected.count || linearSum != gridSum ? 1 : 0;
+			}
+
+			for (v2 & cloudPosition : cloudPositions)
+			{
+				cloudPosition += v2{0.5, 0.2};
+			}
+		}
+
+		s32 lookupCount = frame_count * tree_count * steps_per_tree;
+		s32 rainCount 	= frame_count * cloud_count;
+
+		log_application(0, "Waters, ", worldSize, " m world, ", gridWaters.data.count, " waters left, ", lookupCount, " tree water lookups, ", waterTakenCount,
+							" found water, ", rainCount, " rain queries selecting ", selectedCount, " drops, ", mismatchCount, " mismatches");
+		log_application(0, "\ttree lookups: linear ", (f32)(lookupCount / linearTreeSeconds), " lookups/s, grid ", (f32)(lookupCount / gridTreeSeconds),
+							" lookups/s, ", (f32)(linearTreeSeconds / gridTreeSeconds), "x");
+		log_application(0, "\train: linear ", (f32)(linearRainSeconds / rainCount * 1000), " ms, grid ", (f32)(gridRainSeconds / rainCount * 1000),
+							" ms, ", (f32)(linearRainSeconds / gridRainSeconds), "x");
+	}
+}
+
+/// ---------- TRIANGLE MESH --------------------------
+
+/*
+Note(Leo): Bumpy sphere, about as many triangles as castle, placed like monuments are: same mesh
+several times, rotated and scaled, one of them non uniformly. Flat version is how castle used to be
+done, every instance's triangles copied to world space and put to static bvh. Both should find same
+hits, so distances are compared too.
+*/
+internal void fsheadless_benchmark_triangle_mesh()
+{
+	HeadlessBenchmarkMemory memory;
+	fsheadless_benchmark_memory(memory, gigabytes(1));
+
+	constexpr s32 ring_count 		= 128;
+	constexpr s32 segment_count 	= 128;
+	constexpr s32 instance_count 	= 5;
+	constexpr s32 ray_count 		= 200000;
+	constexpr s32 sweep_count 		= 50000;
+	constexpr f32 ray_length 		= 20;
+	constexpr f32 sweep_length 		= 2;
+	constexpr f32 sweep_radius 		= 0.3f;
+	constexpr f32 world_size 		= 100;
+
+	RandomState random = random_state_from_seed(19);
+
+	MeshAssetData meshData 	= {};
+	meshData.vertexCount 	= ring_count * segment_count;
+	meshData.indexCount 	= (ring_count - 1) * segment_count * 6;
+	meshData.vertices 		= push_memory<Vertex>(memory.transient, meshData.vertexCount, ALLOC_ZERO_MEMORY);
+	meshData.indices 		= push_memory<u16>(memory.transient, meshData.indexCount, ALLOC_GARBAGE);
+
+	for (s32 ring = 0; ring < ring_count; ++ring)
+	{
+		f32 latitude = π * ring / (ring_count - 1);
+		for (s32 segment = 0; segment < segment_count; ++segment)
+		{
+			f32 longitude 	= 2 * π * segment / segment_count;
+			f32 radius 		= 5 + 0.5f * sine(latitude * 7) * f32_cos(longitude * 5);
+
+			meshData.vertices[ring * segment_count + segment].position =
+			{
+				radius * sine(latitude) * f32_cos(longitude),
+				radius * sine(latitude) * sine(longitude),
+				radius * f32_cos(latitude) + 5
+			};
+		}
+	}
+
+	s64 indexCount = 0;
+	for (s32 ring = 0; ring < ring_count - 1; ++ring)
+	{
+		for (s32 segment = 0; segment < segment_count; ++segment)
+		{
+			u16 v00 = (u16)(ring * segment_count + segment);
+			u16 v01 = (u16)(ring * segment_count + (segment + 1) % segment_count);
+			u16 v10 = (u16)(v00 + segment_count);
+			u16 v11 = (u16)(v01 + segment_count);
+
+			u16 quad [] = {v00, v10, v11, v00, v11, v01};
+			for (u16 index : quad)
+			{
+				meshData.indices[indexCount++] = index;
+			}
+		}
+	}
+
+	m44 transforms [instance_count];
+	for (s32 i = 0; i < instance_count; ++i)
+	{
+		v3 position 		= {20 + 15.0f * i, random_range(random, 30, 70), 0};
+		quaternion rotation = quaternion_axis_angle(v3_up, random_range(random, 0, 2 * π));
+		v3 scale 			= i == instance_count - 1 ? v3{1.5, 0.7, 1.2} : v3{1, 1, 1};
+		transforms[i] 		= transform_matrix(position, rotation, scale);
+	}
+
+	/// BUILD
+	s64 meshBuildStart 				= platform_time_now();
+	TriangleMeshCollider mesh 		= make_triangle_mesh_collider(memory.persistent, meshData);
+	f64 meshBuildSeconds 			= platform_time_elapsed_seconds(meshBuildStart, platform_time_now());
+
+	CollisionSystem3D meshSystem 		= {};
+	meshSystem.staticTriangleMeshes 	= push_array<TriangleMeshInstance>(memory.persistent, instance_count, ALLOC_GARBAGE);
+	for (m44 const & transform : transforms)
+	{
+		push_static_triangle_mesh_collider(meshSystem, mesh, transform);
+	}
+
+	CollisionSystem3D flatSystem 	= {};
+	flatSystem.triangleColliders 	= push_array<TriangleCollider>(memory.persistent, mesh.triangleCount * instance_count, ALLOC_GARBAGE);
+
+	s64 flatBuildStart = platform_time_now();
+	for (m44 const & transform : transforms)
+	{
+		for (s32 i = 0; i < mesh.triangleCount; ++i)
+		{
+			TriangleCollider triangle;
+			triangle_mesh_get_triangle(mesh, i, triangle.vertices);
+			for (v3 & vertex : triangle.vertices)
+			{
+				vertex = multiply_point(transform, vertex);
+			}
+			flatSystem.triangleColliders.push(triangle);
+		}
+	}
+	collision_system_build_static_bvh(flatSystem, memory.persistent);
+	f64 flatBuildSeconds = platform_time_elapsed_seconds(flatBuildStart, platform_time_now());
+
+	s64 meshBytes 	= mesh.vertexCount * sizeof(v3) + mesh.triangleCount * 3 * sizeof(u16) + mesh.nodeCount * sizeof(TriangleMeshBVHNode)
+					+ instance_count * sizeof(TriangleMeshInstance);
+	s64 flatBytes 	= flatSystem.triangleColliders.count * sizeof(TriangleCollider)
+					+ flatSystem.staticBVH.nodes.count * sizeof(CollisionBVHNode)
+					+ flatSystem.staticBVH.references.count * sizeof(StaticColliderReference);
+
+	/// RAYS
+	// Note(Leo): Rays start around instances so that most of them hit something
+	Ray * rays = push_memory<Ray>(memory.persistent, ray_count, ALLOC_GARBAGE);
+	for (s32 i = 0; i < ray_count; ++i)
+	{
+		v3 target 		= multiply_point(transforms[i % instance_count], {random_range(random, -4, 4), random_range(random, -4, 4), random_range(random, 1, 9)});
+		v3 direction 	= v3_normalize({random_range(random, -1, 1), random_range(random, -1, 1), random_range(random, -1, 1)});
+		rays[i] 		= {target - direction * (ray_length / 2), direction, ray_length};
+	}
+
+	f32 * flatDistances = push_memory<f32>(memory.persistent, ray_count, ALLOC_GARBAGE);
+	f32 * meshDistances = push_memory<f32>(memory.persistent, ray_count, ALLOC_GARBAGE);
+
+	s64 flatRayStart = platform_time_now();
+	for (s32 i = 0; i < ray_count; ++i)
+	{
+		flatDistances[i] = ray_length;
+		RaycastResult result;
+		if (raycast_3d(&flatSystem, rays[i].start, rays[i].direction, rays[i].length, &result, CollisionLayer_triangle))
+		{
+			flatDistances[i] = result.distance;
+		}
+	}
+	f64 flatRaySeconds = platform_time_elapsed_seconds(flatRayStart, platform_time_now());
+
+	s32 hitCount = 0;
+
+	s64 meshRayStart = platform_time_now();
+	for (s32 i = 0; i < ray_count; ++i)
+	{
+		meshDistances[i] = ray_length;
+		RaycastResult result;
+		if (raycast_3d(&meshSystem, rays[i].start, rays[i].direction, rays[i].length, &result, CollisionLayer_static_triangle_mesh))
+		{
+			meshDistances[i] 	= result.distance;
+			hitCount 			+= 1;
+		}
+	}
+	f64 meshRaySeconds = platform_time_elapsed_seconds(meshRayStart, platform_time_now());
+
+	s32 rayMismatchCount = 0;
+	for (s32 i = 0; i < ray_count; ++i)
+	{
+		if (abs_f32(flatDistances[i] - meshDistances[i]) > 0.001f)
+		{
+			rayMismatchCount += 1;
+		}
+	}
+
+	/// SWEEPS
+	s32 sweepHitCount 		= 0;
+	s32 sweepMismatchCount 	= 0;
+	f64 flatSweepSeconds 	= 0;
+	f64 meshSweepSeconds 	= 0;
+
+	for (s32 i = 0; i < sweep_count; ++i)
+	{
+		v3 start 		= multiply_point(transforms[i % instance_count], {random_range(random, -7, 7), random_range(random, -7, 7), random_range(random, -1, 11)});
+		v3 direction 	= v3_normalize({random_range(random, -1, 1), random_range(random, -1, 1), random_range(random, -1, 1)});
+		v3 top 			= start + v3{0, 0, 1};
+
+		RaycastResult flatResult;
+		s64 flatStart 	= platform_time_now();
+		bool32 flatHit 	= capsule_sweep_3d(&flatSystem, start, top, sweep_radius, direction, sweep_length, &flatResult, CollisionLayer_triangle);
+		flatSweepSeconds += platform_time_elapsed_seconds(flatStart, platform_time_now());
+
+		RaycastResult meshResult;
+		s64 meshStart 	= platform_time_now();
+		bool32 meshHit 	= capsule_sweep_3d(&meshSystem, start, top, sweep_radius, direction, sweep_length, &meshResult, CollisionLayer_static_triangle_mesh);
+		meshSweepSeconds += platform_time_elapsed_seconds(meshStart, platform_time_now());
+
+		sweepHitCount += meshHit ? 1 : 0;
+
+		if (flatHit != meshHit || (flatHit && abs_f32(flatResult.distance - meshResult.distance) > 0.01f))
+		{
+			sweepMismatchCount += 1;
+		}
+	}
+
+	log_application(0, "Triangle mesh, ", instance_count, " instances of ", mesh.triangleCount, " triangles: mesh build ", (f32)(meshBuildSeconds * 1000),
+						" ms, flat build ", (f32)(flatBuildSeconds * 1000), " ms, memory mesh ", (f32)(meshBytes / 1024.0), " kb, flat ", (f32)(flatBytes / 1024.0), " kb");
+	log_application(0, "	rays: flat ", (f32)(ray_count / flatRaySeconds), " rays/s, mesh ", (f32)(ray_count / meshRaySeconds), " rays/s, ",
+						(f32)(flatRaySeconds / meshRaySeconds), "x, hit rate ", (f32)hitCount / ray_count * 100, " %, ", rayMismatchCount, "/", ray_count, " mismatching hits");
+	log_application(0, "	sweeps: flat ", (f32)(sweep_count / flatSweepSeconds), " sweeps/s, mesh ", (f32)(sweep_count / meshSweepSeconds), " sweeps/s, ",
+						(f32)(flatSweepSeconds / meshSweepSeconds), "x, hit rate ", (f32)sweepHitCount / sweep_count * 100, " %, ", sweepMismatchCount, "/", sweep_count, " mismatching hits");
+}
+
+/*
+Note(Leo): Trees grow like in game, and after each frame their capsule trees are refit, and for
+comparison same capsules are inserted to new tree. When trees are grown, rays and sweeps through the
+forest are compared against testing every capsule.
+*/
+internal void fsheadless_benchmark_tree_capsules()
+{
+	HeadlessBenchmarkMemory memory;
+	fsheadless_benchmark_memory(memory, gigabytes(1));
+
+	constexpr s32 tree_count 		= 20;
+	constexpr s32 frame_count 		= 600;
+	constexpr s32 steps_per_frame 	= 4;
+	constexpr s32 ray_count 		= 20000;
+	constexpr s32 sweep_count 		= 20000;
+	constexpr f32 ray_length 		= 10;
+	constexpr f32 sweep_length 		= 1;
+	constexpr f32 sweep_radius 		= 0.3f;
+	constexpr f32 world_size 		= 100;
+
+	RandomState random = random_state_from_seed(20);
+
+	TreeSettings settings 		= {};
+	settings.maxBranchCount 	= 2000;
+	settings.growSpeedScale 	= 4;
+
+	MemoryPool pool = memory_pool(memory.persistent, megabytes(256));
+
+	Array<Tree> trees = push_array<Tree>(memory.persistent, tree_count, ALLOC_ZERO_MEMORY);
+	for (s32 i = 0; i < tree_count; ++i)
+	{
+		trees.count += 1;
+		v3 position = {random_range(random, 0, world_size), random_range(random, 0, world_size), 0};
+		reset_tree_3(trees[i], pool, &settings, position, 100 + i);
+	}
+
+	/// GROW
+	f64 growSeconds 	= 0;
+	f64 refitSeconds 	= 0;
+	f64 rebuildSeconds 	= 0;
+	s32 refitCount 		= 0;
+	s32 updateCount 	= 0;
+
+	for (s32 frame = 0; frame < frame_count; ++frame)
+	{
+		for (Tree & tree : trees)
+		{
+			if (tree.resourceLimitReached)
+			{
+				continue;
+			}
+
+			s64 growStart = platform_time_now();
+			for (s32 step = 0; step < steps_per_frame; ++step)
+			{
+				grow_tree_3(tree, tree_simulation_step, 1);
+			}
+			growSeconds += platform_time_elapsed_seconds(growStart, platform_time_now());
+
+			s64 refitStart = platform_time_now();
+			for (s32 i = 0; i < tree.branches.count; ++i)
+			{
+				refitCount += capsule_tree_collider_set(tree.collider, i, tree_3_branch_capsule(tree, tree.branches[i])) ? 1 : 0;
+			}
+			refitSeconds += platform_time_elapsed_seconds(refitStart, platform_time_now());
+
+			updateCount += tree.branches.count;
+
+			MemoryCheckpoint checkpoint = memory_push_checkpoint(*global_transientMemory);
+			s64 rebuildStart 			= platform_time_now();
+
+			DynamicAABBTree rebuilt = make_dynamic_aabb_tree(*global_transientMemory, tree.branches.count);
+			for (s32 i = 0; i < tree.branches.count; ++i)
+			{
+				dynamic_aabb_tree_create_proxy(rebuilt, compute_capsule_collider_aabb(tree_3_branch_capsule(tree, tree.branches[i])), i);
+			}
+
+			rebuildSeconds += platform_time_elapsed_seconds(rebuildStart, platform_time_now());
+			memory_pop_checkpoint(*global_transientMemory, checkpoint);
+		}
+	}
+
+	s32 capsuleCount 	= 0;
+	s32 maxCapsuleCount = 0;
+
+	CollisionSystem3D system = init_collision_system(memory.persistent);
+	collision_system_begin_submitted_colliders(system);
+	for (s32 i = 0; i < tree_count; ++i)
+	{
+		submit_capsule_tree_collider(system, trees[i].collider, trees[i].position, {EntityType_tree_3, i});
+		capsuleCount 	+= trees[i].collider.capsules.count;
+		maxCapsuleCount = s32_max(maxCapsuleCount, trees[i].collider.capsules.count);
+	}
+	collision_system_end_submitted_colliders(system);
+
+	/// RAYS
+	// Note(Leo): Rays go through random points in trees' crowns, so that many of them hit branches
+	auto random_point_in_tree = [&](s32 i)
+	{
+		Tree const & tree 	= trees[i % tree_count];
+		AABB3D bounds 		= capsule_tree_collider_bounds(tree.collider);
+		v3 local 			= {	random_range(random, bounds.min.x, bounds.max.x),
+								random_range(random, bounds.min.y, bounds.max.y),
+								random_range(random, bounds.min.z, bounds.max.z) };
+		return tree.position + local;
+	};
+
+	auto random_direction = [&]()
+	{
+		return v3_normalize({random_range(random, -1, 1), random_range(random, -1, 1), random_range(random, -1, 1)});
+	};
+
+	Ray * rays = push_memory<Ray>(memory.persistent, ray_count, ALLOC_GARBAGE);
+	for (s32 i = 0; i < ray_count; ++i)
+	{
+		v3 direction 	= random_direction();
+		rays[i] 		= {random_point_in_tree(i) - direction * (ray_length / 2), direction, ray_length};
+	}
+
+	f32 * linearDistances 	= push_memory<f32>(memory.persistent, ray_count, ALLOC_GARBAGE);
+	f32 * treeDistances 	= push_memory<f32>(memory.persistent, ray_count, ALLOC_GARBAGE);
+
+	// Note(Leo): Rays are moved to trees' space like in ray_capsule_tree_collision, so that results are same to last bit
+	s64 linearRayStart = platform_time_now();
+	for (s32 i = 0; i < ray_count; ++i)
+	{
+		linearDistances[i] = ray_length;
+		for (Tree const & tree : trees)
+		{
+			v3 localStart = rays[i].start - tree.position;
+			for (CapsuleCollider const & capsule : tree.collider.capsules)
+			{
+				f32 distance;
+				v3 normal;
+				if (ray_capsule_collision(capsule, localStart, rays[i].direction, linearDistances[i], &distance, &normal))
+				{
+					linearDistances[i] = distance;
+				}
+			}
+		}
+	}
+	f64 linearRaySeconds = platform_time_elapsed_seconds(linearRayStart, platform_time_now());
+
+	s32 hitCount = 0;
+
+	s64 treeRayStart = platform_time_now();
+	for (s32 i = 0; i < ray_count; ++i)
+	{
+		treeDistances[i] = ray_length;
+		RaycastResult result;
+		if (raycast_3d(&system, rays[i].start, rays[i].direction, rays[i].length, &result, CollisionLayer_submitted_capsule_tree))
+		{
+			treeDistances[i] 	= result.distance;
+			hitCount 			+= 1;
+		}
+	}
+	f64 treeRaySeconds = platform_time_elapsed_seconds(treeRayStart, platform_time_now());
+
+	s32 rayMismatchCount = 0;
+	for (s32 i = 0; i < ray_count; ++i)
+	{
+		if (abs_f32(linearDistances[i] - treeDistances[i]) > 0.001f)
+		{
+			rayMismatchCount += 1;
+		}
+	}
+
+	/// SWEEPS
+	s32 sweepHitCount 		= 0;
+	s32 sweepMismatchCount 	= 0;
+	f64 linearSweepSeconds 	= 0;
+	f64 treeSweepSeconds 	= 0;
+
+	for (s32 i = 0; i < sweep_count; ++i)
+	{
+		v3 start 		= random_point_in_tree(i);
+		v3 top 			= start + v3{0, 0, 1};
+		v3 direction 	= random_direction();
+
+		s64 linearStart 		= platform_time_now();
+		CapsuleSweep sweep 		= make_capsule_sweep(start, top, sweep_radius, direction, sweep_length);
+		f32 linearDistance 		= sweep_length;
+		bool32 linearHit 		= false;
+		for (Tree const & tree : trees)
+		{
+			for (CapsuleCollider const & capsule : tree.collider.capsules)
+			{
+				v3 capsuleStart 	= capsule.start + tree.position;
+				v3 capsuleEnd 		= capsule.end + tree.position;
+				if (capsule_sweep_may_hit(sweep, compute_capsule_collider_aabb({capsuleStart, capsuleEnd, capsule.radius}), linearDistance) == false)
+				{
+					continue;
+				}
+
+				CapsuleSweep inflated = make_capsule_sweep(start, top, sweep_radius + capsule.radius, direction, sweep_length);
+				auto support 		= [capsuleStart, capsuleEnd](v3 d) { return segment_support(capsuleStart, capsuleEnd, d); };
+
+				f32 distance;
+				v3 normal;
+				v3 contact;
+				if (capsule_convex_sweep(inflated, linearDistance, support, &distance, &normal, &contact))
+				{
+					linearDistance 	= distance;
+					linearHit 		= true;
+				}
+			}
+		}
+		linearSweepSeconds += platform_time_elapsed_seconds(linearStart, platform_time_now());
+
+		RaycastResult treeResult;
+		s64 treeStart 	= platform_time_now();
+		bool32 treeHit 	= capsule_sweep_3d(&system, start, top, sweep_radius, direction, sweep_length, &treeResult, CollisionLayer_submitted_capsule_tree);
+		treeSweepSeconds += platform_time_elapsed_seconds(treeStart, platform_time_now());
+
+		sweepHitCount += treeHit ? 1 : 0;
+
+		if (linearHit != treeHit || (treeHit && abs_f32(linearDistance - treeResult.distance) > 0.01f))
+		{
+			sweepMismatchCount += 1;
+		}
+	}
+
+	log_application(0, "Tree capsules, ", tree_count, " trees, ", capsuleCount, " capsules, biggest tree ", maxCapsuleCount, " capsules, memory pool ",
+						(f32)(pool.used / 1024.0 / 1024.0), " mb");
+	log_application(0, "	update: grow ", (f32)(growSeconds * 1000 / frame_count), " ms/frame, refit ", (f32)(refitSeconds * 1000 / frame_count),
+						" ms/frame, rebuild ", (f32)(rebuildSeconds * 1000 / frame_count), " ms/frame, ", (f32)(rebuildSeconds / refitSeconds), "x, ",
+						(f32)refitCount / updateCount * 100, " % of capsule updates refit tree");
+	log_application(0, "	rays: linear ", (f32)(ray_count / linearRaySeconds), " rays/s, tree ", (f32)(ray_count / treeRaySeconds), " rays/s, ",
+						(f32)(linearRaySeconds / treeRaySeconds), "x, hit rate ", (f32)hitCount / ray_count * 100, " %, ", rayMismatchCount, "/", ray_count, " mismatching hits");
+	log_application(0, "	sweeps: linear ", (f32)(sweep_count / linearSweepSeconds), " sweeps/s, tree ", (f32)(sweep_count / treeSweepSeconds), " sweeps/s, ",
+						(f32)(linearSweepSeconds / treeSweepSeconds), "x, hit rate ", (f32)sweepHitCount / sweep_count * 100, " %, ", sweepMismatchCount, "/", sweep_count, " mismatching hits");
+}
+
+/*
+Note(Leo): MappedArray as it was before it was slot map: free handle is searched from start of table,
+and since items do not know their handles, removing searches handle of item that is moved.
+*/
+template<typename T>
+struct FsheadlessLinearMappedArray
+{
+	s64 	capacity;
+	s64 	count;
+	s64 * 	indirectionTable;
+	T * 	memory;
+
+	s64 push(T const & item)
+	{
+		s64 index 		= count++;
+		memory[index] 	= item;
+
+		s64 handle = 0;
+		while (indirectionTable[handle] >= 0)
+		{
+			handle += 1;
+		}
+
+		indirectionTable[handle] = index;
+		return handle;
+	}
+
+	void remove(s64 handle)
+	{
+		s64 index 	= indirectionTable[handle];
+		s64 last 	= count - 1;
+
+		for (s64 i = 0; i < capacity; ++i)
+		{
+			if (indirectionTable[i] == last)
+			{
+				indirectionTable[i] = index;
+				break;
+			}
+		}
+
+		memory[index] 				= memory[last];
+		indirectionTable[handle] 	= -1;
+		count 						-= 1;
+	}
+};
+
+internal void fsheadless_benchmark_mapped_array()
+{
+	HeadlessBenchmarkMemory memory;
+	fsheadless_benchmark_memory(memory, gigabytes(1));
+
+	struct Item
+	{
+		v3 	position;
+		v3 	velocity;
+		f32 age;
+		s32 id;
+	};
+
+	constexpr s32 round_count 			= 100;
+	constexpr f32 churn_per_round 		= 0.01f;
+	constexpr s32 linear_churn_count 	= 1000;
+
+	s32 sizes [] = {10000, 100000, 1000000};
+
+	for (s32 size : sizes)
+	{
+		MemoryCheckpoint checkpoint = memory_push_checkpoint(memory.persistent);
+
+		RandomState random 	= random_state_from_seed(size);
+		s32 nextId 			= 0;
+
+		MappedArray<Item> array = push_mapped_array<Item>(memory.persistent, size);
+
+		// Note(Leo): Each handle that was ever pushed, and id of its item, to see that handles find right items and stale ones nothing
+		s32 handleRecordCapacity 	= size + (s32)(size * churn_per_round) * round_count;
+		s64 * handleRecords 		= push_memory<s64>(memory.persistent, handleRecordCapacity, ALLOC_GARBAGE);
+		s32 * handleRecordIds 		= push_memory<s32>(memory.persistent, handleRecordCapacity, ALLOC_GARBAGE);
+		bool8 * handleRecordAlive 	= push_memory<bool8>(memory.persistent, handleRecordCapacity, ALLOC_GARBAGE);
+		s32 handleRecordCount 		= 0;
+
+		auto make_item = [&]() -> Item
+		{
+			return {{random_range(random, 0, 100), random_range(random, 0, 100), 0}, {random_range(random, -1, 1), random_range(random, -1, 1), 0}, 0, nextId++};
+		};
+
+		s64 fillStart = platform_time_now();
+		for (s32 i = 0; i < size; ++i)
+		{
+			Item item 									= make_item();
+			handleRecords[handleRecordCount] 			= array.push(item);
+			handleRecordIds[handleRecordCount] 			= item.id;
+			handleRecordAlive[handleRecordCount++] 		= true;
+		}
+		f64 fillSeconds = platform_time_elapsed_seconds(fillStart, platform_time_now());
+
+		/// CHURN
+		s32 churnCount 			= (s32)(size * churn_per_round);
+		f64 removeSeconds 		= 0;
+		f64 insertSeconds 		= 0;
+		f64 iterateSeconds 		= 0;
+		f64 lookupSeconds 		= 0;
+		f64 checkSum 			= 0;
+
+		s32 * removedIds = push_memory<s32>(memory.persistent, churnCount, ALLOC_GARBAGE);
+
+		for (s32 round = 0; round < round_count; ++round)
+		{
+			s64 removeStart = platform_time_now();
+			for (s32 i = 0; i < churnCount; ++i)
+			{
+				s64 index 		= s32_min((s32)(random_value(random) * array.count), array.count - 1);
+				removedIds[i] 	= array.memory[index].id;
+				array.remove(array.handles[index]);
+			}
+			removeSeconds += platform_time_elapsed_seconds(removeStart, platform_time_now());
+
+			s64 insertStart = platform_time_now();
+			for (s32 i = 0; i < churnCount; ++i)
+			{
+				Item item 									= make_item();
+				handleRecords[handleRecordCount] 			= array.push(item);
+				handleRecordIds[handleRecordCount] 			= item.id;
+				handleRecordAlive[handleRecordCount++] 		= true;
+			}
+			insertSeconds += platform_time_elapsed_seconds(insertStart, platform_time_now());
+
+			// Note(Leo): Ids are given in order, so removed ids can be found from records by binary search
+			for (s32 i = 0; i < churnCount; ++i)
+			{
+				s32 low = 0, high = handleRecordCount - 1;
+				while (low < high)
+				{
+					s32 middle = (low + high) / 2;
+					if (handleRecordIds[middle] < removedIds[i]) { low = middle + 1; } else { high = middle; }
+				}
+				handleRecordAlive[low] = false;
+			}
+
+			s64 iterateStart = platform_time_now();
+			for (Item & item : array)
+			{
+				item.position 	+= item.velocity * 0.01f;
+				item.age 		+= 0.01f;
+			}
+			iterateSeconds += platform_time_elapsed_seconds(iterateStart, platform_time_now());
+
+			/*
+			Note(Leo): Same update through handles, like when handles are stored somewhere else. Handles are
+			live ones in scattered order, since operator[] asserts on removed ones. Those are checked below.
+			*/
+			s64 lookupStart = platform_time_now();
+			for (s64 i = 0; i < array.count; ++i)
+			{
+				Item & item = array[array.handles[(i * 7919) % array.count]];
+				checkSum 	+= item.age;
+			}
+			lookupSeconds += platform_time_elapsed_seconds(lookupStart, platform_time_now());
+		}
+
+		s32 staleCount 		= 0;
+		s32 mismatchCount 	= 0;
+		for (s32 i = 0; i < handleRecordCount; ++i)
+		{
+			Item * item = array.get(handleRecords[i]);
+			if (handleRecordAlive[i])
+			{
+				mismatchCount += (item == nullptr || item->id != handleRecordIds[i]) ? 1 : 0;
+			}
+			else
+			{
+				staleCount 		+= 1;
+				mismatchCount 	+= item != nullptr ? 1 : 0;
+			}
+		}
+
+		/// LINEAR
+		FsheadlessLinearMappedArray<Item> linear 	= {};
+		linear.capacity 							= size;
+		linear.memory 								= push_memory<Item>(memory.persistent, size, ALLOC_GARBAGE);
+		linear.indirectionTable 					= push_memory<s64>(memory.persistent, size, ALLOC_GARBAGE);
+		s64 * linearHandles 						= push_memory<s64>(memory.persistent, size, ALLOC_GARBAGE);
+
+		// Note(Leo): Pushing to empty array gives handles in order, but searching them would take ages here, so this fills it directly
+		for (s32 i = 0; i < size; ++i)
+		{
+			linear.memory[i] 			= make_item();
+			linear.indirectionTable[i] 	= i;
+			linearHandles[i] 			= i;
+		}
+		linear.count = size;
+
+		// Note(Leo): This is slow, so it is measured with fewer operations at random places in array
+		s64 linearStart = platform_time_now();
+		for (s32 i = 0; i < linear_churn_count; ++i)
+		{
+			s32 handleIndex = s32_min((s32)(random_value(random) * size), size - 1);
+			linear.remove(linearHandles[handleIndex]);
+			linearHandles[handleIndex] = linear.push(make_item());
+		}
+		f64 linearSeconds = platform_time_elapsed_seconds(linearStart, platform_time_now());
+
+		f64 slotMapOperationNanoseconds = (removeSeconds + insertSeconds) / (2.0 * churnCount * round_count) * 1e9;
+		f64 linearOperationNanoseconds 	= linearSeconds / (2.0 * linear_churn_count) * 1e9;
+
+		log_application(0, "Mapped array, ", size, " items, ", round_count, " rounds of ", churnCount, " removes and inserts, fill ", (f32)(fillSeconds * 1000), " ms, checksum ", (f32)checkSum);
+		log_application(0, "	slot map: remove ", (f32)(removeSeconds * 1e9 / (churnCount * round_count)), " ns, insert ", (f32)(insertSeconds * 1e9 / (churnCount * round_count)),
+							" ns, iterate ", (f32)(iterateSeconds * 1e9 / ((f64)size * round_count)), " ns/item, through handles ", (f32)(lookupSeconds * 1e9 / ((f64)size * round_count)), " ns/item");
+		log_application(0, "	linear free handle search: ", (f32)linearOperationNanoseconds, " ns per remove or insert, ", (f32)(linearOperationNanoseconds / slotMapOperationNanoseconds), "x slower");
+		log_application(0, "	", handleRecordCount, " handles, ", staleCount, " stale, ", mismatchCount, " mismatching");
+
+		memory_pop_checkpoint(memory.persistent, checkpoint);
+	}
+}
+
+/// ---------- HASH MAP --------------------------
+
+// Note(Leo): Puts all keys to only 4 places, so that probe sequences are long and wrap around table end
+struct FsheadlessCollidingHash
+{
+	static u64 hash(u64 const & key) 					{ return (key & 3) * 5; }
+	static bool32 equals(u64 const & a, u64 const & b) 	{ return a == b; }
+};
+
+/*
+Note(Leo): Map as it was before it was hash map did not find anything by key, so keys were searched
+from arrays of pairs like this.
+*/
+struct FsheadlessLinearMap
+{
+	s64 	count;
+	u64 * 	keys;
+	s32 * 	values;
+
+	s32 * get(u64 key)
+	{
+		for (s64 i = 0; i < count; ++i)
+		{
+			if (keys[i] == key)
+			{
+				return &values[i];
+			}
+		}
+		return nullptr;
+	}
+};
+
+// Note(Leo): Returns number of keys in 'keys' whose value differs between maps, and one for different count
+template<typename THash>
+internal s32 fsheadless_compare_maps(Map<u64, s32, THash> & map, std::unordered_map<u64, s32> const & reference, u64 const * keys, s32 keyCount)
+{
+	s32 mismatchCount = map.count == (s64)reference.size() ? 0 : 1;
+
+	for (s32 i = 0; i < keyCount; ++i)
+	{
+		s32 * value = map_get(map, keys[i]);
+		auto found 	= reference.find(keys[i]);
+
+		if (found == reference.end())
+		{
+			mismatchCount += value != nullptr ? 1 : 0;
+		}
+		else
+		{
+			mismatchCount += (value == nullptr || *value != found->second) ? 1 : 0;
+		}
+	}
+
+	return mismatchCount;
+}
+
+internal void fsheadless_benchmark_hash_map()
+{
+	HeadlessBenchmarkMemory memory;
+	fsheadless_benchmark_memory(memory, gigabytes(1));
+
+	/// CORRECTNESS
+	{
+		/*
+		Note(Leo): Random inserts and removes to small maps, checked against std::unordered_map after each
+		operation. Colliding hash makes long chains for backward shift to move, and growing starts from
+		smallest table.
+		*/
+		constexpr s32 operation_count 	= 20000;
+		constexpr s32 key_range 		= 64;
+
+		MemoryCheckpoint checkpoint = memory_push_checkpoint(memory.persistent);
+
+		RandomState random = random_state_from_seed(1);
+
+		u64 keys [key_range];
+		for (s32 i = 0; i < key_range; ++i)
+		{
+			keys[i] = i * 7 + 1;
+		}
+
+		Map<u64, s32> map 									= push_map<u64, s32>(memory.persistent, 0);
+		Map<u64, s32, FsheadlessCollidingHash> collidingMap = push_map<u64, s32, FsheadlessCollidingHash>(memory.persistent, 0);
+		std::unordered_map<u64, s32> reference;
+
+		s32 mismatchCount = 0;
+		for (s32 i = 0; i < operation_count; ++i)
+		{
+			u64 key = keys[xor128(random) % key_range];
+
+			if (xor128(random) % 3 == 0)
+			{
+				bool32 removed 			= map_remove(map, key);
+				bool32 collidingRemoved = map_remove(collidingMap, key);
+				bool32 referenceRemoved = reference.erase(key) > 0;
+
+				mismatchCount += (removed != referenceRemoved || collidingRemoved != referenceRemoved) ? 1 : 0;
+			}
+			else
+			{
+				map_insert(map, key, i);
+				map_insert(collidingMap, key, i);
+				reference[key] = i;
+			}
+
+			mismatchCount += fsheadless_compare_maps(map, reference, keys, key_range);
+			mismatchCount += fsheadless_compare_maps(collidingMap, reference, keys, key_range);
+		}
+
+		map_clear(map);
+		reference.clear();
+		mismatchCount += fsheadless_compare_maps(map, reference, keys, key_range);
+
+		log_application(0, "Hash map correctness, ", operation_count, " random inserts and removes of ", key_range, " keys, also with colliding hash, ", mismatchCount, " mismatches");
+
+		memory_pop_checkpoint(memory.persistent, checkpoint);
+	}
+
+	/// SPEED
+	constexpr s32 linear_lookup_count 	= 1000;
+	constexpr s32 linear_max_size 		= 100000;
+
+	s32 sizes [] = {1000, 10000, 100000, 1000000};
+
+	for (s32 size : sizes)
+	{
+		MemoryCheckpoint checkpoint = memory_push_checkpoint(memory.persistent);
+
+		RandomState random = random_state_from_seed(size);
+
+		// Note(Leo): First half of keys are inserted, and second half are used for misses and churn
+		u64 * keys = push_memory<u64>(memory.persistent, 2 * size, ALLOC_GARBAGE);
+		for (s32 i = 0; i < 2 * size; ++i)
+		{
+			keys[i] = ((u64)xor128(random) << 32) | xor128(random);
+		}
+
+		u64 checkSum 		= 0;
+		u64 referenceSum 	= 0;
+
+		/// HASH MAP
+		// Note(Leo): Starts from smallest table, so that growing is measured too
+		Map<u64, s32> map = push_map<u64, s32>(memory.persistent, 0);
+
+		s64 insertStart = platform_time_now();
+		for (s32 i = 0; i < size; ++i)
+		{
+			map_insert(map, keys[i], i);
+		}
+		f64 insertSeconds = platform_time_elapsed_seconds(insertStart, platform_time_now());
+
+		s64 hitStart = platform_time_now();
+		for (s32 i = 0; i < size; ++i)
+		{
+			checkSum += *map_get(map, keys[i]);
+		}
+		f64 hitSeconds = platform_time_elapsed_seconds(hitStart, platform_time_now());
+
+		s64 missStart = platform_time_now();
+		for (s32 i = size; i < 2 * size; ++i)
+		{
+			checkSum += map_get(map, keys[i]) != nullptr ? 1 : 0;
+		}
+		f64 missSeconds = platform_time_elapsed_seconds(missStart, platform_time_now());
+
+		// Note(Leo): Each round removes one old key and inserts one new, so there is always same amount of keys
+		s64 churnStart = platform_time_now();
+		for (s32 i = 0; i < size; ++i)
+		{
+			map_remove(map, keys[i]);
+			map_insert(map, keys[size + i], i);
+		}
+		f64 churnSeconds = platform_time_elapsed_seconds(churnStart, platform_time_now());
+
+		s64 iterateStart = platform_time_now();
+		map_for_each(map, [&checkSum](u64 const &, s32 & value) { checkSum += value; });
+		f64 iterateSeconds = platform_time_elapsed_seconds(iterateStart, platform_time_now());
+
+		/// UNORDERED MAP
+		std::unordered_map<u64, s32> reference;
+
+		s64 referenceInsertStart = platform_time_now();
+		for (s32 i = 0; i < size; ++i)
+		{
+			reference[keys[i]] = i;
+		}
+		f64 referenceInsertSeconds = platform_time_elapsed_seconds(referenceInsertStart, platform_time_now());
+
+		// Note(Leo): Verify before churn, while both have first half of keys
+		s32 mismatchCount = 0;
+		{
+			Map<u64, s32> verifyMap = push_map<u64, s32>(memory.persistent, size);
+			for (s32 i = 0; i < size; ++i)
+			{
+				map_insert(verifyMap, keys[i], i);
+			}
+			mismatchCount += fsheadless_compare_maps(verifyMap, reference, keys, 2 * size);
+		}
+
+		s64 referenceHitStart = platform_time_now();
+		for (s32 i = 0; i < size; ++i)
+		{
+			referenceSum += reference.find(keys[i])->second;
+		}
+		f64 referenceHitSeconds = platform_time_elapsed_seconds(referenceHitStart, platform_time_now());
+
+		s64 referenceMissStart = platform_time_now();
+		for (s32 i = size; i < 2 * size; ++i)
+		{
+			referenceSum += reference.find(keys[i]) != reference.end() ? 1 : 0;
+		}
+		f64 referenceMissSeconds = platform_time_elapsed_seconds(referenceMissStart, platform_time_now());
+
+		s64 referenceChurnStart = platform_time_now();
+		for (s32 i = 0; i < size; ++i)
+		{
+			reference.erase(keys[i]);
+			reference[keys[size + i]] = i;
+		}
+		f64 referenceChurnSeconds = platform_time_elapsed_seconds(referenceChurnStart, platform_time_now());
+
+		s64 referenceIterateStart = platform_time_now();
+		for (auto const & pair : reference)
+		{
+			referenceSum += pair.second;
+		}
+		f64 referenceIterateSeconds = platform_time_elapsed_seconds(referenceIterateStart, platform_time_now());
+
+		mismatchCount += fsheadless_compare_maps(map, reference, keys, 2 * size);
+		mismatchCount += checkSum != referenceSum ? 1 : 0;
+
+		/// LINEAR
+		f64 linearHitNanoseconds = 0;
+		if (size <= linear_max_size)
+		{
+			FsheadlessLinearMap linear 	= {};
+			linear.keys 				= push_memory<u64>(memory.persistent, size, ALLOC_GARBAGE);
+			linear.values 				= push_memory<s32>(memory.persistent, size, ALLOC_GARBAGE);
+
+			for (s32 i = 0; i < size; ++i)
+			{
+				linear.keys[i] 		= keys[i];
+				linear.values[i] 	= i;
+			}
+			linear.count = size;
+
+			u64 linearSum 	= 0;
+			s64 linearStart = platform_time_now();
+			for (s32 i = 0; i < linear_lookup_count; ++i)
+			{
+				linearSum += *linear.get(keys[xor128(random) % size]);
+			}
+			linearHitNanoseconds = platform_time_elapsed_seconds(linearStart, platform_time_now()) * 1e9 / linear_lookup_count;
+
+			// Note(Leo): Printed, so that compiler cannot skip loop
+			log_application(0, "Hash map, linear search checksum ", linearSum);
+		}
+
+		auto ns = [size](f64 seconds) { return (f32)(seconds * 1e9 / size); };
+
+		log_application(0, "Hash map, ", size, " u64 keys, table capacity ", map.capacity, ", ", mismatchCount, " mismatches with std::unordered_map");
+		log_application(0, "	robin hood: insert ", ns(insertSeconds), " ns, hit ", ns(hitSeconds), " ns, miss ", ns(missSeconds), " ns, remove and insert ",
+							ns(churnSeconds), " ns, iterate ", ns(iterateSeconds), " ns/item");
+		log_application(0, "	std::unordered_map: insert ", ns(referenceInsertSeconds), " ns, hit ", ns(referenceHitSeconds), " ns, miss ", ns(referenceMissSeconds),
+							" ns, remove and insert ", ns(referenceChurnSeconds), " ns, iterate ", ns(referenceIterateSeconds), " ns/item");
+		if (size <= linear_max_size)
+		{
+			log_application(0, "	linear key search: hit ", (f32)linearHitNanoseconds, " ns, ", (f32)(linearHitNanoseconds / (hitSeconds * 1e9 / size)), "x slower than robin hood");
+		}
+
+		memory_pop_checkpoint(memory.persistent, checkpoint);
+	}
+}
+
+/// ---------- STRUCTURE OF ARRAYS --------------------------
+
+// Note(Leo): Waters as they were before SoA, with separate array for each field
+struct FsheadlessParallelArrayWaters
+{
+	s32 			capacity;
+	s32 			count;
+
+	v3 * 			positions;
+	quaternion * 	rotations;
+	f32	* 			levels;
+
+	SpatialHashGrid grid;
+
+	f32 evaporateLevelPerSecond = 0.05;
+};
+
+internal void fsheadless_parallel_array_waters_remove(FsheadlessParallelArrayWaters & waters, s32 index)
+{
+	s32 lastIndex = waters.count - 1;
+
+	waters.positions[index] = waters.positions[lastIndex];
+	waters.rotations[index] = waters.rotations[lastIndex];
+	waters.levels[index] 	= waters.levels[lastIndex];
+
+	spatial_hash_grid_remove(waters.grid, index);
+	spatial_hash_grid_move_index(waters.grid, lastIndex, index);
+
+	waters.count -= 1;
+}
+
+internal void fsheadless_parallel_array_update_waters(FsheadlessParallelArrayWaters & waters, f32 elapsedTime)
+{
+	for (s32 i = 0; i < waters.count; ++i)
+	{
+		waters.levels[i] -= waters.evaporateLevelPerSecond * elapsedTime;
+
+		if (waters.levels[i] < 0)
+		{
+			fsheadless_parallel_array_waters_remove(waters, i);
+			i -= 1;
+		}
+	}
+}
+
+// Note(Leo): Leaves as they were before SoA
+struct FsheadlessParallelArrayLeaves
+{
+	s32 			capacity;
+	s32 			count;
+
+	v3 				position;
+	quaternion 		rotation;
+
+	v3 * 			localPositions;
+	quaternion * 	localRotations;
+	f32 * 			localScales;
+
+	f32 * 			swayPositions;
+	v3 * 			swayAxes;
+
+	m44 * transientRenderTransforms;
+};
+
+internal void fsheadless_parallel_array_leaves_update(FsheadlessParallelArrayLeaves & leaves, MemoryArena & allocator, f32 elapsedTime, v2 leafScale = {1,1})
+{
+	s32 drawCount = f32_min(leaves.capacity, leaves.count);
+	m44 * leafTransforms = push_memory<m44>(allocator, drawCount, ALLOC_GARBAGE);
+	for (s32 i = 0; i < drawCount; ++i)
+	{
+		v3 position 			= leaves.position + quaternion_rotate_v3(leaves.rotation, leaves.localPositions[i]);
+
+		constexpr f32 swayRange = 0.5;
+		leaves.swayPositions[i] = mod_f32(leaves.swayPositions[i] + elapsedTime, swayRange * 4);
+		f32 sway 				= mathfun_pingpong_f32(leaves.swayPositions[i], swayRange * 2) - swayRange;
+		quaternion rotation 	= quaternion_axis_angle(leaves.swayAxes[i], sway);
+		rotation 				= leaves.localRotations[i] * leaves.rotation * rotation;
+
+		v3 scale 	= make_uniform_v3(leaves.localScales[i]);
+		scale.x 	*= leafScale.x;
+		scale.y 	*= leafScale.y;
+
+		leafTransforms[i] 		= transform_matrix(	position, rotation,	scale);
+	}
+	leaves.transientRenderTransforms = leafTransforms;
+}
+
+internal void fsheadless_benchmark_soa()
+{
+	HeadlessBenchmarkMemory memory;
+	fsheadless_benchmark_memory(memory, gigabytes(2));
+
+	/// WATERS
+	{
+		constexpr s32 water_count 	= 100'000;
+		constexpr s32 frame_count 	= 600;
+		constexpr f32 elapsed_time 	= 1.0f / 60;
+		constexpr f32 world_size 	= 1000;
+
+		RandomState random = random_state_from_seed(water_count);
+
+		Waters waters;
+		initialize_waters(waters, memory.persistent);
+
+		FsheadlessParallelArrayWaters oldWaters = {};
+		oldWaters.capacity 						= water_count;
+		oldWaters.positions 					= push_memory<v3>(memory.persistent, water_count, ALLOC_GARBAGE);
+		oldWaters.rotations 					= push_memory<quaternion>(memory.persistent, water_count, ALLOC_GARBAGE);
+		oldWaters.levels 						= push_memory<f32>(memory.persistent, water_count, ALLOC_GARBAGE);
+		oldWaters.grid 							= make_spatial_hash_grid(memory.persistent, water_count, 2);
+
+		// Note(Leo): Levels are such that about half of waters dry during benchmark
+		for (s32 i = 0; i < water_count; ++i)
+		{
+			v3 position = {random_range(random, 0, world_size), random_range(random, 0, world_size), 0};
+			f32 level 	= random_range(random, 0, 2 * waters.evaporateLevelPerSecond * frame_count * elapsed_time);
+
+			waters_instantiate(waters, position, level);
+
+			s32 index 						= oldWaters.count++;
+			oldWaters.positions[index] 		= position;
+			oldWaters.rotations[index] 		= quaternion_identity;
+			oldWaters.levels[index] 		= level;
+			spatial_hash_grid_move(oldWaters.grid, index, position.xy);
+		}
+
+		f64 oldSeconds = 0;
+		f64 soaSeconds = 0;
+
+		for (s32 frame = 0; frame < frame_count; ++frame)
+		{
+			s64 oldStart = platform_time_now();
+			fsheadless_parallel_array_update_waters(oldWaters, elapsed_time);
+			oldSeconds += platform_time_elapsed_seconds(oldStart, platform_time_now());
+
+			s64 soaStart = platform_time_now();
+			update_waters(waters, elapsed_time);
+			soaSeconds += platform_time_elapsed_seconds(soaStart, platform_time_now());
+		}
+
+		// Note(Leo): Both remove same waters in same order, so all rows should be same
+		s32 mismatchCount = oldWaters.count != waters.data.count ? 1 : 0;
+		for (s32 i = 0; i < s32_min(oldWaters.count, waters.data.count); ++i)
+		{
+			bool32 same = memory_equals(&oldWaters.positions[i], &waters.positions()[i], sizeof(v3))
+						&& memory_equals(&oldWaters.rotations[i], &waters.rotations()[i], sizeof(quaternion))
+						&& oldWaters.levels[i] == waters.levels()[i];
+			mismatchCount += same ? 0 : 1;
+		}
+
+		log_application(0, "SoA waters, ", water_count, " waters, ", frame_count, " frames, ", waters.data.count, " left, ", mismatchCount, " mismatching");
+		log_application(0, "	update_waters: parallel arrays ", (f32)(oldSeconds * 1e6 / frame_count), " us/frame, SoA ", (f32)(soaSeconds * 1e6 / frame_count),
+							" us/frame, ", (f32)(oldSeconds / soaSeconds), "x");
+	}
+
+	/// LEAVES
+	{
+		constexpr s32 tree_count 			= 200;
+		constexpr s32 leaf_count_per_tree 	= 3000;
+		constexpr s32 frame_count 			= 30;
+		constexpr f32 elapsed_time 			= 1.0f / 60;
+
+		RandomState random 	= random_state_from_seed(tree_count);
+		MemoryPool pool 	= memory_pool(memory.persistent, megabytes(512));
+
+		Leaves * leaves 							= push_memory<Leaves>(memory.persistent, tree_count, ALLOC_ZERO_MEMORY);
+		FsheadlessParallelArrayLeaves * oldLeaves 	= push_memory<FsheadlessParallelArrayLeaves>(memory.persistent, tree_count, ALLOC_ZERO_MEMORY);
+
+		for (s32 t = 0; t < tree_count; ++t)
+		{
+			v3 treePosition 			= {random_range(random, -100, 100), random_range(random, -100, 100), 0};
+			quaternion treeRotation 	= quaternion_axis_angle(v3_up, random_range(random, 0, 2 * π));
+
+			// Note(Leo): Grown a few leaves at a time, like trees grow them
+			leaves[t].position 	= treePosition;
+			leaves[t].rotation 	= treeRotation;
+			for (s32 l = 0; l < leaf_count_per_tree; l += 3)
+			{
+				leaves_reserve(pool, leaves[t], leaves[t].data.count + 3);
+				leaves[t].data.append(3);
+			}
+
+			FsheadlessParallelArrayLeaves & old = oldLeaves[t];
+			old.capacity 		= leaves[t].data.capacity;
+			old.count 			= leaves[t].data.count;
+			old.position 		= treePosition;
+			old.rotation 		= treeRotation;
+			old.localPositions 	= push_memory<v3>(memory.persistent, old.capacity, ALLOC_GARBAGE);
+			old.localRotations 	= push_memory<quaternion>(memory.persistent, old.capacity, ALLOC_GARBAGE);
+			old.localScales 	= push_memory<f32>(memory.persistent, old.capacity, ALLOC_GARBAGE);
+			old.swayPositions 	= push_memory<f32>(memory.persistent, old.capacity, ALLOC_GARBAGE);
+			old.swayAxes 		= push_memory<v3>(memory.persistent, old.capacity, ALLOC_GARBAGE);
+
+			for (s32 l = 0; l < leaf_count_per_tree; ++l)
+			{
+				v3 localPosition 			= {random_range(random, -3, 3), random_range(random, -3, 3), random_range(random, 0, 10)};
+				quaternion localRotation 	= quaternion_axis_angle(v3_up, random_range(random, 0, 2 * π));
+				f32 localScale 				= random_range(random, 0.1, 0.3);
+				f32 swayPosition 			= random_range(random, 0, 2);
+				v3 swayAxis 				= quaternion_rotate_v3(localRotation, v3_forward);
+
+				leaves[t].data.set(l, localPosition, localRotation, localScale, swayPosition, swayAxis);
+
+				old.localPositions[l] 	= localPosition;
+				old.localRotations[l] 	= localRotation;
+				old.localScales[l] 		= localScale;
+				old.swayPositions[l] 	= swayPosition;
+				old.swayAxes[l] 		= swayAxis;
+			}
+		}
+
+		f64 oldSeconds 		= 0;
+		f64 soaSeconds 		= 0;
+		s32 mismatchCount 	= 0;
+
+		for (s32 frame = 0; frame < frame_count; ++frame)
+		{
+			MemoryCheckpoint checkpoint = memory_push_checkpoint(memory.transient);
+
+			s64 oldStart = platform_time_now();
+			for (s32 t = 0; t < tree_count; ++t)
+			{
+				fsheadless_parallel_array_leaves_update(oldLeaves[t], memory.transient, elapsed_time);
+			}
+			oldSeconds += platform_time_elapsed_seconds(oldStart, platform_time_now());
+
+			s64 soaStart = platform_time_now();
+			for (s32 t = 0; t < tree_count; ++t)
+			{
+				leaves_update(leaves[t], memory.transient, elapsed_time);
+			}
+			soaSeconds += platform_time_elapsed_seconds(soaStart, platform_time_now());
+
+			for (s32 t = 0; t < tree_count; ++t)
+			{
+				bool32 same = memory_equals(oldLeaves[t].transientRenderTransforms, leaves[t].transientRenderTransforms, leaf_count_per_tree * sizeof(m44));
+				mismatchCount += same ? 0 : 1;
+			}
+
+			memory_pop_checkpoint(memory.transient, checkpoint);
+		}
+
+		s64 leafUpdateCount = (s64)tree_count * leaf_count_per_tree * frame_count;
+
+		log_application(0, "SoA leaves, ", tree_count, " trees of ", leaf_count_per_tree, " leaves, ", frame_count, " frames, memory pool ",
+							(f32)(pool.used / 1024.0 / 1024.0), " mb, ", mismatchCount, " mismatching trees");
+		log_application(0, "	leaves_update: parallel arrays ", (f32)(oldSeconds * 1e9 / leafUpdateCount), " ns/leaf, SoA ", (f32)(soaSeconds * 1e9 / leafUpdateCount),
+							" ns/leaf, ", (f32)(oldSeconds / soaSeconds), "x");
+	}
+}
+
+/// ---------- VIRTUAL ARENA --------------------------
+
+internal void fsheadless_benchmark_virtual_arena()
+{
+	constexpr u64 reserved_size 		= gigabytes(64);
+	constexpr u64 commit_step 			= megabytes(4);
+	constexpr u64 fill_size 			= megabytes(512);
+	constexpr s32 allocation_size 		= 4096;
+	constexpr s32 allocation_count 		= fill_size / allocation_size;
+	constexpr s32 round_count 			= 5;
+
+	// Note(Leo): 'fixed' commits all it needs with its first step, like arenas before virtual ones
+	MemoryArena fixed 		= memory_arena_virtual(fill_size + megabytes(4), fill_size + megabytes(4), false);
+	MemoryArena grow 		= memory_arena_virtual(reserved_size, commit_step, false);
+	MemoryArena decommit 	= memory_arena_virtual(reserved_size, commit_step, true);
+
+	log_application(0, "Virtual arena, ", (f32)reverse_gigabytes(reserved_size), " GB reserved, commit step ", (f32)reverse_megabytes(commit_step),
+						" MB, ", round_count, " rounds of filling ", (f32)reverse_megabytes(fill_size), " MB in ", allocation_size, " byte pushes");
+	log_application(0, "	after reserve: committed ", (f32)reverse_megabytes(grow.committed), " MB of ", (f32)reverse_megabytes(grow.size), " MB");
+
+	/*
+	Note(Leo): Writes first byte of each push, like real use touches memory. Memory that was committed
+	after 'zeroedFrom' should be zeroed, either because it is fresh or because it was decommitted.
+	*/
+	auto fill = [](MemoryArena & arena, u64 zeroedFrom, s32 & nonZeroCount) -> f64
+	{
+		s64 start = platform_time_now();
+		for (s32 i = 0; i < allocation_count; ++i)
+		{
+			u8 * memory 	= push_memory<u8>(arena, allocation_size, ALLOC_GARBAGE);
+			nonZeroCount 	+= (memory - arena.memory >= zeroedFrom && memory[0] != 0) ? 1 : 0;
+			memory[0] 		= 1;
+		}
+		return platform_time_elapsed_seconds(start, platform_time_now());
+	};
+
+	auto flush = [](MemoryArena & arena) -> f64
+	{
+		s64 start = platform_time_now();
+		flush_memory_arena(&arena);
+		return platform_time_elapsed_seconds(start, platform_time_now());
+	};
+
+	f64 fixedSeconds [round_count];
+	f64 growSeconds [round_count];
+	f64 decommitSeconds [round_count];
+	f64 decommitFlushSeconds = 0;
+
+	u64 growCommitted 		= 0;
+	u64 decommitCommitted 	= 0;
+	s32 nonZeroCount 		= 0;
+
+	for (s32 round = 0; round < round_count; ++round)
+	{
+		// Note(Leo): Flushing keeps first commit step, and arenas that do not decommit keep everything
+		u64 zeroedFrom = round == 0 ? 0 : std::numeric_limits<u64>::max();
+
+		fixedSeconds[round] 	= fill(fixed, zeroedFrom, nonZeroCount);
+		growSeconds[round] 		= fill(grow, zeroedFrom, nonZeroCount);
+		decommitSeconds[round] 	= fill(decommit, round == 0 ? 0 : commit_step, nonZeroCount);
+
+		growCommitted 		= grow.committed;
+		decommitCommitted 	= decommit.committed;
+
+		flush(fixed);
+		flush(grow);
+		decommitFlushSeconds += flush(decommit);
+	}
+
+	auto ms = [](f64 seconds) { return (f32)(seconds * 1000); };
+
+	log_application(0, "	after fill: committed ", (f32)reverse_megabytes(growCommitted), " MB, with decommit on flush ", (f32)reverse_megabytes(decommitCommitted),
+						" MB, and after flush ", (f32)reverse_megabytes(decommit.committed), " MB");
+	log_application(0, "	fill, first round: committed up front ", ms(fixedSeconds[0]), " ms, commit on demand ", ms(growSeconds[0]),
+						" ms, with decommit on flush ", ms(decommitSeconds[0]), " ms");
+	log_application(0, "	fill, last round: committed up front ", ms(fixedSeconds[round_count - 1]), " ms, commit on demand ", ms(growSeconds[round_count - 1]),
+						" ms, with decommit on flush ", ms(decommitSeconds[round_count - 1]), " ms, decommit ", ms(decommitFlushSeconds / round_count), " ms/flush");
+	log_application(0, "	", nonZeroCount, " pushes were not zeroed in fresh or decommitted memory");
+
+	memory_arena_virtual_release(fixed);
+	memory_arena_virtual_release(grow);
+	memory_arena_virtual_release(decommit);
+}
+
+/// ---------- ARENA INSTRUMENTATION --------------------------
+
+struct alignas(32) FsheadlessWideItem
+{
+	f32 values [8];
+};
+
+/*
+Note(Leo): Pushes from four callsites with sizes like game's pushes: small odd sized arrays, vectors,
+matrices and items that need 32 byte alignment. Sizes are from same seed on each call, so instrumented
+and plain arenas get same pushes.
+*/
+internal f64 fsheadless_arena_instrumentation_fill(MemoryArena & arena, s32 allocationCount)
+{
+	RandomState random = random_state_from_seed(allocationCount);
+
+	s64 start = platform_time_now();
+	for (s32 i = 0; i < allocationCount; ++i)
+	{
+		s32 count = (s32)random_range(random, 1, 64);
+		switch (i & 3)
+		{
+			case 0: push_memory<u8>(arena, count, ALLOC_GARBAGE); break;
+			case 1: push_memory<v3>(arena, count, ALLOC_GARBAGE); break;
+			case 2: push_memory<m44>(arena, 1, ALLOC_GARBAGE); break;
+			case 3: push_memory<FsheadlessWideItem>(arena, count / 8 + 1, ALLOC_GARBAGE); break;
+		}
+	}
+	return platform_time_elapsed_seconds(start, platform_time_now());
+}
+
+internal void fsheadless_benchmark_arena_instrumentation()
+{
+	constexpr s32 allocation_count 	= 1'000'000;
+	constexpr s32 round_count 		= 5;
+
+	HeadlessBenchmarkMemory memory;
+	fsheadless_benchmark_memory(memory, gigabytes(2));
+
+	log_application(0, "Arena instrumentation, ", round_count, " rounds of ", allocation_count, " pushes from 4 callsites");
+
+	MemoryArena & plain = memory.persistent;
+	f64 plainSeconds 	= 0;
+	for (s32 round = 0; round < round_count; ++round)
+	{
+		flush_memory_arena(&plain);
+		plainSeconds += fsheadless_arena_instrumentation_fill(plain, allocation_count);
+	}
+	u64 plainUsed = plain.used;
+
+	auto nsPerPush = [](f64 seconds) { return (f32)(seconds * 1'000'000'000 / (round_count * allocation_count)); };
+
+	#if defined FS_MEMORY_INSTRUMENTATION_ENABLED
+	{
+		MemoryArena & instrumented = memory.transient;
+
+		MemoryArenaInstrumentation * instrumentation = push_memory<MemoryArenaInstrumentation>(memory.persistent, 1, ALLOC_GARBAGE);
+		memory_instrumentation_attach(instrumented, *instrumentation, "benchmark");
+
+		f64 instrumentedSeconds = 0;
+		for (s32 round = 0; round < round_count; ++round)
+		{
+			memory_instrumentation_begin_arena_frame(instrumented);
+			flush_memory_arena(&instrumented);
+			instrumentedSeconds += fsheadless_arena_instrumentation_fill(instrumented, allocation_count);
+		}
+
+		// Note(Leo): All arena's space should be found from callsites, and from nowhere else
+		u64 callsiteBytes = 0;
+		for (MemoryCallsiteStats const & stats : instrumentation->callsites)
+		{
+			callsiteBytes += stats.bytes;
+		}
+
+		log_application(0, "	plain ", nsPerPush(plainSeconds), " ns/push, instrumented ", nsPerPush(instrumentedSeconds), " ns/push");
+		log_application(0, "	", instrumentation->callsiteCount, " callsites, their bytes ", callsiteBytes, ", total ", instrumentation->total.bytes,
+							", arena used ", instrumented.used, ", plain arena used ", plainUsed);
+
+		memory_instrumentation_log_report(instrumented);
+	}
+	#else
+	{
+		log_application(0, "	plain ", nsPerPush(plainSeconds), " ns/push, instrumentation is compiled out and MemoryCallsite is ", (s32)sizeof(MemoryCallsite), " byte");
+	}
+	#endif
+}
+
+/// ---------- RUN --------------------------
+
+// Note(Leo): Returns false if there is no benchmark with that name
+internal bool32 fsheadless_run_benchmark(char const * name)
+{
+	if (cstring_equals(name, "raycast"))
+	{
+		fsheadless_benchmark_raycast();
+		return true;
+	}
+
+	if (cstring_equals(name, "submitted"))
+	{
+		fsheadless_benchmark_submitted_colliders();
+		return true;
+	}
+
+	if (cstring_equals(name, "raybatch"))
+	{
+		fsheadless_benchmark_ray_batch();
+		return true;
+	}
+
+	if (cstring_equals(name, "terrain"))
+	{
+		fsheadless_benchmark_terrain();
+		return true;
+	}
+
+	if (cstring_equals(name, "sweep"))
+	{
+		fsheadless_benchmark_sweep();
+		return true;
+	}
+
+	if (cstring_equals(name, "entityindex"))
+	{
+		fsheadless_benchmark_entity_index();
+		return true;
+	}
+
+	if (cstring_equals(name, "waters"))
+	{
+		fsheadless_benchmark_waters();
+		return true;
+	}
+
+	if (cstring_equals(name, "trianglemesh"))
+	{
+		fsheadless_benchmark_triangle_mesh();
+		return true;
+	}
+
+	if (cstring_equals(name, "treecapsules"))
+	{
+		fsheadless_benchmark_tree_capsules();
+		return true;
+	}
+
+	if (cstring_equals(name, "mappedarray"))
+	{
+		fsheadless_benchmark_mapped_array();
+		return true;
+	}
+
+	if (cstring_equals(name, "hashmap"))
+	{
+		fsheadless_benchmark_hash_map();
+		return true;
+	}
+
+	if (cstring_equals(name, "soa"))
+	{
+		fsheadless_benchmark_soa();
+		return true;
+	}
+
+	if (cstring_equals(name, "virtualarena"))
+	{
+		fsheadless_benchmark_virtual_arena();
+		return true;
+	}
+
+	if (cstring_equals(name, "arenainstrumentation"))
+	{
+		fsheadless_benchmark_arena_instrumentation();
+		return true;
+	}
+
+	log_application(0, "Unknown benchmark '", name, "'");
+	return false;
+}
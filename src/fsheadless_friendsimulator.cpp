@@ -0,0 +1,521 @@
+/*
+Leo Tamminen
+
+Headless platform layer for Friendsimulator. There is no window, gpu or audio device, but
+everything in PlatformApiDescription is implemented with posix calls and null backends, so
+game_update can be run for a fixed number of frames with fixed timestep and measured on any
+plain cpu box.
+
+Game code is compiled in directly, like in win32 release build.
+
+Input can be recorded and replayed with fs_input_recording.cpp. Replay uses recorded input,
+elapsed time and random seed, so consecutive runs of same recording and build give same results.
+Report file has percentiles of frame cpu times, arena high-water marks and all frame times, and
+it can be given as baseline for a later run to compare against.
+
+Usage:
+	friendsimulator_headless 	[-frames <count>] [-dt <seconds>] [-seed <value>]
+								[-record <file>] [-replay <file>]
+								[-report <file>] [-baseline <report file>]
+								[-trace <frame count>] [-workers <count>]
+	friendsimulator_headless 	-benchmark <name>
+
+'-workers' sets job system worker thread count including main thread, default is one per processor.
+'-benchmark' runs a micro-benchmark from fsheadless_benchmarks.cpp instead of game.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sched.h>
+
+#if !defined FS_DEVELOPMENT && !defined FS_RELEASE
+	#error "FS_DEVELOPMENT or FS_RELEASE must be defined."
+#endif
+
+#include "fs_standard_types.h"
+#include "fs_standard_functions.h"
+
+#define FS_PLATFORM
+#include "fs_platform_interface.hpp"
+
+#include "fs_logging.cpp"
+#include "fs_profiler.cpp"
+
+#include "fsposix_platform_log.cpp"
+#include "fsposix_platform_time.cpp"
+#include "fsposix_platform_memory.cpp"
+#include "fsposix_platform_file.cpp"
+#include "fsposix_platform_thread.cpp"
+
+#include "fs_job_system.cpp"
+
+#include "fs_input_recording.cpp"
+
+#include "fsheadless_platform.cpp"
+#include "fsheadless_graphics.cpp"
+
+#include <ImGui/imgui.cpp>
+#include <ImGui/imgui_draw.cpp>
+#include <ImGui/imgui_widgets.cpp>
+#include <ImGui/imgui_demo.cpp>
+
+#include <ImGui/ImGuizmo.cpp>
+
+#include "friendsimulator.cpp"
+
+#include "fsheadless_benchmarks.cpp"
+
+struct HeadlessSettings
+{
+	s32 frameCount 		= 600;
+	f32 frameSeconds 	= 1.0f / 30;
+	u32 randomSeed 		= 0;
+
+	char const * recordFilename 	= nullptr;
+	char const * replayFilename 	= nullptr;
+	char const * reportFilename 	= nullptr;
+	char const * baselineFilename 	= nullptr;
+
+	s32 traceFrameCount 			= 0;
+	s32 workerCount 				= 0;
+
+	char const * benchmarkName 		= nullptr;
+};
+
+internal HeadlessSettings fsheadless_parse_arguments(int argc, char ** argv)
+{
+	HeadlessSettings settings = {};
+
+	for (s32 i = 1; i < argc; ++i)
+	{
+		bool32 hasValue = (i + 1) < argc;
+
+		if (hasValue && cstring_equals(argv[i], "-frames"))
+		{
+			settings.frameCount = atoi(argv[++i]);
+		}
+		else if (hasValue && cstring_equals(argv[i], "-dt"))
+		{
+			settings.frameSeconds = static_cast<f32>(atof(argv[++i]));
+		}
+		else if (hasValue && cstring_equals(argv[i], "-seed"))
+		{
+			settings.randomSeed = static_cast<u32>(strtoul(argv[++i], nullptr, 10));
+		}
+		else if (hasValue && cstring_equals(argv[i], "-record"))
+		{
+			settings.recordFilename = argv[++i];
+		}
+		else if (hasValue && cstring_equals(argv[i], "-replay"))
+		{
+			settings.replayFilename = argv[++i];
+		}
+		else if (hasValue && cstring_equals(argv[i], "-report"))
+		{
+			settings.reportFilename = argv[++i];
+		}
+		else if (hasValue && cstring_equals(argv[i], "-baseline"))
+		{
+			settings.baselineFilename = argv[++i];
+		}
+		else if (hasValue && cstring_equals(argv[i], "-trace"))
+		{
+			settings.traceFrameCount = atoi(argv[++i]);
+		}
+		else if (hasValue && cstring_equals(argv[i], "-workers"))
+		{
+			settings.workerCount = atoi(argv[++i]);
+		}
+		else if (hasValue && cstring_equals(argv[i], "-benchmark"))
+		{
+			settings.benchmarkName = argv[++i];
+		}
+		else
+		{
+			log_application(0, "Unknown argument '", argv[i], "'");
+		}
+	}
+
+	return settings;
+}
+
+/// ---------- STATISTICS --------------------------
+
+struct HeadlessStatistics
+{
+	s32 frameCount;
+
+	f32 averageMs;
+	f32 p50Ms;
+	f32 p95Ms;
+	f32 p99Ms;
+	f32 maxMs;
+
+	f32 persistentHighWaterMB;
+	f32 transientHighWaterMB;
+};
+
+internal int fsheadless_compare_f64(void const * a, void const * b)
+{
+	f64 valueA = *reinterpret_cast<f64 const*>(a);
+	f64 valueB = *reinterpret_cast<f64 const*>(b);
+	return (valueA > valueB) - (valueA < valueB);
+}
+
+// Note(Leo): Nearest rank percentile, 'sortedTimes' must be sorted ascending
+internal f32 fsheadless_percentile_ms(f64 const * sortedTimes, s32 count, f32 percentile)
+{
+	if (count == 0)
+	{
+		return 0;
+	}
+
+	s32 rank 	= static_cast<s32>(ceil_f32(percentile * count));
+	s32 index 	= s32_clamp(rank - 1, 0, count - 1);
+	return static_cast<f32>(sortedTimes[index] * 1000);
+}
+
+internal HeadlessStatistics fsheadless_compute_statistics(f64 const * frameTimes, s32 frameCount, u64 persistentHighWaterMark, u64 transientHighWaterMark)
+{
+	HeadlessStatistics statistics 		= {};
+	statistics.frameCount 				= frameCount;
+	statistics.persistentHighWaterMB 	= reverse_megabytes(persistentHighWaterMark);
+	statistics.transientHighWaterMB 	= reverse_megabytes(transientHighWaterMark);
+
+	if (frameCount == 0)
+	{
+		return statistics;
+	}
+
+	f64 * sortedTimes = reinterpret_cast<f64*>(malloc(frameCount * sizeof(f64)));
+	memory_copy_structs(sortedTimes, frameTimes, frameCount);
+	qsort(sortedTimes, frameCount, sizeof(f64), fsheadless_compare_f64);
+
+	f64 totalTime = 0;
+	for (s32 i = 0; i < frameCount; ++i)
+	{
+		totalTime += frameTimes[i];
+	}
+
+	statistics.averageMs 	= static_cast<f32>(totalTime / frameCount * 1000);
+	statistics.p50Ms 		= fsheadless_percentile_ms(sortedTimes, frameCount, 0.50f);
+	statistics.p95Ms 		= fsheadless_percentile_ms(sortedTimes, frameCount, 0.95f);
+	statistics.p99Ms 		= fsheadless_percentile_ms(sortedTimes, frameCount, 0.99f);
+	statistics.maxMs 		= static_cast<f32>(sortedTimes[frameCount - 1] * 1000);
+
+	free(sortedTimes);
+
+	return statistics;
+}
+
+/*
+Note(Leo): Report is plain text so that it can be read and diffed as is. Summary is written as
+'key value' lines, followed by 'frame_ms' line and one frame time per line.
+*/
+internal void fsheadless_write_report(char const * filename, HeadlessStatistics const & statistics, f64 const * frameTimes)
+{
+	s32 capacity 	= 1024 + statistics.frameCount * 32;
+	String report 	= {0, reinterpret_cast<char*>(malloc(capacity))};
+
+	string_append_format(report, capacity,
+		"frames ", statistics.frameCount, "\n",
+		"avg_ms ", statistics.averageMs, "\n",
+		"p50_ms ", statistics.p50Ms, "\n",
+		"p95_ms ", statistics.p95Ms, "\n",
+		"p99_ms ", statistics.p99Ms, "\n",
+		"max_ms ", statistics.maxMs, "\n",
+		"persistent_high_water_mb ", statistics.persistentHighWaterMB, "\n",
+		"transient_high_water_mb ", statistics.transientHighWaterMB, "\n",
+		"frame_ms\n");
+
+	for (s32 i = 0; i < statistics.frameCount; ++i)
+	{
+		string_append_format(report, capacity, static_cast<f32>(frameTimes[i] * 1000), "\n");
+	}
+
+	PlatformFileHandle file = platform_file_open(filename, FileMode_write);
+	if (file != nullptr)
+	{
+		platform_file_write(file, 0, report.length, report.memory);
+		platform_file_close(file);
+
+		log_application(0, "Wrote report to '", filename, "'");
+	}
+
+	free(report.memory);
+}
+
+internal bool32 fsheadless_read_report(char const * filename, HeadlessStatistics & outStatistics)
+{
+	PlatformFileHandle file = platform_file_open(filename, FileMode_read);
+	if (file == nullptr)
+	{
+		return false;
+	}
+
+	s64 size 		= platform_file_get_size(file);
+	char * memory 	= reinterpret_cast<char*>(malloc(size));
+	platform_file_read(file, 0, size, memory);
+	platform_file_close(file);
+
+	outStatistics 	= {};
+	String source 	= {size, memory};
+
+	while(source.length > 0)
+	{
+		String line = string_extract_line(source);
+		if (string_equals(line, "frame_ms"))
+		{
+			break;
+		}
+
+		String key = string_extract_until_character(line, ' ');
+		if (line.length <= 0)
+		{
+			continue;
+		}
+
+		if (string_equals(key, "frames")) 							{ string_parse(line, &outStatistics.frameCount); }
+		else if (string_equals(key, "avg_ms")) 						{ string_parse(line, &outStatistics.averageMs); }
+		else if (string_equals(key, "p50_ms")) 						{ string_parse(line, &outStatistics.p50Ms); }
+		else if (string_equals(key, "p95_ms")) 						{ string_parse(line, &outStatistics.p95Ms); }
+		else if (string_equals(key, "p99_ms")) 						{ string_parse(line, &outStatistics.p99Ms); }
+		else if (string_equals(key, "max_ms")) 						{ string_parse(line, &outStatistics.maxMs); }
+		else if (string_equals(key, "persistent_high_water_mb")) 	{ string_parse(line, &outStatistics.persistentHighWaterMB); }
+		else if (string_equals(key, "transient_high_water_mb")) 	{ string_parse(line, &outStatistics.transientHighWaterMB); }
+	}
+
+	free(memory);
+	return true;
+}
+
+internal void fsheadless_log_comparison(char const * label, f32 baseline, f32 current, char const * unit)
+{
+	f32 difference 	= current - baseline;
+	f32 percent 	= baseline != 0 ? difference / baseline * 100 : 0;
+
+	log_application(0, label, " ", baseline, " -> ", current, " ", unit, " (", difference > 0 ? "+" : "", percent, " %)");
+}
+
+int main(int argc, char ** argv)
+{
+	log_application(0,	"\n",
+						"\t----- FriendSimulator (headless) -----\n",
+						"\tBuild time: ", BUILD_DATE_TIME, "\n");
+
+	HeadlessSettings settings = fsheadless_parse_arguments(argc, argv);
+
+	if (settings.benchmarkName != nullptr)
+	{
+		return fsheadless_run_benchmark(settings.benchmarkName) ? 0 : 1;
+	}
+
+	InputRecording replay 		= {};
+	bool32 isReplaying 			= false;
+
+	if (settings.replayFilename != nullptr)
+	{
+		isReplaying = input_recording_begin_read(settings.replayFilename, replay);
+		AssertRelease(isReplaying, "Failed to open input recording");
+
+		settings.frameCount = s32_min(settings.frameCount, replay.header.frameCount);
+		settings.randomSeed = replay.header.randomSeed;
+	}
+
+	InputRecording recording 	= {};
+	bool32 isRecording 			= settings.recordFilename != nullptr;
+
+	if (isRecording)
+	{
+		recording = input_recording_begin_write(settings.recordFilename, settings.randomSeed);
+	}
+
+	random_set_seed(settings.randomSeed);
+
+	#if defined FS_PROFILER_ENABLED
+	if (settings.traceFrameCount > 0)
+	{
+		profiler_capture_trace(profiler_get(), settings.traceFrameCount);
+	}
+	#endif
+
+	// Note(Leo): This is big, so keep it off the stack
+	static PlatformJobs jobs;
+	jobs_initialize(jobs, settings.workerCount);
+
+	HeadlessWindow window 		= {.width = 1920, .height = 1080};
+	HeadlessGraphics graphics 	= {};
+
+	HeadlessInput input 			= {};
+	input.mouseAndKeyboardInputUsed = true;
+
+	HeadlessAudio audio 		= {};
+	audio.sampleRate 			= 48000;
+	audio.sampleCapacity 		= audio.sampleRate;
+	audio.samples 				= reinterpret_cast<StereoSoundSample*>(calloc(audio.sampleCapacity, sizeof(StereoSoundSample)));
+	audio.frameSeconds 			= settings.frameSeconds;
+
+	MemoryBlock gameMemory = {};
+	{
+		// Note(Leo): Same size as win32 platform. Anonymous mapping is zeroed, which game expects.
+		gameMemory.size 	= megabytes(256);
+		void * memory 		= mmap(nullptr, gameMemory.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		AssertRelease(memory != MAP_FAILED, "Failed to allocate game memory");
+		gameMemory.memory 	= reinterpret_cast<u8*>(memory);
+	}
+
+	{
+		IMGUI_CHECKVERSION();
+		ImGui::CreateContext();
+		ImGuiIO & io 	= ImGui::GetIO();
+		io.IniFilename 	= nullptr;
+
+		// Note(Leo): ImGui requires font atlas to be built before first frame, we just throw pixels away
+		u8 * pixels;
+		s32 width, height;
+		io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+	}
+
+	f64 * frameTimes = reinterpret_cast<f64*>(calloc(s32_max(1, settings.frameCount), sizeof(f64)));
+
+	u64 persistentHighWaterMark = 0;
+	u64 transientHighWaterMark 	= 0;
+
+	GameMemoryUsage memoryUsage = {};
+
+	s32 frameIndex 		= 0;
+	bool gameIsRunning 	= true;
+
+	for (; gameIsRunning && frameIndex < settings.frameCount; ++frameIndex)
+	{
+		/// ----- HANDLE INPUT -----
+
+		f32 elapsedSeconds = settings.frameSeconds;
+
+		if (isReplaying)
+		{
+			InputRecordingFrame recordedFrame;
+			if (input_recording_read_frame(replay, recordedFrame) == false)
+			{
+				break;
+			}
+
+			fsheadless_input_set_recorded_frame(input, recordedFrame);
+			elapsedSeconds = recordedFrame.elapsedSeconds;
+		}
+		else
+		{
+			fsheadless_input_reset(input);
+
+			// Note(Leo): Confirm first main menu button, which starts a new game
+			fsheadless_input_set_button(input, InputButton_keyboard_enter, frameIndex == 0);
+		}
+
+		if (isRecording)
+		{
+			input_recording_write_frame(recording, &input, elapsedSeconds);
+		}
+
+		audio.frameSeconds = elapsedSeconds;
+
+		{
+			ImGuiIO & io 	= ImGui::GetIO();
+			io.DisplaySize 	= {(f32)window.width, (f32)window.height};
+
+			// Note(Leo): ImGui asserts on zero delta time, first recorded frame has it
+			io.DeltaTime 	= elapsedSeconds > 0 ? elapsedSeconds : settings.frameSeconds;
+			ImGui::NewFrame();
+		}
+
+		s64 frameStartTime = platform_time_now();
+
+		{
+			FS_PROFILE_SCOPE("game_update");
+			gameIsRunning = game_update(gameMemory, &input, &graphics, &window, &audio, &jobs, elapsedSeconds);
+		}
+
+		frameTimes[frameIndex] = platform_time_elapsed_seconds(frameStartTime, platform_time_now());
+
+		ImGui::EndFrame();
+
+		fsheadless_graphics_end_frame(&graphics);
+
+		#if defined FS_PROFILER_ENABLED
+		profiler_end_frame(*profiler_get());
+		#endif
+
+		memoryUsage 				= game_get_memory_usage(gameMemory);
+		persistentHighWaterMark 	= memoryUsage.persistentHighWaterMark > persistentHighWaterMark ? memoryUsage.persistentHighWaterMark : persistentHighWaterMark;
+		transientHighWaterMark 		= memoryUsage.transientHighWaterMark > transientHighWaterMark ? memoryUsage.transientHighWaterMark : transientHighWaterMark;
+	}
+
+	/// ----- REPORT -----
+	{
+		s32 frameCount 		= frameIndex;
+		s32 frameDivisor 	= s32_max(1, frameCount);
+
+		HeadlessStatistics statistics = fsheadless_compute_statistics(frameTimes, frameCount, persistentHighWaterMark, transientHighWaterMark);
+
+		log_application(0, "Ran ", frameCount, " frames", isReplaying ? " from recording" : "", ", seed ", (s64)settings.randomSeed);
+		log_application(0, "Frame time avg ", statistics.averageMs, " ms, p50 ", statistics.p50Ms, " ms, p95 ", statistics.p95Ms,
+							" ms, p99 ", statistics.p99Ms, " ms, max ", statistics.maxMs, " ms");
+		log_application(0, "Arena high-water marks: persistent ", statistics.persistentHighWaterMB, " MB, transient ", statistics.transientHighWaterMB, " MB");
+		log_application(0, "Arenas committed/reserved at end: persistent ", reverse_megabytes(memoryUsage.persistentCommitted), "/", reverse_megabytes(memoryUsage.persistentSize),
+							" MB, transient ", reverse_megabytes(memoryUsage.transientCommitted), "/", reverse_megabytes(memoryUsage.transientSize), " MB");
+		log_application(0, "Draw calls/frame ", graphics.total.drawCalls / frameDivisor,
+							", instances/frame ", graphics.total.drawInstances / frameDivisor,
+							", bytes/frame ", graphics.total.drawBytes / frameDivisor);
+		log_application(0, "Memory pushes ", graphics.total.memoryPushCalls, ", ", reverse_megabytes(graphics.total.memoryPushBytes), " MB");
+		log_application(0, "Audio buffers ", audio.bufferCount, ", samples ", audio.sampleCount);
+
+		#if defined FS_MEMORY_INSTRUMENTATION_ENABLED
+		game_log_memory_report(gameMemory);
+		#endif
+
+		if (settings.reportFilename != nullptr)
+		{
+			fsheadless_write_report(settings.reportFilename, statistics, frameTimes);
+		}
+
+		HeadlessStatistics baseline;
+		if (settings.baselineFilename != nullptr && fsheadless_read_report(settings.baselineFilename, baseline))
+		{
+			log_application(0, "Compared to baseline '", settings.baselineFilename, "' (", baseline.frameCount, " frames):");
+			fsheadless_log_comparison("\tavg", baseline.averageMs, statistics.averageMs, "ms");
+			fsheadless_log_comparison("\tp50", baseline.p50Ms, statistics.p50Ms, "ms");
+			fsheadless_log_comparison("\tp95", baseline.p95Ms, statistics.p95Ms, "ms");
+			fsheadless_log_comparison("\tp99", baseline.p99Ms, statistics.p99Ms, "ms");
+			fsheadless_log_comparison("\tmax", baseline.maxMs, statistics.maxMs, "ms");
+			fsheadless_log_comparison("\tpersistent high-water", baseline.persistentHighWaterMB, statistics.persistentHighWaterMB, "MB");
+			fsheadless_log_comparison("\ttransient high-water", baseline.transientHighWaterMB, statistics.transientHighWaterMB, "MB");
+		}
+	}
+
+	if (isRecording)
+	{
+		input_recording_end_write(recording);
+	}
+
+	if (isReplaying)
+	{
+		input_recording_end_read(replay);
+	}
+
+	jobs_shutdown(jobs);
+
+	ImGui::DestroyContext();
+
+	free(frameTimes);
+	free(audio.samples);
+	munmap(gameMemory.memory, gameMemory.size);
+
+	return EXIT_SUCCESS;
+}
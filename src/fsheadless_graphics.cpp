@@ -0,0 +1,155 @@
+/*
+Leo Tamminen
+
+Null graphics backend for headless platform. Nothing is drawn, but we count calls,
+instances and bytes passed, so that cost of game_render can be measured without gpu.
+*/
+
+struct HeadlessGraphicsCounters
+{
+	s64 drawCalls;
+	s64 drawInstances;
+	s64 drawBytes;
+
+	s64 memoryPushCalls;
+	s64 memoryPushBytes;
+};
+
+struct PlatformGraphics
+{
+	s64 meshCount;
+	s64 textureCount;
+	s64 materialCount;
+	s64 modelCount;
+
+	// Note(Leo): 'frame' is reset by platform each frame, 'total' accumulates over whole run
+	HeadlessGraphicsCounters frame;
+	HeadlessGraphicsCounters total;
+};
+
+using HeadlessGraphics = PlatformGraphics;
+
+internal void fsheadless_graphics_count_draw(HeadlessGraphics * graphics, s64 instances, s64 bytes)
+{
+	graphics->frame.drawCalls 		+= 1;
+	graphics->frame.drawInstances 	+= instances;
+	graphics->frame.drawBytes 		+= bytes;
+}
+
+internal void fsheadless_graphics_count_push(HeadlessGraphics * graphics, s64 bytes)
+{
+	graphics->frame.memoryPushCalls 	+= 1;
+	graphics->frame.memoryPushBytes 	+= bytes;
+}
+
+internal void fsheadless_graphics_end_frame(HeadlessGraphics * graphics)
+{
+	graphics->total.drawCalls 		+= graphics->frame.drawCalls;
+	graphics->total.drawInstances 	+= graphics->frame.drawInstances;
+	graphics->total.drawBytes 		+= graphics->frame.drawBytes;
+	graphics->total.memoryPushCalls += graphics->frame.memoryPushCalls;
+	graphics->total.memoryPushBytes += graphics->frame.memoryPushBytes;
+
+	graphics->frame = {};
+}
+
+/// ---------- PLATFORM API FUNCTIONS --------------------------
+
+internal void graphics_drawing_update_camera(HeadlessGraphics * graphics, Camera const * camera)
+{
+	fsheadless_graphics_count_draw(graphics, 0, sizeof(Camera));
+}
+
+internal void graphics_drawing_update_lighting(HeadlessGraphics * graphics, Light const * light, Camera const * camera, v3 ambient)
+{
+	fsheadless_graphics_count_draw(graphics, 0, sizeof(Light));
+}
+
+internal void graphics_drawing_update_hdr_settings(HeadlessGraphics * graphics, HdrSettings const * hdrSettings)
+{
+	fsheadless_graphics_count_draw(graphics, 0, sizeof(HdrSettings));
+}
+
+internal void graphics_draw_model(HeadlessGraphics * graphics, ModelHandle model, m44 transform, bool32 castShadow, m44 const * bones, u32 boneCount)
+{
+	fsheadless_graphics_count_draw(graphics, 1, sizeof(m44) * (1 + boneCount));
+}
+
+internal void graphics_draw_meshes(HeadlessGraphics * graphics, s32 count, m44 const * transforms, MeshHandle mesh, MaterialHandle material)
+{
+	fsheadless_graphics_count_draw(graphics, count, sizeof(m44) * count);
+}
+
+internal void graphics_draw_screen_rects(HeadlessGraphics * graphics, s32 count, ScreenRect const * rects, MaterialHandle material, v4 color)
+{
+	fsheadless_graphics_count_draw(graphics, count, sizeof(ScreenRect) * count);
+}
+
+internal void graphics_draw_lines(HeadlessGraphics * graphics, s32 pointCount, v3 const * points, v4 color)
+{
+	fsheadless_graphics_count_draw(graphics, pointCount / 2, sizeof(v3) * pointCount);
+}
+
+internal void graphics_draw_procedural_mesh(HeadlessGraphics * graphics,
+											s32 vertexCount, Vertex const * vertices,
+											s32 indexCount, u16 const * indices,
+											m44 transform, MaterialHandle material)
+{
+	fsheadless_graphics_count_draw(graphics, 1, sizeof(Vertex) * vertexCount + sizeof(u16) * indexCount);
+}
+
+internal void graphics_draw_leaves(HeadlessGraphics * graphics, s32 count, m44 const * transforms, s32 colourIndex, v3 colour, MaterialHandle material)
+{
+	fsheadless_graphics_count_draw(graphics, count, sizeof(m44) * count);
+}
+
+internal MeshHandle graphics_memory_push_mesh(HeadlessGraphics * graphics, MeshAssetData * asset)
+{
+	s64 indexSize = asset->indexType == MeshIndexType_uint32 ? sizeof(u32) : sizeof(u16);
+	s64 skinSize = asset->skinning != nullptr ? sizeof(VertexSkinData) * asset->vertexCount : 0;
+	fsheadless_graphics_count_push(graphics, sizeof(Vertex) * asset->vertexCount + indexSize * asset->indexCount + skinSize);
+
+	MeshHandle handle = {graphics->meshCount++};
+	return handle;
+}
+
+internal TextureHandle graphics_memory_push_texture(HeadlessGraphics * graphics, TextureAssetData * asset)
+{
+	s64 channelSize = asset->format == TextureFormat_f32 ? sizeof(f32) : sizeof(u8);
+	fsheadless_graphics_count_push(graphics, channelSize * asset->channels * asset->width * asset->height);
+
+	TextureHandle handle = {graphics->textureCount++};
+	return handle;
+}
+
+internal MaterialHandle graphics_memory_push_material(HeadlessGraphics * graphics, GraphicsPipeline pipeline, s32 textureCount, TextureHandle * textures)
+{
+	fsheadless_graphics_count_push(graphics, sizeof(TextureHandle) * textureCount);
+
+	MaterialHandle handle = {graphics->materialCount++};
+	return handle;
+}
+
+internal ModelHandle graphics_memory_push_model(HeadlessGraphics * graphics, MeshHandle mesh, MaterialHandle material)
+{
+	fsheadless_graphics_count_push(graphics, sizeof(MeshHandle) + sizeof(MaterialHandle));
+
+	ModelHandle handle = {graphics->modelCount++};
+	return handle;
+}
+
+internal void graphics_memory_unload(HeadlessGraphics * graphics)
+{
+	graphics->meshCount 	= 0;
+	graphics->textureCount 	= 0;
+	graphics->materialCount = 0;
+	graphics->modelCount 	= 0;
+}
+
+internal void graphics_development_update_texture(HeadlessGraphics * graphics, TextureHandle texture, TextureAssetData * asset)
+{
+	s64 channelSize = asset->format == TextureFormat_f32 ? sizeof(f32) : sizeof(u8);
+	fsheadless_graphics_count_push(graphics, channelSize * asset->channels * asset->width * asset->height);
+}
+
+internal void graphics_development_reload_shaders(HeadlessGraphics * graphics) {}
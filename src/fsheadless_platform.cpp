@@ -0,0 +1,194 @@
+/*
+Leo Tamminen
+
+Window, input and audio for headless platform. There is no window or devices, so these
+only hold values that game may ask for. Input is set by platform, audio output is mixed
+into a buffer and discarded.
+*/
+
+/// ---------- WINDOW --------------------------
+
+struct PlatformWindow
+{
+	s32 width;
+	s32 height;
+	bool32 isFullscreen;
+	bool32 cursorHiddenAndLocked;
+};
+
+using HeadlessWindow = PlatformWindow;
+
+static void platform_window_set(HeadlessWindow * window, PlatformWindowSetting setting, bool32 value)
+{
+	switch(setting)
+	{
+		case PlatformWindowSetting_fullscreen: 					window->isFullscreen = value; break;
+		case PlatformWindowSetting_cursor_hidden_and_locked: 	window->cursorHiddenAndLocked = value; break;
+	}
+}
+
+static bool32 platform_window_get (HeadlessWindow * window, PlatformWindowSetting setting)
+{
+	switch(setting)
+	{
+		case PlatformWindowSetting_fullscreen: 					return window->isFullscreen;
+		case PlatformWindowSetting_cursor_hidden_and_locked: 	return window->cursorHiddenAndLocked;
+	}
+	return false;
+}
+
+static u32 platform_window_get_width(HeadlessWindow const * window)
+{
+	return window->width;
+}
+
+static u32 platform_window_get_height(HeadlessWindow const * window)
+{
+	return window->height;
+}
+
+/// ---------- INPUT --------------------------
+
+enum HeadlessInputButtonState : s8
+{
+	HeadlessInputButtonState_is_up,
+	HeadlessInputButtonState_went_down,
+	HeadlessInputButtonState_is_down,
+	HeadlessInputButtonState_went_up,
+};
+
+struct PlatformInput
+{
+	f32 						axes[InputAxisCount];
+	HeadlessInputButtonState 	buttons[InputButtonCount];
+
+	bool32 gamepadInputUsed;
+	bool32 mouseAndKeyboardInputUsed;
+};
+
+using HeadlessInput = PlatformInput;
+
+f32 input_axis_get_value(HeadlessInput * input, InputAxis axis)
+{
+	return input->axes[axis];
+}
+
+v2 input_cursor_get_position(HeadlessInput * input)
+{
+	return {};
+}
+
+static bool32 input_button_went_down(HeadlessInput * input, InputButton button)
+{
+	return input->buttons[button] == HeadlessInputButtonState_went_down;
+}
+
+static bool32 input_button_is_down (HeadlessInput * input, InputButton button)
+{
+	HeadlessInputButtonState state = input->buttons[button];
+	return (state == HeadlessInputButtonState_is_down) || (state == HeadlessInputButtonState_went_down);
+}
+
+static bool32 input_button_went_up (HeadlessInput * input, InputButton button)
+{
+	return input->buttons[button] == HeadlessInputButtonState_went_up;
+}
+
+static bool32 input_is_device_used (HeadlessInput * input, InputDevice device)
+{
+	switch(device)
+	{
+		case InputDevice_gamepad: 				return input->gamepadInputUsed;
+		case InputDevice_mouse_and_keyboard: 	return input->mouseAndKeyboardInputUsed;
+	}
+	return false;
+}
+
+// Note(Leo): Call this before setting new frame's input, so that 'went' states only last for one frame
+internal void fsheadless_input_reset(HeadlessInput & input)
+{
+	for (auto & button : input.buttons)
+	{
+		if (button == HeadlessInputButtonState_went_down)
+		{
+			button = HeadlessInputButtonState_is_down;
+		}
+		else if (button == HeadlessInputButtonState_went_up)
+		{
+			button = HeadlessInputButtonState_is_up;
+		}
+	}
+}
+
+internal void fsheadless_input_set_button(HeadlessInput & input, InputButton button, bool32 isDown)
+{
+	bool32 wasDown = input_button_is_down(&input, button);
+
+	if (isDown && wasDown == false)
+	{
+		input.buttons[button] = HeadlessInputButtonState_went_down;
+	}
+	else if (isDown == false && wasDown)
+	{
+		input.buttons[button] = HeadlessInputButtonState_went_up;
+	}
+}
+
+// Note(Leo): Recorded frame holds full state, so this also sets 'went' states directly, and reset is not needed
+internal void fsheadless_input_set_recorded_frame(HeadlessInput & input, InputRecordingFrame const & frame)
+{
+	for (s32 i = 0; i < InputButtonCount; ++i)
+	{
+		bool32 isDown 	= (frame.buttonsDown & ((u64)1 << i)) != 0;
+		bool32 changed 	= (frame.buttonsChanged & ((u64)1 << i)) != 0;
+
+		if (changed)
+		{
+			input.buttons[i] = isDown ? HeadlessInputButtonState_went_down : HeadlessInputButtonState_went_up;
+		}
+		else
+		{
+			input.buttons[i] = isDown ? HeadlessInputButtonState_is_down : HeadlessInputButtonState_is_up;
+		}
+	}
+
+	for (s32 i = 0; i < InputAxisCount; ++i)
+	{
+		input.axes[i] = frame.axes[i];
+	}
+
+	input.gamepadInputUsed 			= (frame.devicesUsed & (1 << InputDevice_gamepad)) != 0;
+	input.mouseAndKeyboardInputUsed = (frame.devicesUsed & (1 << InputDevice_mouse_and_keyboard)) != 0;
+}
+
+/// ---------- AUDIO --------------------------
+
+struct PlatformAudio
+{
+	s32 sampleRate;
+	s32 sampleCapacity;
+	StereoSoundSample * samples;
+
+	// Note(Leo): Set by platform each frame, so that game mixes as many samples as real device would have asked
+	f32 frameSeconds;
+
+	s64 bufferCount;
+	s64 sampleCount;
+};
+
+using HeadlessAudio = PlatformAudio;
+
+StereoSoundOutput audio_get_output_buffer(HeadlessAudio * audio)
+{
+	s32 sampleCount = static_cast<s32>(audio->sampleRate * audio->frameSeconds);
+	sampleCount 	= s32_min(sampleCount, audio->sampleCapacity);
+
+	StereoSoundOutput output = {sampleCount, audio->samples};
+	return output;
+}
+
+void audio_release_output_buffer(HeadlessAudio * audio, StereoSoundOutput output)
+{
+	audio->bufferCount += 1;
+	audio->sampleCount += output.sampleCount;
+}
@@ -0,0 +1,93 @@
+/*
+Leo Tamminen
+
+platform_file_XXXX functions' implementations for posix systems.
+*/
+
+/* Note(Leo): File descriptor is stored directly to handle. Descriptor 0 is stdin, so we will
+never get it here, and nullptr can be used as invalid handle like on win32 side. */
+internal int fsposix_file_descriptor(PlatformFileHandle file)
+{
+	return static_cast<int>(reinterpret_cast<s64>(file));
+}
+
+PlatformFileHandle platform_file_open(char const * filename, FileMode fileMode)
+{
+	int flags = 0;
+
+	if(fileMode == FileMode_read)
+	{
+		flags = O_RDONLY;
+	}
+	else if (fileMode == FileMode_write)
+	{
+		// Todo(Leo): this may be unwanted, but it matches win32 SetEndOfFile
+		flags = O_WRONLY | O_CREAT | O_TRUNC;
+	}
+
+	int file = open(filename, flags, 0644);
+
+	if (file < 0)
+	{
+		log_application(1, "Failed to open file '", filename, "'");
+		return nullptr;
+	}
+
+	PlatformFileHandle result = reinterpret_cast<PlatformFileHandle>(static_cast<s64>(file));
+	return result;
+}
+
+void platform_file_close(PlatformFileHandle file)
+{
+	if (file != nullptr)
+	{
+		close(fsposix_file_descriptor(file));
+	}
+}
+
+void platform_file_write (PlatformFileHandle file, s64 position, s64 count, const void * memory)
+{
+	u8 const * bytes = reinterpret_cast<u8 const *>(memory);
+
+	// Note(Leo): pwrite may write less than asked, so loop until everything is written
+	while (count > 0)
+	{
+		ssize_t bytesWritten = pwrite(fsposix_file_descriptor(file), bytes, count, position);
+		if (bytesWritten <= 0)
+		{
+			break;
+		}
+
+		bytes 		+= bytesWritten;
+		position 	+= bytesWritten;
+		count 		-= bytesWritten;
+	}
+}
+
+void platform_file_read (PlatformFileHandle file, s64 position, s64 count, void * memory)
+{
+	u8 * bytes = reinterpret_cast<u8*>(memory);
+
+	while (count > 0)
+	{
+		ssize_t bytesRead = pread(fsposix_file_descriptor(file), bytes, count, position);
+		if (bytesRead <= 0)
+		{
+			break;
+		}
+
+		bytes 		+= bytesRead;
+		position 	+= bytesRead;
+		count 		-= bytesRead;
+	}
+}
+
+s64 platform_file_get_size(PlatformFileHandle file)
+{
+	struct stat fileStatus = {};
+	fstat(fsposix_file_descriptor(file), &fileStatus);
+
+	Assert(fileStatus.st_size < max_value_s64);
+
+	return fileStatus.st_size;
+}
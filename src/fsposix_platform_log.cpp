@@ -0,0 +1,12 @@
+/*
+Leo Tamminen
+
+Log api implementation for posix systems. Like win32 one, this function has its own file.
+*/
+
+void platform_log_write(s32 count, char const * buffer)
+{
+	// Todo(Leo): if we fail to log, what can we do, but this can be checked for debugger purposes
+	ssize_t bytesWritten = write(STDOUT_FILENO, buffer, count);
+	(void)bytesWritten;
+}
@@ -0,0 +1,35 @@
+/*
+Leo Tamminen
+
+platform_memory_XXXX functions' implementations for posix systems. Reserved range is mapped with no
+access, so it takes only address space, and committing changes protection so that pages are given
+when they are first touched.
+*/
+
+u64 platform_memory_page_size()
+{
+	return static_cast<u64>(sysconf(_SC_PAGESIZE));
+}
+
+void * platform_memory_reserve(u64 size)
+{
+	void * memory = mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	return memory != MAP_FAILED ? memory : nullptr;
+}
+
+bool32 platform_memory_commit(void * memory, u64 size)
+{
+	return mprotect(memory, size, PROT_READ | PROT_WRITE) == 0;
+}
+
+// Note(Leo): MADV_DONTNEED gives pages back, and they are zeroed if they are committed again
+void platform_memory_decommit(void * memory, u64 size)
+{
+	madvise(memory, size, MADV_DONTNEED);
+	mprotect(memory, size, PROT_NONE);
+}
+
+void platform_memory_release(void * memory, u64 size)
+{
+	munmap(memory, size);
+}
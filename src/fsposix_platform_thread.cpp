@@ -0,0 +1,86 @@
+/*
+Leo Tamminen
+
+Threads and semaphores for posix systems. These are only used by platform layer.
+*/
+
+using PlatformThreadFunc = void(void * data);
+
+struct PlatformThread
+{
+	pthread_t thread;
+};
+
+struct PlatformSemaphore
+{
+	sem_t semaphore;
+};
+
+struct PosixThreadStart
+{
+	PlatformThreadFunc * 	func;
+	void * 					data;
+};
+
+internal void * fsposix_thread_start(void * parameter)
+{
+	PosixThreadStart start = *reinterpret_cast<PosixThreadStart*>(parameter);
+	free(parameter);
+
+	start.func(start.data);
+	return nullptr;
+}
+
+internal PlatformThread platform_thread_start(PlatformThreadFunc * func, void * data)
+{
+	PosixThreadStart * start 	= reinterpret_cast<PosixThreadStart*>(malloc(sizeof(PosixThreadStart)));
+	*start 						= {func, data};
+
+	PlatformThread thread;
+	s32 result = pthread_create(&thread.thread, nullptr, fsposix_thread_start, start);
+	AssertRelease(result == 0, "Failed to create thread");
+
+	return thread;
+}
+
+internal void platform_thread_join(PlatformThread & thread)
+{
+	pthread_join(thread.thread, nullptr);
+}
+
+internal s32 platform_get_processor_count()
+{
+	s32 count = static_cast<s32>(sysconf(_SC_NPROCESSORS_ONLN));
+	return count > 0 ? count : 1;
+}
+
+internal void platform_semaphore_create(PlatformSemaphore & semaphore)
+{
+	sem_init(&semaphore.semaphore, 0, 0);
+}
+
+internal void platform_semaphore_destroy(PlatformSemaphore & semaphore)
+{
+	sem_destroy(&semaphore.semaphore);
+}
+
+internal void platform_semaphore_signal(PlatformSemaphore & semaphore, s32 count)
+{
+	for (s32 i = 0; i < count; ++i)
+	{
+		sem_post(&semaphore.semaphore);
+	}
+}
+
+internal void platform_semaphore_wait(PlatformSemaphore & semaphore)
+{
+	// Note(Leo): Retry if interrupted by a signal
+	while (sem_wait(&semaphore.semaphore) != 0)
+	{
+	}
+}
+
+internal void platform_thread_yield()
+{
+	sched_yield();
+}
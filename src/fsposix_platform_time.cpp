@@ -0,0 +1,18 @@
+/*
+Leo Tamminen
+
+Time api implementation for posix systems. Values are nanoseconds from monotonic clock.
+*/
+
+s64 platform_time_now () 
+{
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return static_cast<s64>(t.tv_sec) * 1'000'000'000 + t.tv_nsec;
+}
+
+f64 platform_time_elapsed_seconds(s64 start, s64 end)
+{
+	f64 seconds = static_cast<f64>(end - start) / 1'000'000'000.0;
+	return seconds;
+}
@@ -93,6 +93,8 @@ internal void graphics_drawing_update_hdr_settings(VulkanContext * context, HdrS
 
 internal void vulkan_prepare_frame(VulkanContext * context)
 {
+	FS_PROFILE_FUNCTION();
+
 	auto * frame 				= fsvulkan_get_current_virtual_frame(context);
 	auto & sceneRenderTarget 	= context->sceneRenderTargets[context->virtualFrameIndex];
 
@@ -218,6 +220,8 @@ internal void vulkan_prepare_frame(VulkanContext * context)
 
 internal void vulkan_render_frame(VulkanContext * context)
 {
+	FS_PROFILE_FUNCTION();
+
 	VulkanVirtualFrame * frame = fsvulkan_get_current_virtual_frame(context);
 
 
@@ -382,6 +386,8 @@ internal void vulkan_render_frame(VulkanContext * context)
 
 internal void graphics_draw_model(VulkanContext * context, ModelHandle model, m44 transform, bool32 castShadow, m44 const * bones, u32 bonesCount)
 {
+	FS_PROFILE_FUNCTION();
+
 	/* Todo(Leo): Get rid of these, we can just as well get them directly from user.
 	That is more flexible and then we don't need to save that data in multiple places. */
 	MeshHandle meshHandle           = context->loadedModels[model].mesh;
@@ -501,6 +507,8 @@ internal void graphics_draw_leaves(	VulkanContext * context,
 											v3 colour,
 											MaterialHandle materialHandle)
 {
+	FS_PROFILE_FUNCTION();
+
 	// Assert(instanceCount > 0 && "Vulkan cannot map memory of size 0, and this function should no be called for 0 meshes");
 	// Note(Leo): lets keep this sensible
 	// Assert(instanceCount <= 20000);
@@ -597,6 +605,8 @@ internal void graphics_draw_leaves(	VulkanContext * context,
 
 internal void graphics_draw_meshes(VulkanContext * context, s32 count, m44 const * transforms, MeshHandle meshHandle, MaterialHandle materialHandle)
 {
+	FS_PROFILE_FUNCTION();
+
 	if (count == 0)
 	{
 		log_graphics(1, FILE_ADDRESS, "Drawing 0 meshes!");
@@ -733,6 +743,8 @@ internal void graphics_draw_procedural_mesh(VulkanContext * context,
 											s32 indexCount, u16 const * indices,
 											m44 transform, MaterialHandle materialHandle)
 {
+	FS_PROFILE_FUNCTION();
+
 	Assert(vertexCount > 0);
 	Assert(indexCount > 0);
 
@@ -818,6 +830,8 @@ internal void graphics_draw_procedural_mesh(VulkanContext * context,
 
 internal void graphics_draw_lines(VulkanContext * context, s32 pointCount, v3 const * points, v4 color)
 {
+	FS_PROFILE_FUNCTION();
+
 	VkCommandBuffer commandBuffer = fsvulkan_get_current_virtual_frame(context)->debugCommandBuffer;
 
 	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, context->linePipeline);
@@ -848,6 +862,8 @@ internal void graphics_draw_screen_rects(	VulkanContext * 	context,
 											// GuiTextureHandle 	textureHandle,
 											v4 					color)
 {
+	FS_PROFILE_FUNCTION();
+
 	// /*
 	// vulkan bufferless drawing
 	// https://www.saschawillems.de/blog/2016/08/13/vulkan-tutorial-on-rendering-a-fullscreen-quad-without-buffers/
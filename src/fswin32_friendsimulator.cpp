@@ -38,7 +38,7 @@ not need console to be created.
 	#define FS_DEVELOPMENT_ONLY(expr) expr
 	#define FS_RELEASE_ONLY(expr) (void(0))
 
-	#define FS_ENTRY_POINT int main()
+	#define FS_ENTRY_POINT int main(int argc, char ** argv)
 
 #else
 	#error "FS_DEVELOPMENT or FS_RELEASE must be defined."
@@ -51,10 +51,15 @@ not need console to be created.
 #include "fs_platform_interface.hpp"
 
 #include "fs_logging.cpp"
+#include "fs_profiler.cpp"
 
 #include "fswin32_platform_log.cpp"
 #include "fswin32_platform_time.cpp"
+#include "fswin32_platform_memory.cpp"
 #include "fswin32_platform_file.cpp"
+#include "fswin32_platform_thread.cpp"
+
+#include "fs_job_system.cpp"
 
 // Todo(Leo): these can be in same file, and maybe even combine them. Windows seems to do that.
 #include "win32_platform_window.cpp"
@@ -62,6 +67,8 @@ not need console to be created.
 
 #include "win32_audio.cpp"
 
+#include "fs_input_recording.cpp"
+
 // Todo(Leo): Get rid of this :) It is used in some stupid places anyway
 #include <vector>
 #include "fsvulkan.cpp"
@@ -91,6 +98,25 @@ FS_ENTRY_POINT
 
 	// ----------------------------------------------------------------------------------
 
+	/*
+	Note(Leo): Input can be recorded with '-record <file>' and replayed with headless platform.
+	Game is not seeded from here, so recording uses default seed 0 that Random.cpp starts with.
+	Hot reloading game code resets random state, so that breaks replay.
+	*/
+	InputRecording inputRecording 	= {};
+	bool32 isRecordingInput 		= false;
+
+	#if defined FS_DEVELOPMENT
+	for (s32 i = 1; i + 1 < argc; ++i)
+	{
+		if (cstring_equals(argv[i], "-record"))
+		{
+			inputRecording 		= input_recording_begin_write(argv[i + 1], 0);
+			isRecordingInput 	= true;
+		}
+	}
+	#endif
+
 	Win32PlatformWindow window;
 	Win32PlatformInput input;
 
@@ -105,11 +131,16 @@ FS_ENTRY_POINT
 	Win32Audio audio = fswin32_create_audio(audioBufferLengthSeconds);
 	fswin32_start_playing(&audio);                
 
+	/// --------- INITIALIZE JOBS ----------------
+	// Note(Leo): Job system and its threads live here, so they survive game code reloads
+	static PlatformJobs jobs;
+	jobs_initialize(jobs, 0);
+
 	MemoryBlock gameMemory = {};
 	{
-		// TODO [MEMORY] (Leo): Properly measure required amount
+		// Note(Leo): This only has game state and worker scratch memory, game reserves its big arenas itself
 		// TODO [MEMORY] (Leo): Think of alignment
-		gameMemory.size = gigabytes(2);
+		gameMemory.size = megabytes(256);
 
 		// TODO [MEMORY] (Leo): Check support for large pages
 		FS_DEVELOPMENT_ONLY(void * baseAddress = (void*)terabytes(2));
@@ -226,13 +257,22 @@ FS_ENTRY_POINT
 				ImGui::NewFrame();
 			}
 
+			if (isRecordingInput)
+			{
+				input_recording_write_frame(inputRecording, &input, lastFrameElapsedSeconds);
+			}
+
 			// Todo(Leo): use function directly in release build
-			gameIsRunning = game.update(gameMemory,
-										&input, &graphics, &window, &audio,
-										lastFrameElapsedSeconds);
+			{
+				FS_PROFILE_SCOPE("game_update");
+				gameIsRunning = game.update(gameMemory,
+											&input, &graphics, &window, &audio, &jobs,
+											lastFrameElapsedSeconds);
+			}
 
 			// Todo(Leo): merge
 			{
+				FS_PROFILE_SCOPE("imgui render");
 				ImGui::EndFrame();
 				ImGui::Render();
 				ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(),
@@ -243,6 +283,8 @@ FS_ENTRY_POINT
 			vulkan_render_frame(&graphics);
 		}
 
+		FS_DEVELOPMENT_ONLY(profiler_end_frame(*profiler_get()));
+
 		if (window.shouldClose)
 		{
 			gameIsRunning = false;
@@ -288,6 +330,13 @@ FS_ENTRY_POINT
 	
 	fswin32_stop_playing(&audio);
 	fswin32_release_audio(&audio);
+
+	jobs_shutdown(jobs);
+
+	if (isRecordingInput)
+	{
+		input_recording_end_write(inputRecording);
+	}
 	
 	/// ----- Cleanup Windows
 	{
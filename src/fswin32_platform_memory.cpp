@@ -0,0 +1,33 @@
+/*
+Leo Tamminen
+
+platform_memory_XXXX functions' implementations.
+*/
+
+u64 platform_memory_page_size()
+{
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwPageSize;
+}
+
+void * platform_memory_reserve(u64 size)
+{
+	return VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS);
+}
+
+bool32 platform_memory_commit(void * memory, u64 size)
+{
+	return VirtualAlloc(memory, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+}
+
+void platform_memory_decommit(void * memory, u64 size)
+{
+	VirtualFree(memory, size, MEM_DECOMMIT);
+}
+
+// Note(Leo): Whole reserved range is released at once, so size is not needed here
+void platform_memory_release(void * memory, u64 size)
+{
+	VirtualFree(memory, 0, MEM_RELEASE);
+}
@@ -0,0 +1,85 @@
+/*
+Leo Tamminen
+
+Threads and semaphores for windows. These are only used by platform layer.
+*/
+
+using PlatformThreadFunc = void(void * data);
+
+struct PlatformThread
+{
+	HANDLE thread;
+};
+
+struct PlatformSemaphore
+{
+	HANDLE semaphore;
+};
+
+struct Win32ThreadStart
+{
+	PlatformThreadFunc * 	func;
+	void * 					data;
+};
+
+internal DWORD WINAPI fswin32_thread_start(LPVOID parameter)
+{
+	Win32ThreadStart start = *reinterpret_cast<Win32ThreadStart*>(parameter);
+	free(parameter);
+
+	start.func(start.data);
+	return 0;
+}
+
+internal PlatformThread platform_thread_start(PlatformThreadFunc * func, void * data)
+{
+	Win32ThreadStart * start 	= reinterpret_cast<Win32ThreadStart*>(malloc(sizeof(Win32ThreadStart)));
+	*start 						= {func, data};
+
+	PlatformThread thread 	= {};
+	thread.thread 			= CreateThread(nullptr, 0, fswin32_thread_start, start, 0, nullptr);
+	AssertRelease(thread.thread != nullptr, "Failed to create thread");
+
+	return thread;
+}
+
+internal void platform_thread_join(PlatformThread & thread)
+{
+	WaitForSingleObject(thread.thread, INFINITE);
+	CloseHandle(thread.thread);
+}
+
+internal s32 platform_get_processor_count()
+{
+	SYSTEM_INFO systemInfo;
+	GetSystemInfo(&systemInfo);
+	return static_cast<s32>(systemInfo.dwNumberOfProcessors);
+}
+
+internal void platform_semaphore_create(PlatformSemaphore & semaphore)
+{
+	semaphore.semaphore = CreateSemaphore(nullptr, 0, max_value_s32, nullptr);
+}
+
+internal void platform_semaphore_destroy(PlatformSemaphore & semaphore)
+{
+	CloseHandle(semaphore.semaphore);
+}
+
+internal void platform_semaphore_signal(PlatformSemaphore & semaphore, s32 count)
+{
+	if (count > 0)
+	{
+		ReleaseSemaphore(semaphore.semaphore, count, nullptr);
+	}
+}
+
+internal void platform_semaphore_wait(PlatformSemaphore & semaphore)
+{
+	WaitForSingleObject(semaphore.semaphore, INFINITE);
+}
+
+internal void platform_thread_yield()
+{
+	SwitchToThread();
+}
@@ -63,6 +63,8 @@ internal void update_clouds(Clouds & 			clouds,
 							CollisionSystem3D & collisionSystem,
 							f32 				elapsedTime)
 {
+	FS_PROFILE_FUNCTION();
+
 	v3 windDirection = quaternion_rotate_v3(quaternion_axis_angle(v3_up, clouds.windDirectionAngle), v3_forward);
 
 	// for (auto & cloud : clouds.clouds)
@@ -87,14 +89,13 @@ internal void update_clouds(Clouds & 			clouds,
 				s32 maxWaterDropsInRain = 1000;
 				Array<s32> selectedWaterDropIndices = push_array<s32>(*global_transientMemory, maxWaterDropsInRain, ALLOC_GARBAGE);
 
-				for (s32 waterIndex = 0; waterIndex < waters.count; ++waterIndex)
+				waters_query_disc(waters, cloud.transform.position.xy, cloud.radius, [&](s32 waterIndex)
 				{
-					f32 distanceToWaterDrop = v2_length(cloud.transform.position.xy - waters.positions[waterIndex].xy);
-					if (distanceToWaterDrop < cloud.radius && waters.levels[waterIndex] < 1)
+					if (waters.levels()[waterIndex] < 1)
 					{
 						selectedWaterDropIndices.push(waterIndex);
 					}
-				}
+				});
 
 				f32 area 					= π * cloud.radius * cloud.radius;
 				f32 totalWaterGrowthAmount 	= area * elapsedTime * clouds.rainWaterDropTotalGrowSpeedPerAreaPerSecond;
@@ -113,7 +114,7 @@ internal void update_clouds(Clouds & 			clouds,
 					v3 position 		= cloud.transform.position + localPosition;
 					position.z 			= get_terrain_height(collisionSystem, position.xy);
 
-					selectedWaterDropIndices.push(waters.count);
+					selectedWaterDropIndices.push(waters.data.count);
 
 					waters_instantiate(waters, position, 0);	
 				}
@@ -122,8 +123,8 @@ internal void update_clouds(Clouds & 			clouds,
 
 				for (s32 index : selectedWaterDropIndices)
 				{
-					waters.levels[index] += actualWaterDropGrowth;
-					waters.levels[index] = f32_min(waters.levels[index], waters.fullWaterLevel);
+					waters.levels()[index] += actualWaterDropGrowth;
+					waters.levels()[index] = f32_min(waters.levels()[index], waters.fullWaterLevel);
 				}
 			}
 
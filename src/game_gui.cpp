@@ -7,8 +7,190 @@ internal Gui init_game_gui(GameAssets & assets)
 }
 
 
+#if defined FS_PROFILER_ENABLED
+internal void profiler_editor_zones(Profiler * profiler, s32 parentIndex, s32 threadIndex)
+{
+	using namespace ImGui;
+
+	for (s32 i = 0; i < profiler->zoneCount; ++i)
+	{
+		ProfilerZoneStats & zone = profiler->zones[i];
+		if (zone.parentIndex != parentIndex || zone.threadIndex != threadIndex)
+		{
+			continue;
+		}
+
+		f32 totalMs = platform_time_elapsed_seconds(0, zone.totalTime) * 1000;
+		f32 selfMs 	= platform_time_elapsed_seconds(0, zone.selfTime) * 1000;
+
+		Text("%*s%s", zone.depth * 2, "", zone.name); 	NextColumn();
+		Text("%i", zone.callCount); 					NextColumn();
+		Text("%.3f", totalMs); 							NextColumn();
+		Text("%.3f", selfMs); 							NextColumn();
+
+		profiler_editor_zones(profiler, i, threadIndex);
+	}
+}
+
+internal void profiler_editor(Profiler * profiler)
+{
+	using namespace ImGui;
+
+	local_persist s32 traceFrameCount = 10;
+
+	Value("Frame ms", (f32)(platform_time_elapsed_seconds(0, profiler->frameTime) * 1000));
+	Value("Lost events", (s32)profiler->lostEventCount);
+
+	InputInt("Trace Frames", &traceFrameCount);
+	traceFrameCount = s32_max(1, traceFrameCount);
+
+	if (profiler_is_capturing_trace(profiler))
+	{
+		Text("Capturing trace...");
+	}
+	else if (Button("Capture Trace"))
+	{
+		profiler_capture_trace(profiler, traceFrameCount);
+	}
+
+	Spacing();
+
+	Columns(4, "profiler_zones");
+	Text("Zone"); 		NextColumn();
+	Text("Calls"); 		NextColumn();
+	Text("Total ms"); 	NextColumn();
+	Text("Self ms"); 	NextColumn();
+	Separator();
+
+	s32 threadCount = profiler->threadCount.load();
+	for (s32 threadIndex = 0; threadIndex < threadCount; ++threadIndex)
+	{
+		profiler_editor_zones(profiler, -1, threadIndex);
+	}
+
+	Columns(1);
+}
+#endif
+
+#if defined FS_MEMORY_INSTRUMENTATION_ENABLED
+internal void memory_instrumentation_editor(MemoryArena & arena)
+{
+	using namespace ImGui;
+
+	if (arena.instrumentation == nullptr)
+	{
+		Text("Arena is not instrumented");
+		return;
+	}
+
+	MemoryArenaInstrumentation & instrumentation 	= *arena.instrumentation;
+	MemoryCallsiteStats & total 					= instrumentation.total;
+
+	PushID(instrumentation.name);
+
+	Value("Used MB", reverse_megabytes(arena.used));
+	Value("Committed MB", reverse_megabytes(arena.committed));
+	Value("Frame high-water MB", reverse_megabytes(instrumentation.frameHighWaterMark));
+	Value("Peak high-water MB", reverse_megabytes(instrumentation.peakHighWaterMark));
+	Value("Peak frame", (s32)instrumentation.peakFrameIndex);
+
+	// Note(Leo): Oldest frame first
+	f32 frameHistoryMB [memory_instrumentation_frame_history];
+	for (s32 i = 0; i < memory_instrumentation_frame_history; ++i)
+	{
+		s64 frame 			= instrumentation.frameIndex + i;
+		frameHistoryMB[i] 	= reverse_megabytes(instrumentation.frameHistory[frame % memory_instrumentation_frame_history]);
+	}
+	PlotLines("High-water MB", frameHistoryMB, memory_instrumentation_frame_history, 0, nullptr, 0, highest_f32, ImVec2(0, 60));
+
+	Spacing();
+
+	Value("Allocations", (s32)total.count);
+	Value("Requested KB", reverse_kilobytes(total.requested));
+	Value("Padding KB", reverse_kilobytes(total.padding));
+	Value("Rounding KB", reverse_kilobytes(total.rounding));
+	Value("memory_align_up extra KB", reverse_kilobytes(total.alignUpExtra));
+
+	if (Button("Log Report"))
+	{
+		memory_instrumentation_log_report(arena, memory_instrumentation_callsite_capacity + 1);
+	}
+
+	Spacing();
+
+	local_persist MemoryCallsiteStats const * sorted [memory_instrumentation_callsite_capacity + 1];
+	s32 callsiteCount = memory_instrumentation_sort_callsites(instrumentation, sorted);
+
+	Columns(5, "memory_callsites");
+	Text("Callsite"); 		NextColumn();
+	Text("Peak KB"); 		NextColumn();
+	Text("Now KB"); 		NextColumn();
+	Text("Count"); 			NextColumn();
+	Text("Waste KB"); 		NextColumn();
+	Separator();
+
+	for (s32 i = 0; i < callsiteCount; ++i)
+	{
+		MemoryCallsiteStats const & stats = *sorted[i];
+
+		if (stats.file != nullptr)
+		{
+			Text("%s:%i", memory_instrumentation_file_name(stats.file), stats.line); 	NextColumn();
+		}
+		else
+		{
+			Text("<overflow>"); 														NextColumn();
+		}
+		Text("%.1f", reverse_kilobytes(stats.peakBytes)); 								NextColumn();
+		Text("%.1f", reverse_kilobytes(stats.bytes)); 									NextColumn();
+		Text("%lli", (long long)stats.count); 											NextColumn();
+		Text("%.1f", reverse_kilobytes(stats.padding + stats.alignUpExtra)); 			NextColumn();
+	}
+
+	Columns(1);
+
+	PopID();
+}
+#endif
+
+internal void frame_systems_editor(FrameSystemReport & report)
+{
+	using namespace ImGui;
+
+	Value("Wall ms", report.wallMs);
+	Value("Work ms", report.workMs);
+	Value("Critical path ms", report.criticalPathMs);
+	Value("Parallelism", report.criticalPathMs > 0 ? report.workMs / report.criticalPathMs : 0.0f);
+	Checkbox32("Log each frame", &report.logEachFrame);
+
+	Spacing();
+
+	Columns(5, "frame_systems");
+	Text("System"); 		NextColumn();
+	Text("Worker"); 		NextColumn();
+	Text("Dependencies"); 	NextColumn();
+	Text("Start ms"); 		NextColumn();
+	Text("Duration ms"); 	NextColumn();
+	Separator();
+
+	for (s32 i = 0; i < report.count; ++i)
+	{
+		FrameSystemReportEntry & entry = report.entries[i];
+
+		// Note(Leo): Systems on critical path are marked with '*'
+		Text("%s %s", entry.isOnCriticalPath ? "*" : " ", entry.name); 	NextColumn();
+		Text("%i", entry.workerIndex); 			NextColumn();
+		Text("%i", entry.dependencyCount); 		NextColumn();
+		Text("%.3f", entry.startMs); 			NextColumn();
+		Text("%.3f", entry.durationMs); 		NextColumn();
+	}
+
+	Columns(1);
+}
+
 bool32 do_gui(Game * game, PlatformInput * input)
 {	
+	FS_PROFILE_FUNCTION();
 
 	local_persist bool demoWindowVisible = false;
 
@@ -185,6 +367,34 @@ bool32 do_gui(Game * game, PlatformInput * input)
 			TreePop();
 		}
 
+		#if defined FS_PROFILER_ENABLED
+		if (TreeNodeEx("Profiler", ImGuiTreeNodeFlags_Framed))
+		{
+			profiler_editor(profiler_get());
+			TreePop();
+		}
+		#endif
+
+		#if defined FS_MEMORY_INSTRUMENTATION_ENABLED
+		if (TreeNodeEx("Persistent Arena", ImGuiTreeNodeFlags_Framed))
+		{
+			memory_instrumentation_editor(*game->persistentMemory);
+			TreePop();
+		}
+
+		if (TreeNodeEx("Transient Arena", ImGuiTreeNodeFlags_Framed))
+		{
+			memory_instrumentation_editor(*global_transientMemory);
+			TreePop();
+		}
+		#endif
+
+		if (TreeNodeEx("Frame Systems", ImGuiTreeNodeFlags_Framed))
+		{
+			frame_systems_editor(game->frameSystemReport);
+			TreePop();
+		}
+
 		if (TreeNodeEx("Mesh Generation", ImGuiTreeNodeFlags_Framed))
 		{
 
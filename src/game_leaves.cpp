@@ -6,21 +6,19 @@ Leaves
 
 struct Leaves
 {
-	s32 			capacity;
-	s32 			count;
-
 	v3 				position;
 	quaternion 		rotation;
 
 	s32 			colourIndex;
 
-	// Todo(Leo): maybe put these into a struct
-	v3 * 			localPositions;
-	quaternion * 	localRotations;
-	f32 * 			localScales;
+	// Note(Leo): Columns are local positions, local rotations, local scales, sway positions and sway axes
+	SoA<v3, quaternion, f32, f32, v3> data;
 
-	f32 * 			swayPositions;
-	v3 * 			swayAxes;
+	v3 * localPositions() 			{ return data.column<0>(); }
+	quaternion * localRotations() 	{ return data.column<1>(); }
+	f32 * localScales() 			{ return data.column<2>(); }
+	f32 * swayPositions() 			{ return data.column<3>(); }
+	v3 * swayAxes() 				{ return data.column<4>(); }
 
 	MaterialHandle	material;
 
@@ -29,39 +27,46 @@ struct Leaves
  
 internal void flush_leaves(Leaves & leaves)
 {
-	leaves.count = 0;
+	soa_flush(leaves.data);
 }
 
-internal Leaves make_leaves(MemoryArena & allocator, s32 capacity)
+/*
+Note(Leo): Leaves' memory is from pool, so that it can grow with tree, see soa_reserve. New leaves are
+zeroed. Returns false and leaves 'leaves' as it was if pool is out of budget.
+*/
+internal bool32 leaves_reserve(MemoryPool & pool, Leaves & leaves, s32 capacity)
 {
-	Leaves leaves 			= {};
-
-	leaves.capacity 		= capacity;
-	leaves.localPositions 	= push_memory<v3>(allocator, leaves.capacity, ALLOC_GARBAGE);
-	leaves.localRotations 	= push_memory<quaternion>(allocator, leaves.capacity, ALLOC_GARBAGE);
-	leaves.localScales 		= push_memory<f32>(allocator, leaves.capacity, ALLOC_GARBAGE);
-	leaves.swayPositions 	= push_memory<f32>(allocator, leaves.capacity, ALLOC_GARBAGE);
-	leaves.swayAxes 		= push_memory<v3>(allocator, leaves.capacity, ALLOC_GARBAGE);
+	return soa_reserve(pool, leaves.data, capacity);
+}
 
-	return leaves;
+internal void leaves_free(MemoryPool & pool, Leaves & leaves)
+{
+	soa_free(pool, leaves.data);
 }
 
-internal void leaves_update(Leaves & leaves, f32 elapsedTime,v2 leafScale = {1,1})
+// Note(Leo): 'allocator' must be flushed no earlier than leaves are drawn. This is called from jobs, so use worker scratch memory.
+internal void leaves_update(Leaves & leaves, MemoryArena & allocator, f32 elapsedTime, v2 leafScale = {1,1})
 {
+	s32 drawCount = leaves.data.count;
+
+	v3 const * localPositions 			= leaves.localPositions();
+	quaternion const * localRotations 	= leaves.localRotations();
+	f32 const * localScales 			= leaves.localScales();
+	f32 * swayPositions 				= leaves.swayPositions();
+	v3 const * swayAxes 				= leaves.swayAxes();
 
-	s32 drawCount = f32_min(leaves.capacity, leaves.count);
-	m44 * leafTransforms = push_memory<m44>(*global_transientMemory, drawCount, ALLOC_GARBAGE);
+	m44 * leafTransforms = push_memory<m44>(allocator, drawCount, ALLOC_GARBAGE);
 	for (s32 i = 0; i < drawCount; ++i)
 	{
-		v3 position 			= leaves.position + quaternion_rotate_v3(leaves.rotation, leaves.localPositions[i]);
+		v3 position 			= leaves.position + quaternion_rotate_v3(leaves.rotation, localPositions[i]);
 
 		constexpr f32 swayRange = 0.5;
-		leaves.swayPositions[i] = mod_f32(leaves.swayPositions[i] + elapsedTime, swayRange * 4);
-		f32 sway 				= mathfun_pingpong_f32(leaves.swayPositions[i], swayRange * 2) - swayRange;
-		quaternion rotation 	= quaternion_axis_angle(leaves.swayAxes[i], sway);
-		rotation 				= leaves.localRotations[i] * leaves.rotation * rotation;
+		swayPositions[i] 		= mod_f32(swayPositions[i] + elapsedTime, swayRange * 4);
+		f32 sway 				= mathfun_pingpong_f32(swayPositions[i], swayRange * 2) - swayRange;
+		quaternion rotation 	= quaternion_axis_angle(swayAxes[i], sway);
+		rotation 				= localRotations[i] * leaves.rotation * rotation;
 
-		v3 scale 	= make_uniform_v3(leaves.localScales[i]);
+		v3 scale 	= make_uniform_v3(localScales[i]);
 		scale.x 	*= leafScale.x;
 		scale.y 	*= leafScale.y;
 
@@ -72,6 +77,5 @@ internal void leaves_update(Leaves & leaves, f32 elapsedTime,v2 leafScale = {1,1
 
 internal void leaves_draw(Leaves & leaves, v3 colour = {})
 {
-	s32 drawCount = f32_min(leaves.capacity, leaves.count);
-	graphics_draw_leaves(platformGraphics, drawCount, leaves.transientRenderTransforms, leaves.colourIndex, colour, leaves.material);
+	graphics_draw_leaves(platformGraphics, leaves.data.count, leaves.transientRenderTransforms, leaves.colourIndex, colour, leaves.material);
 }
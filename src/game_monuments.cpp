@@ -21,6 +21,10 @@ struct Monuments
 	s32 			count;
 	Transform3D *	transforms;
 	Monument 		monuments[5];
+
+	// Note(Leo): Shared by all monuments. Ornaments on top are out of reach, so they have no collider.
+	TriangleMeshCollider baseCollider;
+	TriangleMeshCollider arcsCollider;
 };
 
 
@@ -66,6 +70,9 @@ internal Monuments init_monuments(MemoryArena & persistentMemory, GameAssets & a
 		monuments.transforms[i] = {position, rotation, {2,2,2}};
 	}
 
+	monuments.baseCollider = make_triangle_mesh_collider(persistentMemory, assets_get_mesh_asset_data(assets, MeshAssetId_monument_base, *global_transientMemory));
+	monuments.arcsCollider = make_triangle_mesh_collider(persistentMemory, assets_get_mesh_asset_data(assets, MeshAssetId_monument_arcs, *global_transientMemory));
+
 	memory_pop_checkpoint(*global_transientMemory, checkpoint);
 
 	return monuments;
@@ -73,33 +80,13 @@ internal Monuments init_monuments(MemoryArena & persistentMemory, GameAssets & a
 
 internal void monuments_submit_colliders(Monuments const & monuments, CollisionSystem3D & collisionSystem)
 {
-	local_persist Transform3D colliderTransforms [] =
-	{
-		Transform3D {{0, 0, -0.2356}, 	quaternion_identity,					{2, 2, 0.99}},
-		Transform3D {{0, 2, -0.07}, 	quaternion_axis_angle(v3_right, π/4), 	{1.75, 0.575, 0.575}},
-		Transform3D {{0, -2, -0.07}, 	quaternion_axis_angle(v3_right, π/4), 	{1.75, 0.575, 0.575}},
-		Transform3D {{2, 0, -0.07}, 	quaternion_axis_angle(v3_forward, π/4), {0.575, 1.75, 0.575}},
-		Transform3D {{-2, 0, -0.07}, 	quaternion_axis_angle(v3_forward, π/4), {0.575, 1.75, 0.575}},
-
-		Transform3D {{1.75, 1.86, 2}, 	quaternion_identity, {0.67, 0.56, 5}},
-		Transform3D {{-1.75, 1.86, 2}, 	quaternion_identity, {0.67, 0.56, 5}},
-		Transform3D {{1.75, -1.86, 2}, 	quaternion_identity, {0.67, 0.56, 5}},
-		Transform3D {{-1.75, -1.86, 2}, quaternion_identity, {0.67, 0.56, 5}},
-	};
-
 	for (s32 i = 0; i < monuments.count; ++i)
 	{
 		m44 transformMatrix = transform_matrix(monuments.transforms[i]);
-		m44 inverseMatrix 	= inverse_transform_matrix(monuments.transforms[i]);	
-
-		for (auto collider : colliderTransforms)
-		{
-			m44 colliderTransform 			= transform_matrix(collider);
-			m44 colliderInverseTransform 	= inverse_transform_matrix(collider);
 
-			collisionSystem.submittedBoxColliders.push({transformMatrix * colliderTransform,
-													colliderInverseTransform * inverseMatrix});
-		}
+		// Note(Leo): Monuments do not move, so after first frame these only compare transforms
+		submit_triangle_mesh_collider(collisionSystem, monuments.baseCollider, transformMatrix);
+		submit_triangle_mesh_collider(collisionSystem, monuments.arcsCollider, transformMatrix);
 	}	
 }
 
@@ -1,6 +1,8 @@
 
 internal void game_render(Game * game)
 {
+	FS_PROFILE_FUNCTION();
+
 	auto * graphics = platformGraphics;
 
 
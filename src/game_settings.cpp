@@ -45,8 +45,9 @@ internal void read_settings_file(SerializedPropertyList<Ts...> serializedObjects
 	}
 }
 
-template<typename ... Ts>
-internal void write_settings_file(PlatformFileHandle file, Game & game)
+// Note(Leo): Game is template parameter so lookup of its serialized objects waits until Game is complete
+template<typename TGame>
+internal void write_settings_file(PlatformFileHandle file, TGame & game)
 {
 	auto checkpoint = memory_push_checkpoint(*global_transientMemory);
 	s64 currentFilePosition = 0;
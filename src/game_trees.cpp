@@ -19,6 +19,19 @@ DONE:
 	- leaves from buds age separately from tree growth
 */
 
+/* Note(Leo): Trees are updated in phases, so that growing can run in parallel, and results do not
+depend on worker count or order:
+	1. trees_schedule_simulation, serial: decide how many fixed steps each tree simulates this frame
+	2. trees_take_water, serial in tree order: growing trees take water from Waters for those steps
+	3. update_tree_3, parallel: grow with taken water, using tree's own random stream
+	4. trees_spawn_fruit_trees, serial in tree order: spawn new trees from ripe fruits
+
+Trees are always simulated in fixed steps of 'tree_simulation_step', so results do not depend on frame
+rate. Each tree accumulates frame time, and near trees simulate all their whole steps every frame.
+Far trees and trees behind camera do that only every few frames, and under a per frame step budget,
+so they just catch up later in bigger batches of the same steps.
+*/
+
 // Todo(Leo): This is maybe stupid(as in unnecessary) that this is functor
 struct GetWaterFunc
 {
@@ -28,37 +41,18 @@ struct GetWaterFunc
 
 	f32 operator()(v3 position, f32 requestedAmount)
 	{
-		s32 closestIndex;
-		f32 closestDistance = highest_f32;
-
-		for (s32 i = 0; i < waters.count; ++i)
-		{
-			if (carriedItemIndex == i && waterIsCarried)
-			{
-				continue;
-			}
-
-			f32 distance = v3_length(waters.positions[i] - position);
-			if (distance < closestDistance)
-			{
-				closestDistance = distance;
-				closestIndex 	= i;
-			}
-		}
-
 		f32 amount 				= 0;
 		f32 distanceThreshold	= 2;
 
-		if (closestDistance < distanceThreshold)
+		s32 ignoredIndex = waterIsCarried ? carriedItemIndex : -1;
+		s32 nearestIndex = waters_find_nearest(waters, position, distanceThreshold, ignoredIndex);
+
+		if (nearestIndex >= 0)
 		{
-			waters.levels[closestIndex] -= requestedAmount;
-			if (waters.levels[closestIndex] < 0)
+			waters.levels()[nearestIndex] -= requestedAmount;
+			if (waters.levels()[nearestIndex] < 0)
 			{
-				memory_unordered_pop(waters.positions, closestIndex, waters.count);
-				memory_unordered_pop(waters.rotations, closestIndex, waters.count);
-				memory_unordered_pop(waters.levels, closestIndex, waters.count);
-
-				waters.count -= 1;
+				waters_unordered_remove(waters, nearestIndex);
 			}
 
 			amount = requestedAmount;
@@ -90,6 +84,14 @@ struct TreeBranch
 	s32 		budIndex;
 
 	bool32	dontGrowLength;
+
+	// Note(Leo): Nodes as they were when this branch's mesh was last built, see build_tree_3_mesh
+	TreeNode 	meshStartNode;
+	TreeNode 	meshEndNode;
+	bool32 		meshIsBuilt;
+	s32 		meshDetail;
+	s32 		meshVertexStart;
+	s32 		meshIndexStart;
 };
 
 struct TreeBud
@@ -137,6 +139,9 @@ struct TreeSettings
 	f32 waterUsageSpeed 		= 0.5;
 	f32 waterReservoirCapacity 	= 10;
 
+	// Note(Leo): Tree stops growing at this. Default is what fit into fixed size mesh that trees used to have.
+	s32 maxBranchCount 			= 99;
+
 
 	static constexpr auto serializedProperties = make_property_list
 	(	
@@ -162,12 +167,31 @@ struct TreeSettings
 		SERIALIZE(seedDrawSizeThreshold),
 		SERIALIZE(waterDrainSpeed),
 		SERIALIZE(waterUsageSpeed),
-		SERIALIZE(waterReservoirCapacity)
+		SERIALIZE(waterReservoirCapacity),
+		SERIALIZE(maxBranchCount)
 
 		#undef SERIALIZE
 	);
 };
 
+constexpr f32 tree_simulation_step 				= 1.0f / 30;
+constexpr s32 tree_max_simulation_steps_per_update 	= 32;
+
+enum TreeSimulationTier : s32
+{
+	TreeSimulationTier_near,
+	TreeSimulationTier_far,
+	TreeSimulationTier_distant,
+
+	TreeSimulationTierCount
+};
+
+// Note(Leo): Tree in a tier is simulated every nth frame. Trees are staggered by index, so that they do not all catch up on same frame.
+constexpr s32 tree_simulation_tier_cadences [TreeSimulationTierCount] = { 1, 4, 16 };
+
+// Note(Leo): Tree that is simulated every nth frame can take n times as many steps, so that it keeps up as well as near trees
+constexpr s32 tree_max_simulation_steps = tree_max_simulation_steps_per_update * tree_simulation_tier_cadences[TreeSimulationTierCount - 1];
+
 struct Tree
 {
 	Array<TreeNode> 	nodes;
@@ -176,12 +200,32 @@ struct Tree
 
 	Leaves 		leaves;
 	DynamicMesh mesh;
+	f32 		meshTangentScale;
+
+	// Note(Leo): One capsule for each branch, in same order and in tree's local space, see tree_3_update_collider
+	CapsuleTreeCollider collider;
+	s32 		meshRebuiltBranchCount;
+
+	// Note(Leo): Branches' mesh detail is chosen with this, see tree_3_update_mesh_lod
+	f32 		meshPixelsPerMeter = highest_f32;
+	static f32 	meshMaxPixelError;
 
 	MeshHandle 		seedMesh;
 	MaterialHandle 	seedMaterial;
 
 	f32 waterReservoir = 0;
 
+	// Note(Leo): Time not yet simulated, and steps to simulate this frame, see trees_schedule_simulation
+	f32 	simulationTime;
+	s32 	simulationStepCount;
+	s32 	simulationTier;
+
+	// Note(Leo): Set for each simulation step in trees_take_water
+	f32 	simulationWaterGrowthFactors [tree_max_simulation_steps];
+
+	// Note(Leo): Tree's own random stream, seeded from spawn data, so that trees can grow in parallel
+	RandomState random;
+
 	v3 			position;
 	quaternion 	rotation;
 
@@ -193,22 +237,40 @@ struct Tree
 
 	static bool32 globalEnabled;
 
+	// Note(Leo): Set when tree has 'maxBranchCount' branches or shared memory pool is out of budget
 	bool32 resourceLimitReached 	= false;
-	f32 resourceLimitThresholdValue = 0.8;
 
 	static constexpr f32 fruitMaturationTime = 5; 
 	bool32 	hasFruit;
 	f32 	fruitAge;
 	v3 		fruitPosition;
 
+	// Note(Leo): Set during parallel update, and new tree is spawned after that
+	bool32 	spawnFruitTree;
+	v3 		fruitTreeSpawnPosition;
+
 	s32 			typeIndex;
 	TreeSettings * settings;
 
 
+	// Note(Leo): All trees' arrays, leaves and mesh are from this shared pool, see tree_3_reserve
+	MemoryPool * memoryPool;
+
 	// Todo(Leo): I would like not to include this here, but we do need connection to falling system etc.
 	Game * game;
 };
 bool32 Tree::globalEnabled = true;
+f32 Tree::meshMaxPixelError = 0.5;
+
+// Note(Leo): Camera info for choosing trees' mesh detail, set each frame before trees are updated
+struct TreeMeshLodView
+{
+	bool32 	enabled;
+	v3 		cameraPosition;
+
+	// Note(Leo): Screen pixels covered by one meter at one meter away from camera
+	f32 	pixelsAtUnitDistance;
+};
 
 // Study(Leo): this would be fun?
 // struct Trees : public Array<Tree>
@@ -217,9 +279,154 @@ struct Trees
 	Array<Tree> 	array;
 	s32 			selectedIndex;
 	TreeSettings 	settings[2];	
+
+	MemoryPool 		memoryPool;
+
+	bool32 			meshLodEnabled = true;
+	TreeMeshLodView meshLodView;
+
+	// Note(Leo): Trees further than these are in far and distant tiers. Trees behind camera are at least far.
+	f32 			simulationTierDistances [TreeSimulationTierCount - 1] = {50, 200};
+
+	// Note(Leo): Steps per frame for trees that are not near, near trees are always simulated fully
+	s32 			simulationStepBudget = 300;
+	s32 			simulationCursor;
+	s64 			simulationFrameIndex;
+
+	// Note(Leo): Stats from last frame
+	s32 			simulationTreeCountPerTier [TreeSimulationTierCount];
+	s32 			simulationStepCount;
+	s32 			simulationPostponedCount;
 };
 
 
+// Note(Leo): Same as old fixed sizes for all trees, 200 trees times 0.8 MB
+constexpr u64 trees_default_memory_budget = megabytes(160);
+
+/*
+Note(Leo): Trees grow in parallel and share one pool, so pool is used one thread at a time. Memory is
+only allocated when arrays need to grow, and they double then, so this is rare.
+*/
+static std::atomic_flag global_treeMemoryLock = ATOMIC_FLAG_INIT;
+
+internal void tree_3_free_memory(Tree & tree)
+{
+	if (tree.memoryPool == nullptr)
+	{
+		return;
+	}
+
+	while(global_treeMemoryLock.test_and_set(std::memory_order_acquire))
+	{}
+
+	MemoryPool & pool = *tree.memoryPool;
+
+	array_free(pool, tree.nodes);
+	array_free(pool, tree.buds);
+	array_free(pool, tree.branches);
+	leaves_free(pool, tree.leaves);
+	dynamic_mesh_free(pool, tree.mesh);
+	capsule_tree_collider_free(pool, tree.collider);
+
+	global_treeMemoryLock.clear(std::memory_order_release);
+}
+
+/*
+Note(Leo): Makes room for this many more of each. References to tree's elements are not valid after
+this, so call this before taking them. If pool is out of budget, this sets 'resourceLimitReached' and
+returns false, and tree stops growing.
+*/
+internal bool32 tree_3_reserve(Tree & tree, s32 nodeCount, s32 budCount, s32 branchCount, s32 leafCount)
+{
+	bool32 hasRoom 	= tree.nodes.count + nodeCount <= tree.nodes.capacity
+					&& tree.buds.count + budCount <= tree.buds.capacity
+					&& tree.branches.count + branchCount <= tree.branches.capacity
+					&& tree.leaves.data.count + leafCount <= tree.leaves.data.capacity
+					&& capsule_tree_collider_has_room(tree.collider, branchCount);
+
+	if (hasRoom)
+	{
+		return true;
+	}
+
+	while(global_treeMemoryLock.test_and_set(std::memory_order_acquire))
+	{}
+
+	MemoryPool & pool = *tree.memoryPool;
+
+	bool32 success 	= array_reserve(pool, tree.nodes, tree.nodes.count + nodeCount)
+					&& array_reserve(pool, tree.buds, tree.buds.count + budCount)
+					&& array_reserve(pool, tree.branches, tree.branches.count + branchCount)
+					&& leaves_reserve(pool, tree.leaves, tree.leaves.data.count + leafCount)
+					&& capsule_tree_collider_reserve(pool, tree.collider, branchCount);
+
+	global_treeMemoryLock.clear(std::memory_order_release);
+
+	if (success == false)
+	{
+		tree.resourceLimitReached = true;
+		log_debug(FILE_ADDRESS, "tree memory pool is out of budget");
+	}
+
+	return success;
+}
+
+internal bool32 tree_3_reserve_mesh(Tree & tree, s64 vertexCount, s64 indexCount)
+{
+	if (vertexCount <= tree.mesh.vertices.capacity && indexCount <= tree.mesh.indices.capacity)
+	{
+		return true;
+	}
+
+	// Note(Leo): Indices are u16
+	if (vertexCount > 65536)
+	{
+		tree.resourceLimitReached = true;
+		log_debug(FILE_ADDRESS, "tree mesh has too many vertices for u16 indices");
+		return false;
+	}
+
+	while(global_treeMemoryLock.test_and_set(std::memory_order_acquire))
+	{}
+
+	bool32 success = dynamic_mesh_reserve(*tree.memoryPool, tree.mesh, vertexCount, indexCount);
+
+	global_treeMemoryLock.clear(std::memory_order_release);
+
+	if (success == false)
+	{
+		tree.resourceLimitReached = true;
+		log_debug(FILE_ADDRESS, "tree memory pool is out of budget");
+	}
+
+	return success;
+}
+
+/*
+Note(Leo): Start node is usually thicker, and capsule has only one radius, so capsule is as thick as
+start node all the way. It is little thicker than branch near its end, but that is good for climbing.
+*/
+internal CapsuleCollider tree_3_branch_capsule(Tree const & tree, TreeBranch const & branch)
+{
+	TreeNode const & startNode 	= tree.nodes[branch.startNodeIndex];
+	TreeNode const & endNode 	= tree.nodes[branch.endNodeIndex];
+
+	return {startNode.position, endNode.position, f32_max(startNode.radius, endNode.radius)};
+}
+
+/*
+Note(Leo): Growing moves only end nodes and makes nodes thicker, so capsules grow a little at a time,
+and collider's tree is only refit when one grows out of its fat box. This is called once after all of
+frame's growing steps.
+*/
+internal void tree_3_update_collider(Tree & tree)
+{
+	for (s32 branchIndex = 0; branchIndex < tree.branches.count; ++branchIndex)
+	{
+		capsule_tree_collider_set(tree.collider, branchIndex, tree_3_branch_capsule(tree, tree.branches[branchIndex]));
+	}
+}
+
 internal void tree_3_add_branch(Tree & tree, s64 parentBranchIndex, v3 position, quaternion rotation, f32 distanceFromParentStartNode)
 {
 	s32 newBranchIndex 				= tree.branches.count++;
@@ -250,11 +457,13 @@ internal void tree_3_add_branch(Tree & tree, s64 parentBranchIndex, v3 position,
 		.radius 	= nodeStartSize / 2,
 	};
 
+	s32 capsuleIndex = capsule_tree_collider_add(tree.collider, tree_3_branch_capsule(tree, newBranch));
+	Assert(capsuleIndex == newBranchIndex);
+
 	// Todo(Leo): reset new bud here
 	TreeBud & newBud 		= tree.buds[newBranch.budIndex];
 	newBud.hasLeaf	 		= true;
-	newBud.firstLeafIndex 	= tree.leaves.count;
-	tree.leaves.count 		+= tree.settings->leafCountPerBud;
+	newBud.firstLeafIndex 	= tree.leaves.data.append(tree.settings->leafCountPerBud);
 	newBud.age 				= 0;
 
 	newBud.distanceFromStartNode 	= 0;
@@ -265,33 +474,170 @@ internal void tree_3_add_branch(Tree & tree, s64 parentBranchIndex, v3 position,
 	// quaternion 	rotation;
 	// f32 		size;
 
-	tree.branches[parentBranchIndex].childBranchCount += 1;
+	// Note(Leo): Root branch has no parent
+	if (parentBranchIndex >= 0)
+	{
+		tree.branches[parentBranchIndex].childBranchCount += 1;
+	}
 }
 
-internal void grow_tree_3(Tree & tree, f32 elapsedTime, GetWaterFunc & get_water)
+internal bool32 tree_3_is_growing(Tree const & tree)
 {
-	elapsedTime *= tree.settings->growSpeedScale;
+	return Tree::globalEnabled && tree.planted && tree.enabled && !tree.resourceLimitReached;
+}
 
-	f32 waterCapacityAvailable 	= tree.settings->waterReservoirCapacity - tree.waterReservoir; 
-	f32 waterDrain 				= f32_min(waterCapacityAvailable, tree.settings->waterDrainSpeed * elapsedTime);
-	tree.waterReservoir 		+= get_water(tree.position, waterDrain);
-	
-	tree.waterReservoir         -= tree.settings->waterUsageSpeed * elapsedTime;
-	tree.waterReservoir 		= f32_clamp(tree.waterReservoir, 0, tree.settings->waterReservoirCapacity);
+internal bool32 tree_3_is_simulated(Tree const & tree)
+{
+	// Note(Leo): Trees that have stopped growing still ripen fruits
+	return tree_3_is_growing(tree) || (tree.resourceLimitReached && tree.enabled);
+}
 
+/*
+Note(Leo): Decides how many fixed steps each tree simulates this frame. Trees that are not updated
+this frame, or are over budget, keep accumulating time and simulate it later. Tree that does not fit
+to budget takes what is left of it, so that trees that want more steps than whole budget still move.
+
+Tree can take at most 'tree_max_simulation_steps_per_update' steps for each frame of its tier's
+cadence. If it falls behind more than that, like when frame rate or time scale is very high, extra
+time is dropped, so that backlog does not grow without bound.
+Trees that are not simulated at all, like seeds not planted yet, do not accumulate time, so that
+they do not jump when they are planted.
+*/
+internal void trees_schedule_simulation(Trees & trees, f32 elapsedTime, v3 cameraPosition, v3 cameraDirection)
+{
+	s64 frameIndex 			= trees.simulationFrameIndex++;
+	s32 budgetLeft 			= trees.simulationStepBudget;
+	s32 firstPostponedIndex = -1;
+
+	trees.simulationStepCount 		= 0;
+	trees.simulationPostponedCount 	= 0;
+
+	for (s32 tier = 0; tier < TreeSimulationTierCount; ++tier)
+	{
+		trees.simulationTreeCountPerTier[tier] = 0;
+	}
 
-	f32 waterGrowthFactor;
+	s32 treeCount = trees.array.count;
+	for (s32 i = 0; i < treeCount; ++i)
 	{
-		waterGrowthFactor = f32_clamp(tree.waterReservoir / tree.settings->waterReservoirCapacity, 0, 1);
-		waterGrowthFactor = pow_f32(waterGrowthFactor, 0.5);
-		// waterGrowthFactor = waterGrowthFactor * waterGrowthFactor;
-		// waterGrowthFactor *= -1;
-		// waterGrowthFactor += 1;
+		// Note(Leo): Start from where budget ran out last frame, so that every tree gets its turn
+		s32 treeIndex 	= (trees.simulationCursor + i) % treeCount;
+		Tree & tree 	= trees.array[treeIndex];
+
+		tree.simulationStepCount = 0;
+
+		if (tree_3_is_simulated(tree) == false)
+		{
+			tree.simulationTime = 0;
+			continue;
+		}
+
+		tree.simulationTime += elapsedTime;
+
+		v3 toTree 		= tree.position - cameraPosition;
+		f32 distance 	= v3_length(toTree);
+		bool32 isBehind = v3_dot(toTree, cameraDirection) < 0;
+
+		s32 tier = TreeSimulationTier_near;
+		while(tier < TreeSimulationTierCount - 1 && distance > trees.simulationTierDistances[tier])
+		{
+			tier += 1;
+		}
+
+		if (isBehind && tier == TreeSimulationTier_near && distance > trees.simulationTierDistances[0] * 0.5f)
+		{
+			tier = TreeSimulationTier_far;
+		}
+
+		tree.simulationTier = tier;
+		trees.simulationTreeCountPerTier[tier] += 1;
+
+		bool32 isDue = ((frameIndex + treeIndex) % tree_simulation_tier_cadences[tier]) == 0;
+		if (isDue == false)
+		{
+			continue;
+		}
+
+		s32 maxStepCount 	= tree_max_simulation_steps_per_update * tree_simulation_tier_cadences[tier];
+		f32 maxTime 		= maxStepCount * tree_simulation_step;
+		tree.simulationTime = f32_min(tree.simulationTime, maxTime);
+
+		s32 stepCount = s32_min((s32)(tree.simulationTime / tree_simulation_step), maxStepCount);
+
+		if (tier != TreeSimulationTier_near)
+		{
+			if (stepCount > budgetLeft)
+			{
+				trees.simulationPostponedCount += 1;
+				if (firstPostponedIndex < 0)
+				{
+					firstPostponedIndex = treeIndex;
+				}
+				stepCount = budgetLeft;
+			}
+
+			budgetLeft -= stepCount;
+		}
+
+		tree.simulationStepCount 	= stepCount;
+		tree.simulationTime 		-= stepCount * tree_simulation_step;
+		trees.simulationStepCount 	+= stepCount;
 	}
 
+	if (firstPostponedIndex >= 0)
+	{
+		trees.simulationCursor = firstPostponedIndex;
+	}
+}
+
+/*
+Note(Leo): Takes water for each scheduled step, and computes what water reservoir will be on each step,
+so that growing does not need to touch Waters. Call trees_schedule_simulation before this.
+*/
+internal void trees_take_water(Trees & trees, GetWaterFunc & get_water)
+{
+	for (auto & tree : trees.array)
+	{
+		if (tree_3_is_growing(tree) == false)
+		{
+			continue;
+		}
+
+		for (s32 step = 0; step < tree.simulationStepCount; ++step)
+		{
+			f32 growTime 				= tree_simulation_step * tree.settings->growSpeedScale;
+			f32 waterCapacityAvailable 	= tree.settings->waterReservoirCapacity - tree.waterReservoir; 
+			f32 waterDrain 				= f32_min(waterCapacityAvailable, tree.settings->waterDrainSpeed * growTime);
+			f32 waterTaken 				= get_water(tree.position, waterDrain);
+
+			tree.waterReservoir 		+= waterTaken;
+			tree.waterReservoir         -= tree.settings->waterUsageSpeed * growTime;
+			tree.waterReservoir 		= f32_clamp(tree.waterReservoir, 0, tree.settings->waterReservoirCapacity);
+
+			f32 waterGrowthFactor 		= f32_clamp(tree.waterReservoir / tree.settings->waterReservoirCapacity, 0, 1);
+			waterGrowthFactor 			= pow_f32(waterGrowthFactor, 0.5);
+
+			tree.simulationWaterGrowthFactors[step] = waterGrowthFactor;
+		}
+	}
+}
+
+// Note(Leo): Only touches this tree, so this can be called in parallel for different trees
+internal void grow_tree_3(Tree & tree, f32 elapsedTime, f32 waterGrowthFactor)
+{
+	elapsedTime *= tree.settings->growSpeedScale;
+
+	s32 leafCountPerBud = tree.settings->leafCountPerBud;
+
 	s32 branchCountBefore = tree.branches.count;
 	for (s32 branchIndex = 0; branchIndex < branchCountBefore; ++branchIndex)
 	{
+		// Note(Leo): Room for at most 3 new apex branches, which is most that one branch can add
+		if (tree_3_reserve(tree, 6, 3, 3, 3 * leafCountPerBud) == false)
+		{
+			return;
+		}
+
 		TreeBranch & branch 	= tree.branches[branchIndex];
 
 		TreeNode & startNode 	= tree.nodes[branch.startNodeIndex];
@@ -347,18 +693,15 @@ internal void grow_tree_3(Tree & tree, f32 elapsedTime, GetWaterFunc & get_water
 			if (ratioToNextBud < 0)
 			{
 				// Note(Leo): this is inverted..
-				if (random_value() > tree.settings->apexBranchingProbability)
+				if (random_value(tree.random) > tree.settings->apexBranchingProbability)
 				{
-					Assert(tree.buds.has_room_for(1));
-
-					f32 budIntervalRandom 	= 1 + random_range(-tree.settings->budIntervalRandomness, tree.settings->budIntervalRandomness);
+					f32 budIntervalRandom 	= 1 + random_range(tree.random, -tree.settings->budIntervalRandomness, tree.settings->budIntervalRandomness);
 					branch.nextBudPosition 	= distanceFromStart + tree.settings->budInterval * budIntervalRandom;
 
 					branch.budIndex = tree.buds.count++;
 
 					tree.buds[branch.budIndex].hasLeaf 			= true;
-					tree.buds[branch.budIndex].firstLeafIndex 	= tree.leaves.count;
-					tree.leaves.count 							+= tree.settings->leafCountPerBud;
+					tree.buds[branch.budIndex].firstLeafIndex 	= tree.leaves.data.append(tree.settings->leafCountPerBud);
 
 					tree.buds[branch.budIndex].age 				= 0;
 
@@ -369,20 +712,16 @@ internal void grow_tree_3(Tree & tree, f32 elapsedTime, GetWaterFunc & get_water
 					tree.buds[branch.budIndex].size 					= 1;
 
 					v3 branchDirection 		= quaternion_rotate_v3(endNode.rotation, v3_up);
-					f32 axisRotationAngle 	= tree.settings->budAngle + random_range(-tree.settings->budAngleRandomness, tree.settings->budAngleRandomness);
+					f32 axisRotationAngle 	= tree.settings->budAngle + random_range(tree.random, -tree.settings->budAngleRandomness, tree.settings->budAngleRandomness);
 					branch.nextBudRotation 	= branch.nextBudRotation * quaternion_axis_angle(branchDirection, axisRotationAngle);
 				}
 				else
 				{
-					s32 newApexBranchesCount = (random_value() < 0.6) ? 2 : 3;
-
-					Assert(tree.branches.has_room_for(newApexBranchesCount));
-					Assert(tree.buds.has_room_for(newApexBranchesCount));
-					Assert(tree.nodes.has_room_for(newApexBranchesCount * 2));
+					s32 newApexBranchesCount = (random_value(tree.random) < 0.6) ? 2 : 3;
 
 					for(s32 newBranchIndex = 0; newBranchIndex < newApexBranchesCount; ++newBranchIndex)
 					{
-						f32 angle 			= newBranchIndex * 2 * π / newApexBranchesCount * (1 + random_range(-0.15, 0.15));
+						f32 angle 			= newBranchIndex * 2 * π / newApexBranchesCount * (1 + random_range(tree.random, -0.15, 0.15));
 						v3 direction 		= quaternion_rotate_v3(branch.nextBudRotation, v3_up);
 						quaternion rotation = branch.nextBudRotation * quaternion_axis_angle(direction, angle);
 						// quaternion rotation = endNode.rotation * quaternion_axis_angle(quaternion_rotate_v3(endNode.rotation, v3_up), angle);
@@ -409,6 +748,11 @@ internal void grow_tree_3(Tree & tree, f32 elapsedTime, GetWaterFunc & get_water
 
 	for (s32 i = 0; i < tree.buds.count; ++i)
 	{
+		if (tree_3_reserve(tree, 2, 1, 1, leafCountPerBud) == false)
+		{
+			return;
+		}
+
 		TreeBud & bud = tree.buds[i];
 
 		bud.age += elapsedTime;
@@ -424,20 +768,16 @@ internal void grow_tree_3(Tree & tree, f32 elapsedTime, GetWaterFunc & get_water
 
 				for(s32 leafIndex = 0; leafIndex < tree.settings->leafCountPerBud; ++leafIndex)
 				{
-					tree.leaves.localPositions[leafIndex + bud.firstLeafIndex] 	= {};
-					tree.leaves.localRotations[leafIndex + bud.firstLeafIndex] 	= {};
-					tree.leaves.localScales[leafIndex + bud.firstLeafIndex] 	= 0;
-					tree.leaves.swayAxes[leafIndex + bud.firstLeafIndex] 		= {};
+					tree.leaves.localPositions()[leafIndex + bud.firstLeafIndex] 	= {};
+					tree.leaves.localRotations()[leafIndex + bud.firstLeafIndex] 	= {};
+					tree.leaves.localScales()[leafIndex + bud.firstLeafIndex] 		= 0;
+					tree.leaves.swayAxes()[leafIndex + bud.firstLeafIndex] 			= {};
 				}
 			}
 
 			v3 axis 			= quaternion_rotate_v3(bud.rotation, v3_forward);
 			quaternion rotation = bud.rotation * quaternion_axis_angle(axis, 0.25 * π);
 
-			Assert(tree.nodes.has_room_for(2));
-			Assert(tree.branches.has_room_for(1));
-			Assert(tree.buds.has_room_for(1));
-
 			tree_3_add_branch(tree, bud.parentBranchIndex, bud.position, rotation, bud.distanceFromStartNode);
 		}
 
@@ -446,65 +786,142 @@ internal void grow_tree_3(Tree & tree, f32 elapsedTime, GetWaterFunc & get_water
 			for(s32 leafIndex = 0; leafIndex < tree.settings->leafCountPerBud; ++leafIndex)
 			{
 				s32 l = leafIndex + bud.firstLeafIndex;
-				tree.leaves.localPositions[l] 	= bud.position;
+				tree.leaves.localPositions()[l] 	= bud.position;
 
-				f32 angle 						= leafIndex * 2 * π / tree.settings->leafCountPerBud;
-				quaternion rotation 			= bud.rotation * quaternion_axis_angle(quaternion_rotate_v3(bud.rotation, v3_up), angle);
-				tree.leaves.localRotations[l] 	= rotation;
+				f32 angle 							= leafIndex * 2 * π / tree.settings->leafCountPerBud;
+				quaternion rotation 				= bud.rotation * quaternion_axis_angle(quaternion_rotate_v3(bud.rotation, v3_up), angle);
+				tree.leaves.localRotations()[l] 	= rotation;
 
-				tree.leaves.localScales[l] 		= f32_clamp(bud.age / tree.settings->leafMaturationTime, 0, 1) * bud.size;
-				tree.leaves.swayAxes[l] 		= quaternion_rotate_v3(rotation, v3_forward);
+				tree.leaves.localScales()[l] 		= f32_clamp(bud.age / tree.settings->leafMaturationTime, 0, 1) * bud.size;
+				tree.leaves.swayAxes()[l] 			= quaternion_rotate_v3(rotation, v3_forward);
 			}
 		}
 	}
 
-	if (	used_percent(tree.nodes) > tree.resourceLimitThresholdValue
-		or 	used_percent(tree.buds) > tree.resourceLimitThresholdValue
-		or 	used_percent(tree.branches) > tree.resourceLimitThresholdValue)
+	if (tree.branches.count >= tree.settings->maxBranchCount)
 	{
 		tree.resourceLimitReached = true;
 		log_debug(FILE_ADDRESS, "tree resource limit reached");
 	}
 }
 
-internal void build_tree_3_mesh(Tree & tree)
+/*
+Note(Leo): Each branch has its own range in tree's mesh, in the same order as branches. Branch sections
+do not share vertices, so a branch can be rebuilt in place without touching others. Branch is only
+rebuilt when its start or end node has changed enough from when it was last built, or when its range
+moves because an earlier branch changed detail level.
+
+Detail level of each branch is chosen so that the error from using fewer ring vertices stays below
+'maxPixelError' on screen, ie. the coarser level's polygon is at most that far inside the round
+branch. Thin twigs on far trees end up with triangular rings, and twigs thinner than that on screen
+are not built at all. Levels only change where the difference is below that error, so they do not pop.
+*/
+enum TreeMeshDetail : s32
 {
-	DynamicMesh & mesh 	= tree.mesh;
-	Leaves & leaves 	= tree.leaves;
+	TreeMeshDetail_full,
+	TreeMeshDetail_reduced,
+	TreeMeshDetail_low,
+	TreeMeshDetail_none,
 
-	flush_dynamic_mesh(mesh);
+	TreeMeshDetailCount
+};
 
-	/*
-	DONE:
-	number of vertices in a loop to variable,
-		->later make it depend on size of node and somehow combine where it changes
-	interpolate positions
-	interpolate with bezier curves by fixed t-values
+struct TreeMeshTessellation
+{
+	s32 verticesInLoop;
+	s32 loopsInNodeSection;
+	s32 bottomDomeLoops;
+	s32 topDomeLoops;
+};
 
-	TODO:
-	platform graphics based dynamic mesh, so no need to copy each frame
-	*/
+// Note(Leo): Full detail is what all branches always used before. Bottom dome must have at least one loop.
+constexpr TreeMeshTessellation tree_mesh_tessellations [] =
+{
+	{6, 4, 2, 3},
+	{4, 2, 1, 1},
+	{3, 1, 1, 0},
+	{0, 0, 0, 0},
+};
+static_assert(array_count(tree_mesh_tessellations) == TreeMeshDetailCount);
 
+constexpr s32 tree_mesh_max_vertices_in_loop = 6;
 
-	// Todo(Leo): make these dynamic based on radius of branch
-	constexpr s32 verticesInLoop = 6;
-	s32 vertexLoopsInNodeSection = 4;
-	f32 loopTStep = 1.0f / vertexLoopsInNodeSection;
-	s32 bottomSphereLoops 	= 2;
+internal s32 tree_mesh_vertex_count(TreeMeshDetail detail)
+{
+	if (detail == TreeMeshDetail_none)
+	{
+		return 0;
+	}
+
+	TreeMeshTessellation t = tree_mesh_tessellations[detail];
+	return 1 + (t.bottomDomeLoops + t.loopsInNodeSection + t.topDomeLoops) * t.verticesInLoop + 1;
+}
 
-	local_persist v3 baseVertexPositions[verticesInLoop] = {};
-	local_persist bool32 arraysInitialized = false;
-	if (arraysInitialized == false)
+internal s32 tree_mesh_index_count(TreeMeshDetail detail)
+{
+	if (detail == TreeMeshDetail_none)
 	{
-		arraysInitialized = true;
-		f32 angleStep = 2 * π / verticesInLoop;
+		return 0;
+	}
 
-		for (s32 i = 0; i < verticesInLoop; ++i)
-		{
-			baseVertexPositions[i].xy 	= rotate_v2({1 ,0}, i * angleStep);
-		}
+	TreeMeshTessellation t = tree_mesh_tessellations[detail];
+	return 	t.verticesInLoop * 3
+			+ (t.bottomDomeLoops - 1 + t.loopsInNodeSection + t.topDomeLoops) * t.verticesInLoop * 6
+			+ t.verticesInLoop * 3;
+}
+
+// Note(Leo): Changes smaller than these are not visible enough to rebuild branch
+constexpr f32 tree_mesh_rebuild_distance 		= 0.002;
+constexpr f32 tree_mesh_rebuild_radius_ratio 	= 0.01;
+
+// Note(Leo): Tree's detail scale is only changed when camera has moved this much relatively, so that
+// branches do not change detail level every frame when camera moves
+constexpr f32 tree_mesh_lod_hysteresis = 1.25;
+
+internal bool32 tree_3_node_changed(TreeNode const & built, TreeNode const & current)
+{
+	bool32 moved 			= v3_length(current.position - built.position) > tree_mesh_rebuild_distance;
+	bool32 radiusChanged 	= abs_f32(current.radius - built.radius) > built.radius * tree_mesh_rebuild_radius_ratio;
+	bool32 rotated 			= current.rotation.x != built.rotation.x
+							|| current.rotation.y != built.rotation.y
+							|| current.rotation.z != built.rotation.z
+							|| current.rotation.w != built.rotation.w;
+
+	return moved || radiusChanged || rotated;
+}
+
+internal void build_tree_3_branch_mesh(Tree & tree, s32 branchIndex, TreeMeshDetail detail, s32 vertexStart, s32 indexStart, v3 const * baseVertexPositions)
+{
+	DynamicMesh & mesh 	= tree.mesh;
+	TreeBranch & branch = tree.branches[branchIndex];
+
+	TreeNode const & startNode 	= tree.nodes[branch.startNodeIndex];
+	TreeNode const & endNode 	= tree.nodes[branch.endNodeIndex];
+
+	branch.meshStartNode 	= startNode;
+	branch.meshEndNode 		= endNode;
+	branch.meshDetail 		= detail;
+	branch.meshVertexStart 	= vertexStart;
+	branch.meshIndexStart 	= indexStart;
+	branch.meshIsBuilt 		= true;
+
+	if (detail == TreeMeshDetail_none)
+	{
+		return;
 	}
 
+	TreeMeshTessellation tessellation = tree_mesh_tessellations[detail];
+
+	s32 verticesInLoop 				= tessellation.verticesInLoop;
+	s32 vertexLoopsInNodeSection 	= tessellation.loopsInNodeSection;
+	s32 bottomSphereLoops 			= tessellation.bottomDomeLoops;
+	s32 topDomeLoops 				= tessellation.topDomeLoops;
+
+	f32 loopTStep = 1.0f / vertexLoopsInNodeSection;
+
+	// Note(Leo): These work like mesh.vertices.count and mesh.indices.count did when whole mesh was built at once
+	s32 vertexCount = vertexStart;
+	s32 indexCount 	= indexStart;
 
 	/* DOCUMENT (Leo):
 	1. generate first vertices outside of the loop
@@ -515,237 +932,353 @@ internal void build_tree_3_mesh(Tree & tree)
 
 	*/
 
-	for (s32 branchIndex = 0; branchIndex < tree.branches.count; ++branchIndex)
-	// for (s32 branchIndex = 0; branchIndex < 1; ++branchIndex)
+	/// BOTTOM DOME
 	{
-		TreeNode const & startNode = tree.nodes[tree.branches[branchIndex].startNodeIndex];
-		TreeNode const & endNode 	= tree.nodes[tree.branches[branchIndex].endNodeIndex];
+		v3 nodePosition 		= startNode.position;
+		quaternion nodeRotation = startNode.rotation;
+		f32 radius 				= startNode.radius;
 
-		/// BOTTOM DOME
-		{
-			Assert(mesh.vertices.has_room_for(bottomSphereLoops * verticesInLoop + 1));
-			Assert(mesh.indices.has_room_for((2 * bottomSphereLoops * verticesInLoop - 1) * 3));
+		v3 downDirection 		= quaternion_rotate_v3(nodeRotation, -v3_up);
 
-			v3 nodePosition 		= startNode.position;
-			quaternion nodeRotation = startNode.rotation;
-			f32 radius 				= startNode.radius;
+		s32 bottomVertexIndex = vertexCount++;
+		mesh.vertices[bottomVertexIndex] = { .position = nodePosition + downDirection * radius };
 
-			v3 downDirection 		= quaternion_rotate_v3(nodeRotation, -v3_up);
+		f32 fullAngle 			= 0.5f * π;
+		f32 angleStep 			= fullAngle / bottomSphereLoops;
 
-			s32 bottomVertexIndex = mesh.vertices.count++;
-			mesh.vertices[bottomVertexIndex] = { .position = nodePosition + downDirection * radius };
+		for (s32 loopIndex = 0; loopIndex < bottomSphereLoops; ++loopIndex)
+		{
+			f32 angle 	= fullAngle - (loopIndex + 1) * angleStep;
+			f32 sin 	= sine(angle);
+			f32 cos 	= f32_cos(angle);
 
-			f32 fullAngle 			= 0.5f * π;
-			f32 angleStep 			= fullAngle / bottomSphereLoops;
+			s32 verticesStartCount = vertexCount;
 
-			for (s32 loopIndex = 0; loopIndex < bottomSphereLoops; ++loopIndex)
+			for (s32 i = 0; i < verticesInLoop; ++i)
 			{
-				f32 angle 	= fullAngle - (loopIndex + 1) * angleStep;
-				f32 sin 	= sine(angle);
-				f32 cos 	= f32_cos(angle);
-
-				s32 verticesStartCount = mesh.vertices.count;
-
-				for (s32 i = 0; i < verticesInLoop; ++i)
-				{
-					v3 pos = quaternion_rotate_v3(nodeRotation, baseVertexPositions[i]) * radius * cos;
-					mesh.vertices[mesh.vertices.count++] = {.position = pos + nodePosition + downDirection * sin * radius};
-				}
+				v3 pos = quaternion_rotate_v3(nodeRotation, baseVertexPositions[i]) * radius * cos;
+				mesh.vertices[vertexCount++] = {.position = pos + nodePosition + downDirection * sin * radius};
+			}
 
-				if (loopIndex == 0)
+			if (loopIndex == 0)
+			{
+				for(s32 i = 0; i < verticesInLoop; ++i)
 				{
-					for(s32 i = 0; i < verticesInLoop; ++i)
-					{
-						mesh.indices[mesh.indices.count++] = bottomVertexIndex;
-						mesh.indices[mesh.indices.count++] = verticesStartCount + ((i + 1) % verticesInLoop);
-						mesh.indices[mesh.indices.count++] = verticesStartCount + i;
-					}
+					mesh.indices[indexCount++] = bottomVertexIndex;
+					mesh.indices[indexCount++] = verticesStartCount + ((i + 1) % verticesInLoop);
+					mesh.indices[indexCount++] = verticesStartCount + i;
 				}
-				else
+			}
+			else
+			{
+				for (s32 i = 0; i < verticesInLoop; ++i)
 				{
-					for (s32 i = 0; i < verticesInLoop; ++i)
-					{
-						mesh.indices[mesh.indices.count++] = i + verticesStartCount - verticesInLoop;
-						mesh.indices[mesh.indices.count++] = ((i + 1) % verticesInLoop) + verticesStartCount - verticesInLoop;
-						mesh.indices[mesh.indices.count++] = i + verticesStartCount;
+					mesh.indices[indexCount++] = i + verticesStartCount - verticesInLoop;
+					mesh.indices[indexCount++] = ((i + 1) % verticesInLoop) + verticesStartCount - verticesInLoop;
+					mesh.indices[indexCount++] = i + verticesStartCount;
 
-						mesh.indices[mesh.indices.count++] = i + verticesStartCount;
-						mesh.indices[mesh.indices.count++] = ((i + 1) % verticesInLoop) + verticesStartCount - verticesInLoop;
-						mesh.indices[mesh.indices.count++] = ((i + 1) % verticesInLoop) + verticesStartCount;
-					}
+					mesh.indices[indexCount++] = i + verticesStartCount;
+					mesh.indices[indexCount++] = ((i + 1) % verticesInLoop) + verticesStartCount - verticesInLoop;
+					mesh.indices[indexCount++] = ((i + 1) % verticesInLoop) + verticesStartCount;
 				}
 			}
 		}
+	}
 
+	{
+		// Todo(Leo): expose in tree editor once we have that
+		// Note(Leo): this can be tweaked for artistic purposes
+		f32 tangentScale 			= tree.settings->tangentScale;
+
+		f32 maxTangentLength 		= v3_length(startNode.position - endNode.position) / 3;
+		f32 previousTangentLength 	= f32_min(maxTangentLength, startNode.radius * tangentScale);
+		f32 nextTangentLength 		= f32_min(maxTangentLength, endNode.radius * tangentScale);
+
+		v3 bezier0 = startNode.position;
+		v3 bezier1 = startNode.position + previousTangentLength * quaternion_rotate_v3(startNode.rotation, v3_up);
+		v3 bezier2 = endNode.position - nextTangentLength * quaternion_rotate_v3(endNode.rotation, v3_up);
+		v3 bezier3 = endNode.position;
+
+		auto bezier_lerp_v3 = [&](f32 t) -> v3
 		{
-			// Todo(Leo): expose in tree editor once we have that
-			// Note(Leo): this can be tweaked for artistic purposes
-			f32 tangentScale 			= tree.settings->tangentScale;
+			v3 b01 = v3_lerp(bezier0, bezier1, t);
+			v3 b12 = v3_lerp(bezier1, bezier2, t);
+			v3 b23 = v3_lerp(bezier2, bezier3, t);
 
-			f32 maxTangentLength 		= v3_length(startNode.position - endNode.position) / 3;
-			f32 previousTangentLength 	= f32_min(maxTangentLength, startNode.radius * tangentScale);
-			f32 nextTangentLength 		= f32_min(maxTangentLength, endNode.radius * tangentScale);
+			v3 b012 = v3_lerp(b01, b12, t);
+			v3 b123 = v3_lerp(b12, b23, t);
 
-			v3 bezier0 = startNode.position;
-			v3 bezier1 = startNode.position + previousTangentLength * quaternion_rotate_v3(startNode.rotation, v3_up);
-			v3 bezier2 = endNode.position - nextTangentLength * quaternion_rotate_v3(endNode.rotation, v3_up);
-			v3 bezier3 = endNode.position;
+			v3 b0123 = v3_lerp(b012, b123, t);
 
-			auto bezier_lerp_v3 = [&](f32 t) -> v3
-			{
-				v3 b01 = v3_lerp(bezier0, bezier1, t);
-				v3 b12 = v3_lerp(bezier1, bezier2, t);
-				v3 b23 = v3_lerp(bezier2, bezier3, t);
+			return b0123;
+		};
 
-				v3 b012 = v3_lerp(b01, b12, t);
-				v3 b123 = v3_lerp(b12, b23, t);
+		for (s32 loopIndex = 0; loopIndex < vertexLoopsInNodeSection; ++loopIndex)
+		{
+			f32 t 				= (loopIndex + 1) * loopTStep;
+			v3 position 		= bezier_lerp_v3(t);
+			f32 radius 			= f32_lerp(startNode.radius, endNode.radius, t);
 
-				v3 b0123 = v3_lerp(b012, b123, t);
+			// Todo(Leo): maybe bezier slerp this too, but let's not bother with that right now
+			quaternion rotation = quaternion_slerp(startNode.rotation, endNode.rotation, t);
 
-				return b0123;
-			};
+			s32 verticesStartCount = vertexCount;
 
-			Assert(mesh.vertices.has_room_for(vertexLoopsInNodeSection * verticesInLoop));
-			Assert(mesh.indices.has_room_for(vertexLoopsInNodeSection * verticesInLoop * 6));
+			for (s32 i = 0; i < verticesInLoop; ++i)
+			{
+				v3 vertexPosition = quaternion_rotate_v3(rotation, baseVertexPositions[i] * radius) + position;
+				mesh.vertices[vertexCount++] = {.position = vertexPosition};
+			}
 
-			for (s32 loopIndex = 0; loopIndex < vertexLoopsInNodeSection; ++loopIndex)
+			for (s32 i = 0; i < verticesInLoop; ++i)
 			{
-				f32 t 				= (loopIndex + 1) * loopTStep;
-				v3 position 		= bezier_lerp_v3(t);
-				f32 radius 			= f32_lerp(startNode.radius, endNode.radius, t);
+				mesh.indices[indexCount++] = ((i + 0) % verticesInLoop) + verticesStartCount - verticesInLoop; 
+				mesh.indices[indexCount++] = ((i + 1) % verticesInLoop) + verticesStartCount - verticesInLoop; 
+				mesh.indices[indexCount++] = ((i + 0) % verticesInLoop) + verticesStartCount; 
 
-				// Todo(Leo): maybe bezier slerp this too, but let's not bother with that right now
-				quaternion rotation = quaternion_slerp(startNode.rotation, endNode.rotation, t);
+				mesh.indices[indexCount++] = ((i + 0) % verticesInLoop) + verticesStartCount; 
+				mesh.indices[indexCount++] = ((i + 1) % verticesInLoop) + verticesStartCount - verticesInLoop; 
+				mesh.indices[indexCount++] = ((i + 1) % verticesInLoop) + verticesStartCount; 
+			}
+		}
 
-				s32 verticesStartCount = mesh.vertices.count;
+	}
 
-				for (s32 i = 0; i < verticesInLoop; ++i)
-				{
-					v3 vertexPosition = quaternion_rotate_v3(rotation, baseVertexPositions[i] * radius) + position;
-					mesh.vertices[mesh.vertices.count++] = {.position = vertexPosition};
-				}
+	/// TOP DOME
+	{
+		v3 position 		= endNode.position;
+		quaternion rotation = endNode.rotation;
+		f32 radius 			= endNode.radius;
 
-				for (s32 i = 0; i < verticesInLoop; ++i)
-				{
-					mesh.indices[mesh.indices.count++] = ((i + 0) % verticesInLoop) + verticesStartCount - verticesInLoop; 
-					mesh.indices[mesh.indices.count++] = ((i + 1) % verticesInLoop) + verticesStartCount - verticesInLoop; 
-					mesh.indices[mesh.indices.count++] = ((i + 0) % verticesInLoop) + verticesStartCount; 
+		v3 upDirection = quaternion_rotate_v3(rotation, v3_up);
 
-					mesh.indices[mesh.indices.count++] = ((i + 0) % verticesInLoop) + verticesStartCount; 
-					mesh.indices[mesh.indices.count++] = ((i + 1) % verticesInLoop) + verticesStartCount - verticesInLoop; 
-					mesh.indices[mesh.indices.count++] = ((i + 1) % verticesInLoop) + verticesStartCount; 
-				}
-			}
 
-		}
-	
-		/// TOP DOME
+		f32 fullAngle 			= 0.5f * π;
+		f32 angleStep 			= fullAngle / (topDomeLoops + 1);
+
+		for (s32 loopIndex = 0; loopIndex < topDomeLoops; ++loopIndex)
 		{
-			s32 topDomeLoops = 3;
+			f32 angle 	= (loopIndex + 1) * angleStep;
+			f32 sin 	= sine(angle);
+			f32 cos 	= f32_cos(angle);
 
-			Assert(mesh.vertices.has_room_for(topDomeLoops * verticesInLoop + 1));
-			// Assert(mesh.indices.has_room_for(((2 * topDomeLoops + 1) * verticesInLoop - 1) * 3));
+			s32 baseVertexIndex = vertexCount - verticesInLoop;
 
-			v3 position 		= endNode.position;
-			quaternion rotation = endNode.rotation;
-			f32 radius 			= endNode.radius;
+			for (s32 i = 0; i < verticesInLoop; ++i)
+			{
+				v3 vertexPosition = quaternion_rotate_v3(rotation, baseVertexPositions[i]) * radius * cos;
+				vertexPosition += sin * upDirection * radius + position;
+				mesh.vertices[vertexCount++] = { .position = vertexPosition };
+			}
 
-			v3 upDirection = quaternion_rotate_v3(rotation, v3_up);
+			for (s32 i = 0; i < verticesInLoop; ++i)
+			{
+				mesh.indices[indexCount++] = baseVertexIndex + i;
+				mesh.indices[indexCount++] = baseVertexIndex + ((i + 1) % verticesInLoop);
+				mesh.indices[indexCount++] = baseVertexIndex + i + verticesInLoop;
 
+				mesh.indices[indexCount++] = baseVertexIndex + i + verticesInLoop;
+				mesh.indices[indexCount++] = baseVertexIndex + ((i + 1) % verticesInLoop);
+				mesh.indices[indexCount++] = baseVertexIndex + ((i + 1) % verticesInLoop) + verticesInLoop;
+			}
+		}
 
-			f32 fullAngle 			= 0.5f * π;
-			f32 angleStep 			= fullAngle / (topDomeLoops + 1);
+		{
+			s32 baseVertexIndex 			= vertexCount - verticesInLoop;
+			v3 topVertexPosition 			= position + upDirection * radius;
+			s32 topVertexIndex 				= vertexCount++;
+			mesh.vertices[topVertexIndex] 	= { .position = topVertexPosition };
 
-			for (s32 loopIndex = 0; loopIndex < topDomeLoops; ++loopIndex)
+			for (s32 v = 0; v < verticesInLoop; ++v)
 			{
-				f32 angle 	= (loopIndex + 1) * angleStep;
-				f32 sin 	= sine(angle);
-				f32 cos 	= f32_cos(angle);
+				mesh.indices[indexCount++] = baseVertexIndex + v;
+				mesh.indices[indexCount++] = baseVertexIndex + ((v + 1) % verticesInLoop);
+				mesh.indices[indexCount++] = topVertexIndex;
+			}
+		}
+	}
 
-				s32 baseVertexIndex = mesh.vertices.count - verticesInLoop;
+	Assert(vertexCount - vertexStart == tree_mesh_vertex_count(detail));
+	Assert(indexCount - indexStart == tree_mesh_index_count(detail));
 
-				for (s32 i = 0; i < verticesInLoop; ++i)
-				{
-					v3 vertexPosition = quaternion_rotate_v3(rotation, baseVertexPositions[i]) * radius * cos;
-					vertexPosition += sin * upDirection * radius + position;
-					mesh.vertices[mesh.vertices.count++] = { .position = vertexPosition };
-				}
+	/* Note(Leo): Same as mesh_generate_normals, but only for this branch's range. That also used transient
+	memory, which is not thread safe, and here normals can be summed directly to vertices. */
+	for (s32 i = vertexStart; i < vertexCount; ++i)
+	{
+		mesh.vertices[i].normal = {};
+	}
 
-				for (s32 i = 0; i < verticesInLoop; ++i)
-				{
-					mesh.indices[mesh.indices.count++] = baseVertexIndex + i;
-					mesh.indices[mesh.indices.count++] = baseVertexIndex + ((i + 1) % verticesInLoop);
-					mesh.indices[mesh.indices.count++] = baseVertexIndex + i + verticesInLoop;
+	for (s32 i = indexStart; i < indexCount; i += 3)
+	{
+		u32 i0 = mesh.indices[i];
+		u32 i1 = mesh.indices[i + 1];
+		u32 i2 = mesh.indices[i + 2];
 
-					mesh.indices[mesh.indices.count++] = baseVertexIndex + i + verticesInLoop;
-					mesh.indices[mesh.indices.count++] = baseVertexIndex + ((i + 1) % verticesInLoop);
-					mesh.indices[mesh.indices.count++] = baseVertexIndex + ((i + 1) % verticesInLoop) + verticesInLoop;
-				}
-			}
+		v3 p0 = mesh.vertices[i0].position;
+		v3 p1 = mesh.vertices[i1].position;
+		v3 p2 = mesh.vertices[i2].position;
 
-			{
-				s32 baseVertexIndex 			= mesh.vertices.count - verticesInLoop;
-				v3 topVertexPosition 			= position + upDirection * radius;
-				s32 topVertexIndex 				= mesh.vertices.count++;
-				mesh.vertices[topVertexIndex] 	= { .position = topVertexPosition };
+		v3 normal = v3_normalize(v3_cross(p1 - p0, p2 - p0));
 
-				for (s32 v = 0; v < verticesInLoop; ++v)
-				{
-					mesh.indices[mesh.indices.count++] = baseVertexIndex + v;
-					mesh.indices[mesh.indices.count++] = baseVertexIndex + ((v + 1) % verticesInLoop);
-					mesh.indices[mesh.indices.count++] = topVertexIndex;
-				}
-			}
+		mesh.vertices[i0].normal += normal;
+		mesh.vertices[i1].normal += normal;
+		mesh.vertices[i2].normal += normal;
+	}
+
+	for (s32 i = vertexStart; i < vertexCount; ++i)
+	{
+		mesh.vertices[i].normal = v3_normalize(mesh.vertices[i].normal);
+	}
+}
+
+// Note(Leo): Coarsest detail level whose ring is at most 'maxPixelError' pixels inside the actual branch
+internal TreeMeshDetail tree_3_branch_mesh_detail(Tree const & tree, TreeBranch const & branch, f32 maxPixelError)
+{
+	f32 radius 			= f32_max(tree.nodes[branch.startNodeIndex].radius, tree.nodes[branch.endNodeIndex].radius);
+	f32 pixelRadius 	= radius * tree.meshPixelsPerMeter;
+
+	// Note(Leo): Whole branch is less than error wide, so it is not worth drawing
+	if (2 * pixelRadius < maxPixelError)
+	{
+		return TreeMeshDetail_none;
+	}
+
+	for (s32 detail = TreeMeshDetail_low; detail > TreeMeshDetail_full; --detail)
+	{
+		f32 ringError = pixelRadius * (1 - f32_cos(π / tree_mesh_tessellations[detail].verticesInLoop));
+		if (ringError < maxPixelError)
+		{
+			return (TreeMeshDetail)detail;
 		}
+	}
+
+	return TreeMeshDetail_full;
+}
+
+internal void build_tree_3_mesh(Tree & tree)
+{
+	DynamicMesh & mesh 	= tree.mesh;
+
+	/*
+	DONE:
+	number of vertices in a loop to variable,
+		->later make it depend on size of node and somehow combine where it changes
+	interpolate positions
+	interpolate with bezier curves by fixed t-values
+
+	TODO:
+	platform graphics based dynamic mesh, so no need to copy each frame
+	*/
+
+	// Note(Leo): This used to be local_persist, but trees are built in parallel now, and this is cheap
+	v3 baseVertexPositions[TreeMeshDetailCount][tree_mesh_max_vertices_in_loop] = {};
+	for (s32 detail = 0; detail < TreeMeshDetail_none; ++detail)
+	{
+		s32 verticesInLoop 	= tree_mesh_tessellations[detail].verticesInLoop;
+		f32 angleStep 		= 2 * π / verticesInLoop;
 
+		for (s32 i = 0; i < verticesInLoop; ++i)
+		{
+			baseVertexPositions[detail][i].xy 	= rotate_v2({1 ,0}, i * angleStep);
+		}
 	}
 
-	mesh_generate_normals(mesh.vertices.count, mesh.vertices.memory, mesh.indices.count, mesh.indices.memory);
-	// mesh_generate_tangents(mesh.vertexCount, mesh.vertices, mesh.indexCount, mesh.indices);
+	// Note(Leo): Tangent scale affects every branch, so if it has been edited, rebuild all
+	bool32 rebuildAll 		= tree.meshTangentScale != tree.settings->tangentScale;
+	tree.meshTangentScale 	= tree.settings->tangentScale;
+
+	tree.meshRebuiltBranchCount = 0;
 
+	s32 vertexStart = 0;
+	s32 indexStart 	= 0;
 
-	if (	used_percent(mesh.vertices) > tree.resourceLimitThresholdValue 
-		or 	used_percent(mesh.indices) > tree.resourceLimitThresholdValue)
+	for (s32 branchIndex = 0; branchIndex < tree.branches.count; ++branchIndex)
 	{
-		tree.resourceLimitReached = true;
-		log_debug(FILE_ADDRESS, "tree resource limit reached");
+		TreeBranch const & branch 	= tree.branches[branchIndex];
+		TreeMeshDetail detail 		= tree_3_branch_mesh_detail(tree, branch, Tree::meshMaxPixelError);
+
+		bool32 isDirty = rebuildAll
+						|| branch.meshIsBuilt == false
+						|| branch.meshDetail != detail
+						|| branch.meshVertexStart != vertexStart
+						|| branch.meshIndexStart != indexStart
+						|| tree_3_node_changed(branch.meshStartNode, tree.nodes[branch.startNodeIndex])
+						|| tree_3_node_changed(branch.meshEndNode, tree.nodes[branch.endNodeIndex]);
+
+		s32 vertexEnd 	= vertexStart + tree_mesh_vertex_count(detail);
+		s32 indexEnd 	= indexStart + tree_mesh_index_count(detail);
+
+		// Note(Leo): If pool is out of budget, draw what fits. Tree does not grow after that anyway.
+		if (tree_3_reserve_mesh(tree, vertexEnd, indexEnd) == false)
+		{
+			break;
+		}
+
+		// Note(Leo): Branch is written in place, these are set to exact counts after all branches
+		if (mesh.vertices.count < vertexEnd) { mesh.vertices.count = vertexEnd; }
+		if (mesh.indices.count < indexEnd) { mesh.indices.count = indexEnd; }
+
+		if (isDirty)
+		{
+			build_tree_3_branch_mesh(tree, branchIndex, detail, vertexStart, indexStart, baseVertexPositions[detail]);
+			tree.meshRebuiltBranchCount += 1;
+		}
+
+		vertexStart = vertexEnd;
+		indexStart 	= indexEnd;
 	}
+
+	mesh.vertices.count = vertexStart;
+	mesh.indices.count 	= indexStart;
 }
 
-internal void reset_tree_3(Tree & tree, TreeSettings * settings, v3 position)
+/*
+Note(Leo): Updates tree's pixels per meter from camera, which is what branch detail levels are chosen
+by. Returns true if it changed enough that mesh should be rebuilt. Distance is taken to nearest point
+of tree's bounding sphere, so that detail is never too low for any part of the tree.
+*/
+internal bool32 tree_3_update_mesh_lod(Tree & tree, TreeMeshLodView const & view)
 {
-	tree.position = position;
-	tree.settings = settings;
+	f32 pixelsPerMeter = highest_f32;
 
-	// Note(Leo): arrays are initialized to 0
-	array_clear(tree.nodes);
-	array_clear(tree.buds);
-	array_clear(tree.branches);
+	if (view.enabled)
+	{
+		f32 boundingRadius 	= 0.5f * tree.settings->maxHeight;
+		v3 center 			= tree.position + v3_up * boundingRadius;
+		f32 distance 		= f32_max(1, v3_length(center - view.cameraPosition) - boundingRadius);
 
-	flush_leaves(tree.leaves);
-	flush_dynamic_mesh(tree.mesh);
+		pixelsPerMeter 		= view.pixelsAtUnitDistance / distance;
+	}
 
-	tree_3_add_branch(tree, -1, {0,0,0}, quaternion_identity, 0);
+	f32 ratio 			= pixelsPerMeter / tree.meshPixelsPerMeter;
+	bool32 changed 		= ratio > tree_mesh_lod_hysteresis || ratio < (1 / tree_mesh_lod_hysteresis);
 
-	tree.resourceLimitReached 	= false;
-	tree.drawSeed 				= true;
-	tree.waterReservoir 		= 0;
-	tree.enabled 				= true;
+	if (changed)
+	{
+		tree.meshPixelsPerMeter = pixelsPerMeter;
+	}
 
-	build_tree_3_mesh(tree);
+	return changed;
 }
 
-internal void allocate_tree_memory(MemoryArena & allocator, Tree & tree)
+// Note(Leo): If this tree was used before, its memory is returned to pool first
+internal void reset_tree_3(Tree & tree, MemoryPool & memoryPool, TreeSettings * settings, v3 position, u32 randomSeed)
 {
+	tree_3_free_memory(tree);
+
 	tree = {};
 
-	tree.nodes 		= push_array<TreeNode>(allocator, 1000, ALLOC_ZERO_MEMORY);
-	tree.buds 		= push_array<TreeBud>(allocator, 1000, ALLOC_ZERO_MEMORY);
-	tree.branches 	= push_array<TreeBranch>(allocator, 1000, ALLOC_ZERO_MEMORY);
-	tree.leaves 	= make_leaves(allocator, 2000);
-	tree.mesh 		= push_dynamic_mesh(allocator, 10000, 40000);
+	tree.memoryPool = &memoryPool;
+	tree.position 	= position;
+	tree.settings 	= settings;
+	tree.random 	= random_state_from_seed(randomSeed);
+	tree.enabled 	= true;
 
-	// reset_tree_3(tree);
+	if (tree_3_reserve(tree, 2, 1, 1, settings->leafCountPerBud))
+	{
+		tree_3_add_branch(tree, -1, {0,0,0}, quaternion_identity, 0);
+		build_tree_3_mesh(tree);
+	}
 }
 
 namespace ImGui
@@ -783,11 +1316,44 @@ internal void trees_editor(Trees & trees)
 		Checkbox32("Global Enable", &Tree::globalEnabled);
 		Checkbox32("Enable Updates", &tree.enabled);
 		Checkbox32("Draw Gizmos", &tree.drawGizmos);
+		Checkbox32("Mesh LOD", &trees.meshLodEnabled);
+		DragFloat("Mesh LOD Max Pixel Error", &Tree::meshMaxPixelError, 0.01, 0.01, 10);
 		DragFloat("Grow Speed Scale", &tree.settings->growSpeedScale, 0.01);
 
 		TreePop();
 	}
 
+	if (ImGui::TreeNode("Simulation"))
+	{
+		DragInt("Step Budget", &trees.simulationStepBudget, 1, 0, 100000);
+		DragFloat("Far Distance", &trees.simulationTierDistances[0], 1, 0, trees.simulationTierDistances[1]);
+		DragFloat("Distant Distance", &trees.simulationTierDistances[1], 1, trees.simulationTierDistances[0], highest_f32);
+
+		Value("Near trees", trees.simulationTreeCountPerTier[TreeSimulationTier_near]);
+		Value("Far trees", trees.simulationTreeCountPerTier[TreeSimulationTier_far]);
+		Value("Distant trees", trees.simulationTreeCountPerTier[TreeSimulationTier_distant]);
+		Value("Steps", trees.simulationStepCount);
+		Value("Postponed over budget", trees.simulationPostponedCount);
+
+		TreePop();
+	}
+
+	if (ImGui::TreeNode("Memory"))
+	{
+		// Note(Leo): Lowering budget below what is reserved does not free anything, it just stops growing
+		f32 budgetMegabytes = reverse_megabytes(trees.memoryPool.budget);
+		if (DragFloat("Budget MB", &budgetMegabytes, 1, 0, highest_f32))
+		{
+			trees.memoryPool.budget = (u64)(budgetMegabytes * megabytes(1));
+		}
+
+		Value("Used MB", reverse_megabytes(trees.memoryPool.used));
+		Value("Reserved MB", reverse_megabytes(trees.memoryPool.reserved));
+		Value("Arena free MB", reverse_megabytes(trees.memoryPool.backingArena->size - trees.memoryPool.backingArena->used));
+
+		TreePop();
+	}
+
 	if (ImGui::TreeNode("Properties"))
 	{
 		DragFloat("Area Grow Speed", &tree.settings->areaGrowthSpeed, 0.01, 0, highest_f32);
@@ -804,6 +1370,11 @@ internal void trees_editor(Trees & trees)
 
 		SliderFloat("Apex Branching Probability", &tree.settings->apexBranchingProbability, 0, 1);
 
+		if(InputInt("Max Branch Count", &tree.settings->maxBranchCount, 1, 10))
+		{
+			tree.settings->maxBranchCount = s32_max(1, tree.settings->maxBranchCount);
+		}
+
 		TreePop();
 	}
 
@@ -835,11 +1406,25 @@ internal void trees_editor(Trees & trees)
 		s32 budCount 				= tree.buds.count;
 		s32 vertexCount 			= tree.mesh.vertices.count;
 		s32 indexCount 				= tree.mesh.indices.count;
-		s32 leafCount 				= tree.leaves.count;
+		s32 leafCount 				= tree.leaves.data.count;
+		s32 rebuiltBranchCount 		= tree.meshRebuiltBranchCount;
 		bool resourceLimitReached = tree.resourceLimitReached;
 
 		Value("Buds", budCount);
 		Value("Vertices", vertexCount);
+		Value("Rebuilt branches", rebuiltBranchCount);
+
+		s32 branchCountPerDetail [TreeMeshDetailCount] = {};
+		for (auto const & branch : tree.branches)
+		{
+			branchCountPerDetail[branch.meshDetail] += 1;
+		}
+
+		Value("Mesh pixels per meter", tree.meshPixelsPerMeter);
+		Value("Full detail branches", branchCountPerDetail[TreeMeshDetail_full]);
+		Value("Reduced detail branches", branchCountPerDetail[TreeMeshDetail_reduced]);
+		Value("Low detail branches", branchCountPerDetail[TreeMeshDetail_low]);
+		Value("Skipped branches", branchCountPerDetail[TreeMeshDetail_none]);
 		Value("Indices", indexCount);
 		Value("Leaves", leafCount);
 		Value("Resources reached", resourceLimitReached);
@@ -914,7 +1499,7 @@ internal void trees_editor(Trees & trees)
 		s32 budCount 				= tree.buds.count;
 		s32 vertexCount 			= tree.mesh.vertices.count;
 		s32 indexCount 				= tree.mesh.indices.count;
-		s32 leafCount 				= tree.leaves.count;
+		s32 leafCount 				= tree.leaves.data.count;
 		bool32 resourceLimitReached = tree.resourceLimitReached;
 
 		gui_int_field("Buds", &budCount);
@@ -934,20 +1519,38 @@ internal void trees_editor(Trees & trees)
 	*/
 }
 
-internal void update_tree_3(Tree & tree, f32 elapsedTime, GetWaterFunc & get_water)
+// Note(Leo): Call trees_take_water before this. This only touches this tree, so this can be called in parallel for different trees
+internal void update_tree_3(Tree & tree, TreeMeshLodView const & lodView)
 {
 	if (tree.breakOnUpdate)
 	{
 		tree.breakOnUpdate = false;
 	}
 
-	if (Tree::globalEnabled && tree.planted && tree.enabled && !tree.resourceLimitReached)
+	bool32 lodChanged 	= tree_3_update_mesh_lod(tree, lodView);
+	bool32 hasGrown 	= false;
+
+	// Note(Leo): Water was taken for all steps, but tree may stop growing in between, and rest of that water just stays in reservoir
+	for (s32 step = 0; step < tree.simulationStepCount && tree_3_is_growing(tree); ++step)
+	{
+		grow_tree_3(tree, tree_simulation_step, tree.simulationWaterGrowthFactors[step]);
+
+		hasGrown = true;
+	}
+
+	if (hasGrown)
+	{
+		tree_3_update_collider(tree);
+	}
+
+	if (hasGrown || lodChanged)
 	{
-		grow_tree_3(tree, elapsedTime, get_water);
 		build_tree_3_mesh(tree);
 	}
 
-	if (tree.resourceLimitReached)
+	f32 elapsedTime = tree.simulationStepCount * tree_simulation_step;
+
+	if (tree.resourceLimitReached && elapsedTime > 0)
 	{
 		if (tree.hasFruit == false)
 		{
@@ -960,9 +1563,10 @@ internal void update_tree_3(Tree & tree, f32 elapsedTime, GetWaterFunc & get_wat
 
 		if (tree.fruitAge > tree.fruitMaturationTime)
 		{
-			game_spawn_tree(*tree.game, tree.fruitPosition + tree.position, tree.typeIndex);
+			tree.spawnFruitTree 		= true;
+			tree.fruitTreeSpawnPosition = tree.fruitPosition + tree.position;
 
-			s32 budIndex = random_range(0, tree.buds.count);
+			s32 budIndex = random_range(tree.random, 0, tree.buds.count);
 			v3 fruitPosition = tree.buds[budIndex].position;
 
 			tree.fruitPosition 	= fruitPosition;
@@ -989,4 +1593,19 @@ internal void update_tree_3(Tree & tree, f32 elapsedTime, GetWaterFunc & get_wat
 		// 	}
 		// }
 	}	
-}
\ No newline at end of file
+}
+
+internal void trees_spawn_fruit_trees(Trees & trees)
+{
+	// Note(Leo): New trees are added to the end, and they do not have fruit yet
+	s32 treeCount = trees.array.count;
+	for (s32 i = 0; i < treeCount; ++i)
+	{
+		Tree & tree = trees.array[i];
+		if (tree.spawnFruitTree)
+		{
+			tree.spawnFruitTree = false;
+			game_spawn_tree(*tree.game, tree.fruitTreeSpawnPosition, tree.typeIndex);
+		}
+	}
+}
@@ -1,11 +1,18 @@
 struct Waters
 {
-	s32 			capacity;
-	s32 			count;
+	// Note(Leo): Columns are positions, rotations and levels, get them with functions below
+	SoA<v3, quaternion, f32> data;
 
-	v3 * 			positions;
-	quaternion * 	rotations;
-	f32	* 			levels;
+	v3 * positions() 						{ return data.column<0>(); }
+	quaternion * rotations() 				{ return data.column<1>(); }
+	f32 * levels() 							{ return data.column<2>(); }
+
+	v3 const * positions() const 			{ return data.column<0>(); }
+	quaternion const * rotations() const 	{ return data.column<1>(); }
+	f32 const * levels() const 				{ return data.column<2>(); }
+
+	// Note(Leo): Water index is item index in grid, keep this updated when waters move in xy plane
+	SpatialHashGrid grid;
 
 	s32 fullWaterLevel 			= 1;
 	f32 evaporateLevelPerSecond = 0.05;
@@ -15,33 +22,38 @@ internal void initialize_waters(Waters & waters, MemoryArena & allocator)
 {
 	waters = {};
 
-	waters.capacity 	= 100'000;
-	waters.count 		= 0;
-	waters.positions 	= push_memory<v3>(allocator, waters.capacity, ALLOC_GARBAGE);
-	waters.rotations 	= push_memory<quaternion>(allocator, waters.capacity, ALLOC_GARBAGE);
-	waters.levels 		= push_memory<f32>(allocator, waters.capacity, ALLOC_GARBAGE);
+	s32 capacity 		= 100'000;
+	waters.data 		= push_soa<v3, quaternion, f32>(allocator, capacity);
+
+	f32 gridCellSize 	= 2;
+	waters.grid 		= make_spatial_hash_grid(allocator, capacity, gridCellSize);
 }
 
-// Todo(Leo): testing these here, move to memory
-template<typename T>
-internal void memory_unordered_pop(T * memory, s32 index, s32 count)
+// Note(Leo): Last water takes removed water's index, so water references after this are not valid
+internal void waters_unordered_remove(Waters & waters, s32 index)
 {
-	memory[index] = memory[count - 1];
+	s32 lastIndex = waters.data.count - 1;
+
+	waters.data.unordered_remove(index);
+
+	spatial_hash_grid_remove(waters.grid, index);
+	spatial_hash_grid_move_index(waters.grid, lastIndex, index);
 }
 
 internal void update_waters(Waters & waters, f32 elapsedTime)
 {
-	for (s32 i = 0; i < waters.count; ++i)
+	FS_PROFILE_FUNCTION();
+
+	f32 evaporatedLevel = waters.evaporateLevelPerSecond * elapsedTime;
+
+	f32 * levels = waters.levels();
+	for (s32 i = 0; i < waters.data.count; ++i)
 	{
-		waters.levels[i] -= waters.evaporateLevelPerSecond * elapsedTime;
+		levels[i] -= evaporatedLevel;
 
-		if (waters.levels[i] < 0)
+		if (levels[i] < 0)
 		{
-			memory_unordered_pop(waters.positions, i, waters.count);
-			memory_unordered_pop(waters.rotations, i, waters.count);
-			memory_unordered_pop(waters.levels, i, waters.count);
-
-			waters.count -= 1;
+			waters_unordered_remove(waters, i);
 			i -= 1;
 		}
 	}
@@ -49,30 +61,66 @@ internal void update_waters(Waters & waters, f32 elapsedTime)
 
 internal void waters_instantiate(Waters & waters, v3 position, f32 level)
 {
-	if (waters.count < waters.capacity)
+	if (waters.data.count < waters.data.capacity)
 	{
-		s32 index 		= waters.count;
-		waters.count 	+= 1;
-
-		waters.positions[index] = position;
-		waters.rotations[index] = quaternion_identity;
-		waters.levels[index] 	= level;
+		s32 index = waters.data.push(position, quaternion_identity, level);
+		spatial_hash_grid_move(waters.grid, index, position.xy);
 	}
 }
 
+/*
+Note(Leo): Returns index of nearest water closer than 'maxDistance', or -1 if there is none.
+'ignoredIndex' is not considered, use it for example for carried water.
+*/
+internal s32 waters_find_nearest(Waters const & waters, v3 position, f32 maxDistance, s32 ignoredIndex = -1)
+{
+	s32 nearestIndex 	= -1;
+	f32 nearestDistance = maxDistance;
+
+	spatial_hash_grid_query(waters.grid, position.xy, maxDistance, [&](s32 index)
+	{
+		f32 distance = v3_length(waters.positions()[index] - position);
+		if (distance < nearestDistance && index != ignoredIndex)
+		{
+			nearestDistance = distance;
+			nearestIndex 	= index;
+		}
+	});
+
+	return nearestIndex;
+}
+
+// Note(Leo): Calls 'func(s32 index)' for every water inside disc on xy plane
+template<typename TFunc>
+internal void waters_query_disc(Waters const & waters, v2 center, f32 radius, TFunc func)
+{
+	spatial_hash_grid_query(waters.grid, center, radius, [&](s32 index)
+	{
+		if (v2_length(waters.positions()[index].xy - center) < radius)
+		{
+			func(index);
+		}
+	});
+}
+
 internal void draw_waters(Waters & waters, PlatformGraphics * graphics, GameAssets & assets)
 {
-	if (waters.count > 0)
+	s32 count = waters.data.count;
+	if (count > 0)
 	{
-		m44 * waterTransforms = push_memory<m44>(*global_transientMemory, waters.count, ALLOC_GARBAGE);
-		for (s32 i = 0; i < waters.count; ++i)
+		v3 const * positions 			= waters.positions();
+		quaternion const * rotations 	= waters.rotations();
+		f32 const * levels 				= waters.levels();
+
+		m44 * waterTransforms = push_memory<m44>(*global_transientMemory, count, ALLOC_GARBAGE);
+		for (s32 i = 0; i < count; ++i)
 		{
-			waterTransforms[i] = transform_matrix(	waters.positions[i],
-													waters.rotations[i],
-													make_uniform_v3(waters.levels[i] / waters.fullWaterLevel));
+			waterTransforms[i] = transform_matrix(	positions[i],
+													rotations[i],
+													make_uniform_v3(levels[i] / waters.fullWaterLevel));
 		}
 
-		graphics_draw_meshes(	platformGraphics, waters.count, waterTransforms, 
+		graphics_draw_meshes(	platformGraphics, count, waterTransforms, 
 								assets_get_mesh(assets, MeshAssetId_water_drop),
 								assets_get_material(assets, MaterialAssetId_water));
 	}
@@ -0,0 +1,67 @@
+/*
+Leo Tamminen
+
+Game side helpers for platform's job system. Jobs must not use global_transientMemory, since
+it is not thread safe. Instead each worker has its own scratch arena, which is flushed at the
+start of each frame like transient memory.
+*/
+
+static PlatformJobs * 	platformJobs;
+static MemoryArena * 	global_workerScratchMemory;
+
+internal MemoryArena & jobs_get_scratch_memory(s32 workerIndex)
+{
+	return global_workerScratchMemory[workerIndex];
+}
+
+template<typename TFunc>
+struct ParallelForRange
+{
+	TFunc * func;
+	s32 	start;
+	s32 	end;
+};
+
+template<typename TFunc>
+internal void parallel_for_job(void * data, s32 workerIndex)
+{
+	auto * range = reinterpret_cast<ParallelForRange<TFunc>*>(data);
+
+	for (s32 i = range->start; i < range->end; ++i)
+	{
+		(*range->func)(i, workerIndex);
+	}
+}
+
+/*
+Note(Leo): Calls func(index, workerIndex) once for each index in [0, count) on any worker, and
+returns when all are done. 'grainSize' is the number of indices per job, it is grown if there
+would be too many jobs. Calling thread executes jobs too while waiting.
+*/
+template<typename TFunc>
+internal void parallel_for(s32 count, s32 grainSize, TFunc func)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+
+	constexpr s32 maxJobCount = 256;
+
+	grainSize 		= s32_max(grainSize, 1);
+	grainSize 		= s32_max(grainSize, (count + maxJobCount - 1) / maxJobCount);
+	s32 jobCount 	= (count + grainSize - 1) / grainSize;
+
+	ParallelForRange<TFunc> ranges [maxJobCount];
+	Job jobs [maxJobCount];
+
+	for (s32 i = 0; i < jobCount; ++i)
+	{
+		ranges[i] 	= {&func, i * grainSize, s32_min((i + 1) * grainSize, count)};
+		jobs[i] 	= {parallel_for_job<TFunc>, &ranges[i]};
+	}
+
+	JobCounter counter = {};
+	jobs_submit(platformJobs, jobCount, jobs, &counter);
+	jobs_wait(platformJobs, &counter);
+}
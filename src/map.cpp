@@ -1,43 +1,331 @@
-template<typename T>
+/*
+Leo Tamminen
+
+Hash map with open addressing and Robin Hood hashing. Entries are in one table whose capacity is
+power of two, and each entry is placed to first free place after its hash's place. When inserting,
+entry that is closer to its own place gives its place to one that is further, so all entries stay
+close to their place and lookups can stop as soon as they reach entry that is closer to its place
+than searched key would be.
+
+Removing shifts following entries back one place until one that is at its own place or empty place,
+so there are no tombstones, and table does not get slower when entries are removed.
+
+Table is from MemoryArena. When it gets too full, new table with double capacity is taken from same
+arena and entries are copied there. Arena cannot free old table, so give big enough capacity from
+start if map is in persistent memory, or use 'map_reserve' before inserting lots of entries.
+
+Keys and values are copied around, so they must be trivially copyable. Hash and key equality come
+from 'THash', see MapDefaultHash.
+
+References:
+	Celis: Robin Hood Hashing (1986)
+	Goossaert: Robin Hood hashing: backward shift deletion (2013)
+*/
+
+// Note(Leo): Murmur3's 64 bit finalizer, so that keys that differ only in few bits end up far apart
+internal u64 map_hash_mix(u64 value)
+{
+	value ^= value >> 33;
+	value *= 0xff51afd7ed558ccdull;
+	value ^= value >> 33;
+	value *= 0xc4ceb9fe1a85ec53ull;
+	value ^= value >> 33;
+	return value;
+}
+
+// Note(Leo): FNV-1a
+internal u64 map_hash_bytes(void const * memory, u64 size)
+{
+	u8 const * bytes 	= reinterpret_cast<u8 const *>(memory);
+	u64 hash 			= 0xcbf29ce484222325ull;
+
+	for (u64 i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+/*
+Note(Leo): Integers, enums and pointers are hashed by their value, and other keys by their bytes, so
+those must not have padding. Give other hash to Map for keys that need something else.
+*/
+template<typename TKey>
+struct MapDefaultHash
+{
+	static u64 hash(TKey const & key)
+	{
+		if constexpr (std::is_integral<TKey>::value || std::is_enum<TKey>::value)
+		{
+			return map_hash_mix((u64)key);
+		}
+		else if constexpr (std::is_pointer<TKey>::value)
+		{
+			return map_hash_mix(reinterpret_cast<u64>(key));
+		}
+		else
+		{
+			return map_hash_bytes(&key, sizeof(TKey));
+		}
+	}
+
+	static bool32 equals(TKey const & a, TKey const & b)
+	{
+		if constexpr (std::is_integral<TKey>::value || std::is_enum<TKey>::value || std::is_pointer<TKey>::value)
+		{
+			return a == b;
+		}
+		else
+		{
+			return memory_equals(&a, &b, sizeof(TKey));
+		}
+	}
+};
+
+// Note(Leo): Keys are compared by contents, so strings must stay alive as long as they are in map
+struct MapStringHash
+{
+	static u64 hash(String const & key)
+	{
+		return map_hash_bytes(key.memory, key.length);
+	}
+
+	static bool32 equals(String const & a, String const & b)
+	{
+		return a.length == b.length && memory_equals(a.memory, b.memory, a.length);
+	}
+};
+
+constexpr s64 map_min_capacity = 16;
+
+template<typename TKey, typename TValue, typename THash = MapDefaultHash<TKey>>
 struct Map
 {
-	s32 capacity;
-	s32 count;	
+	s64 capacity;
+	s64 count;
+
+	// Note(Leo): Distance from entry's place plus one, or zero for empty place
+	u32 * 		distances;
+	TKey * 		keys;
+	TValue * 	values;
 
-	s32 * 	mappedIndices;
-	T * 	memory;
+	MemoryArena * allocator;
 
-	T & operator[](s32 index)
+	// Note(Leo): Returns nullptr if key is not in map
+	TValue * operator[] (TKey const & key)
 	{
-		s32 mappedIndex = mappedIndices[index];
-		return memory[index];
+		return map_get(*this, key);
 	}
 };
 
-template<typename T>
-internal s32 map_push(Map<T> & map, T value)
+template<typename TKey, typename TValue, typename THash>
+internal Map<TKey, TValue, THash> map_make_table(MemoryArena & allocator, s64 capacity)
+{
+	Assert((capacity & (capacity - 1)) == 0 && "Map capacity must be power of two");
+
+	Map<TKey, TValue, THash> map 	= {};
+	map.capacity 					= capacity;
+	map.allocator 					= &allocator;
+	map.distances 					= push_memory<u32>(allocator, capacity, ALLOC_ZERO_MEMORY);
+	map.keys 						= push_memory<TKey>(allocator, capacity, ALLOC_GARBAGE);
+	map.values 						= push_memory<TValue>(allocator, capacity, ALLOC_GARBAGE);
+
+	return map;
+}
+
+// Note(Leo): Capacity is rounded up to power of two, and map grows when it is 7/8 full
+template<typename TKey, typename TValue, typename THash = MapDefaultHash<TKey>>
+internal Map<TKey, TValue, THash> push_map(MemoryArena & allocator, s64 capacity)
+{
+	static_assert(std::is_trivially_copyable<TKey>::value && std::is_trivially_copyable<TValue>::value);
+
+	s64 tableCapacity = map_min_capacity;
+	while (tableCapacity < capacity)
+	{
+		tableCapacity *= 2;
+	}
+
+	return map_make_table<TKey, TValue, THash>(allocator, tableCapacity);
+}
+
+template<typename TKey, typename TValue, typename THash>
+internal bool32 map_is_too_full(Map<TKey, TValue, THash> const & map, s64 count)
+{
+	return count * 8 > map.capacity * 7;
+}
+
+template<typename TKey, typename TValue, typename THash>
+internal s64 map_find_index(Map<TKey, TValue, THash> const & map, TKey const & key)
+{
+	if (map.capacity == 0)
+	{
+		return -1;
+	}
+
+	s64 mask 		= map.capacity - 1;
+	s64 index 		= THash::hash(key) & mask;
+	u32 distance 	= 1;
+
+	// Note(Leo): Entry that is closer to its place than key would be here means key is not in map
+	while (map.distances[index] >= distance)
+	{
+		if (map.distances[index] == distance && THash::equals(map.keys[index], key))
+		{
+			return index;
+		}
+
+		index 		= (index + 1) & mask;
+		distance 	+= 1;
+	}
+
+	return -1;
+}
+
+// Note(Leo): Table must have room, and key must not be in it yet. Returns index where key was put.
+template<typename TKey, typename TValue, typename THash>
+internal s64 map_insert_new(Map<TKey, TValue, THash> & map, TKey key, TValue value)
+{
+	s64 mask 		= map.capacity - 1;
+	s64 index 		= THash::hash(key) & mask;
+	u32 distance 	= 1;
+	s64 result 		= -1;
+
+	while (true)
+	{
+		if (map.distances[index] == 0)
+		{
+			map.distances[index] 	= distance;
+			map.keys[index] 		= key;
+			map.values[index] 		= value;
+			map.count 				+= 1;
+
+			return result >= 0 ? result : index;
+		}
+
+		// Note(Leo): Rich gives to poor, and then we continue with entry that was here
+		if (map.distances[index] < distance)
+		{
+			memory_swap(map.distances[index], distance);
+			memory_swap(map.keys[index], key);
+			memory_swap(map.values[index], value);
+
+			if (result < 0)
+			{
+				result = index;
+			}
+		}
+
+		index 		= (index + 1) & mask;
+		distance 	+= 1;
+	}
+}
+
+// Note(Leo): Makes room for 'count' entries in total, growing table if needed
+template<typename TKey, typename TValue, typename THash>
+internal void map_reserve(Map<TKey, TValue, THash> & map, s64 count)
 {
-	s32 mappedIndex = map.count;
-	map.count 		+= 1;
+	if (map_is_too_full(map, count) == false)
+	{
+		return;
+	}
+
+	s64 capacity = map.capacity > map_min_capacity ? map.capacity : map_min_capacity;
+	while (count * 8 > capacity * 7)
+	{
+		capacity *= 2;
+	}
+
+	Map<TKey, TValue, THash> grown = map_make_table<TKey, TValue, THash>(*map.allocator, capacity);
+
+	for (s64 i = 0; i < map.capacity; ++i)
+	{
+		if (map.distances[i] > 0)
+		{
+			map_insert_new(grown, map.keys[i], map.values[i]);
+		}
+	}
 
-	map.memory[mappedIndex] = value;
+	map = grown;
+}
 
-	s32 handleIndex = 0;
+// Note(Leo): Returns nullptr if key is not in map. Pointer is valid until next insert.
+template<typename TKey, typename TValue, typename THash>
+internal TValue * map_get(Map<TKey, TValue, THash> & map, TKey const & key)
+{
+	s64 index = map_find_index(map, key);
+	return index >= 0 ? &map.values[index] : nullptr;
+}
 
-	while(map.mappedIndices[handleIndex] >= 0)
+template<typename TKey, typename TValue, typename THash>
+internal bool32 map_contains(Map<TKey, TValue, THash> const & map, TKey const & key)
+{
+	return map_find_index(map, key) >= 0;
+}
+
+// Note(Leo): Sets key's value, adding it if it is not in map yet. Returns pointer to value, which is valid until next insert.
+template<typename TKey, typename TValue, typename THash>
+internal TValue * map_insert(Map<TKey, TValue, THash> & map, TKey const & key, TValue const & value)
+{
+	s64 index = map_find_index(map, key);
+	if (index >= 0)
 	{
-		handleIndex += 1;
+		map.values[index] = value;
+		return &map.values[index];
 	}
 
-	map.mappedIndices[handleIndex] = mappedIndex;
-	return handleIndex;
+	map_reserve(map, map.count + 1);
+
+	index = map_insert_new(map, key, value);
+	return &map.values[index];
 }
 
-template<typename T>
-internal void map_remove(Map<T> & map, s32 handle)
+// Note(Leo): Returns false if key was not in map
+template<typename TKey, typename TValue, typename THash>
+internal bool32 map_remove(Map<TKey, TValue, THash> & map, TKey const & key)
 {
-	s32 mappedIndex 		= map.mappedIndices[handle];
-	map.memory[mappedIndex] = map.memory[map.count - 1];
+	s64 index = map_find_index(map, key);
+	if (index < 0)
+	{
+		return false;
+	}
+
+	s64 mask = map.capacity - 1;
+	s64 next = (index + 1) & mask;
+
+	// Note(Leo): Entries after this that are not at their own place move one place back
+	while (map.distances[next] > 1)
+	{
+		map.distances[index] 	= map.distances[next] - 1;
+		map.keys[index] 		= map.keys[next];
+		map.values[index] 		= map.values[next];
+
+		index 	= next;
+		next 	= (next + 1) & mask;
+	}
+
+	map.distances[index] 	= 0;
 	map.count 				-= 1;
-	map.mappedIndices 		= -1;
-}
\ No newline at end of file
+
+	return true;
+}
+
+template<typename TKey, typename TValue, typename THash>
+internal void map_clear(Map<TKey, TValue, THash> & map)
+{
+	memset(map.distances, 0, map.capacity * sizeof(u32));
+	map.count = 0;
+}
+
+// Note(Leo): Calls 'func(TKey const & key, TValue & value)' for each entry, in no particular order
+template<typename TKey, typename TValue, typename THash, typename TFunc>
+internal void map_for_each(Map<TKey, TValue, THash> & map, TFunc func)
+{
+	for (s64 i = 0; i < map.capacity; ++i)
+	{
+		if (map.distances[i] > 0)
+		{
+			func(map.keys[i], map.values[i]);
+		}
+	}
+}
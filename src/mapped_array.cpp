@@ -1,41 +1,141 @@
+/*
+Leo Tamminen
+
+Array whose items are found with handles that stay valid when other items are removed. Items are
+kept packed in 'memory', so they can be iterated like Array, and removing moves last item to removed
+item's place. Handles point to slots, and slots know where their item is in 'memory'.
+
+Free slots are in a linked list, so pushing and removing are O(1). Each slot has generation that is
+incremented when slot is taken and again when it is freed, so generation is odd while slot is used.
+Handle has slot's generation from when it was pushed, so handle to removed item does not find
+another item that reuses same slot.
+
+Handle is s64, with slot in low 32 bits and generation in high 32 bits. Generation wraps after 2^31
+reuses of same slot, which we do not expect to happen.
+*/
+
+constexpr s64 mapped_array_null_handle = -1;
+
+struct MappedArraySlot
+{
+	// Note(Leo): Item's index in 'memory' while slot is used, and next free slot when it is not
+	s32 index;
+	u32 generation;
+};
+
 template<typename T>
 struct MappedArray
 {
 	s64 	capacity;
 	s64 	count;
-	s64 * 	indirectionTable;
 	T * 	memory;
 
+	// Note(Leo): Handle of each item, in same order as 'memory'
+	s64 * 				handles;
+	MappedArraySlot * 	slots;
+	s32 				firstFreeSlot;
+
+	static u32 handle_slot(s64 handle) 			{ return (u32)((u64)handle & 0xffffffff); }
+	static u32 handle_generation(s64 handle) 	{ return (u32)((u64)handle >> 32); }
+
+	// Note(Leo): Null handle's slot is never less than capacity
+	bool32 contains(s64 handle) const
+	{
+		u32 slot = handle_slot(handle);
+		return slot < capacity && slots[slot].generation == handle_generation(handle);
+	}
+
 	T & operator[] (s64 handle)
 	{
-		s64 index = indirectionTable[handle];
-		return memory[index];
+		Assert(contains(handle) && "Handle is not in mapped array");
+		return memory[slots[handle_slot(handle)].index];
+	}
+
+	T const & operator[] (s64 handle) const
+	{
+		Assert(contains(handle) && "Handle is not in mapped array");
+		return memory[slots[handle_slot(handle)].index];
+	}
+
+	// Note(Leo): Returns nullptr if item was removed, so this can be used with handles that may be old
+	T * get(s64 handle)
+	{
+		return contains(handle) ? &memory[slots[handle_slot(handle)].index] : nullptr;
 	}
 
 	s64 push (T const & item)
 	{
 		Assert(count < capacity);
 
-		s64 index 	= count;
-		count 		+= 1;
+		s32 slot 		= firstFreeSlot;
+		firstFreeSlot 	= slots[slot].index;
 
-		memory[index] = item;
+		s32 index 				= (s32)count++;
+		slots[slot].index 		= index;
+		slots[slot].generation 	+= 1;
 
-		s64 handle = get_free_handle();
-		indirectionTable[handle] = index;
+		s64 handle 		= (s64)(((u64)slots[slot].generation << 32) | (u64)slot);
+		memory[index] 	= item;
+		handles[index] 	= handle;
 
 		return handle;
 	}
 
-	s64 get_free_handle()
+	void remove(s64 handle)
 	{
-		for(s64 i = 0; i < capacity; ++i)
+		Assert(contains(handle) && "Handle is not in mapped array");
+
+		u32 slot 	= handle_slot(handle);
+		s32 index 	= slots[slot].index;
+		s32 last 	= (s32)count - 1;
+
+		if (index != last)
 		{
-			if (indirectionTable[i] < 0)
-			{
-				return i;
-			}
+			memory[index] 	= memory[last];
+			handles[index] 	= handles[last];
+
+			slots[handle_slot(handles[index])].index = index;
 		}
-		return -1;
+		count -= 1;
+
+		slots[slot].index 		= firstFreeSlot;
+		slots[slot].generation 	+= 1;
+		firstFreeSlot 			= (s32)slot;
+	}
+
+	T const * begin () const { return memory; }
+	T const * end () const { return memory + count; }
+
+	T * begin () { return memory; }
+	T * end () { return memory + count; }
+};
+
+template<typename T>
+internal MappedArray<T> push_mapped_array(MemoryArena & allocator, s64 capacity)
+{
+	Assert(capacity <= std::numeric_limits<s32>::max());
+
+	MappedArray<T> array 	= {};
+	array.capacity 			= capacity;
+	array.memory 			= push_memory<T>(allocator, capacity, ALLOC_GARBAGE);
+	array.handles 			= push_memory<s64>(allocator, capacity, ALLOC_GARBAGE);
+	array.slots 			= push_memory<MappedArraySlot>(allocator, capacity, ALLOC_GARBAGE);
+
+	for (s32 i = 0; i < capacity; ++i)
+	{
+		array.slots[i] = {i + 1, 0};
+	}
+	array.firstFreeSlot = 0;
+
+	return array;
+}
+
+// Note(Leo): Removes all items, handles to them become invalid
+template<typename T>
+internal void mapped_array_flush(MappedArray<T> & array)
+{
+	while (array.count > 0)
+	{
+		array.remove(array.handles[array.count - 1]);
 	}
-};
\ No newline at end of file
+}
@@ -0,0 +1,151 @@
+/*
+Leo Tamminen
+
+Game side of memory arena instrumentation, see MemoryArenaInstrumentation in Memory.cpp. Persistent and
+transient arenas are instrumented in development builds, and this logs their usage reports and tells
+who used the memory when one runs out. Editor is in game_gui.cpp.
+*/
+
+#if defined FS_MEMORY_INSTRUMENTATION_ENABLED
+
+constexpr s32 memory_instrumentation_report_callsite_count = 20;
+
+// Note(Leo): __builtin_FILE gives path as it was given to compiler, we only want file's name
+internal char const * memory_instrumentation_file_name(char const * file)
+{
+	char const * name = file;
+	for (char const * c = file; *c != 0; ++c)
+	{
+		if (*c == '/' || *c == '\\')
+		{
+			name = c + 1;
+		}
+	}
+	return name;
+}
+
+internal int memory_instrumentation_compare_callsites(void const * a, void const * b)
+{
+	MemoryCallsiteStats const * statsA = *reinterpret_cast<MemoryCallsiteStats const * const *>(a);
+	MemoryCallsiteStats const * statsB = *reinterpret_cast<MemoryCallsiteStats const * const *>(b);
+
+	if (statsA->peakBytes != statsB->peakBytes)
+	{
+		return statsA->peakBytes > statsB->peakBytes ? -1 : 1;
+	}
+	return statsA->line - statsB->line;
+}
+
+/*
+Note(Leo): Writes used callsites to 'sorted', largest peak first, and returns their count. Peak is used
+instead of current bytes, so that transient arena's callsites are sorted by their largest frame.
+Overflow is last if it was used.
+*/
+internal s32 memory_instrumentation_sort_callsites(	MemoryArenaInstrumentation const & instrumentation,
+													MemoryCallsiteStats const * (&sorted)[memory_instrumentation_callsite_capacity + 1])
+{
+	s32 count = 0;
+	for (MemoryCallsiteStats const & stats : instrumentation.callsites)
+	{
+		if (stats.file != nullptr)
+		{
+			sorted[count++] = &stats;
+		}
+	}
+
+	qsort(sorted, count, sizeof(MemoryCallsiteStats const *), memory_instrumentation_compare_callsites);
+
+	if (instrumentation.overflow.totalCount > 0)
+	{
+		sorted[count++] = &instrumentation.overflow;
+	}
+
+	return count;
+}
+
+internal void memory_instrumentation_log_report(MemoryArena const & arena, s32 maxCallsiteCount = memory_instrumentation_report_callsite_count)
+{
+	if (arena.instrumentation == nullptr)
+	{
+		return;
+	}
+
+	MemoryArenaInstrumentation const & instrumentation 	= *arena.instrumentation;
+	MemoryCallsiteStats const & total 					= instrumentation.total;
+
+	log_application(0, "Memory report for ", instrumentation.name, " arena: used ", reverse_megabytes(arena.used),
+						" MB, committed ", reverse_megabytes(arena.committed), " MB, size ", reverse_megabytes(arena.size), " MB");
+
+	log_application(0, "    High-water marks: this frame ", reverse_megabytes(instrumentation.frameHighWaterMark),
+						" MB, peak ", reverse_megabytes(instrumentation.peakHighWaterMark), " MB on frame ", instrumentation.peakFrameIndex);
+
+	f32 alignUpExtraPercent = total.bytes > 0 ? 100.0f * total.alignUpExtra / total.bytes : 0.0f;
+	log_application(0, "    Since flush: ", total.count, " allocations, requested ", total.requested, " B, padding ", total.padding,
+						" B, rounding ", total.rounding, " B, memory_align_up extra ", total.alignUpExtra, " B (", alignUpExtraPercent, " %)");
+
+	local_persist MemoryCallsiteStats const * sorted [memory_instrumentation_callsite_capacity + 1];
+	s32 callsiteCount = memory_instrumentation_sort_callsites(instrumentation, sorted);
+
+	for (s32 i = 0; i < callsiteCount && i < maxCallsiteCount; ++i)
+	{
+		MemoryCallsiteStats const & stats 	= *sorted[i];
+		char const * file 					= stats.file != nullptr ? memory_instrumentation_file_name(stats.file) : "<overflow>";
+
+		log_application(0, "    ", file, ":", stats.line, ": peak ", stats.peakBytes, " B, now ", stats.bytes, " B in ", stats.count,
+							" allocations (", stats.totalCount, " total), padding ", stats.padding, " B, memory_align_up extra ", stats.alignUpExtra, " B");
+	}
+
+	if (callsiteCount > maxCallsiteCount)
+	{
+		log_application(0, "    ...and ", callsiteCount - maxCallsiteCount, " more callsites");
+	}
+}
+
+internal void memory_instrumentation_out_of_memory(MemoryArena & arena, u64 size, MemoryCallsite callsite)
+{
+	log_application(0, "Arena '", arena.instrumentation->name, "' is out of memory, ", memory_instrumentation_file_name(callsite.file), ":",
+						callsite.line, " tried to allocate ", size, " B, ", arena.size - arena.used, " B left");
+
+	memory_instrumentation_log_report(arena, memory_instrumentation_callsite_capacity + 1);
+}
+
+// Note(Leo): Clears 'instrumentation', and records arena's allocations to it from now on
+internal void memory_instrumentation_attach(MemoryArena & arena, MemoryArenaInstrumentation & instrumentation, char const * name)
+{
+	memset(&instrumentation, 0, sizeof(MemoryArenaInstrumentation));
+	// Note(Leo): Name is copied, since string literals in game code would be gone after reload
+	for (s32 i = 0; i < (s32)array_count(instrumentation.name) - 1 && name[i] != 0; ++i)
+	{
+		instrumentation.name[i] = name[i];
+	}
+
+	instrumentation.outOfMemory = memory_instrumentation_out_of_memory;
+	arena.instrumentation 		= &instrumentation;
+}
+
+// Note(Leo): Call at start of each frame
+internal void memory_instrumentation_begin_arena_frame(MemoryArena & arena)
+{
+	if (arena.instrumentation == nullptr)
+	{
+		return;
+	}
+
+	MemoryArenaInstrumentation & instrumentation = *arena.instrumentation;
+
+	/*
+	Note(Leo): Callsites' file names and out of memory handler are in game code. If it was reloaded,
+	handler's address is different, and old file names may be gone, so callsites are cleared.
+	*/
+	if (instrumentation.outOfMemory != memory_instrumentation_out_of_memory)
+	{
+		memset(instrumentation.callsites, 0, sizeof(instrumentation.callsites));
+		instrumentation.overflow 		= {};
+		instrumentation.callsiteCount 	= 0;
+		instrumentation.outOfMemory 	= memory_instrumentation_out_of_memory;
+	}
+
+	memory_instrumentation_begin_frame(instrumentation, arena.used);
+}
+
+#endif
@@ -277,7 +277,7 @@ internal void generate_mesh_marching_cubes(	s32 vertexCapacity, Vertex * vertice
 	u32 vertexCount = 0;
 	u32 indexCount = 0;
 
-	s64 startTime = platform_time_now();
+	FS_PROFILE_FUNCTION();
 
 	constexpr s32 edges [24][2] = 
 	{
@@ -684,7 +684,6 @@ internal void generate_mesh_marching_cubes(	s32 vertexCapacity, Vertex * vertice
 
 	// log_debug(0) << "zCount = " << zCount;
 
-	// log_debug(0) << "Marching Cubes Took: " << platformApi->elapsed_seconds(startTime, platformApi->current_time()) << " s";
 	// log_debug(0) << "Vertices: " << vertexCount << "/" << vertexCapacity << ", indices: " << indexCount << "/" << indexCapacity;
 
 	mesh_generate_normals(vertexCount, vertices, indexCount, indices);
@@ -34,6 +34,8 @@ internal void physics_world_remove_entity(PhysicsWorld & physicsWorld, EntityRef
 
 internal void update_physics_world(PhysicsWorld & physics, Game * game, f32 elapsedTime)
 {
+	FS_PROFILE_FUNCTION();
+
 	for (s32 i = 0; i < physics.entities.count; ++i)
 	{
 		// bool cancelFall = physics.entities[i].entity == game->playerCarriedEntity;
@@ -0,0 +1,245 @@
+/*
+Leo Tamminen
+
+Structure of arrays. Each of 'Ts' is a column, and row is made of same index in each column. All
+columns are in one allocation and each column starts at 'soa_column_alignment', so kernels that go
+through one or two columns do not load others, and can use aligned SIMD loads.
+
+Rows are added to end, and removing moves last row to removed row's place in all columns at once,
+so rows stay packed, but last row's index changes.
+
+Memory is from MemoryArena with push_soa, and then capacity is fixed, or from MemoryPool with
+soa_reserve, which grows like array_reserve.
+*/
+
+constexpr u64 soa_column_alignment = 32;
+
+template<s32 Column, typename TFirst, typename ... TOthers>
+struct SoAColumnType
+{
+	using type = typename SoAColumnType<Column - 1, TOthers...>::type;
+};
+
+template<typename TFirst, typename ... TOthers>
+struct SoAColumnType<0, TFirst, TOthers...>
+{
+	using type = TFirst;
+};
+
+template<typename ... Ts>
+struct SoA
+{
+	static constexpr s32 column_count = sizeof...(Ts);
+
+	template<s32 Column>
+	using ColumnType = typename SoAColumnType<Column, Ts...>::type;
+
+	s32 capacity;
+	s32 count;
+
+	// Note(Leo): Whole allocation, columns are inside this. Pool needs size to free it.
+	void * 	memory;
+	u64 	memorySize;
+
+	void * 	columns [column_count];
+
+	template<s32 Column>
+	ColumnType<Column> * column() { return reinterpret_cast<ColumnType<Column>*>(columns[Column]); }
+
+	template<s32 Column>
+	ColumnType<Column> const * column() const { return reinterpret_cast<ColumnType<Column> const *>(columns[Column]); }
+
+	// Note(Leo): Calls 'func(T * column)' for each column, so 'func' must work with all column types
+	template<s32 Column = 0, typename TFunc>
+	void for_each_column(TFunc const & func)
+	{
+		if constexpr (Column < column_count)
+		{
+			func(column<Column>());
+			for_each_column<Column + 1>(func);
+		}
+	}
+
+	template<s32 Column = 0, typename TFirst, typename ... TOthers>
+	void set(s32 index, TFirst const & first, TOthers const & ... others)
+	{
+		column<Column>()[index] = first;
+
+		if constexpr (sizeof...(TOthers) > 0)
+		{
+			set<Column + 1>(index, others...);
+		}
+	}
+
+	// Note(Leo): Returns index of new row
+	s32 push(Ts const & ... values)
+	{
+		Assert(count < capacity);
+
+		s32 index = count++;
+		set(index, values...);
+		return index;
+	}
+
+	// Note(Leo): Adds 'rowCount' zeroed rows, returns index of first
+	s32 append(s32 rowCount)
+	{
+		Assert(count + rowCount <= capacity);
+
+		s32 first = count;
+		count += rowCount;
+
+		for_each_column([first, rowCount](auto * column) { memset(column + first, 0, rowCount * sizeof(*column)); });
+		return first;
+	}
+
+	// Note(Leo): Adds 'rowCount' rows copied from one array per column, returns index of first
+	s32 append(s32 rowCount, Ts const * ... sources)
+	{
+		Assert(count + rowCount <= capacity);
+
+		s32 first = count;
+		count += rowCount;
+
+		copy_columns(first, rowCount, sources...);
+		return first;
+	}
+
+	template<s32 Column = 0, typename TFirst, typename ... TOthers>
+	void copy_columns(s32 first, s32 rowCount, TFirst const * source, TOthers const * ... others)
+	{
+		memory_copy(column<Column>() + first, source, rowCount * sizeof(TFirst));
+
+		if constexpr (sizeof...(TOthers) > 0)
+		{
+			copy_columns<Column + 1>(first, rowCount, others...);
+		}
+	}
+
+	// Note(Leo): Copies first 'rowCount' rows of each column from other SoA with same columns
+	template<s32 Column = 0>
+	void copy_rows(SoA const & source, s32 rowCount)
+	{
+		if constexpr (Column < column_count)
+		{
+			memory_copy(column<Column>(), source.template column<Column>(), rowCount * sizeof(ColumnType<Column>));
+			copy_rows<Column + 1>(source, rowCount);
+		}
+	}
+
+	// Note(Leo): Last row takes removed row's index
+	void unordered_remove(s32 index)
+	{
+		Assert(index < count);
+
+		s32 last = count - 1;
+		for_each_column([index, last](auto * column) { column[index] = column[last]; });
+		count -= 1;
+	}
+};
+
+// Note(Leo): Writes each column's offset from start, and returns size of whole allocation
+template<typename ... Ts>
+internal u64 soa_layout(s64 capacity, u64 (&offsets)[sizeof...(Ts)])
+{
+	static_assert(((alignof(Ts) <= soa_column_alignment) && ...), "SoA column type needs more alignment than soa_column_alignment");
+
+	u64 columnSizes [] 	= {sizeof(Ts)...};
+	u64 size 			= 0;
+
+	for (s32 i = 0; i < (s32)sizeof...(Ts); ++i)
+	{
+		offsets[i] 	= size;
+		size 		+= (columnSizes[i] * capacity + soa_column_alignment - 1) & ~(soa_column_alignment - 1);
+	}
+
+	return size;
+}
+
+// Note(Leo): 'memory' must be aligned to 'soa_column_alignment'
+template<typename ... Ts>
+internal void soa_set_memory(SoA<Ts...> & soa, void * memory, s32 capacity)
+{
+	Assert(((u64)memory & (soa_column_alignment - 1)) == 0);
+
+	u64 offsets [sizeof...(Ts)];
+	soa_layout<Ts...>(capacity, offsets);
+
+	for (s32 i = 0; i < (s32)sizeof...(Ts); ++i)
+	{
+		soa.columns[i] = reinterpret_cast<u8*>(memory) + offsets[i];
+	}
+	soa.capacity = capacity;
+}
+
+template<typename ... Ts>
+internal SoA<Ts...> push_soa(MemoryArena & allocator, s32 capacity, MemoryCallsite callsite = MemoryCallsite::here())
+{
+	u64 offsets [sizeof...(Ts)];
+	u64 size = soa_layout<Ts...>(capacity, offsets);
+
+	SoA<Ts...> soa 	= {};
+	soa.memory 		= memory_arena_allocate(allocator, size, soa_column_alignment, callsite);
+	soa.memorySize 	= size;
+	soa_set_memory(soa, soa.memory, capacity);
+
+	return soa;
+}
+
+/*
+Note(Leo): For SoAs whose memory is from MemoryPool. Grows capacity to at least 'capacity', and at least
+doubles it. Existing rows are copied and new ones are zeroed. Returns false and leaves 'soa' as it was if
+pool is out of budget.
+*/
+template<typename ... Ts>
+internal bool32 soa_reserve(MemoryPool & pool, SoA<Ts...> & soa, s32 capacity, MemoryCallsite callsite = MemoryCallsite::here())
+{
+	if (capacity <= soa.capacity)
+	{
+		return true;
+	}
+
+	s32 newCapacity = s32_max(capacity, soa.capacity * 2);
+
+	// Note(Leo): Pool's blocks are only aligned to arena's default alignment, so take extra to align start
+	u64 offsets [sizeof...(Ts)];
+	u64 size = soa_layout<Ts...>(newCapacity, offsets) + soa_column_alignment - MemoryArena::defaultAlignment;
+
+	void * newMemory = memory_pool_allocate(pool, size, callsite);
+	if (newMemory == nullptr)
+	{
+		return false;
+	}
+
+	u64 alignedMemory = ((u64)newMemory + soa_column_alignment - 1) & ~(soa_column_alignment - 1);
+
+	SoA<Ts...> newSoa 	= {};
+	newSoa.memory 		= newMemory;
+	newSoa.memorySize 	= size;
+	soa_set_memory(newSoa, reinterpret_cast<void*>(alignedMemory), newCapacity);
+
+	newSoa.copy_rows(soa, soa.count);
+	newSoa.count = soa.count;
+
+	s32 newRowCount = newCapacity - soa.count;
+	newSoa.for_each_column([&soa, newRowCount](auto * column) { memset(column + soa.count, 0, newRowCount * sizeof(*column)); });
+
+	// Note(Leo): memory_pool_free skips nullptrs
+	memory_pool_free(pool, soa.memory, soa.memorySize);
+
+	soa = newSoa;
+	return true;
+}
+
+template<typename ... Ts>
+internal void soa_free(MemoryPool & pool, SoA<Ts...> & soa)
+{
+	memory_pool_free(pool, soa.memory, soa.memorySize);
+	soa = {};
+}
+
+template<typename ... Ts>
+internal void soa_flush(SoA<Ts...> & soa)
+{
+	soa.count = 0;
+}
@@ -0,0 +1,247 @@
+/*
+Leo Tamminen
+
+Spatial hash grid over XY plane. Items are identified by index from 0 to capacity, and each is in
+one bucket, found by hashing the cell it is in. Buckets are doubly linked lists through items, so
+inserting, moving and removing are all O(1), and grid never allocates after it is made.
+
+Grid does not store positions, only which cell each item is in. Queries give all items in cells
+that overlap query area, and caller checks actual distances from its own positions. That way things
+that move only in z, like falling things, do not need to tell grid.
+*/
+
+constexpr s32 spatial_hash_grid_null = -1;
+
+struct SpatialHashGridItem
+{
+	// Note(Leo): Cell is stored so that items from other cells in same bucket can be skipped
+	s32 cellX;
+	s32 cellY;
+
+	s32 bucket;
+	s32 next;
+	s32 previous;
+};
+
+constexpr SpatialHashGridItem spatial_hash_grid_null_item = {	0, 0,
+																spatial_hash_grid_null,
+																spatial_hash_grid_null,
+																spatial_hash_grid_null };
+
+struct SpatialHashGrid
+{
+	f32 cellSize;
+	f32 inverseCellSize;
+
+	// Note(Leo): Bucket count is power of two, each bucket has index of its first item or null
+	s32 	bucketCount;
+	s32 * 	buckets;
+
+	s32 					capacity;
+	SpatialHashGridItem * 	items;
+};
+
+internal SpatialHashGrid make_spatial_hash_grid(MemoryArena & allocator, s32 capacity, f32 cellSize)
+{
+	SpatialHashGrid grid 	= {};
+	grid.cellSize 			= cellSize;
+	grid.inverseCellSize 	= 1.0f / cellSize;
+	grid.capacity 			= capacity;
+
+	// Note(Leo): At least as many buckets as items, so that chains stay short
+	grid.bucketCount = 16;
+	while (grid.bucketCount < capacity)
+	{
+		grid.bucketCount *= 2;
+	}
+
+	grid.buckets 	= push_memory<s32>(allocator, grid.bucketCount, ALLOC_GARBAGE);
+	grid.items 		= push_memory<SpatialHashGridItem>(allocator, capacity, ALLOC_GARBAGE);
+
+	for (s32 i = 0; i < grid.bucketCount; ++i)
+	{
+		grid.buckets[i] = spatial_hash_grid_null;
+	}
+
+	for (s32 i = 0; i < capacity; ++i)
+	{
+		grid.items[i] = spatial_hash_grid_null_item;
+	}
+
+	return grid;
+}
+
+internal s32 spatial_hash_grid_cell_coordinate(SpatialHashGrid const & grid, f32 value)
+{
+	return (s32)floor_f32(value * grid.inverseCellSize);
+}
+
+internal s32 spatial_hash_grid_cell_bucket(SpatialHashGrid const & grid, s32 cellX, s32 cellY)
+{
+	u32 hash = (u32)cellX * 73856093u ^ (u32)cellY * 19349663u;
+	return (s32)(hash & (u32)(grid.bucketCount - 1));
+}
+
+internal bool32 spatial_hash_grid_contains(SpatialHashGrid const & grid, s32 item)
+{
+	return grid.items[item].bucket != spatial_hash_grid_null;
+}
+
+internal void spatial_hash_grid_link(SpatialHashGrid & grid, s32 item, s32 cellX, s32 cellY)
+{
+	SpatialHashGridItem & gridItem = grid.items[item];
+	s32 bucket = spatial_hash_grid_cell_bucket(grid, cellX, cellY);
+
+	gridItem.cellX 		= cellX;
+	gridItem.cellY 		= cellY;
+	gridItem.bucket 	= bucket;
+	gridItem.previous 	= spatial_hash_grid_null;
+	gridItem.next 		= grid.buckets[bucket];
+
+	if (gridItem.next != spatial_hash_grid_null)
+	{
+		grid.items[gridItem.next].previous = item;
+	}
+	grid.buckets[bucket] = item;
+}
+
+internal void spatial_hash_grid_unlink(SpatialHashGrid & grid, s32 item)
+{
+	SpatialHashGridItem & gridItem = grid.items[item];
+
+	if (gridItem.previous != spatial_hash_grid_null)
+	{
+		grid.items[gridItem.previous].next = gridItem.next;
+	}
+	else
+	{
+		grid.buckets[gridItem.bucket] = gridItem.next;
+	}
+
+	if (gridItem.next != spatial_hash_grid_null)
+	{
+		grid.items[gridItem.next].previous = gridItem.previous;
+	}
+
+	gridItem = spatial_hash_grid_null_item;
+}
+
+internal void spatial_hash_grid_remove(SpatialHashGrid & grid, s32 item)
+{
+	Assert(item >= 0 && item < grid.capacity);
+
+	if (spatial_hash_grid_contains(grid, item))
+	{
+		spatial_hash_grid_unlink(grid, item);
+	}
+}
+
+// Note(Leo): Inserts item if it is not in grid yet
+internal void spatial_hash_grid_move(SpatialHashGrid & grid, s32 item, v2 position)
+{
+	Assert(item >= 0 && item < grid.capacity);
+
+	s32 cellX = spatial_hash_grid_cell_coordinate(grid, position.x);
+	s32 cellY = spatial_hash_grid_cell_coordinate(grid, position.y);
+
+	if (spatial_hash_grid_contains(grid, item))
+	{
+		if (grid.items[item].cellX == cellX && grid.items[item].cellY == cellY)
+		{
+			return;
+		}
+
+		spatial_hash_grid_unlink(grid, item);
+	}
+	spatial_hash_grid_link(grid, item, cellX, cellY);
+}
+
+/*
+Note(Leo): For unordered removes, where last item is moved to removed item's place. 'item' must not
+be in grid anymore, and 'lastItem' takes its index, keeping its place in grid.
+*/
+internal void spatial_hash_grid_move_index(SpatialHashGrid & grid, s32 lastItem, s32 item)
+{
+	Assert(spatial_hash_grid_contains(grid, item) == false);
+
+	if (lastItem == item || spatial_hash_grid_contains(grid, lastItem) == false)
+	{
+		return;
+	}
+
+	SpatialHashGridItem gridItem = grid.items[lastItem];
+	grid.items[item] = gridItem;
+
+	if (gridItem.previous != spatial_hash_grid_null)
+	{
+		grid.items[gridItem.previous].next = item;
+	}
+	else
+	{
+		grid.buckets[gridItem.bucket] = item;
+	}
+
+	if (gridItem.next != spatial_hash_grid_null)
+	{
+		grid.items[gridItem.next].previous = item;
+	}
+
+	grid.items[lastItem] = spatial_hash_grid_null_item;
+}
+
+/*
+Note(Leo): Calls 'func(s32 item)' once for every item in cells that overlap circle on XY plane.
+Each cell's bucket is visited, and items from other cells that hash to same bucket are skipped.
+*/
+template<typename TFunc>
+internal void spatial_hash_grid_query(SpatialHashGrid const & grid, v2 center, f32 radius, TFunc func)
+{
+	s32 minX = spatial_hash_grid_cell_coordinate(grid, center.x - radius);
+	s32 maxX = spatial_hash_grid_cell_coordinate(grid, center.x + radius);
+	s32 minY = spatial_hash_grid_cell_coordinate(grid, center.y - radius);
+	s32 maxY = spatial_hash_grid_cell_coordinate(grid, center.y + radius);
+
+	s64 cellCount = (s64)(maxX - minX + 1) * (s64)(maxY - minY + 1);
+
+	// Note(Leo): When there are more cells than buckets, it is cheaper to go through buckets
+	if (cellCount > grid.bucketCount)
+	{
+		for (s32 bucket = 0; bucket < grid.bucketCount; ++bucket)
+		{
+			for (s32 item = grid.buckets[bucket]; item != spatial_hash_grid_null; item = grid.items[item].next)
+			{
+				SpatialHashGridItem const & gridItem = grid.items[item];
+				if (gridItem.cellX >= minX && gridItem.cellX <= maxX && gridItem.cellY >= minY && gridItem.cellY <= maxY)
+				{
+					func(item);
+				}
+			}
+		}
+		return;
+	}
+
+	for (s32 y = minY; y <= maxY; ++y)
+	{
+		// Note(Leo): Only cells that touch circle on this row, found from row's nearest edge to center
+		f32 rowMin 		= y * grid.cellSize;
+		f32 rowMax 		= rowMin + grid.cellSize;
+		f32 rowDistance = f32_max(0, f32_max(rowMin - center.y, center.y - rowMax));
+		f32 halfWidth 	= f32_sqr_root(f32_max(0, radius * radius - rowDistance * rowDistance));
+
+		s32 rowMinX = s32_max(minX, spatial_hash_grid_cell_coordinate(grid, center.x - halfWidth));
+		s32 rowMaxX = s32_min(maxX, spatial_hash_grid_cell_coordinate(grid, center.x + halfWidth));
+
+		for (s32 x = rowMinX; x <= rowMaxX; ++x)
+		{
+			s32 bucket = spatial_hash_grid_cell_bucket(grid, x, y);
+
+			for (s32 item = grid.buckets[bucket]; item != spatial_hash_grid_null; item = grid.items[item].next)
+			{
+				if (grid.items[item].cellX == x && grid.items[item].cellY == y)
+				{
+					func(item);
+				}
+			}
+		}
+	}
+}
@@ -127,10 +127,7 @@ String string_extract_line(String & source)
 	String result = { length, source.memory };
 	string_eat_spaces(result);
 
-	#ifndef _WIN32
-	static_assert(false, "Not sure if newline is still the same on this os");
-	#endif
-
+	// Note(Leo): Both '\r\n' (windows) and '\n' (linux) line endings are handled above
 	// Note(Leo) add two for \r and \n
 	source.memory += length + skipLength;
 	source.length -= length + skipLength;
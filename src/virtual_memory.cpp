@@ -0,0 +1,36 @@
+/*
+Leo Tamminen
+
+Virtual memory arenas. These reserve a big range of address space from platform, and commit it in
+steps as arena grows, see MemoryArena. Address space is cheap on 64 bit systems, so reserve generously
+and let arena grow with world instead of guessing its size up front. Memory is never moved, so
+pointers to it stay valid.
+*/
+
+// Note(Leo): First commit step is always committed, and flushing keeps it
+internal MemoryArena memory_arena_virtual(u64 reservedSize, u64 commitStep, bool32 decommitOnFlush)
+{
+	u64 pageSize 	= platform_memory_page_size();
+	commitStep 		= ((commitStep + pageSize - 1) / pageSize) * pageSize;
+	reservedSize 	= ((reservedSize + commitStep - 1) / commitStep) * commitStep;
+
+	MemoryArena arena 		= {};
+	arena.memory 			= reinterpret_cast<u8*>(platform_memory_reserve(reservedSize));
+	arena.size 				= reservedSize;
+	arena.commitStep 		= commitStep;
+	arena.decommitOnFlush 	= decommitOnFlush;
+	arena.commit 			= platform_memory_commit;
+	arena.decommit 			= platform_memory_decommit;
+
+	AssertRelease(arena.memory != nullptr, "Failed to reserve memory for arena");
+
+	memory_arena_commit(arena, commitStep);
+
+	return arena;
+}
+
+internal void memory_arena_virtual_release(MemoryArena & arena)
+{
+	platform_memory_release(arena.memory, arena.size);
+	arena = {};
+}